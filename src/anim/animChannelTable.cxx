@@ -620,11 +620,7 @@ fillin(DatagramIterator &scan, BamReader *manager) {
       num_floats += count_bits_in_word(format);
     }
 
-    for (size_t i = 1; i < _frames.size(); ++i) {
-      for (unsigned int j = 0; j < num_floats; ++j) {
-        _frames[i].push_back(scan.get_float32());
-      }
-    }
+    read_frames(scan, manager, _frames, num_floats);
   }
 
   if (_table_flags & TF_sliders) {
@@ -651,12 +647,37 @@ fillin(DatagramIterator &scan, BamReader *manager) {
         ++num_floats;
       }
     }
-    for (size_t i = 1; i < _slider_frames.size(); ++i) {
-      for (int j = 0; j < num_floats; ++j) {
-        _slider_frames[i].push_back(scan.get_float32());
-      }
-    }
+    read_frames(scan, manager, _slider_frames, num_floats);
   }
 
   _root_motion_vector.read_datagram(scan);
 }
+
+/**
+ * Reads the non-zero frames of the indicated table, each of which stores
+ * num_floats values.  The frames make up the bulk of a table, so they are
+ * handed to the BamReader to unpack, possibly in parallel with other tables
+ * and vertex data.
+ */
+void AnimChannelTable::
+read_frames(DatagramIterator &scan, BamReader *manager, FrameDatas &frames,
+            size_t num_floats) {
+  if (frames.size() <= 1) {
+    return;
+  }
+
+  for (size_t i = 1; i < frames.size(); ++i) {
+    frames[i].resize(num_floats);
+  }
+
+  FrameDatas *dest = &frames;
+  size_t size = (frames.size() - 1) * num_floats * sizeof(PN_float32);
+  manager->defer_decode(scan, size, [dest, num_floats] (DatagramIterator &scan) {
+    for (size_t i = 1; i < dest->size(); ++i) {
+      float *data = (*dest)[i].data();
+      for (size_t j = 0; j < num_floats; ++j) {
+        data[j] = scan.get_float32();
+      }
+    }
+  });
+}
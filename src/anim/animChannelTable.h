@@ -117,6 +117,8 @@ protected:
   INLINE AnimChannelTable(const AnimChannelTable &copy);
 
   void fillin(DatagramIterator &scan, BamReader *manager);
+  static void read_frames(DatagramIterator &scan, BamReader *manager,
+                          FrameDatas &frames, size_t num_floats);
 
 private:
   // Matches up to indices in frame data.
@@ -19,6 +19,7 @@
 #include "loader.h"
 #include "pStatCollector.h"
 #include "pStatTimer.h"
+#include "pStatCounterTimer.h"
 #include "characterJointEffect.h"
 #include "randomizer.h"
 #include "animChannelTable.h"
@@ -31,7 +32,7 @@
 TypeHandle Character::_type_handle;
 
 static PStatCollector apply_pose_collector("*:Animation:Joints:ApplyPose");
-static PStatCollector ap_compose_collector("*:Animation:Joints:ApplyPose:Compose");
+static PStatCounter ap_compose_counter("*:Animation:Joints:ApplyPose:Compose");
 static PStatCollector ap_net_collector("*:Animation:Joints:ApplyPose:NetTransform");
 static PStatCollector ap_skinning_collector("*:Animation:Joints:ApplyPose:SkinningMatrix");
 static PStatCollector ap_mark_jvt_collector("*:Animation:Joints:ApplyPose:MarkModified");
@@ -781,8 +782,8 @@ apply_pose(CData *cdata, const LMatrix4 &root_xform, const AnimEvalData &data, T
   //JobSystem *js = JobSystem::get_global_ptr();
   //js->parallel_process(joint_count, [&data, &root_xform, &merge_char, &parent_to_me, this] (int i) {
   for (size_t i = 0; i < joint_count; i++) {
-    //ap_compose_collector.start();
-    
+    PStatCounterTimer compose_timer(ap_compose_counter);
+
     CharacterJointPoseData &joint = _joint_poses[i];
 
     if (joint._merge_joint == -1) {
@@ -822,8 +823,6 @@ apply_pose(CData *cdata, const LMatrix4 &root_xform, const AnimEvalData &data, T
         joint._value = joint._net_transform;
       }
     }
-    
-    //ap_compose_collector.stop();
   }
   //});
 
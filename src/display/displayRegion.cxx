@@ -727,6 +727,7 @@ do_cull(CullHandler *cull_handler, SceneSetup *scene_setup,
   if (culler != nullptr) {
     culler->bin_lights(scene_setup->get_camera_path(), scene_setup->get_lens());
   }
+  scene_setup->set_light_culler(culler);
 
   GraphicsEngine::do_cull(cull_handler, scene_setup, gsg, current_thread);
 }
@@ -27,6 +27,7 @@
     httpDigestAuthorization.I httpDigestAuthorization.h \
     httpEntityTag.I httpEntityTag.h \
     httpEnum.h \
+    httpParallelDownload.I httpParallelDownload.h \
     identityStream.I identityStream.h \
     identityStreamBuf.h identityStreamBuf.I \
     multiplexStream.I multiplexStream.h \
@@ -57,6 +58,7 @@
     httpDigestAuthorization.cxx \
     httpEntityTag.cxx \
     httpEnum.cxx \
+    httpParallelDownload.cxx \
     identityStream.cxx identityStreamBuf.cxx \
     multiplexStream.cxx multiplexStreamBuf.cxx \
     patcher.cxx \
@@ -85,6 +87,7 @@
     httpDigestAuthorization.I httpDigestAuthorization.h \
     httpEntityTag.I httpEntityTag.h \
     httpEnum.h \
+    httpParallelDownload.I httpParallelDownload.h \
     identityStream.I identityStream.h \
     identityStreamBuf.h identityStreamBuf.I \
     multiplexStream.I multiplexStream.h \
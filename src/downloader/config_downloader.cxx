@@ -113,6 +113,24 @@ ConfigVariableInt http_max_connect_count
           "prevent the code from attempting runaway connections; this limit "
           "should never be reached in practice."));
 
+ConfigVariableInt http_parallel_channels
+("http-parallel-channels", 4,
+ PRC_DESC("The default number of HTTPChannels an HTTPParallelDownload uses to "
+          "request different parts of a document at the same time."));
+
+ConfigVariableInt http_parallel_chunk_size
+("http-parallel-chunk-size", 1048576,
+ PRC_DESC("The default number of bytes an HTTPParallelDownload requests at a "
+          "time on each channel.  This much data is held in memory per "
+          "channel, and is the granularity at which an interrupted download "
+          "resumes."));
+
+ConfigVariableInt http_parallel_max_retries
+("http-parallel-max-retries", 3,
+ PRC_DESC("The default number of times an HTTPParallelDownload requests any "
+          "one part of a document again, after a lost connection or a hash "
+          "mismatch, before it gives up."));
+
 ConfigVariableInt tcp_header_size
 ("tcp-header-size", 2,
  PRC_DESC("Specifies the number of bytes to use to specify the datagram "
@@ -43,6 +43,9 @@ extern ConfigVariableDouble http_timeout;
 extern ConfigVariableInt http_skip_body_size;
 extern ConfigVariableDouble http_idle_timeout;
 extern ConfigVariableInt http_max_connect_count;
+extern EXPCL_PANDA_DOWNLOADER ConfigVariableInt http_parallel_channels;
+extern EXPCL_PANDA_DOWNLOADER ConfigVariableInt http_parallel_chunk_size;
+extern EXPCL_PANDA_DOWNLOADER ConfigVariableInt http_parallel_max_retries;
 
 extern EXPCL_PANDA_DOWNLOADER ConfigVariableInt tcp_header_size;
 extern EXPCL_PANDA_DOWNLOADER ConfigVariableBool support_ipv6;
@@ -0,0 +1,630 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file httpParallelDownload.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "httpParallelDownload.h"
+
+#ifdef HAVE_OPENSSL
+
+#include "config_downloader.h"
+#include "virtualFileSystem.h"
+
+#include <algorithm>
+#include <sstream>
+
+using std::string;
+
+// The first line of the state file.  Change the number if the format
+// changes, so that old state files are ignored.
+static const char *const state_magic = "pdl 1";
+
+/**
+ * Prepares to download the indicated document to the indicated file, using
+ * channels made from the indicated client.  If client is NULL, the global
+ * HTTPClient is used.  Nothing is requested until download() or
+ * begin_download() is called.
+ */
+HTTPParallelDownload::
+HTTPParallelDownload(HTTPClient *client, const DocumentSpec &url,
+                     const Filename &filename) :
+  _client(client),
+  _url(url),
+  _filename(filename),
+  _num_channels(std::max((int)http_parallel_channels, 1)),
+  _chunk_size((size_t)std::max((int)http_parallel_chunk_size, 1)),
+  _max_retries(http_parallel_max_retries),
+  _state(S_new),
+  _file_size_known(false),
+  _file_size(0),
+  _file(nullptr),
+  _num_complete(0),
+  _num_resumed(0),
+  _num_retried(0),
+  _bytes_complete(0)
+{
+  if (_client == nullptr) {
+    _client = HTTPClient::get_global_ptr();
+  }
+  _filename.set_binary();
+}
+
+/**
+ *
+ */
+HTTPParallelDownload::
+~HTTPParallelDownload() {
+  close_file();
+}
+
+/**
+ * Downloads the whole document, and returns true if it was successfully
+ * written to the file, false otherwise.  If this returns false, the chunks
+ * that were downloaded are kept, and calling this again will download only
+ * the rest.
+ */
+bool HTTPParallelDownload::
+download() {
+  if (!begin_download()) {
+    return false;
+  }
+  while (run()) {
+    thread_consider_yield();
+  }
+  return is_download_complete();
+}
+
+/**
+ * Begins a nonblocking download.  Call run() repeatedly until it returns
+ * false, then check is_download_complete().
+ */
+bool HTTPParallelDownload::
+begin_download() {
+  close_file();
+  _channel.clear();
+  _slots.clear();
+  _chunks.clear();
+  _pending.clear();
+  _file_size_known = false;
+  _file_size = 0;
+  _num_complete = 0;
+  _num_resumed = 0;
+  _num_retried = 0;
+  _bytes_complete = 0;
+
+  // Ask for the size and version of the document first.
+  _channel = _client->make_channel(true);
+  _channel->begin_get_header(_url);
+  _state = S_header;
+  return true;
+}
+
+/**
+ * Does as much work as can be done without blocking.  Returns true if the
+ * download is still in progress and run() should be called again, or false
+ * if it has finished, successfully or not.
+ */
+bool HTTPParallelDownload::
+run() {
+  switch (_state) {
+  case S_header:
+    return run_header();
+
+  case S_chunks:
+    return run_chunks();
+
+  case S_single:
+    return run_single();
+
+  default:
+    return false;
+  }
+}
+
+/**
+ * Returns the number of bytes of the document that have been downloaded so
+ * far, including chunks that were complete already from a previous attempt.
+ */
+size_t HTTPParallelDownload::
+get_bytes_downloaded() const {
+  if (_state == S_single) {
+    return _channel->get_bytes_downloaded();
+  }
+  size_t bytes = _bytes_complete;
+  for (const Slot &slot : _slots) {
+    if (slot._chunk >= 0) {
+      bytes += slot._data._data.size();
+    }
+  }
+  return bytes;
+}
+
+/**
+ * Waits for the response to the HEAD request, then decides how to download
+ * the document, and starts doing so.
+ */
+bool HTTPParallelDownload::
+run_header() {
+  if (_channel->run()) {
+    return true;
+  }
+
+  if (!_channel->is_valid()) {
+    downloader_cat.info()
+      << "Could not get " << _url.get_url() << ": "
+      << _channel->get_status_code() << " "
+      << _channel->get_status_string() << "\n";
+    fail();
+    return false;
+  }
+
+  // The document spec now has the actual URL, after any redirects, and the
+  // tag and date of the version the server has.  Ask for exactly that version
+  // from now on.
+  _document = _channel->get_document_spec();
+  _document.set_cache_control(_url.get_cache_control());
+  if (_document.has_tag() || _document.has_date()) {
+    _document.set_request_mode(DocumentSpec::RM_equal);
+  }
+
+  _file_size_known = _channel->is_file_size_known();
+  _file_size = _file_size_known ? (size_t)_channel->get_file_size() : 0;
+  bool accept_ranges =
+    (_channel->get_header_value("Accept-Ranges").find("bytes") != string::npos);
+  _channel.clear();
+
+  if (!accept_ranges || !_file_size_known || _file_size == 0) {
+    if (downloader_cat.is_debug()) {
+      downloader_cat.debug()
+        << "Server does not support range requests for " << _document.get_url()
+        << "; downloading over one channel.\n";
+    }
+    return begin_single();
+  }
+
+  make_chunks();
+  if (!_chunk_hashes.empty() && _chunk_hashes.size() != _chunks.size()) {
+    downloader_cat.warning()
+      << "Got " << _chunk_hashes.size() << " chunk hashes for "
+      << _document.get_url() << ", which has " << _chunks.size()
+      << " chunks of " << _chunk_size << " bytes.\n";
+  }
+
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  bool resume = read_state();
+  _file = vfs->open_read_write_file(_filename, !resume);
+  if (_file == nullptr) {
+    downloader_cat.info()
+      << "Could not open " << _filename << " for writing.\n";
+    fail();
+    return false;
+  }
+
+  for (int ci = 0; ci < (int)_chunks.size(); ++ci) {
+    Chunk &chunk = _chunks[ci];
+    if (chunk._complete && ci < (int)_chunk_hashes.size()) {
+      // Don't trust a chunk from a previous attempt if we can check it.
+      chunk._complete = check_file_chunk(*_file, ci);
+    }
+    if (chunk._complete) {
+      ++_num_complete;
+      ++_num_resumed;
+      _bytes_complete += chunk._last_byte - chunk._first_byte + 1;
+    } else {
+      _pending.push_back(ci);
+    }
+  }
+  _file->clear();
+
+  if (resume && downloader_cat.is_debug()) {
+    downloader_cat.debug()
+      << "Resuming download of " << _document.get_url() << " with "
+      << _num_resumed << " of " << _chunks.size() << " chunks complete.\n";
+  }
+  write_state();
+
+  int num_slots = std::min(_num_channels, (int)_pending.size());
+  _slots.resize(num_slots);
+  for (Slot &slot : _slots) {
+    slot._channel = _client->make_channel(true);
+    slot._chunk = -1;
+  }
+
+  _state = S_chunks;
+  return run_chunks();
+}
+
+/**
+ * Services each of the channels in turn, starting the next chunk on any
+ * channel that has finished one.
+ */
+bool HTTPParallelDownload::
+run_chunks() {
+  for (Slot &slot : _slots) {
+    if (slot._chunk < 0) {
+      if (_pending.empty()) {
+        continue;
+      }
+      start_chunk(slot, _pending.front());
+      _pending.pop_front();
+    }
+
+    if (slot._channel->run()) {
+      const Chunk &chunk = _chunks[slot._chunk];
+      if (slot._channel->get_status_code() == 200 &&
+          (chunk._first_byte != 0 || chunk._last_byte + 1 != _file_size)) {
+        // The server claimed to support ranges, but is sending the whole
+        // document anyway.  Stop it before it fills up memory, and just
+        // download the whole thing once.
+        downloader_cat.info()
+          << "Server ignored range request for " << _document.get_url()
+          << "; downloading over one channel.\n";
+        close_file();
+        _slots.clear();
+        _chunks.clear();
+        _pending.clear();
+        _num_complete = 0;
+        _num_resumed = 0;
+        _bytes_complete = 0;
+        delete_state();
+        return begin_single();
+      }
+      continue;
+    }
+
+    if (!finish_chunk(slot)) {
+      return false;
+    }
+  }
+
+  if (_num_complete == (int)_chunks.size()) {
+    close_file();
+    _slots.clear();
+    delete_state();
+    _state = S_complete;
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * Waits for the download of the whole document over one channel to finish.
+ */
+bool HTTPParallelDownload::
+run_single() {
+  if (_channel->run()) {
+    return true;
+  }
+
+  if (!_channel->is_download_complete() || !_channel->is_valid()) {
+    downloader_cat.info()
+      << "Could not download " << _document.get_url() << ": "
+      << _channel->get_status_code() << " "
+      << _channel->get_status_string() << "\n";
+    fail();
+    return false;
+  }
+
+  _file_size = _channel->get_bytes_downloaded();
+  _file_size_known = true;
+  _channel.clear();
+
+  // We can still check the chunk hashes, although there's nothing to do
+  // about a mismatch but start over.
+  if (!_chunk_hashes.empty()) {
+    make_chunks();
+    VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+    std::istream *in = vfs->open_read_file(_filename, false);
+    bool ok = (in != nullptr);
+    for (int ci = 0; ok && ci < (int)_chunks.size(); ++ci) {
+      ok = check_file_chunk(*in, ci);
+    }
+    vfs->close_read_file(in);
+    _chunks.clear();
+
+    if (!ok) {
+      downloader_cat.warning()
+        << _filename << " does not match the chunk hashes for "
+        << _document.get_url() << ".\n";
+      fail();
+      return false;
+    }
+  }
+
+  _bytes_complete = _file_size;
+  _state = S_complete;
+  return false;
+}
+
+/**
+ * Starts downloading the whole document over one channel, straight into the
+ * file.
+ */
+bool HTTPParallelDownload::
+begin_single() {
+  _channel = _client->make_channel(true);
+  _channel->begin_get_document(_document);
+  if (!_channel->download_to_file(_filename, false)) {
+    fail();
+    return false;
+  }
+  _state = S_single;
+  return true;
+}
+
+/**
+ * Requests the indicated chunk on the slot's channel.
+ */
+void HTTPParallelDownload::
+start_chunk(Slot &slot, int ci) {
+  const Chunk &chunk = _chunks[ci];
+  slot._chunk = ci;
+  slot._data.clear();
+  slot._channel->begin_get_subdocument(_document, chunk._first_byte,
+                                       chunk._last_byte);
+  slot._channel->download_to_ram(&slot._data, false);
+}
+
+/**
+ * Called when the slot's channel has finished with its chunk.  If the chunk
+ * arrived intact, writes it to the file; otherwise, queues it to be requested
+ * again.  Returns false if the whole download has failed.
+ */
+bool HTTPParallelDownload::
+finish_chunk(Slot &slot) {
+  int ci = slot._chunk;
+  slot._chunk = -1;
+  Chunk &chunk = _chunks[ci];
+  HTTPChannel *channel = slot._channel;
+  size_t length = chunk._last_byte - chunk._first_byte + 1;
+  const string &data = slot._data._data;
+
+  int status_code = channel->get_status_code();
+  if (status_code == 412) {
+    // The If-Match failed: the document has changed since we started.  The
+    // chunks we have are no good any more.
+    downloader_cat.warning()
+      << _document.get_url() << " changed on the server during download.\n";
+    delete_state();
+    fail();
+    return false;
+  }
+
+  bool ok = channel->is_download_complete() && channel->is_valid() &&
+    data.size() == length;
+  if (ok && status_code == 206) {
+    ok = (channel->get_first_byte_delivered() == chunk._first_byte);
+  }
+  if (ok && !check_chunk_hash(ci, data.data(), length)) {
+    downloader_cat.warning()
+      << "Chunk " << ci << " of " << _document.get_url()
+      << " does not match its hash.\n";
+    ok = false;
+  }
+
+  if (ok) {
+    _file->seekp(chunk._first_byte);
+    _file->write(data.data(), length);
+    _file->flush();
+    if (_file->fail()) {
+      downloader_cat.warning()
+        << "Error writing to " << _filename << "\n";
+      fail();
+      return false;
+    }
+
+    chunk._complete = true;
+    ++_num_complete;
+    _bytes_complete += length;
+    slot._data.clear();
+    write_state();
+    return true;
+  }
+
+  slot._data.clear();
+  if (chunk._retries >= _max_retries) {
+    downloader_cat.info()
+      << "Could not download chunk " << ci << " of " << _document.get_url()
+      << " after " << chunk._retries + 1 << " attempts: " << status_code
+      << " " << channel->get_status_string() << "\n";
+    fail();
+    return false;
+  }
+
+  ++chunk._retries;
+  ++_num_retried;
+  if (downloader_cat.is_debug()) {
+    downloader_cat.debug()
+      << "Requesting chunk " << ci << " of " << _document.get_url()
+      << " again.\n";
+  }
+  _pending.push_back(ci);
+  return true;
+}
+
+/**
+ * Returns true if the data matches the hash given for the indicated chunk,
+ * or if there is no hash for it.
+ */
+bool HTTPParallelDownload::
+check_chunk_hash(int ci, const char *data, size_t length) const {
+  if (ci >= (int)_chunk_hashes.size()) {
+    return true;
+  }
+  HashVal hash;
+  hash.hash_buffer(data, length);
+  return hash == _chunk_hashes[ci];
+}
+
+/**
+ * Reads the indicated chunk back from the stream, and returns true if it is
+ * all there and matches its hash.
+ */
+bool HTTPParallelDownload::
+check_file_chunk(std::istream &in, int ci) const {
+  const Chunk &chunk = _chunks[ci];
+  size_t length = chunk._last_byte - chunk._first_byte + 1;
+  string data(length, '\0');
+
+  in.clear();
+  in.seekg(chunk._first_byte);
+  in.read(&data[0], length);
+  if ((size_t)in.gcount() != length) {
+    return false;
+  }
+  return check_chunk_hash(ci, data.data(), length);
+}
+
+/**
+ * Divides the document into chunks of _chunk_size bytes, all incomplete.
+ */
+void HTTPParallelDownload::
+make_chunks() {
+  _chunks.clear();
+  size_t num_chunks = (_file_size + _chunk_size - 1) / _chunk_size;
+  _chunks.reserve(num_chunks);
+  for (size_t i = 0; i < num_chunks; ++i) {
+    Chunk chunk;
+    chunk._first_byte = i * _chunk_size;
+    chunk._last_byte = std::min(chunk._first_byte + _chunk_size, _file_size) - 1;
+    chunk._retries = 0;
+    chunk._complete = false;
+    _chunks.push_back(chunk);
+  }
+}
+
+/**
+ * Reads the state file left by a previous attempt, if there is one and it
+ * describes the same version of the same document, and marks the chunks it
+ * lists as complete.  Returns true if the download should resume, false if
+ * it should start over.
+ */
+bool HTTPParallelDownload::
+read_state() {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  Filename state_filename = get_state_filename();
+  if (!vfs->exists(state_filename) || !vfs->exists(_filename)) {
+    return false;
+  }
+
+  // Without a tag or date, we have no way of knowing whether the document is
+  // still the same, unless we can check every chunk we already have.
+  if (!_document.has_tag() && !_document.has_date() &&
+      _chunk_hashes.size() < _chunks.size()) {
+    return false;
+  }
+
+  std::istream *in = vfs->open_read_file(state_filename, false);
+  if (in == nullptr) {
+    return false;
+  }
+
+  string magic, sizes, url, tag, date, complete;
+  std::getline(*in, magic);
+  std::getline(*in, sizes);
+  std::getline(*in, url);
+  std::getline(*in, tag);
+  std::getline(*in, date);
+  std::getline(*in, complete);
+  bool read_ok = !in->fail();
+  vfs->close_read_file(in);
+
+  std::ostringstream expect_sizes;
+  expect_sizes << _file_size << " " << _chunk_size;
+  string expect_tag = _document.has_tag() ? _document.get_tag().get_string() : string();
+  string expect_date = _document.has_date() ? _document.get_date().get_string() : string();
+
+  if (!read_ok || magic != state_magic || sizes != expect_sizes.str() ||
+      url != _document.get_url().get_url() || tag != expect_tag ||
+      date != expect_date || complete.size() != _chunks.size()) {
+    if (downloader_cat.is_debug()) {
+      downloader_cat.debug()
+        << "Ignoring " << state_filename << ", which is for a different "
+        << "version of " << _document.get_url() << ".\n";
+    }
+    return false;
+  }
+
+  for (size_t ci = 0; ci < _chunks.size(); ++ci) {
+    _chunks[ci]._complete = (complete[ci] == '1');
+  }
+  return true;
+}
+
+/**
+ * Records the version of the document and the chunks that have been written
+ * so far in the state file.  This is called after each chunk is written.
+ */
+bool HTTPParallelDownload::
+write_state() const {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  Filename state_filename = get_state_filename();
+  std::ostream *out = vfs->open_write_file(state_filename, false, true);
+  if (out == nullptr) {
+    downloader_cat.warning()
+      << "Could not write " << state_filename << "\n";
+    return false;
+  }
+
+  (*out) << state_magic << "\n"
+         << _file_size << " " << _chunk_size << "\n"
+         << _document.get_url().get_url() << "\n"
+         << (_document.has_tag() ? _document.get_tag().get_string() : string()) << "\n"
+         << (_document.has_date() ? _document.get_date().get_string() : string()) << "\n";
+  for (const Chunk &chunk : _chunks) {
+    (*out) << (chunk._complete ? '1' : '0');
+  }
+  (*out) << "\n";
+
+  bool okflag = !out->fail();
+  vfs->close_write_file(out);
+  return okflag;
+}
+
+/**
+ * Removes the state file, once the download is complete or the chunks on disk
+ * are known to be useless.
+ */
+void HTTPParallelDownload::
+delete_state() const {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  Filename state_filename = get_state_filename();
+  if (vfs->exists(state_filename)) {
+    vfs->delete_file(state_filename);
+  }
+}
+
+/**
+ * Closes the file being downloaded to, if it is open.
+ */
+void HTTPParallelDownload::
+close_file() {
+  if (_file != nullptr) {
+    VirtualFileSystem::close_read_write_file(_file);
+    _file = nullptr;
+  }
+}
+
+/**
+ * Abandons the download.  The state file is left alone, so that the chunks
+ * that were written may be used by a later attempt.
+ */
+void HTTPParallelDownload::
+fail() {
+  close_file();
+  _channel.clear();
+  _slots.clear();
+  _pending.clear();
+  _state = S_failure;
+}
+
+#endif  // HAVE_OPENSSL
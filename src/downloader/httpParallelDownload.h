@@ -0,0 +1,175 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file httpParallelDownload.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef HTTPPARALLELDOWNLOAD_H
+#define HTTPPARALLELDOWNLOAD_H
+
+#include "pandabase.h"
+
+// This module requires OpenSSL to compile, even if you do not intend to use
+// this to establish https connections; this is because it uses the OpenSSL
+// library to portably handle all of the socket communications.
+
+#ifdef HAVE_OPENSSL
+
+#include "httpClient.h"
+#include "httpChannel.h"
+#include "documentSpec.h"
+#include "filename.h"
+#include "hashVal.h"
+#include "ramfile.h"
+#include "referenceCount.h"
+#include "pointerTo.h"
+#include "pvector.h"
+#include "pdeque.h"
+
+/**
+ * Downloads a single large document to a file over several HTTPChannels at
+ * once, by requesting separate byte ranges of it on each channel.  This is
+ * useful when the bandwidth of any one connection to the server is limited.
+ *
+ * The document is divided into chunks of get_chunk_size() bytes.  Each chunk
+ * is downloaded into memory, checked against the expected hash, if one was
+ * supplied with add_chunk_hash(), and then written into place within the
+ * file.  The chunks that have been written so far are recorded in a small
+ * state file next to the target file, so that if the download is interrupted,
+ * a later download of the same document to the same file will fetch only the
+ * missing chunks.
+ *
+ * If the server does not support range requests, or does not report the size
+ * of the document, this falls back to downloading the whole document over a
+ * single channel.
+ *
+ * Like HTTPChannel, this may be used either in blocking mode, with
+ * download(), or in nonblocking mode, with begin_download() followed by
+ * repeated calls to run().
+ */
+class EXPCL_PANDA_DOWNLOADER HTTPParallelDownload : public ReferenceCount {
+PUBLISHED:
+  HTTPParallelDownload(HTTPClient *client, const DocumentSpec &url,
+                       const Filename &filename);
+  virtual ~HTTPParallelDownload();
+
+  INLINE HTTPClient *get_client() const;
+  INLINE const DocumentSpec &get_document_spec() const;
+  INLINE const Filename &get_filename() const;
+
+  INLINE void set_num_channels(int num_channels);
+  INLINE int get_num_channels() const;
+  INLINE void set_chunk_size(size_t chunk_size);
+  INLINE size_t get_chunk_size() const;
+  INLINE void set_max_retries(int max_retries);
+  INLINE int get_max_retries() const;
+
+  INLINE void add_chunk_hash(const HashVal &hash);
+  INLINE void clear_chunk_hashes();
+  INLINE int get_num_chunk_hashes() const;
+
+  BLOCKING bool download();
+  bool begin_download();
+  bool run();
+
+  INLINE bool is_download_complete() const;
+  INLINE bool is_file_size_known() const;
+  INLINE size_t get_file_size() const;
+  size_t get_bytes_downloaded() const;
+
+  INLINE int get_num_chunks() const;
+  INLINE int get_num_chunks_complete() const;
+  INLINE int get_num_chunks_resumed() const;
+  INLINE int get_num_chunks_retried() const;
+
+  INLINE Filename get_state_filename() const;
+
+private:
+  enum State {
+    S_new,
+    S_header,
+    S_chunks,
+    S_single,
+    S_complete,
+    S_failure,
+  };
+
+  class Chunk {
+  public:
+    size_t _first_byte;
+    size_t _last_byte;
+    int _retries;
+    bool _complete;
+  };
+
+  // One of the channels downloading chunks at the same time.  _chunk is the
+  // index of the chunk it is downloading into _data, or -1 if it is idle.
+  class Slot {
+  public:
+    Ramfile _data;
+    PT(HTTPChannel) _channel;
+    int _chunk;
+  };
+
+  bool run_header();
+  bool run_chunks();
+  bool run_single();
+
+  bool begin_single();
+  void start_chunk(Slot &slot, int ci);
+  bool finish_chunk(Slot &slot);
+  bool check_chunk_hash(int ci, const char *data, size_t length) const;
+  bool check_file_chunk(std::istream &in, int ci) const;
+  void make_chunks();
+
+  bool read_state();
+  bool write_state() const;
+  void delete_state() const;
+  void close_file();
+  void fail();
+
+  PT(HTTPClient) _client;
+  DocumentSpec _url;
+  Filename _filename;
+
+  int _num_channels;
+  size_t _chunk_size;
+  int _max_retries;
+  pvector<HashVal> _chunk_hashes;
+
+  State _state;
+
+  // The document spec as reported by the server's response to the HEAD
+  // request, with its entity tag and modification date.  The chunks are
+  // requested with this spec, so that the server refuses them if the
+  // document changes partway through.
+  DocumentSpec _document;
+  bool _file_size_known;
+  size_t _file_size;
+
+  // This channel makes the HEAD request, and downloads the whole document if
+  // it can't be divided into chunks.
+  PT(HTTPChannel) _channel;
+  pvector<Chunk> _chunks;
+  pdeque<int> _pending;
+  pvector<Slot> _slots;
+  std::iostream *_file;
+
+  int _num_complete;
+  int _num_resumed;
+  int _num_retried;
+  size_t _bytes_complete;
+};
+
+#include "httpParallelDownload.I"
+
+#endif  // HAVE_OPENSSL
+
+#endif
@@ -9,6 +9,7 @@
 #include "httpDigestAuthorization.cxx"
 #include "httpEntityTag.cxx"
 #include "httpEnum.cxx"
+#include "httpParallelDownload.cxx"
 #include "identityStream.cxx"
 #include "identityStreamBuf.cxx"
 #include "multiplexStream.cxx"
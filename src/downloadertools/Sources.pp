@@ -22,6 +22,15 @@
 
 #end bin_target
 
+#begin bin_target
+  #define TARGET parallel_download
+  #define BUILD_TARGET $[HAVE_OPENSSL]
+
+  #define SOURCES \
+    parallel_download.cxx
+
+#end bin_target
+
 #begin bin_target
   #define TARGET show_ddb
   #define BUILD_TARGET $[HAVE_OPENSSL]
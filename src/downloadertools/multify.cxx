@@ -36,6 +36,8 @@ bool kill_cmd = false;         // -k
 bool verbose = false;          // -v
 bool compress_flag = false;    // -z
 int default_compression_level = 6;
+Multifile::CompressionType compression_type = Multifile::CT_zlib; // -M
+bool train_dictionary = false; // -D
 Filename multifile_name;       // -f
 bool got_multifile_name = false;
 bool to_stdout = false;        // -O
@@ -47,6 +49,8 @@ bool got_header_prefix = false;
 Filename chdir_to;             // -C
 bool got_chdir_to = false;
 size_t scale_factor = 0;       // -F
+int num_threads = 0;           // -j
+bool got_num_threads = false;
 pset<string> dont_compress;    // -Z
 pset<string> text_ext;         // -X
 vector_string sign_params;     // -S
@@ -231,6 +235,25 @@ help() {
     "      generate slightly smaller files, but compression takes longer.  The\n"
     "      default is -" << default_compression_level << ".\n\n"
 
+    "  -M <type>\n"
+    "      Specify the compression algorithm to use when -z is in effect: zlib\n"
+    "      (the default), zstd or lz4.  zstd and lz4 decompress much faster than\n"
+    "      zlib, but the resulting multifile can only be read by a version of\n"
+    "      Panda that supports them.  The compression level means 1 .. 19 for\n"
+    "      zstd, and 1 .. 12 for lz4, where levels below 3 select its fastest\n"
+    "      mode.\n\n"
+
+    "  -D\n"
+    "      With -c and -M zstd, train a compression dictionary on the files being\n"
+    "      added and store it in the multifile.  This greatly improves the\n"
+    "      compression of many small, similar files.\n\n"
+
+    "  -j <threads>\n"
+    "      Specify the number of threads to use for compressing and encrypting\n"
+    "      files with -c, -r or -u, and for extracting them with -x.  The default\n"
+    "      is taken from the multifile-num-threads config variable, which\n"
+    "      defaults to one thread per CPU core.\n\n"
+
     "  -S file.crt[,chain.crt[,file.key[,\"password\"]]]\n"
     "      Sign the multifile.  The signing certificate should be in PEM form in\n"
     "      file.crt, with its private key in PEM form in file.key.  If the key\n"
@@ -409,6 +432,11 @@ add_files(const vector_string &params) {
     multifile->set_scale_factor(scale_factor);
   }
 
+  multifile->set_compression_type(compression_type);
+  if (got_num_threads) {
+    multifile->set_num_threads(num_threads);
+  }
+
   pvector<Filename> filenames;
   filenames.reserve(params.size());
   vector_string::const_iterator si;
@@ -425,6 +453,18 @@ add_files(const vector_string &params) {
 
   bool okflag = do_add_files(multifile, filenames);
 
+  if (train_dictionary && create && compress_flag &&
+      compression_type == Multifile::CT_zstd) {
+    if (multifile->train_zstd_dictionary()) {
+      if (verbose) {
+        cout << "Trained " << multifile->get_zstd_dictionary().size()
+             << "-byte compression dictionary.\n";
+      }
+    } else {
+      cerr << "Unable to train a compression dictionary; continuing without.\n";
+    }
+  }
+
   bool needs_repack = multifile->needs_repack();
   if (append) {
     // If we specified -r mode, we always repack.
@@ -484,6 +524,14 @@ extract_files(const vector_string &params) {
     multifile->set_encryption_password(get_password());
   }
 
+  if (params.empty() && !to_stdout && !verbose) {
+    // We're extracting everything, so let the Multifile do it in parallel.
+    if (got_num_threads) {
+      multifile->set_num_threads(num_threads);
+    }
+    return multifile->extract_subfiles(got_chdir_to ? chdir_to : Filename());
+  }
+
   // Now walk back through the list and this time do the extraction.
   for (i = 0; i < num_subfiles; i++) {
     string subfile_name = multifile->get_subfile_name(i);
@@ -808,7 +856,7 @@ main(int argc, char **argv) {
 
   extern char *optarg;
   extern int optind;
-  static const char *optflags = "crutxkvz123456789Z:T:X:S:f:OC:ep:P:F:h";
+  static const char *optflags = "crutxkvz123456789Z:T:X:S:f:OC:ep:P:F:M:Dj:h";
   int flag = getopt(argc, argv, optflags);
   Filename rel_path;
   while (flag != EOF) {
@@ -876,6 +924,30 @@ main(int argc, char **argv) {
     case 'Z':
       dont_compress_str = optarg;
       break;
+    case 'M':
+      if (string(optarg) == "zlib") {
+        compression_type = Multifile::CT_zlib;
+      } else if (string(optarg) == "zstd") {
+        compression_type = Multifile::CT_zstd;
+      } else if (string(optarg) == "lz4") {
+        compression_type = Multifile::CT_lz4;
+      } else {
+        cerr << "Invalid compression type: " << optarg << "\n";
+        usage();
+        return 1;
+      }
+      break;
+    case 'D':
+      train_dictionary = true;
+      break;
+    case 'j':
+      if (!string_to_int(optarg, num_threads) || num_threads < 0) {
+        cerr << "Invalid number of threads: " << optarg << "\n";
+        usage();
+        return 1;
+      }
+      got_num_threads = true;
+      break;
     case 'X':
       text_ext_str = optarg;
       break;
@@ -0,0 +1,206 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file parallel_download.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "httpParallelDownload.h"
+#include "httpClient.h"
+#include "config_downloader.h"
+#include "hashVal.h"
+#include "filename.h"
+#include "trueClock.h"
+#include "panda_getopt.h"
+#include "preprocess_argv.h"
+
+#include <algorithm>
+
+using std::cerr;
+using std::cout;
+using std::string;
+
+void
+usage() {
+  cerr <<
+    "\n"
+    "Usage:\n\n"
+    "parallel_download [-n channels] [-c chunk_size] [-m hash_file] url filename\n"
+    "parallel_download -p [-c chunk_size] filename\n"
+    "parallel_download -h\n\n";
+}
+
+void
+help() {
+  usage();
+  cerr <<
+    "This program downloads a document to a file with HTTPParallelDownload,\n"
+    "which requests different byte ranges of the document on several\n"
+    "connections at once.  If the download is interrupted, running the same\n"
+    "command again downloads only the missing chunks.\n\n"
+
+    "  -n channels\n"
+    "     The number of connections to use at once.  The default is taken\n"
+    "     from http-parallel-channels.\n\n"
+
+    "  -c chunk_size\n"
+    "     The number of bytes to request at a time on each connection.  The\n"
+    "     default is taken from http-parallel-chunk-size.\n\n"
+
+    "  -m hash_file\n"
+    "     Checks each chunk against the MD5 hashes in the indicated file,\n"
+    "     one per line in hexadecimal, as written by -p.\n\n"
+
+    "  -p\n"
+    "     Instead of downloading anything, writes the MD5 hash of each chunk\n"
+    "     of the indicated local file to standard output, for use with -m.\n\n"
+
+    "To try this against the fake_http_server test program in net, run\n"
+    "fake_http_server 8080 dir 7, which serves the files in dir and cuts off\n"
+    "every seventh response, then download http://localhost:8080/file.\n\n";
+}
+
+/**
+ * Writes the hash of each chunk_size piece of the file to standard output.
+ */
+bool
+print_chunk_hashes(const Filename &filename, size_t chunk_size) {
+  pifstream in;
+  if (!filename.open_read(in)) {
+    cerr << "Unable to read " << filename << "\n";
+    return false;
+  }
+
+  string buffer(chunk_size, '\0');
+  in.read(&buffer[0], chunk_size);
+  size_t count = in.gcount();
+  while (count != 0) {
+    HashVal hash;
+    hash.hash_buffer(buffer.data(), count);
+    hash.output_hex(cout);
+    cout << "\n";
+    in.read(&buffer[0], chunk_size);
+    count = in.gcount();
+  }
+  return true;
+}
+
+int
+main(int argc, char **argv) {
+  extern char *optarg;
+  extern int optind;
+  const char *optstr = "n:c:m:ph";
+
+  int num_channels = 0;
+  size_t chunk_size = 0;
+  Filename hash_filename;
+  bool print_hashes = false;
+
+  preprocess_argv(argc, argv);
+  int flag = getopt(argc, argv, optstr);
+
+  while (flag != EOF) {
+    switch (flag) {
+    case 'n':
+      num_channels = atoi(optarg);
+      break;
+
+    case 'c':
+      chunk_size = (size_t)atoll(optarg);
+      break;
+
+    case 'm':
+      hash_filename = Filename::text_filename(string(optarg));
+      break;
+
+    case 'p':
+      print_hashes = true;
+      break;
+
+    case 'h':
+      help();
+      exit(1);
+
+    default:
+      exit(1);
+    }
+    flag = getopt(argc, argv, optstr);
+  }
+
+  argc -= (optind-1);
+  argv += (optind-1);
+
+  if (print_hashes) {
+    if (argc != 2) {
+      usage();
+      exit(1);
+    }
+    Filename filename = Filename::binary_filename(Filename::from_os_specific(argv[1]));
+    if (chunk_size == 0) {
+      chunk_size = (size_t)std::max((int)http_parallel_chunk_size, 1);
+    }
+    return print_chunk_hashes(filename, chunk_size) ? 0 : 1;
+  }
+
+  if (argc != 3) {
+    usage();
+    exit(1);
+  }
+
+  DocumentSpec url = DocumentSpec(string(argv[1]));
+  Filename filename = Filename::from_os_specific(argv[2]);
+
+  PT(HTTPParallelDownload) download =
+    new HTTPParallelDownload(HTTPClient::get_global_ptr(), url, filename);
+  if (num_channels > 0) {
+    download->set_num_channels(num_channels);
+  }
+  if (chunk_size > 0) {
+    download->set_chunk_size(chunk_size);
+  }
+
+  if (!hash_filename.empty()) {
+    pifstream in;
+    if (!hash_filename.open_read(in)) {
+      cerr << "Unable to read " << hash_filename << "\n";
+      exit(1);
+    }
+    string line;
+    while (std::getline(in, line)) {
+      HashVal hash;
+      if (!hash.set_from_hex(line)) {
+        cerr << "Invalid hash in " << hash_filename << ": " << line << "\n";
+        exit(1);
+      }
+      download->add_chunk_hash(hash);
+    }
+  }
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+  bool okflag = download->download();
+  double elapsed = clock->get_short_time() - start;
+
+  cerr << "Downloaded " << download->get_bytes_downloaded() << " bytes in "
+       << elapsed << " seconds";
+  if (download->get_num_chunks() != 0) {
+    cerr << " over " << download->get_num_channels() << " channels: "
+         << download->get_num_chunks_complete() << " of "
+         << download->get_num_chunks() << " chunks complete, "
+         << download->get_num_chunks_resumed() << " resumed, "
+         << download->get_num_chunks_retried() << " retried";
+  }
+  cerr << ".\n";
+
+  if (!okflag) {
+    cerr << "Download of " << url.get_url() << " failed.\n";
+    return 1;
+  }
+  return 0;
+}
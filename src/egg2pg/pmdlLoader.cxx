@@ -46,6 +46,8 @@
 #include "transformTable.h"
 #include "jointVertexTransform.h"
 #include "config_putil.h"
+#include "bamFile.h"
+#include "bamReader.h"
 
 #ifdef HAVE_PHYSX
 #include "physConvexMeshData.h"
@@ -1683,6 +1685,57 @@ find_or_load_anim(const std::string &anim_name) {
   }
 }
 
+/**
+ * If the indicated animation bam file has a table of contents, reads just
+ * the first channel of its AnimChannelBundle, which is the one load_anim()
+ * would pick from the full model, and nothing else.  Returns NULL if the file
+ * has no table of contents or the channel can't be found that way.
+ */
+PT(AnimChannelTable) PMDLLoader::
+read_toc_anim(const Filename &fullpath) {
+  BamFile bam;
+  if (!bam.open_read(fullpath, false)) {
+    return nullptr;
+  }
+
+  BamReader *reader = bam.get_reader();
+  if (!reader->read_toc()) {
+    return nullptr;
+  }
+
+  int bundle = reader->find_toc_entry(AnimChannelBundle::get_class_type());
+  if (bundle < 0) {
+    return nullptr;
+  }
+
+  // The bundle's channels are the only tables it refers to, in order.
+  int table = -1;
+  int num_deps = reader->get_num_toc_dependencies(bundle);
+  for (int i = 0; i < num_deps && table < 0; ++i) {
+    int dep = reader->get_toc_dependency(bundle, i);
+    if (reader->get_toc_type(dep).is_derived_from(AnimChannelTable::get_class_type())) {
+      table = dep;
+    }
+  }
+  if (table < 0) {
+    return nullptr;
+  }
+
+  TypedWritable *object;
+  ReferenceCount *ref_ptr;
+  if (!reader->read_toc_object(table, object, ref_ptr) || !reader->resolve()) {
+    egg2pg_cat.warning()
+      << "Unable to read animation table from " << fullpath << "\n";
+    return nullptr;
+  }
+
+  if (egg2pg_cat.is_debug()) {
+    egg2pg_cat.debug()
+      << "Read animation table directly from " << fullpath << "\n";
+  }
+  return DCAST(AnimChannelTable, object);
+}
+
 /**
  *
  */
@@ -1698,26 +1751,33 @@ load_anim(const std::string &anim_name, const Filename &filename) {
     return nullptr;
   }
 
-  PT(PandaNode) anim_model = loader->load_sync(fullpath);
-  if (anim_model == nullptr) {
-    egg2pg_cat.error()
-      << "Failed to load animation model " << fullpath << "\n";
-    return nullptr;
-  }
-  NodePath anim_np(anim_model);
-  NodePath anim_bundle_np = anim_np.find("**/+AnimChannelBundle");
-  if (anim_bundle_np.is_empty()) {
-    egg2pg_cat.error()
-      << "Model " << fullpath << " is not an animation!\n";
-    return nullptr;
+  PT(AnimChannelTable) anim_bundle;
+  if (fullpath.get_extension() == "bam") {
+    anim_bundle = read_toc_anim(fullpath);
   }
-  AnimChannelBundle *anim_bundle_node = DCAST(AnimChannelBundle, anim_bundle_np.node());
-  if (anim_bundle_node->get_num_channels() == 0) {
-    egg2pg_cat.error()
-      << "Animation model " << fullpath << " contains no channels\n";
-    return nullptr;
+
+  if (anim_bundle == nullptr) {
+    PT(PandaNode) anim_model = loader->load_sync(fullpath);
+    if (anim_model == nullptr) {
+      egg2pg_cat.error()
+        << "Failed to load animation model " << fullpath << "\n";
+      return nullptr;
+    }
+    NodePath anim_np(anim_model);
+    NodePath anim_bundle_np = anim_np.find("**/+AnimChannelBundle");
+    if (anim_bundle_np.is_empty()) {
+      egg2pg_cat.error()
+        << "Model " << fullpath << " is not an animation!\n";
+      return nullptr;
+    }
+    AnimChannelBundle *anim_bundle_node = DCAST(AnimChannelBundle, anim_bundle_np.node());
+    if (anim_bundle_node->get_num_channels() == 0) {
+      egg2pg_cat.error()
+        << "Animation model " << fullpath << " contains no channels\n";
+      return nullptr;
+    }
+    anim_bundle = DCAST(AnimChannelTable, anim_bundle_node->get_channel(0));
   }
-  AnimChannelTable *anim_bundle = DCAST(AnimChannelTable, anim_bundle_node->get_channel(0));
   anim_bundle->set_frame_rate(30);
   anim_bundle->set_name(anim_name);
   if (!_part_bundle->bind_anim(anim_bundle)) {
@@ -425,6 +425,7 @@ public:
 
   AnimChannel *find_or_load_anim(const std::string &anim_name);
   AnimChannelTable *load_anim(const std::string &name, const Filename &filename);
+  static PT(AnimChannelTable) read_toc_anim(const Filename &fullpath);
 
   void calc_ik_touch_offsets(AnimChannel *chan, AnimChannel::IKEvent &ik_event, const std::string &source_anim);
 
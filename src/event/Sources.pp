@@ -7,6 +7,7 @@
   #define BUILDING_DLL BUILDING_PANDA_EVENT
 
   #define SOURCES \
+    asyncFileReader.h asyncFileReader.I \
     asyncFuture.h asyncFuture.I \
     asyncTask.h asyncTask.I \
     asyncTaskChain.h asyncTaskChain.I \
@@ -21,11 +22,14 @@
     pointerEvent.I pointerEvent.h \
     pointerEventList.I pointerEventList.h \
     event.I event.h eventHandler.h eventHandler.I \
+    eventName.I eventName.h \
     eventParameter.I eventParameter.h \
     eventQueue.I eventQueue.h eventReceiver.h \
+    fileReadRequest.h fileReadRequest.I \
     pt_Event.h throw_event.I throw_event.h
 
   #define COMPOSITE_SOURCES \
+    asyncFileReader.cxx \
     asyncFuture.cxx \
     asyncTask.cxx \
     asyncTaskChain.cxx \
@@ -38,11 +42,13 @@
     genericAsyncTask.cxx \
     pointerEvent.cxx \
     pointerEventList.cxx \
-    config_event.cxx event.cxx eventHandler.cxx \
+    config_event.cxx event.cxx eventHandler.cxx eventName.cxx \
     eventParameter.cxx eventQueue.cxx eventReceiver.cxx \
+    fileReadRequest.cxx \
     pt_Event.cxx
 
   #define INSTALL_HEADERS \
+    asyncFileReader.h asyncFileReader.I \
     asyncFuture.h asyncFuture.I \
     asyncTask.h asyncTask.I \
     asyncTaskChain.h asyncTaskChain.I \
@@ -56,8 +62,10 @@
     pointerEvent.I pointerEvent.h \
     pointerEventList.I pointerEventList.h \
     event.I event.h eventHandler.h eventHandler.I \
+    eventName.I eventName.h \
     eventParameter.I eventParameter.h \
     eventQueue.I eventQueue.h eventReceiver.h \
+    fileReadRequest.h fileReadRequest.I \
     pt_Event.h throw_event.I throw_event.h
 
   #define IGATESCAN all
@@ -82,3 +90,27 @@
     test_task.cxx
 
 #end test_bin_target
+
+#begin test_bin_target
+  #define TARGET test_events
+  #define LOCAL_LIBS $[LOCAL_LIBS] pipeline
+  #define OTHER_LIBS \
+   dtoolbase:c prc \
+   dtoolutil:c dtool:m
+
+  #define SOURCES \
+    test_events.cxx
+
+#end test_bin_target
+
+#begin test_bin_target
+  #define TARGET test_file_reader
+  #define LOCAL_LIBS $[LOCAL_LIBS] pipeline
+  #define OTHER_LIBS \
+   dtoolbase:c prc \
+   dtoolutil:c dtool:m
+
+  #define SOURCES \
+    test_file_reader.cxx
+
+#end test_bin_target
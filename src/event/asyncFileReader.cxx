@@ -0,0 +1,230 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file asyncFileReader.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "asyncFileReader.h"
+#include "config_event.h"
+#include "virtualFileSystem.h"
+#include "virtualFileSimple.h"
+#include "virtualFileMountMultifile.h"
+#include "configVariableInt.h"
+#include <algorithm>
+#include <sstream>
+
+using std::string;
+
+static ConfigVariableInt async_file_reader_threads
+("async-file-reader-threads", 2,
+ PRC_DESC("The number of I/O threads used by the global AsyncFileReader to "
+          "read files in the background.  Reads are mostly limited by the "
+          "disk, so a small number is usually enough."));
+
+static ConfigVariableInt async_file_reader_batch_size
+("async-file-reader-batch-size", 32,
+ PRC_DESC("The maximum number of queued files within the same multifile "
+          "that one AsyncFileReader thread will pick up at once, in order "
+          "to read them in the order they are stored."));
+
+AsyncFileReader *AsyncFileReader::_global_ptr = nullptr;
+
+/**
+ * Creates a reader with the indicated number of I/O threads.  The threads are
+ * started when the first read is submitted.
+ */
+AsyncFileReader::
+AsyncFileReader(int num_threads) :
+  _num_threads(std::max(num_threads, 1)),
+  _lock("AsyncFileReader::_lock"),
+  _cvar(_lock)
+{
+}
+
+/**
+ *
+ */
+AsyncFileReader::
+~AsyncFileReader() {
+  stop_threads();
+}
+
+/**
+ * Queues up the indicated file to be read in the background, and returns a
+ * future that is finished once its contents are available.  If auto_unwrap
+ * is true, a compressed file (e.g. a .pz file) is transparently decompressed.
+ */
+PT(FileReadRequest) AsyncFileReader::
+read_file(const Filename &filename, bool auto_unwrap) {
+  PT(FileReadRequest) request = new FileReadRequest(filename, auto_unwrap);
+
+  // Look up the file now, in the calling thread, so that we know where it
+  // lives before any of the I/O threads see it.
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  request->_file = vfs->get_file(filename);
+  if (request->_file == nullptr) {
+    request->read();
+    return request;
+  }
+
+  if (request->_file->is_of_type(VirtualFileSimple::get_class_type())) {
+    VirtualFileSimple *simple = (VirtualFileSimple *)request->_file.p();
+    VirtualFileMount *mount = simple->get_mount();
+    if (mount->is_of_type(VirtualFileMountMultifile::get_class_type())) {
+      Multifile *multifile = ((VirtualFileMountMultifile *)mount)->get_multifile();
+      int index = multifile->find_subfile(simple->get_local_filename());
+      if (index >= 0) {
+        request->_multifile = multifile;
+        request->_offset = multifile->get_subfile_internal_start(index);
+      }
+    }
+  }
+
+  if (!Thread::is_threading_supported()) {
+    // Without threads, we can only read it right away.
+    request->read();
+    return request;
+  }
+
+  MutexHolder holder(_lock);
+  if (_threads.empty()) {
+    start_threads();
+  }
+  _pending.push_back(request);
+  _cvar.notify();
+  return request;
+}
+
+/**
+ * Stops the I/O threads, after they have finished the reads they are working
+ * on.  Any reads still waiting in the queue are cancelled.  The threads will
+ * be restarted if another read is submitted.
+ */
+void AsyncFileReader::
+stop_threads() {
+  Threads threads;
+  Pending pending;
+  {
+    MutexHolder holder(_lock);
+    threads.swap(_threads);
+    pending.swap(_pending);
+
+    // Only the threads we are stopping are told to stop, so that a read
+    // submitted while we are waiting for them starts a new set of threads
+    // that keeps running.
+    for (ReaderThread *thread : threads) {
+      thread->_stopped = true;
+    }
+    _cvar.notify_all();
+  }
+
+  for (ReaderThread *thread : threads) {
+    thread->join();
+  }
+  for (FileReadRequest *request : pending) {
+    request->cancel();
+  }
+}
+
+/**
+ * Returns the global AsyncFileReader, which has as many threads as specified
+ * by the config variable async-file-reader-threads.
+ */
+AsyncFileReader *AsyncFileReader::
+get_global_ptr() {
+  if (_global_ptr == nullptr) {
+    _global_ptr = new AsyncFileReader(async_file_reader_threads);
+    _global_ptr->ref();
+  }
+  return _global_ptr;
+}
+
+/**
+ * Starts the I/O threads.  Assumes the lock is held.
+ */
+void AsyncFileReader::
+start_threads() {
+  _threads.reserve(_num_threads);
+  for (int i = 0; i < _num_threads; ++i) {
+    std::ostringstream strm;
+    strm << "AsyncFileReader_" << i;
+    PT(ReaderThread) thread = new ReaderThread(strm.str(), this);
+    if (thread->start(TP_low, true)) {
+      _threads.push_back(thread);
+    }
+  }
+}
+
+/**
+ * Waits for at least one read to be queued, then removes it from the queue
+ * along with any other queued reads from the same Multifile, sorted in the
+ * order they are stored in it.  Returns false if the indicated thread is
+ * being stopped instead.
+ */
+bool AsyncFileReader::
+take_batch(ReaderThread *thread, Batch &batch) {
+  MutexHolder holder(_lock);
+  while (_pending.empty() && !thread->_stopped) {
+    _cvar.wait();
+  }
+  if (thread->_stopped) {
+    return false;
+  }
+
+  PT(FileReadRequest) first = _pending.front();
+  _pending.pop_front();
+  batch.push_back(first);
+
+  if (first->_multifile != nullptr) {
+    size_t max_size = (size_t)std::max((int)async_file_reader_batch_size, 1);
+    Pending::iterator pi = _pending.begin();
+    while (pi != _pending.end() && batch.size() < max_size) {
+      if ((*pi)->_multifile == first->_multifile) {
+        batch.push_back(*pi);
+        pi = _pending.erase(pi);
+      } else {
+        ++pi;
+      }
+    }
+
+    if (batch.size() > 1) {
+      std::sort(batch.begin(), batch.end(),
+                [] (const FileReadRequest *a, const FileReadRequest *b) {
+        return a->_offset < b->_offset;
+      });
+    }
+  }
+  return true;
+}
+
+/**
+ *
+ */
+AsyncFileReader::ReaderThread::
+ReaderThread(const string &name, AsyncFileReader *reader) :
+  Thread(name, "AsyncFileReader"),
+  _reader(reader),
+  _stopped(false)
+{
+}
+
+/**
+ *
+ */
+void AsyncFileReader::ReaderThread::
+thread_main() {
+  Batch batch;
+  while (_reader->take_batch(this, batch)) {
+    for (FileReadRequest *request : batch) {
+      request->read();
+    }
+    batch.clear();
+  }
+}
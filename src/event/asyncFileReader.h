@@ -0,0 +1,88 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file asyncFileReader.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef ASYNCFILEREADER_H
+#define ASYNCFILEREADER_H
+
+#include "pandabase.h"
+#include "fileReadRequest.h"
+#include "referenceCount.h"
+#include "thread.h"
+#include "pmutex.h"
+#include "mutexHolder.h"
+#include "conditionVar.h"
+#include "pvector.h"
+#include "pdeque.h"
+
+/**
+ * Reads files from the VirtualFileSystem on a small pool of I/O threads.
+ * Any number of reads may be submitted at once with read_file(); each one
+ * returns a FileReadRequest, which is an AsyncFuture that is finished when
+ * the file's contents are available.  This lets a caller such as the Loader
+ * keep the disk busy while it works on files that were read earlier.
+ *
+ * When several queued files live in the same Multifile, one thread picks
+ * them up together and reads them in the order they are stored, rather than
+ * seeking back and forth between them.
+ */
+class EXPCL_PANDA_EVENT AsyncFileReader : public ReferenceCount {
+PUBLISHED:
+  explicit AsyncFileReader(int num_threads);
+  ~AsyncFileReader();
+
+  PT(FileReadRequest) read_file(const Filename &filename,
+                                bool auto_unwrap = true);
+
+  INLINE int get_num_threads() const;
+  INLINE size_t get_num_pending() const;
+  void stop_threads();
+
+  static AsyncFileReader *get_global_ptr();
+
+private:
+  typedef pvector<PT(FileReadRequest)> Batch;
+  class ReaderThread;
+
+  void start_threads();
+  bool take_batch(ReaderThread *thread, Batch &batch);
+
+  class ReaderThread : public Thread {
+  public:
+    ReaderThread(const std::string &name, AsyncFileReader *reader);
+    virtual void thread_main();
+
+    AsyncFileReader *_reader;
+
+    // Set by stop_threads(), protected by the reader's lock.
+    bool _stopped;
+  };
+
+  int _num_threads;
+
+  mutable Mutex _lock;
+  ConditionVar _cvar;
+
+  typedef pdeque<PT(FileReadRequest)> Pending;
+  Pending _pending;
+
+  typedef pvector<PT(ReaderThread)> Threads;
+  Threads _threads;
+
+  static AsyncFileReader *_global_ptr;
+
+  friend class ReaderThread;
+};
+
+#include "asyncFileReader.I"
+
+#endif
@@ -20,6 +20,7 @@
 #include "pStatTimer.h"
 #include "clockObject.h"
 #include "config_event.h"
+#include "configVariableBool.h"
 #include <algorithm>
 #include <stdio.h>  // For sprintf/snprintf
 
@@ -33,6 +34,14 @@ TypeHandle AsyncTaskChain::_type_handle;
 PStatCollector AsyncTaskChain::_task_pcollector("Task");
 PStatCollector AsyncTaskChain::_wait_pcollector("Wait");
 
+AsyncTaskChain::JobFunc *AsyncTaskChain::_job_func = nullptr;
+
+static ConfigVariableBool task_chain_use_job_system
+("task-chain-use-job-system", false,
+ PRC_DESC("Set this true to make threaded task chains run their tasks on the "
+          "worker threads of the job system by default, rather than starting "
+          "threads of their own.  See AsyncTaskChain::set_use_job_system()."));
+
 /**
  *
  */
@@ -46,6 +55,9 @@ AsyncTaskChain(AsyncTaskManager *manager, const string &name, int num_threads,
   _timeslice_priority(false),
   _num_threads(num_threads),
   _thread_priority(thread_priority),
+  _use_job_system(task_chain_use_job_system),
+  _job_mode(false),
+  _num_service_jobs(0),
   _frame_budget(-1.0),
   _frame_sync(false),
   _num_busy_threads(0),
@@ -175,6 +187,47 @@ get_thread_priority() const {
   return _thread_priority;
 }
 
+/**
+ * Sets the use_job_system flag.  When this is true, a threaded task chain
+ * does not start threads of its own, but instead runs its tasks on the worker
+ * threads of the job system, which are shared with the rest of the
+ * application.  The number of threads set on the chain is then the most
+ * workers that may be servicing its tasks at any one time.  The sort and
+ * priority of the tasks are honored just as they are with the chain's own
+ * threads.
+ *
+ * Each task is run as a separate job, so the tasks on such a chain should not
+ * block for long periods; any thread that waits on the job system may end up
+ * running one of them.  Since there is no thread of the chain's own waiting
+ * around, sleeping tasks and frame-synced tasks are picked up again by
+ * AsyncTaskManager::poll(), which must be called once per frame.
+ *
+ * If the job system has not been initialized, or has no worker threads, the
+ * chain starts its own threads anyway.  This may require stopping the threads
+ * if they are already running.
+ */
+void AsyncTaskChain::
+set_use_job_system(bool use_job_system) {
+  MutexHolder holder(_manager->_lock);
+  if (_use_job_system != use_job_system) {
+    do_stop_threads();
+    _use_job_system = use_job_system;
+
+    if (_num_tasks != 0) {
+      do_start_threads();
+    }
+  }
+}
+
+/**
+ * Returns the use_job_system flag.  See set_use_job_system().
+ */
+bool AsyncTaskChain::
+get_use_job_system() const {
+  MutexHolder holder(_manager->_lock);
+  return _use_job_system;
+}
+
 /**
  * Sets the maximum amount of time per frame the tasks on this chain are
  * granted for execution.  If this is less than zero, there is no limit; if it
@@ -486,6 +539,7 @@ do_add(AsyncTask *task) {
   _needs_cleanup = true;
 
   _cvar.notify_all();
+  do_schedule_service_jobs();
 }
 
 /**
@@ -554,7 +608,7 @@ void AsyncTaskChain::
 do_wait_for_tasks() {
   do_start_threads();
 
-  if (_threads.empty()) {
+  if (_threads.empty() && !_job_mode) {
     // Non-threaded case.
     while (_num_tasks > 0) {
       if (_state == S_shutdown || _state == S_interrupted) {
@@ -572,6 +626,17 @@ do_wait_for_tasks() {
       }
 
       PStatTimer timer(_wait_pcollector);
+      if (_job_mode) {
+        // There are no threads of our own to wake up the sleeping tasks, so
+        // we have to check back when the next one is due.
+        do_schedule_service_jobs();
+        if (!_sleeping.empty()) {
+          double wake_time = do_get_next_wake_time();
+          double now = _manager->_clock->get_frame_time();
+          _cvar.wait(max(wake_time - now, 0.0));
+          continue;
+        }
+      }
       _cvar.wait();
     }
   }
@@ -687,6 +752,8 @@ service_one_task(AsyncTaskChain::AsyncTaskChainThread *thread) {
 
     if (thread != nullptr) {
       thread->_servicing = task;
+    } else if (_job_mode) {
+      _job_servicing.push_back(task);
     }
 
     if (task_cat.is_spam()) {
@@ -704,6 +771,11 @@ service_one_task(AsyncTaskChain::AsyncTaskChainThread *thread) {
 
     if (thread != nullptr) {
       thread->_servicing = nullptr;
+    } else if (!_job_servicing.empty()) {
+      TaskHeap::iterator si = std::find(_job_servicing.begin(), _job_servicing.end(), task);
+      if (si != _job_servicing.end()) {
+        _job_servicing.erase(si);
+      }
     }
     task->_servicing_thread = nullptr;
 
@@ -1060,6 +1132,20 @@ do_stop_threads() {
     _cvar.notify_all();
     _manager->_frame_cvar.notify_all();
 
+    // Any jobs that are still queued or running will notice the shutdown
+    // and return as soon as they get the lock.  If we are being called from
+    // a task of this chain, our own job can't return until we do, so don't
+    // wait for it.
+    Thread *current_thread = Thread::get_current_thread();
+    int num_own_jobs = (int)std::count(_service_job_threads.begin(),
+                                       _service_job_threads.end(),
+                                       current_thread);
+    while (_num_service_jobs > num_own_jobs) {
+      PStatTimer timer(_wait_pcollector);
+      _cvar.wait();
+    }
+    _job_mode = false;
+
 #ifdef HAVE_THREADS
     Threads wait_threads;
     wait_threads.swap(_threads);
@@ -1106,7 +1192,18 @@ do_start_threads() {
     _state = S_started;
 
 #ifdef HAVE_THREADS
-    if (Thread::is_threading_supported() && _num_threads > 0) {
+    if (Thread::is_threading_supported() && _num_threads > 0 &&
+        _use_job_system && _job_func != nullptr) {
+      if (task_cat.is_debug()) {
+        task_cat.debug()
+          << "Using up to " << _num_threads << " job system workers for "
+          << _manager->get_name() << " chain " << get_name() << "\n";
+      }
+      _needs_cleanup = true;
+      _job_mode = true;
+      do_schedule_service_jobs();
+
+    } else if (Thread::is_threading_supported() && _num_threads > 0) {
       if (task_cat.is_debug()) {
         task_cat.debug()
           << "Starting " << _num_threads << " threads for "
@@ -1145,6 +1242,10 @@ do_get_active_tasks() const {
   }
 #endif
   TaskHeap::const_iterator ti;
+  for (ti = _job_servicing.begin(); ti != _job_servicing.end(); ++ti) {
+    AsyncTask *task = (*ti);
+    result.add_task(task);
+  }
   for (ti = _active.begin(); ti != _active.end(); ++ti) {
     AsyncTask *task = (*ti);
     result.add_task(task);
@@ -1197,6 +1298,15 @@ do_poll() {
   }
 #endif
 
+  if (_job_mode) {
+    // The tasks are serviced by the job system.  We only have to make sure
+    // that jobs get scheduled for anything that has become runnable since,
+    // such as a sleeping task that is due, or the tasks that were waiting
+    // for a new frame.
+    do_schedule_service_jobs();
+    return;
+  }
+
   if (_num_busy_threads != 0) {
     // We are recursively nested within another task.  Return, with a warning.
     task_cat.warning()
@@ -1246,6 +1356,123 @@ do_poll() {
   } while (_pickup_mode);
 }
 
+/**
+ * Schedules as many jobs as are useful to service the runnable tasks on a
+ * chain that runs on the job system, up to the number of threads allowed for
+ * the chain.  Assumes the lock is held.
+ */
+void AsyncTaskChain::
+do_schedule_service_jobs() {
+  if (!_job_mode || _state != S_started) {
+    return;
+  }
+
+  if (_num_busy_threads != 0 &&
+      (_active.empty() || _active.front()->get_sort() != _current_sort)) {
+    // Nothing can run until the tasks that are running now have finished,
+    // and the job that finishes last will come back here.
+    return;
+  }
+
+  int wanted;
+  if (!_active.empty()) {
+    wanted = (int)_active.size();
+
+  } else if (!_this_active.empty() || !_next_active.empty() ||
+             (!_sleeping.empty() &&
+              _sleeping.front()->_wake_time <= _manager->_clock->get_frame_time())) {
+    // One job to start the next epoch.
+    wanted = 1;
+
+  } else {
+    return;
+  }
+
+  if (is_frame_blocked()) {
+    // We'll try again on the next frame's poll().
+    return;
+  }
+
+  wanted = std::min(wanted, _num_threads) - _num_service_jobs;
+  for (int i = 0; i < wanted; ++i) {
+    if (!(*_job_func)(&service_job_main, this)) {
+      break;
+    }
+    ++_num_service_jobs;
+  }
+}
+
+/**
+ * The body of a job that services a chain running on the job system.  Runs
+ * one task, moving on to the next sort group or epoch first if need be, and
+ * then schedules whatever jobs are needed to continue.  Assumes the lock is
+ * held.
+ */
+void AsyncTaskChain::
+do_service_job() {
+  Thread *current_thread = Thread::get_current_thread();
+  _service_job_threads.push_back(current_thread);
+
+  while (_state == S_started) {
+    if (!_active.empty() && _active.front()->get_sort() == _current_sort) {
+      if (is_frame_blocked()) {
+        // We're out of time for this frame.  The next frame's poll() will
+        // schedule us again.
+        cleanup_pickup_mode();
+        break;
+      }
+
+      PStatTimer timer(_task_pcollector);
+      _num_busy_threads++;
+      service_one_task(nullptr);
+      _num_busy_threads--;
+      break;
+    }
+
+    // We've finished all the available tasks of the current sort value.  The
+    // last job to finish moves on to the next one.
+    if (_num_busy_threads != 0 || !finish_sort_group()) {
+      break;
+    }
+  }
+
+  _service_job_threads.erase(std::find(_service_job_threads.begin(),
+                                       _service_job_threads.end(),
+                                       current_thread));
+  --_num_service_jobs;
+  do_schedule_service_jobs();
+  _cvar.notify_all();
+}
+
+/**
+ * The function that the job system calls to run a job scheduled by
+ * do_schedule_service_jobs().
+ */
+void AsyncTaskChain::
+service_job_main(void *data) {
+  AsyncTaskChain *chain = (AsyncTaskChain *)data;
+  MutexHolder holder(chain->_manager->_lock);
+  chain->do_service_job();
+}
+
+/**
+ * Returns true if the chain has used up its time for the current frame, and
+ * should not service any more tasks until the clock ticks.  Resets the
+ * per-frame accounting first if the clock has ticked since the last call.
+ * Assumes the lock is held.
+ */
+bool AsyncTaskChain::
+is_frame_blocked() {
+  int frame = _manager->_clock->get_frame_count();
+  if (_current_frame != frame) {
+    _current_frame = frame;
+    _time_in_frame = 0.0;
+    _block_till_next_frame = false;
+  }
+  return _block_till_next_frame ||
+    (_frame_budget >= 0.0 && _time_in_frame >= _frame_budget);
+}
+
 /**
  * Clean up the damage from setting pickup mode.  This means we restore the
  * _active and _next_active lists as they should have been without pickup
@@ -1291,7 +1518,10 @@ do_write(ostream &out, int indent_level) const {
   indent(out, indent_level)
     << "Task chain \"" << get_name() << "\"\n";
 #ifdef HAVE_THREADS
-  if (_num_threads > 0) {
+  if (_job_mode) {
+    indent(out, indent_level + 2)
+      << "up to " << _num_threads << " job system workers\n";
+  } else if (_num_threads > 0) {
     indent(out, indent_level + 2)
       << _num_threads << " threads, priority " << _thread_priority << "\n";
   }
@@ -1341,6 +1571,7 @@ do_write(ostream &out, int indent_level) const {
     }
   }
 #endif
+  tasks.insert(tasks.end(), _job_servicing.begin(), _job_servicing.end());
 
   double now = _manager->_clock->get_frame_time();
 
@@ -46,6 +46,11 @@ class AsyncTaskManager;
  * parallelism.  Tasks with different sort values are never run in parallel
  * together, but tasks with different priority values might be (if there is
  * more than one thread).
+ *
+ * Instead of spawning its own threads, a chain may be told to run its tasks on
+ * the worker threads of the job system, with set_use_job_system().  In this
+ * case, the number of threads is the most workers that will service the chain
+ * at once.
  */
 class EXPCL_PANDA_EVENT AsyncTaskChain : public TypedReferenceCount, public Namable {
 public:
@@ -64,6 +69,9 @@ PUBLISHED:
   BLOCKING void set_thread_priority(ThreadPriority priority);
   ThreadPriority get_thread_priority() const;
 
+  BLOCKING void set_use_job_system(bool use_job_system);
+  bool get_use_job_system() const;
+
   void set_frame_budget(double frame_budget);
   double get_frame_budget() const;
 
@@ -98,6 +106,10 @@ PUBLISHED:
   virtual void output(std::ostream &out) const;
   virtual void write(std::ostream &out, int indent_level = 0) const;
 
+public:
+  typedef bool JobFunc(void (*func)(void *), void *data);
+  INLINE static void set_job_func(JobFunc *func);
+
 protected:
   class AsyncTaskChainThread;
   typedef pvector< PT(AsyncTask) > TaskHeap;
@@ -119,6 +131,10 @@ protected:
   AsyncTaskCollection do_get_active_tasks() const;
   AsyncTaskCollection do_get_sleeping_tasks() const;
   void do_poll();
+  void do_schedule_service_jobs();
+  void do_service_job();
+  static void service_job_main(void *data);
+  bool is_frame_blocked();
   void cleanup_pickup_mode();
   INLINE double do_get_next_wake_time() const;
   static INLINE double get_wake_time(AsyncTask *task);
@@ -180,6 +196,13 @@ protected:
   int _num_threads;
   ThreadPriority _thread_priority;
   Threads _threads;
+  bool _use_job_system;
+  bool _job_mode;
+  int _num_service_jobs;
+  // The threads that are running a service job of this chain right now, so
+  // that a task can tell whether it is running on one of them.
+  pvector<Thread *> _service_job_threads;
+  TaskHeap _job_servicing;
   double _frame_budget;
   bool _frame_sync;
   int _num_busy_threads;
@@ -203,6 +226,8 @@ protected:
   static PStatCollector _task_pcollector;
   static PStatCollector _wait_pcollector;
 
+  static JobFunc *_job_func;
+
 public:
   static TypeHandle get_class_type() {
     return _type_handle;
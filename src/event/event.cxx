@@ -26,6 +26,18 @@ Event(const std::string &event_name, EventReceiver *receiver) :
   _receiver = receiver;
 }
 
+/**
+ * Constructs an Event from a name that has already been interned, which
+ * allows the EventHandler to dispatch it without looking up its name.
+ */
+Event::
+Event(const EventName *event_name, EventReceiver *receiver) :
+  _name(event_name->get_name()),
+  _event_name(event_name)
+{
+  _receiver = receiver;
+}
+
 /**
  *
  */
@@ -33,7 +45,8 @@ Event::
 Event(const Event &copy) :
   _parameters(copy._parameters),
   _receiver(copy._receiver),
-  _name(copy._name)
+  _name(copy._name),
+  _event_name(copy._event_name)
 {
 }
 
@@ -45,6 +58,7 @@ operator = (const Event &copy) {
   _parameters = copy._parameters;
   _receiver = copy._receiver;
   _name = copy._name;
+  _event_name = copy._event_name;
 }
 
 /**
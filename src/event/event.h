@@ -17,6 +17,7 @@
 
 #include "pandabase.h"
 #include "eventParameter.h"
+#include "eventName.h"
 #include "typedReferenceCount.h"
 #include "small_vector.h"
 
@@ -34,6 +35,7 @@ class EventReceiver;
 class EXPCL_PANDA_EVENT Event : public TypedReferenceCount {
 PUBLISHED:
   Event(const std::string &event_name, EventReceiver *receiver = nullptr);
+  explicit Event(const EventName *event_name, EventReceiver *receiver = nullptr);
   Event(const Event &copy);
   void operator = (const Event &copy);
   ~Event();
@@ -42,6 +44,7 @@ PUBLISHED:
   INLINE void clear_name();
   INLINE bool has_name() const;
   INLINE const std::string &get_name() const;
+  INLINE const EventName *get_event_name() const;
 
   void add_parameter(const EventParameter &obj);
 
@@ -68,6 +71,10 @@ protected:
 private:
   std::string _name;
 
+  // Set only if the Event was constructed from an EventName; otherwise the
+  // EventHandler has to look the name up.
+  CPT(EventName) _event_name;
+
 public:
   static TypeHandle get_class_type() {
     return _type_handle;
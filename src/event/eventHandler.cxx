@@ -15,6 +15,8 @@
 #include "eventQueue.h"
 #include "config_event.h"
 
+#include <algorithm>
+
 using std::string;
 
 TypeHandle EventHandler::_type_handle;
@@ -29,24 +31,28 @@ EventHandler::
 EventHandler(EventQueue *ev_queue) : _queue(*ev_queue) {
 }
 
+/**
+ *
+ */
+EventHandler::
+~EventHandler() {
+  remove_all_hooks();
+}
+
 /**
  * Returns a pending future that will be marked as done when the event is next
  * fired.
  */
 AsyncFuture *EventHandler::
 get_future(const string &event_name) {
-  Futures::iterator fi;
-  fi = _futures.find(event_name);
+  Hook &hook = get_hook(event_name);
 
   // If we already have a future, but someone cancelled it, we need to create
   // a new future instead.
-  if (fi != _futures.end() && !fi->second->cancelled()) {
-    return fi->second;
-  } else {
-    AsyncFuture *fut = new AsyncFuture;
-    _futures[event_name] = fut;
-    return fut;
+  if (hook._future == nullptr || hook._future->cancelled()) {
+    hook._future = new AsyncFuture;
   }
+  return hook._future;
 }
 
 /**
@@ -68,66 +74,66 @@ void EventHandler::
 dispatch_event(const Event *event) {
   nassertv(event != nullptr);
 
-  // Is the event name defined in the hook table?  It will be if anyone has
-  // ever assigned a hook to this particular event name.
-  Hooks::const_iterator hi;
-  hi = _hooks.find(event->get_name());
-
-  if (hi != _hooks.end()) {
-    // Yes, it is!  Now walk through all the functions assigned to that event
-    // name.
-    Functions copy_functions = (*hi).second;
-
-    Functions::const_iterator fi;
-    for (fi = copy_functions.begin(); fi != copy_functions.end(); ++fi) {
-      if (event_cat.is_spam()) {
-        event_cat->spam()
-          << "calling callback 0x" << (void*)(*fi)
-          << " for event '" << event->get_name() << "'"
-          << std::endl;
-      }
-      (*fi)(event);
+  // If the event was made from an EventName, we already have the key.
+  // Otherwise, look it up; if the name isn't in the table at all, nobody has
+  // ever hooked it, and we're done.
+  const EventName *name = event->get_event_name();
+  CPT(EventName) found;
+  if (name == nullptr) {
+    found = EventName::find(event->get_name());
+    if (found == nullptr) {
+      return;
     }
+    name = found;
+  }
+  if (!name->has_hooks()) {
+    return;
   }
 
-  // now for callback hooks
-  CallbackHooks::const_iterator chi;
-  chi = _cbhooks.find(event->get_name());
+  Hooks::iterator hi = _hooks.find(name);
+  if (hi == _hooks.end()) {
+    return;
+  }
 
-  if (chi != _cbhooks.end()) {
-    // found one
-    CallbackFunctions copy_functions = (*chi).second;
+  // The hooks may add or remove other hooks, which may move the table
+  // around, so we make copies of the functions before calling any of them.
+  Hook &hook = (*hi).second;
+  Functions copy_functions = hook._functions;
+  CallbackFunctions copy_cbfunctions = hook._cbfunctions;
+  LambdaFunctions copy_lambdas = hook._lambdas;
+
+  // The future is only triggered once.
+  PT(AsyncFuture) fut = std::move(hook._future);
+  if (fut != nullptr && hook.is_empty()) {
+    erase_hook(hi);
+  }
 
-    CallbackFunctions::const_iterator cfi;
-    for (cfi = copy_functions.begin(); cfi != copy_functions.end(); ++cfi) {
-      ((*cfi).first)(event, (*cfi).second);
+  Functions::const_iterator fi;
+  for (fi = copy_functions.begin(); fi != copy_functions.end(); ++fi) {
+    if (event_cat.is_spam()) {
+      event_cat->spam()
+        << "calling callback 0x" << (void*)(*fi)
+        << " for event '" << event->get_name() << "'"
+        << std::endl;
     }
+    (*fi)(event);
   }
 
-  // now for lambda hooks
-  LambdaHooks::const_iterator lhi;
-  lhi = _lambdahooks.find(event->get_name());
-
-  if (lhi != _lambdahooks.end()) {
-    // found one
-    const LambdaFunctions &functions = (*lhi).second;
-
-    size_t num_functions = functions.size();
-    for (size_t i = 0; i < num_functions; ++i) {
-      functions[i](event);
-    }
+  // now for callback hooks
+  CallbackFunctions::const_iterator cfi;
+  for (cfi = copy_cbfunctions.begin(); cfi != copy_cbfunctions.end(); ++cfi) {
+    ((*cfi).first)(event, (*cfi).second);
   }
 
-  // Finally, check for futures that need to be triggered.
-  Futures::iterator fi;
-  fi = _futures.find(event->get_name());
+  // now for lambda hooks
+  size_t num_lambdas = copy_lambdas.size();
+  for (size_t i = 0; i < num_lambdas; ++i) {
+    copy_lambdas[i](event);
+  }
 
-  if (fi != _futures.end()) {
-    AsyncFuture *fut = (*fi).second;
-    if (!fut->done()) {
-      fut->set_result((TypedReferenceCount *)event);
-    }
-    _futures.erase(fi);
+  // Finally, trigger the future, if there was one.
+  if (fut != nullptr && !fut->done()) {
+    fut->set_result((TypedReferenceCount *)event);
   }
 }
 
@@ -137,35 +143,20 @@ dispatch_event(const Event *event) {
  */
 void EventHandler::
 write(std::ostream &out) const {
+  // Write the hooks in order by name, so the output doesn't depend on the
+  // layout of the hash table.
+  pvector<const Hook *> hooks;
+  hooks.reserve(_hooks.size());
   Hooks::const_iterator hi;
-  hi = _hooks.begin();
-
-  CallbackHooks::const_iterator chi;
-  chi = _cbhooks.begin();
-
-  while (hi != _hooks.end() && chi != _cbhooks.end()) {
-    if ((*hi).first < (*chi).first) {
-      write_hook(out, *hi);
-      ++hi;
-    } else if ((*chi).first < (*hi).first) {
-      write_cbhook(out, *chi);
-      ++chi;
-    } else {
-      write_hook(out, *hi);
-      write_cbhook(out, *chi);
-      ++hi;
-      ++chi;
-    }
-  }
-
-  while (hi != _hooks.end()) {
-    write_hook(out, *hi);
-    ++hi;
+  for (hi = _hooks.begin(); hi != _hooks.end(); ++hi) {
+    hooks.push_back(&(*hi).second);
   }
+  std::sort(hooks.begin(), hooks.end(), [](const Hook *a, const Hook *b) {
+    return a->_name->get_name() < b->_name->get_name();
+  });
 
-  while (chi != _cbhooks.end()) {
-    write_cbhook(out, *chi);
-    ++chi;
+  for (const Hook *hook : hooks) {
+    write_hook(out, *hook);
   }
 }
 
@@ -185,7 +176,7 @@ add_hook(const string &event_name, EventFunction *function) {
   }
   assert(!event_name.empty());
   assert(function);
-  return _hooks[event_name].insert(function).second;
+  return get_hook(event_name)._functions.insert(function).second;
 }
 
 
@@ -200,7 +191,7 @@ add_hook(const string &event_name, EventCallbackFunction *function,
          void *data) {
   assert(!event_name.empty());
   assert(function);
-  return _cbhooks[event_name].insert(CallbackFunction(function, data)).second;
+  return get_hook(event_name)._cbfunctions.insert(CallbackFunction(function, data)).second;
 }
 
 /**
@@ -213,7 +204,7 @@ void EventHandler::
 add_hook(const string &event_name, EventLambda function) {
   assert(!event_name.empty());
   assert(function);
-  _lambdahooks[event_name].push_back(function);
+  get_hook(event_name)._lambdas.push_back(std::move(function));
 }
 
 /**
@@ -223,28 +214,11 @@ add_hook(const string &event_name, EventLambda function) {
 bool EventHandler::
 has_hook(const string &event_name) const {
   assert(!event_name.empty());
-  Hooks::const_iterator hi;
-  hi = _hooks.find(event_name);
+  Hooks::const_iterator hi = find_hook(event_name);
   if (hi != _hooks.end()) {
-    if (!(*hi).second.empty()) {
-      return true;
-    }
-  }
-
-  CallbackHooks::const_iterator chi;
-  chi = _cbhooks.find(event_name);
-  if (chi != _cbhooks.end()) {
-    if (!(*chi).second.empty()) {
-      return true;
-    }
-  }
-
-  LambdaHooks::const_iterator lhi;
-  lhi = _lambdahooks.find(event_name);
-  if (lhi != _lambdahooks.end()) {
-    if (!(*lhi).second.empty()) {
-      return true;
-    }
+    const Hook &hook = (*hi).second;
+    return !hook._functions.empty() || !hook._cbfunctions.empty() ||
+           !hook._lambdas.empty();
   }
 
   return false;
@@ -258,10 +232,9 @@ has_hook(const string &event_name) const {
 bool EventHandler::
 has_hook(const string &event_name, EventFunction *function) const {
   assert(!event_name.empty());
-  Hooks::const_iterator hi;
-  hi = _hooks.find(event_name);
+  Hooks::const_iterator hi = find_hook(event_name);
   if (hi != _hooks.end()) {
-    const Functions& functions = (*hi).second;
+    const Functions &functions = (*hi).second._functions;
     if (functions.find(function) != functions.end()) {
       return true;
     }
@@ -278,10 +251,9 @@ has_hook(const string &event_name, EventFunction *function) const {
 bool EventHandler::
 has_hook(const string &event_name, EventCallbackFunction *function, void *data) const {
   assert(!event_name.empty());
-  CallbackHooks::const_iterator chi;
-  chi = _cbhooks.find(event_name);
-  if (chi != _cbhooks.end()) {
-    const CallbackFunctions& cbfunctions = (*chi).second;
+  Hooks::const_iterator hi = find_hook(event_name);
+  if (hi != _hooks.end()) {
+    const CallbackFunctions &cbfunctions = (*hi).second._cbfunctions;
     if (cbfunctions.find(CallbackFunction(function, data)) != cbfunctions.end()) {
       return true;
     }
@@ -299,7 +271,16 @@ bool EventHandler::
 remove_hook(const string &event_name, EventFunction *function) {
   assert(!event_name.empty());
   assert(function);
-  return _hooks[event_name].erase(function) != 0;
+  Hooks::iterator hi = find_hook(event_name);
+  if (hi == _hooks.end()) {
+    return false;
+  }
+
+  bool removed = (*hi).second._functions.erase(function) != 0;
+  if ((*hi).second.is_empty()) {
+    erase_hook(hi);
+  }
+  return removed;
 }
 
 
@@ -313,7 +294,16 @@ remove_hook(const string &event_name, EventCallbackFunction *function,
             void *data) {
   assert(!event_name.empty());
   assert(function);
-  return _cbhooks[event_name].erase(CallbackFunction(function, data)) != 0;
+  Hooks::iterator hi = find_hook(event_name);
+  if (hi == _hooks.end()) {
+    return false;
+  }
+
+  bool removed = (*hi).second._cbfunctions.erase(CallbackFunction(function, data)) != 0;
+  if ((*hi).second.is_empty()) {
+    erase_hook(hi);
+  }
+  return removed;
 }
 
 /**
@@ -323,32 +313,22 @@ remove_hook(const string &event_name, EventCallbackFunction *function,
 bool EventHandler::
 remove_hooks(const string &event_name) {
   assert(!event_name.empty());
-  bool any_removed = false;
-
-  Hooks::iterator hi = _hooks.find(event_name);
-  if (hi != _hooks.end()) {
-    if (!(*hi).second.empty()) {
-      any_removed = true;
-    }
-    _hooks.erase(hi);
+  Hooks::iterator hi = find_hook(event_name);
+  if (hi == _hooks.end()) {
+    return false;
   }
 
-  CallbackHooks::iterator chi = _cbhooks.find(event_name);
-  if (chi != _cbhooks.end()) {
-    if (!(*chi).second.empty()) {
-      any_removed = true;
-    }
-    _cbhooks.erase(chi);
-  }
+  Hook &hook = (*hi).second;
+  bool any_removed = !hook._functions.empty() || !hook._cbfunctions.empty() ||
+                     !hook._lambdas.empty();
+  hook._functions.clear();
+  hook._cbfunctions.clear();
+  hook._lambdas.clear();
 
-  LambdaHooks::iterator lhi = _lambdahooks.find(event_name);
-  if (lhi != _lambdahooks.end()) {
-    if (!(*lhi).second.empty()) {
-      any_removed = true;
-    }
-    _lambdahooks.erase(lhi);
+  // A pending future is left alone.
+  if (hook.is_empty()) {
+    erase_hook(hi);
   }
-
   return any_removed;
 }
 
@@ -360,9 +340,11 @@ bool EventHandler::
 remove_hooks_with(void *data) {
   bool any_removed = false;
 
-  CallbackHooks::iterator chi;
-  for (chi = _cbhooks.begin(); chi != _cbhooks.end(); ++chi) {
-    CallbackFunctions &funcs = (*chi).second;
+  pvector<const EventName *> emptied;
+
+  Hooks::iterator hi;
+  for (hi = _hooks.begin(); hi != _hooks.end(); ++hi) {
+    CallbackFunctions &funcs = (*hi).second._cbfunctions;
     CallbackFunctions::iterator cfi;
 
     CallbackFunctions new_funcs;
@@ -374,6 +356,14 @@ remove_hooks_with(void *data) {
       }
     }
     funcs.swap(new_funcs);
+
+    if ((*hi).second.is_empty()) {
+      emptied.push_back((*hi).first);
+    }
+  }
+
+  for (const EventName *name : emptied) {
+    erase_hook(_hooks.find(name));
   }
 
   return any_removed;
@@ -385,9 +375,11 @@ remove_hooks_with(void *data) {
  */
 void EventHandler::
 remove_all_hooks() {
+  Hooks::iterator hi;
+  for (hi = _hooks.begin(); hi != _hooks.end(); ++hi) {
+    (*hi).first->remove_hook_ref();
+  }
   _hooks.clear();
-  _cbhooks.clear();
-  _lambdahooks.clear();
 }
 
 /**
@@ -398,23 +390,74 @@ make_global_event_handler() {
   _global_event_handler = new EventHandler(EventQueue::get_global_event_queue());
 }
 
+/**
+ * Returns the Hook for the indicated event name, creating a new empty one if
+ * there isn't one already.
+ */
+EventHandler::Hook &EventHandler::
+get_hook(const string &event_name) {
+  PT(EventName) name = EventName::make(event_name);
+  Hooks::iterator hi = _hooks.find(name);
+  if (hi != _hooks.end()) {
+    return (*hi).second;
+  }
+
+  name->add_hook_ref();
+  Hook &hook = _hooks[name];
+  hook._name = std::move(name);
+  return hook;
+}
+
+/**
+ * Returns the Hook for the indicated event name, or _hooks.end() if there is
+ * none.
+ */
+EventHandler::Hooks::iterator EventHandler::
+find_hook(const string &event_name) {
+  CPT(EventName) name = EventName::find(event_name);
+  if (name == nullptr) {
+    return _hooks.end();
+  }
+  return _hooks.find(name);
+}
+
+/**
+ * Returns the Hook for the indicated event name, or _hooks.end() if there is
+ * none.
+ */
+EventHandler::Hooks::const_iterator EventHandler::
+find_hook(const string &event_name) const {
+  CPT(EventName) name = EventName::find(event_name);
+  if (name == nullptr) {
+    return _hooks.end();
+  }
+  return _hooks.find(name);
+}
 
 /**
- *
+ * Removes the indicated Hook from the table, and releases its name.
  */
 void EventHandler::
-write_hook(std::ostream &out, const EventHandler::Hooks::value_type &hook) const {
-  if (!hook.second.empty()) {
-    out << hook.first << " has " << hook.second.size() << " functions.\n";
-  }
+erase_hook(Hooks::iterator hi) {
+  nassertv(hi != _hooks.end());
+
+  // Hold on to the name until the entry that is keyed on it is gone.
+  CPT(EventName) name = std::move((*hi).second._name);
+  _hooks.erase(hi);
+  name->remove_hook_ref();
 }
 
+
 /**
  *
  */
 void EventHandler::
-write_cbhook(std::ostream &out, const EventHandler::CallbackHooks::value_type &hook) const {
-  if (!hook.second.empty()) {
-    out << hook.first << " has " << hook.second.size() << " callback functions.\n";
+write_hook(std::ostream &out, const Hook &hook) const {
+  const string &name = hook._name->get_name();
+  if (!hook._functions.empty()) {
+    out << name << " has " << hook._functions.size() << " functions.\n";
+  }
+  if (!hook._cbfunctions.empty()) {
+    out << name << " has " << hook._cbfunctions.size() << " callback functions.\n";
   }
 }
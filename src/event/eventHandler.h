@@ -17,6 +17,7 @@
 #include "pandabase.h"
 
 #include "event.h"
+#include "eventName.h"
 #include "pt_Event.h"
 #include "asyncFuture.h"
 
@@ -53,7 +54,7 @@ public:
 
 PUBLISHED:
   explicit EventHandler(EventQueue *ev_queue);
-  ~EventHandler() {}
+  ~EventHandler();
 
   AsyncFuture *get_future(const std::string &event_name);
 
@@ -84,29 +85,39 @@ public:
   void remove_all_hooks();
 
 protected:
-
   typedef pset<EventFunction *> Functions;
-  typedef pmap<std::string, Functions> Hooks;
   typedef std::pair<EventCallbackFunction*, void*> CallbackFunction;
   typedef pset<CallbackFunction> CallbackFunctions;
-  typedef pmap<std::string, CallbackFunctions> CallbackHooks;
   typedef pvector<EventLambda> LambdaFunctions;
-  typedef pmap<std::string, LambdaFunctions> LambdaHooks;
-  typedef pmap<std::string, PT(AsyncFuture)> Futures;
+
+  // Everything that is waiting on one particular event name.
+  class Hook {
+  public:
+    INLINE bool is_empty() const;
+
+    CPT(EventName) _name;
+    Functions _functions;
+    CallbackFunctions _cbfunctions;
+    LambdaFunctions _lambdas;
+    PT(AsyncFuture) _future;
+  };
+
+  // Keyed on the EventName pointer, which the Hook keeps a reference to.
+  typedef pflat_hash_map<const EventName *, Hook, pointer_hash> Hooks;
 
   Hooks _hooks;
-  CallbackHooks _cbhooks;
-  LambdaHooks _lambdahooks;
-  Futures _futures;
   EventQueue &_queue;
 
   static EventHandler *_global_event_handler;
   static void make_global_event_handler();
 
 private:
-  void write_hook(std::ostream &out, const Hooks::value_type &hook) const;
-  void write_cbhook(std::ostream &out, const CallbackHooks::value_type &hook) const;
+  Hook &get_hook(const std::string &event_name);
+  Hooks::iterator find_hook(const std::string &event_name);
+  Hooks::const_iterator find_hook(const std::string &event_name) const;
+  void erase_hook(Hooks::iterator hi);
 
+  void write_hook(std::ostream &out, const Hook &hook) const;
 
 public:
   static TypeHandle get_class_type() {
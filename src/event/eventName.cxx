@@ -0,0 +1,102 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file eventName.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "eventName.h"
+#include "lightMutexHolder.h"
+
+EventName::NameTable EventName::_name_table;
+LightMutex EventName::_name_table_lock("EventName::_name_table_lock");
+
+/**
+ * Use make() to make a new EventName instance.
+ */
+EventName::
+EventName(const std::string &name) :
+  _name(name)
+{
+}
+
+/**
+ *
+ */
+EventName::
+~EventName() {
+#ifndef NDEBUG
+  // unref() should have removed us from the table already.
+  LightMutexHolder holder(_name_table_lock);
+  NameTable::iterator ni = _name_table.find(_name);
+  nassertv(ni == _name_table.end() || (*ni).second != this);
+#endif
+}
+
+/**
+ * Returns the unique EventName for the indicated string, creating it if it
+ * does not already exist.
+ */
+PT(EventName) EventName::
+make(const std::string &name) {
+  LightMutexHolder holder(_name_table_lock);
+
+  NameTable::iterator ni = _name_table.find(name);
+  if (ni != _name_table.end()) {
+    return (*ni).second;
+  }
+
+  EventName *event_name = new EventName(name);
+  _name_table[name] = event_name;
+  return event_name;
+}
+
+/**
+ * Returns the EventName for the indicated string if one currently exists, or
+ * NULL if it does not.  Since the EventHandler holds a reference to the name
+ * of every hook, a NULL return means that nobody is listening for this name.
+ */
+PT(EventName) EventName::
+find(const std::string &name) {
+  LightMutexHolder holder(_name_table_lock);
+
+  NameTable::iterator ni = _name_table.find(name);
+  if (ni != _name_table.end()) {
+    return (*ni).second;
+  }
+  return nullptr;
+}
+
+/**
+ *
+ */
+void EventName::
+output(std::ostream &out) const {
+  out << _name;
+}
+
+/**
+ * This method overrides ReferenceCount::unref() to remove the name from the
+ * table when its reference count goes to zero.
+ */
+bool EventName::
+unref() const {
+  LightMutexHolder holder(_name_table_lock);
+
+  if (ReferenceCount::unref()) {
+    return true;
+  }
+
+  // The reference count has just reached zero.
+  NameTable::iterator ni = _name_table.find(_name);
+  nassertr(ni != _name_table.end(), false);
+  _name_table.erase(ni);
+
+  return false;
+}
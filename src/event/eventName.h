@@ -0,0 +1,70 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file eventName.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef EVENTNAME_H
+#define EVENTNAME_H
+
+#include "pandabase.h"
+
+#include "referenceCount.h"
+#include "pointerTo.h"
+#include "pmap.h"
+#include "patomic.h"
+#include "lightMutex.h"
+
+/**
+ * An event name encoded in a global hash table, so that each distinct name is
+ * represented by exactly one EventName pointer.  The EventHandler keys its
+ * hooks on these pointers, and an Event that is constructed from an EventName
+ * can be dispatched without hashing or comparing its name at all.
+ *
+ * Each EventName also counts the EventHandlers that have anything attached to
+ * it, so that events nobody is listening for can be discarded immediately.
+ */
+class EXPCL_PANDA_EVENT EventName final : public ReferenceCount {
+private:
+  explicit EventName(const std::string &name);
+
+PUBLISHED:
+  virtual ~EventName();
+
+  static PT(EventName) make(const std::string &name);
+  static PT(EventName) find(const std::string &name);
+
+  INLINE const std::string &get_name() const;
+  INLINE bool has_hooks() const;
+
+  void output(std::ostream &out) const;
+
+  MAKE_PROPERTY(name, get_name);
+
+public:
+  virtual bool unref() const;
+
+  INLINE void add_hook_ref() const;
+  INLINE void remove_hook_ref() const;
+
+private:
+  std::string _name;
+  mutable patomic<int> _num_hook_refs {0};
+
+  typedef pflat_hash_map<std::string, EventName *, string_hash> NameTable;
+  static NameTable _name_table;
+  static LightMutex _name_table_lock;
+};
+
+INLINE std::ostream &operator << (std::ostream &out, const EventName &name);
+
+#include "eventName.I"
+
+#endif
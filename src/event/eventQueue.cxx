@@ -30,6 +30,7 @@ EventQueue() : _lock("EventQueue::_lock") {
  */
 EventQueue::
 ~EventQueue() {
+  clear();
 }
 
 /**
@@ -43,9 +44,6 @@ queue_event(CPT_Event event) {
     return;
   }
 
-  LightMutexHolder holder(_lock);
-
-  _queue.push_back(event);
   if (event_cat.is_debug()) {
     if (event->get_name() == "NewFrame") {
       // Don't bother us with this particularly spammy event.
@@ -58,6 +56,14 @@ queue_event(CPT_Event event) {
         << "Throwing event " << *event << "\n";
     }
   }
+
+  Node *node = new Node(std::move(event));
+  Node *head = _incoming.load(std::memory_order_relaxed);
+  do {
+    node->_next = head;
+  } while (!_incoming.compare_exchange_weak(head, node,
+                                            std::memory_order_release,
+                                            std::memory_order_relaxed));
 }
 
 /**
@@ -67,6 +73,12 @@ void EventQueue::
 clear() {
   LightMutexHolder holder(_lock);
 
+  Node *node = _incoming.exchange(nullptr, std::memory_order_acquire);
+  while (node != nullptr) {
+    Node *next = node->_next;
+    delete node;
+    node = next;
+  }
   _queue.clear();
 }
 
@@ -77,7 +89,8 @@ clear() {
 bool EventQueue::
 is_queue_empty() const {
   LightMutexHolder holder(_lock);
-  return _queue.empty();
+  return _queue.empty() &&
+         _incoming.load(std::memory_order_relaxed) == nullptr;
 }
 
 /**
@@ -96,13 +109,44 @@ CPT_Event EventQueue::
 dequeue_event() {
   LightMutexHolder holder(_lock);
 
-  CPT_Event result = _queue.front();
+  if (_queue.empty()) {
+    take_incoming();
+    nassertr(!_queue.empty(), nullptr);
+  }
+
+  CPT_Event result = std::move(_queue.front());
   _queue.pop_front();
 
   nassertr(!result.is_null(), result);
   return result;
 }
 
+/**
+ * Moves everything that has been pushed by queue_event() since the last call
+ * onto the end of _queue, in the order it was thrown.  Assumes the lock is
+ * held.
+ */
+void EventQueue::
+take_incoming() {
+  Node *node = _incoming.exchange(nullptr, std::memory_order_acquire);
+
+  // The list is newest first; reverse it.
+  Node *prev = nullptr;
+  while (node != nullptr) {
+    Node *next = node->_next;
+    node->_next = prev;
+    prev = node;
+    node = next;
+  }
+
+  while (prev != nullptr) {
+    Node *next = prev->_next;
+    _queue.push_back(std::move(prev->_event));
+    delete prev;
+    prev = next;
+  }
+}
+
 /**
  *
  */
@@ -20,11 +20,17 @@
 #include "pt_Event.h"
 #include "lightMutex.h"
 #include "pdeque.h"
+#include "patomic.h"
 
 /**
  * A queue of pending events.  As events are thrown, they are added to this
  * queue; eventually, they will be extracted out again by an EventHandler and
  * processed.
+ *
+ * Any number of threads may throw events at once without blocking each other:
+ * queue_event() pushes onto a lock-free list, which the reading side takes
+ * over as a whole the next time it runs out of events.  Events thrown by the
+ * same thread are always dequeued in the order they were thrown.
  */
 class EXPCL_PANDA_EVENT EventQueue {
 PUBLISHED:
@@ -44,6 +50,23 @@ private:
   static void make_global_event_queue();
   static EventQueue *_global_event_queue;
 
+  void take_incoming();
+
+  // One event pushed by queue_event().  These are deliberately allocated
+  // with plain new, rather than a DeletedChain, which would take a lock.
+  class Node {
+  public:
+    INLINE Node(CPT_Event event);
+
+    CPT_Event _event;
+    Node *_next;
+  };
+
+  // Newest first.
+  patomic<Node *> _incoming {nullptr};
+
+  // Oldest first.  This and the reading of _incoming are protected by _lock,
+  // which is only ever held by the reading side.
   typedef pdeque<CPT_Event> Events;
   Events _queue;
 
@@ -0,0 +1,58 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file fileReadRequest.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "fileReadRequest.h"
+#include "config_event.h"
+
+TypeHandle FileReadRequest::_type_handle;
+
+/**
+ *
+ */
+FileReadRequest::
+FileReadRequest(const Filename &filename, bool auto_unwrap) :
+  _filename(filename),
+  _auto_unwrap(auto_unwrap),
+  _ok(false),
+  _offset(0)
+{
+}
+
+/**
+ * Reads the file and finishes the future.  This is called by one of the
+ * AsyncFileReader's threads.  Does nothing if the request has been cancelled
+ * in the meantime.
+ */
+void FileReadRequest::
+read() {
+  if (done()) {
+    return;
+  }
+
+  if (_file != nullptr) {
+    _ok = _file->read_file(_data, _auto_unwrap);
+  }
+  if (!_ok) {
+    event_cat.warning()
+      << "Unable to read " << _filename << "\n";
+    _data.clear();
+  }
+
+  // Don't keep the Multifile open any longer than we need to.
+  _file.clear();
+  _multifile.clear();
+
+  if (set_future_state(FS_finished)) {
+    notify_done(true);
+  }
+}
@@ -0,0 +1,81 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file fileReadRequest.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef FILEREADREQUEST_H
+#define FILEREADREQUEST_H
+
+#include "pandabase.h"
+#include "asyncFuture.h"
+#include "filename.h"
+#include "virtualFile.h"
+#include "multifile.h"
+#include "vector_uchar.h"
+
+/**
+ * A request to read the entire contents of a file from the
+ * VirtualFileSystem, issued by AsyncFileReader.  The future is finished once
+ * the file has been read, at which point get_data() returns its contents.
+ */
+class EXPCL_PANDA_EVENT FileReadRequest final : public AsyncFuture {
+public:
+  FileReadRequest(const Filename &filename, bool auto_unwrap);
+
+PUBLISHED:
+  INLINE const Filename &get_filename() const;
+  INLINE bool is_ok() const;
+  INLINE const vector_uchar &get_data() const;
+
+  MAKE_PROPERTY(filename, get_filename);
+  MAKE_PROPERTY(data, get_data);
+
+public:
+  INLINE vector_uchar take_data();
+
+  void read();
+
+private:
+  Filename _filename;
+  bool _auto_unwrap;
+  bool _ok;
+  vector_uchar _data;
+
+  // Filled in when the request is queued.  If the file lives in a
+  // Multifile, this is the Multifile and the position of the subfile within
+  // it, so that reads from the same Multifile can be issued in file order.
+  PT(VirtualFile) _file;
+  PT(Multifile) _multifile;
+  std::streampos _offset;
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    AsyncFuture::init_type();
+    register_type(_type_handle, "FileReadRequest",
+                  AsyncFuture::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+
+  friend class AsyncFileReader;
+};
+
+#include "fileReadRequest.I"
+
+#endif
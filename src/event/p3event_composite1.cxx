@@ -1,3 +1,4 @@
+#include "asyncFileReader.cxx"
 #include "asyncFuture.cxx"
 #include "asyncTask.cxx"
 #include "asyncTaskChain.cxx"
@@ -1,8 +1,10 @@
 #include "config_event.cxx"
 #include "event.cxx"
 #include "eventHandler.cxx"
+#include "eventName.cxx"
 #include "eventParameter.cxx"
 #include "eventQueue.cxx"
 #include "eventReceiver.cxx"
+#include "fileReadRequest.cxx"
 #include "pt_Event.cxx"
 
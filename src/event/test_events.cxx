@@ -0,0 +1,143 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_events.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "pandabase.h"
+#include "eventQueue.h"
+#include "eventHandler.h"
+#include "eventName.h"
+#include "genericThread.h"
+#include "trueClock.h"
+#include "patomic.h"
+
+#include <stdlib.h>
+
+static int num_dispatched = 0;
+
+static void
+count_event(const Event *) {
+  ++num_dispatched;
+}
+
+/**
+ * Throws events at an EventQueue from a number of threads while the main
+ * thread dispatches them, and reports the number of events per second.  Half
+ * of the events have a hook attached and half do not; each half is thrown
+ * both by string and by EventName.
+ */
+int
+main(int argc, char *argv[]) {
+  if (argc > 3) {
+    std::cerr << "test_events [num_threads [events_per_thread]]\n";
+    exit(1);
+  }
+
+  int num_threads = (argc > 1) ? atoi(argv[1]) : 4;
+  int events_per_thread = (argc > 2) ? atoi(argv[2]) : 1000000;
+
+  EventQueue queue;
+  EventHandler handler(&queue);
+  handler.add_hook("hooked", &count_event);
+
+  PT(EventName) hooked = EventName::make("hooked");
+  PT(EventName) unhooked = EventName::make("unhooked");
+
+  patomic<int> num_running(num_threads);
+  pvector<PT(GenericThread)> threads;
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+
+  for (int i = 0; i < num_threads; ++i) {
+    PT(GenericThread) thread = new GenericThread("thrower", "thrower", [&] () {
+      for (int j = 0; j < events_per_thread; ++j) {
+        switch (j & 3) {
+        case 0:
+          queue.queue_event(new Event("hooked"));
+          break;
+        case 1:
+          queue.queue_event(new Event("unhooked"));
+          break;
+        case 2:
+          queue.queue_event(new Event(hooked));
+          break;
+        default:
+          queue.queue_event(new Event(unhooked));
+          break;
+        }
+      }
+      num_running.fetch_sub(1);
+    });
+    thread->start(TP_normal, true);
+    threads.push_back(thread);
+  }
+
+  // Dispatch while the threads are still throwing.
+  int num_processed = 0;
+  while (num_running.load() > 0 || !queue.is_queue_empty()) {
+    while (!queue.is_queue_empty()) {
+      handler.dispatch_event(queue.dequeue_event());
+      ++num_processed;
+    }
+    Thread::consider_yield();
+  }
+
+  double elapsed = clock->get_short_time() - start;
+
+  for (GenericThread *thread : threads) {
+    thread->join();
+  }
+
+  std::cerr
+    << num_threads << " threads threw " << num_processed << " events in "
+    << elapsed << " seconds: " << num_processed / elapsed << " events/sec, "
+    << num_dispatched << " dispatched to a hook.\n";
+
+  // Now time the dispatch alone.
+  CPT_Event by_string = new Event("unhooked");
+  CPT_Event by_name = new Event(unhooked.p());
+  CPT_Event hooked_event = new Event(hooked.p());
+  const int num_dispatches = 1000000;
+
+  start = clock->get_short_time();
+  for (int i = 0; i < num_dispatches; ++i) {
+    handler.dispatch_event(by_string);
+  }
+  double string_time = clock->get_short_time() - start;
+
+  start = clock->get_short_time();
+  for (int i = 0; i < num_dispatches; ++i) {
+    handler.dispatch_event(by_name);
+  }
+  double name_time = clock->get_short_time() - start;
+
+  start = clock->get_short_time();
+  for (int i = 0; i < num_dispatches; ++i) {
+    handler.dispatch_event(hooked_event);
+  }
+  double hooked_time = clock->get_short_time() - start;
+
+  std::cerr
+    << "Dispatching with no listeners: "
+    << string_time * 1.0e9 / num_dispatches << " ns by string, "
+    << name_time * 1.0e9 / num_dispatches << " ns by EventName.\n"
+    << "Dispatching to one hook: "
+    << hooked_time * 1.0e9 / num_dispatches << " ns by EventName.\n";
+
+  // The even-numbered events from each thread are hooked.
+  int expected = num_threads * ((events_per_thread + 1) / 2) + num_dispatches;
+  if (num_dispatched != expected) {
+    std::cerr << "Expected " << expected << " hooked events!\n";
+    return 1;
+  }
+  return 0;
+}
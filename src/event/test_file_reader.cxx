@@ -0,0 +1,152 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_file_reader.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "pandabase.h"
+#include "asyncFileReader.h"
+#include "virtualFileSystem.h"
+#include "genericThread.h"
+#include "patomic.h"
+
+#include <stdlib.h>
+
+using std::cerr;
+using std::string;
+
+static const int num_files = 64;
+static const int num_rounds = 200;
+
+static pvector<Filename> filenames;
+static pvector<string> contents;
+
+/**
+ * Checks that the indicated request has finished with the contents of the
+ * nth file, or was cancelled if that is allowed.  Returns true if it is okay.
+ */
+static bool
+check_request(FileReadRequest *request, int n, bool allow_cancel) {
+  // Don't wait forever; a read that never finishes is what we're testing for.
+  request->wait(10.0);
+  if (!request->done()) {
+    cerr << "Read of " << request->get_filename() << " never finished!\n";
+    return false;
+  }
+  if (request->cancelled()) {
+    if (!allow_cancel) {
+      cerr << "Read of " << request->get_filename() << " was cancelled!\n";
+      return false;
+    }
+    return true;
+  }
+  const vector_uchar &data = request->get_data();
+  if (!request->is_ok() ||
+      string((const char *)data.data(), data.size()) != contents[n]) {
+    cerr << "Read of " << request->get_filename() << " returned the wrong data!\n";
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Reads a number of files with an AsyncFileReader and checks their contents.
+ * Then does it again while another thread keeps stopping the reader's
+ * threads, to make sure that every read still finishes, either with the
+ * right contents or by being cancelled.
+ */
+int
+main(int argc, char *argv[]) {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+
+  for (int i = 0; i < num_files; ++i) {
+    Filename filename = Filename::temporary("", "afr_", ".txt");
+    filename.set_binary();
+    std::ostringstream strm;
+    for (int j = 0; j <= i * 16; ++j) {
+      strm << "line " << j << " of file " << i << "\n";
+    }
+    if (!vfs->write_file(filename, strm.str(), false)) {
+      cerr << "Unable to write " << filename << "\n";
+      return 1;
+    }
+    filenames.push_back(filename);
+    contents.push_back(strm.str());
+  }
+
+  PT(AsyncFileReader) reader = new AsyncFileReader(4);
+  int num_failed = 0;
+
+  cerr << "Reading " << num_files << " files.\n";
+  {
+    pvector<PT(FileReadRequest)> requests;
+    for (int i = 0; i < num_files; ++i) {
+      requests.push_back(reader->read_file(filenames[i]));
+    }
+    for (int i = 0; i < num_files; ++i) {
+      if (!check_request(requests[i], i, false)) {
+        ++num_failed;
+      }
+    }
+  }
+
+  cerr << "Reading while stopping the threads.\n";
+  {
+    patomic<bool> done(false);
+    PT(GenericThread) stopper = new GenericThread("stopper", "stopper", [&] () {
+      while (!done.load()) {
+        reader->stop_threads();
+        Thread::consider_yield();
+      }
+    });
+    stopper->start(TP_normal, true);
+
+    int num_cancelled = 0;
+    for (int round = 0; round < num_rounds; ++round) {
+      pvector<PT(FileReadRequest)> requests;
+      for (int i = 0; i < num_files; ++i) {
+        requests.push_back(reader->read_file(filenames[i]));
+      }
+      for (int i = 0; i < num_files; ++i) {
+        if (!check_request(requests[i], i, true)) {
+          ++num_failed;
+        } else if (requests[i]->cancelled()) {
+          ++num_cancelled;
+        }
+      }
+    }
+
+    done.store(true);
+    stopper->join();
+
+    cerr << num_cancelled << " of " << num_rounds * num_files
+         << " reads were cancelled.\n";
+  }
+
+  // After all that, the reader should still work normally.
+  for (int i = 0; i < num_files; ++i) {
+    PT(FileReadRequest) request = reader->read_file(filenames[i]);
+    if (!check_request(request, i, false)) {
+      ++num_failed;
+    }
+  }
+
+  reader->stop_threads();
+  for (const Filename &filename : filenames) {
+    vfs->delete_file(filename);
+  }
+
+  if (num_failed != 0) {
+    cerr << num_failed << " reads failed!\n";
+    return 1;
+  }
+  cerr << "All reads succeeded.\n";
+  return 0;
+}
@@ -38,6 +38,15 @@ INLINE void throw_event(const std::string &event_name,
                         const EventParameter &p3,
                         const EventParameter &p4);
 
+// These versions take a name that has already been interned, which saves the
+// EventHandler from having to look it up.
+INLINE void throw_event(const EventName *event_name);
+INLINE void throw_event(const EventName *event_name,
+                        const EventParameter &p1);
+INLINE void throw_event(const EventName *event_name,
+                        const EventParameter &p1,
+                        const EventParameter &p2);
+
 #include "eventHandler.h"
 
 INLINE void throw_event_directly(EventHandler& handler,
@@ -3,7 +3,7 @@
 
 #begin lib_target
   #define TARGET express
-  #define USE_PACKAGES zlib openssl
+  #define USE_PACKAGES zlib zstd lz4 openssl
 
   #define BUILDING_DLL BUILDING_PANDA_EXPRESS
 
@@ -25,6 +25,7 @@
     hashGeneratorBase.I hashGeneratorBase.h \
     hashVal.I hashVal.h \
     indirectLess.I indirectLess.h \
+    lz4Stream.I lz4Stream.h lz4StreamBuf.h \
     lzmaDecoder.h \
     memoryInfo.I memoryInfo.h \
     memoryUsage.I memoryUsage.h \
@@ -60,6 +61,7 @@
     typedReferenceCount.I typedReferenceCount.h \
     virtualFile.I virtualFileList.I virtualFileList.h virtualFileMount.h \
     virtualFileComposite.h virtualFileComposite.I virtualFile.h \
+    virtualFileMapping.h virtualFileMapping.I \
     virtualFileMount.I virtualFileMountMultifile.h \
     virtualFileMountAndroidAsset.h virtualFileMountAndroidAsset.I \
     virtualFileMountMultifile.I \
@@ -75,7 +77,8 @@
     weakReferenceList.I weakReferenceList.h \
     windowsRegistry.h \
     zipArchive.I zipArchive.h \
-    zStream.I zStream.h zStreamBuf.h
+    zStream.I zStream.h zStreamBuf.h \
+    zstdStream.I zstdStream.h zstdStreamBuf.h
 
   #define COMPOSITE_SOURCES  \
     buffer.cxx checksumHashGenerator.cxx \
@@ -90,6 +93,7 @@
     error_utils.cxx \
     fileReference.cxx \
     hashGeneratorBase.cxx hashVal.cxx \
+    lz4Stream.cxx lz4StreamBuf.cxx \
     lzmaDecoder.cxx \
     memoryInfo.cxx memoryUsage.cxx memoryUsagePointerCounts.cxx \
     memoryUsagePointers.cxx multifile.cxx \
@@ -118,6 +122,7 @@
     trueClock.cxx \
     typedReferenceCount.cxx \
     virtualFileComposite.cxx virtualFile.cxx virtualFileList.cxx \
+    virtualFileMapping.cxx \
     virtualFileMount.cxx \
     $[if $[ANDROID_PLATFORM], virtualFileMountAndroidAsset.cxx] \
     virtualFileMountMultifile.cxx \
@@ -132,7 +137,8 @@
     weakReferenceList.cxx \
     windowsRegistry.cxx \
     zipArchive.cxx \
-    zStream.cxx zStreamBuf.cxx
+    zStream.cxx zStreamBuf.cxx \
+    zstdStream.cxx zstdStreamBuf.cxx
 
   #define INSTALL_HEADERS  \
     buffer.I buffer.h \
@@ -151,6 +157,7 @@
     hashGeneratorBase.I hashGeneratorBase.h \
     hashVal.I hashVal.h \
     indirectLess.I indirectLess.h \
+    lz4Stream.I lz4Stream.h lz4StreamBuf.h \
     lzmaDecoder.h \
     memoryInfo.I memoryInfo.h \
     memoryUsage.I memoryUsage.h \
@@ -186,6 +193,7 @@
     typedReferenceCount.I typedReferenceCount.h \
     virtualFile.I virtualFileList.I virtualFileList.h virtualFileMount.h \
     virtualFileComposite.h virtualFileComposite.I virtualFile.h \
+    virtualFileMapping.h virtualFileMapping.I \
     virtualFileMount.I virtualFileMountMultifile.h \
     virtualFileMountMultifile.I \
     virtualFileMountRamdisk.h virtualFileMountRamdisk.I \
@@ -200,7 +208,8 @@
     weakReferenceList.I weakReferenceList.h \
     windowsRegistry.h \
     zipArchive.I zipArchive.h \
-    zStream.I zStream.h zStreamBuf.h
+    zStream.I zStream.h zStreamBuf.h \
+    zstdStream.I zstdStream.h zstdStreamBuf.h
 
   #define IGATESCAN all
 
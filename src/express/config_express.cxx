@@ -21,6 +21,7 @@
 #include "typedReferenceCount.h"
 #include "virtualFile.h"
 #include "virtualFileComposite.h"
+#include "virtualFileMapping.h"
 #include "virtualFileMount.h"
 #include "virtualFileMountAndroidAsset.h"
 #include "virtualFileMountMultifile.h"
@@ -119,6 +120,7 @@ init_libexpress() {
   VirtualFileMountSystem::init_type();
   VirtualFileMountZip::init_type();
   VirtualFileSimple::init_type();
+  VirtualFileMapping::init_type();
   FileReference::init_type();
   TemporaryFile::init_type();
 
@@ -131,6 +133,20 @@ init_libexpress() {
   }
 #endif
 
+#ifdef HAVE_ZSTD
+  {
+    PandaSystem *ps = PandaSystem::get_global_ptr();
+    ps->add_system("zstd");
+  }
+#endif
+
+#ifdef HAVE_LZ4
+  {
+    PandaSystem *ps = PandaSystem::get_global_ptr();
+    ps->add_system("lz4");
+  }
+#endif
+
   // This is a fine place to ensure that the numeric types have been chosen
   // correctly.
   nassertv(sizeof(int8_t) == 1 && sizeof(uint8_t) == 1);
@@ -14,26 +14,101 @@
 #include "datagram.h"
 
 #include "pnotify.h"
+#include "configVariableInt.h"
+#include "pvector.h"
 
 // for sprintf().
 #include <stdio.h>
 
 TypeHandle Datagram::_type_handle;
 
+static ConfigVariableInt datagram_pool_size
+("datagram-pool-size", 32,
+ PRC_DESC("The maximum number of unused Datagram buffers that each thread "
+          "keeps around for reuse.  Set this to 0 to disable the pool, so "
+          "that every Datagram allocates its own buffer."));
+
+static ConfigVariableInt datagram_pool_max_capacity
+("datagram-pool-max-capacity", 65536,
+ PRC_DESC("Datagram buffers that have grown larger than this many bytes are "
+          "freed rather than returned to the buffer pool, so that one very "
+          "large message doesn't hold on to its memory indefinitely."));
+
+/**
+ * The per-thread pool of unused Datagram buffers.
+ */
+class DatagramBufferPool {
+public:
+  ~DatagramBufferPool();
+
+  pvector<PTA_uchar> _buffers;
+};
+
+// This is set once the current thread's pool has been destructed, so that
+// Datagrams destructed after that point don't try to use it.
+static thread_local bool buffer_pool_destroyed = false;
+static thread_local DatagramBufferPool buffer_pool;
+
+/**
+ *
+ */
+DatagramBufferPool::
+~DatagramBufferPool() {
+  buffer_pool_destroyed = true;
+}
+
 /**
  *
  */
 Datagram::
 ~Datagram() {
+  free_buffer();
 }
 
 /**
  * Resets the datagram to empty, in preparation for building up a new
- * datagram.
+ * datagram.  The buffer is returned to the current thread's pool.
  */
 void Datagram::
 clear() {
-  _data.clear();
+  free_buffer();
+}
+
+/**
+ * Resets the datagram to empty, but unlike clear(), keeps the buffer with
+ * this Datagram if it isn't shared, so that it can be filled up again without
+ * reallocating.  This is useful for a Datagram that is reused in a loop.
+ */
+void Datagram::
+reset() {
+  if (_data != nullptr && _data.get_ref_count() == 1) {
+    _data.v().clear();
+  } else {
+    _data.clear();
+  }
+}
+
+/**
+ * Ensures that the datagram can hold at least the indicated number of bytes
+ * without reallocating.  Unlike the gradual growth of append_data(), this
+ * allocates exactly the requested size, which is useful when the final size
+ * of the message is known up front.
+ */
+void Datagram::
+reserve(size_t size) {
+  if (_data == nullptr) {
+    _data = alloc_buffer();
+
+  } else if (_data.get_ref_count() != 1) {
+    // Copy on write.
+    PTA_uchar new_data = alloc_buffer();
+    new_data.v() = _data.v();
+    _data = new_data;
+  }
+
+  if (size > _data.v().capacity()) {
+    _data.v().reserve(size);
+  }
 }
 
 /**
@@ -101,11 +176,11 @@ pad_bytes(size_t size) {
 
   if (_data == nullptr) {
     // Create a new array.
-    _data = PTA_uchar::empty_array(0);
+    _data = alloc_buffer();
 
   } else if (_data.get_ref_count() != 1) {
     // Copy on write.
-    PTA_uchar new_data = PTA_uchar::empty_array(0);
+    PTA_uchar new_data = alloc_buffer();
     new_data.v() = _data.v();
     _data = new_data;
   }
@@ -131,11 +206,11 @@ append_data(const void *data, size_t size) {
 
   if (_data == nullptr) {
     // Create a new array.
-    _data = PTA_uchar::empty_array(0);
+    _data = alloc_buffer();
 
   } else if (_data.get_ref_count() != 1) {
     // Copy on write.
-    PTA_uchar new_data = PTA_uchar::empty_array(0);
+    PTA_uchar new_data = alloc_buffer();
     new_data.v() = _data.v();
     _data = new_data;
   }
@@ -160,7 +235,11 @@ void Datagram::
 assign(const void *data, size_t size) {
   nassertv((int)size >= 0);
 
-  _data = PTA_uchar::empty_array(0);
+  if (_data == nullptr || _data.get_ref_count() != 1) {
+    _data = alloc_buffer();
+  } else {
+    _data.v().clear();
+  }
   _data.v().insert(_data.v().end(), (const unsigned char *)data,
                    (const unsigned char *)data + size);
 }
@@ -186,3 +265,37 @@ write(std::ostream &out, unsigned int indent) const {
   dump_hex(out, indent);
   #endif //] NDEBUG
 }
+
+/**
+ * Returns an empty buffer from the current thread's pool, or a newly
+ * allocated one if the pool is empty.
+ */
+PTA_uchar Datagram::
+alloc_buffer() {
+  if (!buffer_pool_destroyed && !buffer_pool._buffers.empty()) {
+    PTA_uchar data = std::move(buffer_pool._buffers.back());
+    buffer_pool._buffers.pop_back();
+    return data;
+  }
+  return PTA_uchar::empty_array(0);
+}
+
+/**
+ * Releases the datagram's buffer.  If no other Datagram shares it, it is
+ * returned to the current thread's pool, unless the pool is full or the
+ * buffer has grown too large.
+ */
+void Datagram::
+free_buffer() {
+  if (_data != nullptr && _data.get_ref_count() == 1 &&
+      !buffer_pool_destroyed) {
+    size_t capacity = _data.v().capacity();
+    if (capacity != 0 &&
+        capacity <= (size_t)datagram_pool_max_capacity &&
+        buffer_pool._buffers.size() < (size_t)datagram_pool_size) {
+      _data.v().clear();
+      buffer_pool._buffers.push_back(std::move(_data));
+    }
+  }
+  _data.clear();
+}
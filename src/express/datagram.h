@@ -34,6 +34,12 @@
  *
  * A Datagram is itself headerless; it is simply a collection of data
  * elements.
+ *
+ * When a Datagram that is the only owner of its buffer is destroyed or
+ * cleared, the buffer is kept in a small pool belonging to the current
+ * thread, and handed to the next Datagram that this thread fills up.  This
+ * way, code that builds many short-lived messages doesn't have to allocate
+ * and grow a new buffer for each one.
  */
 class EXPCL_PANDA_EXPRESS Datagram : public TypedObject {
 PUBLISHED:
@@ -48,6 +54,9 @@ PUBLISHED:
   Datagram &operator = (Datagram &&from) noexcept = default;
 
   virtual void clear();
+  void reset();
+  void reserve(size_t size);
+  INLINE size_t get_capacity() const;
   void dump_hex(std::ostream &out, unsigned int indent=0) const;
 
   INLINE void add_bool(bool value);
@@ -117,6 +126,9 @@ PUBLISHED:
   void write(std::ostream &out, unsigned int indent=0) const;
 
 private:
+  static PTA_uchar alloc_buffer();
+  void free_buffer();
+
   PTA_uchar _data;
 
 #ifdef STDFLOAT_DOUBLE
@@ -90,3 +90,34 @@ std::streampos DatagramGenerator::
 get_file_pos() {
   return 0;
 }
+
+/**
+ * Moves the read position within the data stream, so that the next call to
+ * get_datagram() returns the datagram that begins at the indicated position,
+ * as with istream::seekg().  Returns true on success, or false if the
+ * position could not be changed, which is always the case for
+ * DatagramGenerators that do not read from a seekable file.
+ */
+bool DatagramGenerator::
+seek_file_pos(std::streamoff offset, std::ios::seekdir dir) {
+  return false;
+}
+
+/**
+ * Returns the memory mapping of the source file that the datagrams are being
+ * read from, if any, or NULL if the source is not mapped.
+ */
+VirtualFileMapping *DatagramGenerator::
+get_mapping() {
+  return nullptr;
+}
+
+/**
+ * If the source is mapped (see get_mapping()), returns a pointer to the
+ * contents of the datagram most recently returned by get_datagram() within
+ * the mapping.  Returns NULL if the source is not mapped.
+ */
+const unsigned char *DatagramGenerator::
+get_mapped_datagram_data() {
+  return nullptr;
+}
@@ -22,6 +22,7 @@ class SubfileInfo;
 class FileReference;
 class Filename;
 class VirtualFile;
+class VirtualFileMapping;
 
 /**
  * This class defines the abstract interace to any source of datagrams,
@@ -42,6 +43,13 @@ PUBLISHED:
   virtual const FileReference *get_file();
   virtual VirtualFile *get_vfile();
   virtual std::streampos get_file_pos();
+
+public:
+  virtual bool seek_file_pos(std::streamoff offset,
+                             std::ios::seekdir dir = std::ios::beg);
+
+  virtual VirtualFileMapping *get_mapping();
+  virtual const unsigned char *get_mapped_datagram_data();
 };
 
 #include "datagramGenerator.I"
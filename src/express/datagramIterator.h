@@ -83,7 +83,28 @@ PUBLISHED:
   void output(std::ostream &out) const;
   void write(std::ostream &out, unsigned int indent=0) const;
 
+public:
+  // These extract primitive values without checking whether they run past
+  // the end of the datagram.  They may only be used for a span of data that
+  // has first been validated with has_remaining().
+  INLINE bool has_remaining(size_t size) const;
+
+  INLINE int8_t get_int8_unchecked();
+  INLINE uint8_t get_uint8_unchecked();
+  INLINE int16_t get_int16_unchecked();
+  INLINE int32_t get_int32_unchecked();
+  INLINE int64_t get_int64_unchecked();
+  INLINE uint16_t get_uint16_unchecked();
+  INLINE uint32_t get_uint32_unchecked();
+  INLINE uint64_t get_uint64_unchecked();
+  INLINE PN_float32 get_float32_unchecked();
+  INLINE PN_float64 get_float64_unchecked();
+  INLINE PN_stdfloat get_stdfloat_unchecked();
+
 private:
+  template<class Type>
+  INLINE Type do_get_unchecked();
+
   const Datagram *_datagram;
   size_t _current_index;
 
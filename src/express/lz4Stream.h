@@ -0,0 +1,80 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file lz4Stream.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef LZ4STREAM_H
+#define LZ4STREAM_H
+
+#include "pandabase.h"
+
+// This module is not compiled if LZ4 is not available.
+#ifdef HAVE_LZ4
+
+#include "lz4StreamBuf.h"
+
+/**
+ * An input stream object that uses LZ4 to decompress the input from another
+ * source stream on-the-fly.  This is the LZ4 equivalent of
+ * IDecompressStream.  LZ4 compresses less than zlib, but decompresses many
+ * times faster.
+ *
+ * Seeking is not supported, except back to the beginning.
+ */
+class EXPCL_PANDA_EXPRESS ILz4DecompressStream : public std::istream {
+PUBLISHED:
+  INLINE ILz4DecompressStream();
+  INLINE explicit ILz4DecompressStream(std::istream *source, bool owns_source,
+                                       std::streamsize source_length = -1);
+
+#if _MSC_VER >= 1800
+  INLINE ILz4DecompressStream(const ILz4DecompressStream &copy) = delete;
+#endif
+
+  INLINE ILz4DecompressStream &open(std::istream *source, bool owns_source,
+                                    std::streamsize source_length = -1);
+  INLINE ILz4DecompressStream &close();
+
+private:
+  Lz4StreamBuf _buf;
+};
+
+/**
+ * An output stream object that uses LZ4 to compress data to another
+ * destination stream on-the-fly.  This is the LZ4 equivalent of
+ * OCompressStream.
+ *
+ * Seeking is not supported.
+ */
+class EXPCL_PANDA_EXPRESS OLz4CompressStream : public std::ostream {
+PUBLISHED:
+  INLINE OLz4CompressStream();
+  INLINE explicit OLz4CompressStream(std::ostream *dest, bool owns_dest,
+                                     int compression_level = 0);
+
+#if _MSC_VER >= 1800
+  INLINE OLz4CompressStream(const OLz4CompressStream &copy) = delete;
+#endif
+
+  INLINE OLz4CompressStream &open(std::ostream *dest, bool owns_dest,
+                                  int compression_level = 0);
+  INLINE OLz4CompressStream &close();
+
+private:
+  Lz4StreamBuf _buf;
+};
+
+#include "lz4Stream.I"
+
+#endif  // HAVE_LZ4
+
+
+#endif
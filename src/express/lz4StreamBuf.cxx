@@ -0,0 +1,404 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file lz4StreamBuf.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "lz4StreamBuf.h"
+
+#ifdef HAVE_LZ4
+
+#include "pnotify.h"
+#include "config_express.h"
+
+using std::ios;
+using std::streamoff;
+using std::streampos;
+
+static const size_t lz4_buffer_size = 4096;
+
+/**
+ *
+ */
+Lz4StreamBuf::
+Lz4StreamBuf() {
+  _source = nullptr;
+  _owns_source = false;
+  _dest = nullptr;
+  _owns_dest = false;
+  _dctx = nullptr;
+  _cctx = nullptr;
+  _total_out = 0;
+  _read_eof = true;
+  _in_pos = 0;
+  _in_size = 0;
+  _compress_buffer = nullptr;
+  _compress_buffer_size = 0;
+
+  _buffer = (char *)PANDA_MALLOC_ARRAY(lz4_buffer_size);
+  char *ebuf = _buffer + lz4_buffer_size;
+  setg(_buffer, ebuf, ebuf);
+  setp(_buffer, ebuf);
+}
+
+/**
+ *
+ */
+Lz4StreamBuf::
+~Lz4StreamBuf() {
+  close_read();
+  close_write();
+  PANDA_FREE_ARRAY(_buffer);
+}
+
+/**
+ *
+ */
+void Lz4StreamBuf::
+open_read(std::istream *source, bool owns_source, std::streamsize source_length) {
+  _source = source;
+  _source_length = source_length;
+  _source_bytes_left = source_length;
+  _owns_source = owns_source;
+  _total_out = 0;
+  _read_eof = false;
+  _in_pos = 0;
+  _in_size = 0;
+
+  size_t result = LZ4F_createDecompressionContext(&_dctx, LZ4F_VERSION);
+  if (LZ4F_isError(result)) {
+    show_lz4_error("LZ4F_createDecompressionContext", result);
+    _dctx = nullptr;
+    close_read();
+  }
+  thread_consider_yield();
+}
+
+/**
+ *
+ */
+void Lz4StreamBuf::
+close_read() {
+  _source_bytes_left = 0;
+  _read_eof = true;
+
+  if (_dctx != nullptr) {
+    LZ4F_freeDecompressionContext(_dctx);
+    _dctx = nullptr;
+  }
+
+  if (_source != nullptr) {
+    if (_owns_source) {
+      delete _source;
+      _owns_source = false;
+    }
+    _source = nullptr;
+  }
+}
+
+/**
+ * Attaches the indicated destination stream, which will receive
+ * LZ4-compressed data.  A compression_level of 0 selects the default fast
+ * mode; 3 or higher selects the slower high-compression mode, which
+ * decompresses just as quickly.
+ */
+void Lz4StreamBuf::
+open_write(std::ostream *dest, bool owns_dest, int compression_level) {
+  _dest = dest;
+  _owns_dest = owns_dest;
+
+  size_t result = LZ4F_createCompressionContext(&_cctx, LZ4F_VERSION);
+  if (LZ4F_isError(result)) {
+    show_lz4_error("LZ4F_createCompressionContext", result);
+    _cctx = nullptr;
+    close_write();
+    return;
+  }
+
+  LZ4F_preferences_t prefs;
+  memset(&prefs, 0, sizeof(prefs));
+  prefs.compressionLevel = compression_level;
+  prefs.frameInfo.contentChecksumFlag = LZ4F_contentChecksumEnabled;
+
+  _compress_buffer_size = std::max(LZ4F_compressBound(lz4_buffer_size, &prefs),
+                                   (size_t)LZ4F_HEADER_SIZE_MAX);
+  _compress_buffer = (char *)PANDA_MALLOC_ARRAY(_compress_buffer_size);
+
+  result = LZ4F_compressBegin(_cctx, _compress_buffer, _compress_buffer_size, &prefs);
+  flush_dest(result, "LZ4F_compressBegin");
+  thread_consider_yield();
+}
+
+/**
+ *
+ */
+void Lz4StreamBuf::
+close_write() {
+  if (_dest != nullptr) {
+    if (_cctx != nullptr) {
+      size_t n = pptr() - pbase();
+      write_chars(pbase(), n);
+      pbump(-(int)n);
+
+      size_t result = LZ4F_compressEnd(_cctx, _compress_buffer, _compress_buffer_size, nullptr);
+      flush_dest(result, "LZ4F_compressEnd");
+
+      LZ4F_freeCompressionContext(_cctx);
+      _cctx = nullptr;
+    }
+    thread_consider_yield();
+
+    if (_owns_dest) {
+      delete _dest;
+      _owns_dest = false;
+    }
+    _dest = nullptr;
+  }
+
+  if (_compress_buffer != nullptr) {
+    PANDA_FREE_ARRAY(_compress_buffer);
+    _compress_buffer = nullptr;
+    _compress_buffer_size = 0;
+  }
+}
+
+/**
+ * Implements seeking within the stream.  Lz4StreamBuf only allows seeking
+ * back to the beginning of the stream.
+ */
+streampos Lz4StreamBuf::
+seekoff(streamoff off, ios_seekdir dir, ios_openmode which) {
+  if (which != ios::in || _source == nullptr) {
+    // We can only do this with the input stream.
+    return -1;
+  }
+
+  // Determine the current position.
+  size_t n = egptr() - gptr();
+  streampos gpos = _total_out - n;
+
+  // Implement tellg() and seeks to current position.
+  if ((dir == ios::cur && off == 0) ||
+      (dir == ios::beg && off == gpos)) {
+    return gpos;
+  }
+
+  if (off != 0 || dir != ios::beg) {
+    // We only know how to reposition to the beginning.
+    return -1;
+  }
+
+  gbump(n);
+
+  if (_source->rdbuf()->pubseekpos(0, ios::in) == (streampos)0) {
+    _source->clear();
+    _source_bytes_left = _source_length;
+    _total_out = 0;
+    _in_pos = 0;
+    _in_size = 0;
+    if (_dctx != nullptr) {
+      LZ4F_resetDecompressionContext(_dctx);
+    }
+    _read_eof = (_dctx == nullptr);
+    return 0;
+  }
+
+  return -1;
+}
+
+/**
+ * Implements seeking within the stream.  Lz4StreamBuf only allows seeking
+ * back to the beginning of the stream.
+ */
+streampos Lz4StreamBuf::
+seekpos(streampos pos, ios_openmode which) {
+  return seekoff(pos, ios::beg, which);
+}
+
+/**
+ * Called by the system ostream implementation when its internal buffer is
+ * filled, plus one character.
+ */
+int Lz4StreamBuf::
+overflow(int ch) {
+  size_t n = pptr() - pbase();
+  if (n != 0) {
+    write_chars(pbase(), n);
+    pbump(-(int)n);
+  }
+
+  if (ch != EOF) {
+    // Write one more character.
+    char c = ch;
+    write_chars(&c, 1);
+  }
+
+  return 0;
+}
+
+/**
+ * Called by the system iostream implementation to implement a flush
+ * operation.
+ */
+int Lz4StreamBuf::
+sync() {
+  if (_source != nullptr) {
+    size_t n = egptr() - gptr();
+    gbump(n);
+  }
+
+  if (_dest != nullptr && _cctx != nullptr) {
+    size_t n = pptr() - pbase();
+    write_chars(pbase(), n);
+    pbump(-(int)n);
+
+    size_t result = LZ4F_flush(_cctx, _compress_buffer, _compress_buffer_size, nullptr);
+    flush_dest(result, "LZ4F_flush");
+    _dest->flush();
+  }
+
+  return 0;
+}
+
+/**
+ * Called by the system istream implementation when its internal buffer needs
+ * more characters.
+ */
+int Lz4StreamBuf::
+underflow() {
+  // Sometimes underflow() is called even if the buffer is not empty.
+  if (gptr() >= egptr()) {
+    size_t buffer_size = egptr() - eback();
+    gbump(-(int)buffer_size);
+
+    size_t num_bytes = buffer_size;
+    size_t read_count = read_chars(gptr(), buffer_size);
+
+    if (read_count != num_bytes) {
+      // Oops, we didn't read what we thought we would.
+      if (read_count == 0) {
+        gbump(num_bytes);
+        return EOF;
+      }
+
+      // Slide what we did read to the top of the buffer.
+      nassertr(read_count < num_bytes, EOF);
+      size_t delta = num_bytes - read_count;
+      memmove(gptr() + delta, gptr(), read_count);
+      gbump(delta);
+    }
+  }
+
+  return (unsigned char)*gptr();
+}
+
+/**
+ * Gets some characters from the source stream.
+ */
+size_t Lz4StreamBuf::
+read_chars(char *start, size_t length) {
+  if (_read_eof || _dctx == nullptr) {
+    return 0;
+  }
+
+  size_t bytes_read = 0;
+  size_t hint = 1;
+
+  while (bytes_read < length) {
+    bool source_eof = (_source_bytes_left == 0 || _source->eof() || _source->fail());
+    if (_in_pos >= _in_size && !source_eof) {
+      std::streamsize read_count;
+      if (_source_bytes_left >= 0) {
+        // Don't read more than the specified limit.
+        _source->read(_decompress_buffer,
+          std::min(_source_bytes_left, (std::streamsize)decompress_buffer_size));
+        read_count = _source->gcount();
+        _source_bytes_left -= read_count;
+      } else {
+        _source->read(_decompress_buffer, decompress_buffer_size);
+        read_count = _source->gcount();
+      }
+      _in_pos = 0;
+      _in_size = (size_t)read_count;
+    }
+
+    size_t dst_size = length - bytes_read;
+    size_t src_size = _in_size - _in_pos;
+    hint = LZ4F_decompress(_dctx, start + bytes_read, &dst_size,
+                           _decompress_buffer + _in_pos, &src_size, nullptr);
+    thread_consider_yield();
+
+    if (LZ4F_isError(hint)) {
+      show_lz4_error("LZ4F_decompress", hint);
+      _read_eof = true;
+      break;
+    }
+
+    bytes_read += dst_size;
+    _in_pos += src_size;
+
+    if (dst_size == 0 && src_size == 0 && _in_pos >= _in_size) {
+      // No progress is possible without more input, and there is no more
+      // input.  A nonzero hint means the last frame was not complete.
+      if (hint != 0) {
+        express_cat.warning()
+          << "LZ4 stream is truncated.\n";
+      }
+      _read_eof = true;
+      break;
+    }
+  }
+
+  _total_out += bytes_read;
+  return bytes_read;
+}
+
+/**
+ * Compresses some characters and sends them to the dest stream.
+ */
+void Lz4StreamBuf::
+write_chars(const char *start, size_t length) {
+  // _compress_buffer is only guaranteed to be big enough for lz4_buffer_size
+  // bytes of input at a time.
+  while (length > 0) {
+    size_t count = std::min(length, lz4_buffer_size);
+    size_t result = LZ4F_compressUpdate(_cctx, _compress_buffer, _compress_buffer_size,
+                                        start, count, nullptr);
+    flush_dest(result, "LZ4F_compressUpdate");
+    thread_consider_yield();
+    start += count;
+    length -= count;
+  }
+}
+
+/**
+ * Writes the indicated number of bytes from _compress_buffer to the dest
+ * stream, which are the result of a call to the indicated LZ4F function.
+ */
+void Lz4StreamBuf::
+flush_dest(size_t result, const char *function) {
+  if (LZ4F_isError(result)) {
+    show_lz4_error(function, result);
+  } else if (result != 0) {
+    _dest->write(_compress_buffer, result);
+  }
+}
+
+/**
+ * Reports a recent error code returned by LZ4.
+ */
+void Lz4StreamBuf::
+show_lz4_error(const char *function, size_t error_code) {
+  express_cat.warning()
+    << "LZ4 error in " << function << ": "
+    << LZ4F_getErrorName(error_code) << "\n";
+}
+
+#endif  // HAVE_LZ4
@@ -0,0 +1,88 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file lz4StreamBuf.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef LZ4STREAMBUF_H
+#define LZ4STREAMBUF_H
+
+#include "pandabase.h"
+
+// This module is not compiled if LZ4 is not available.
+#ifdef HAVE_LZ4
+
+#include <lz4frame.h>
+
+/**
+ * The streambuf object that implements ILz4DecompressStream and
+ * OLz4CompressStream.  The data is stored in the LZ4 frame format.
+ */
+class EXPCL_PANDA_EXPRESS Lz4StreamBuf : public std::streambuf {
+public:
+  Lz4StreamBuf();
+  virtual ~Lz4StreamBuf();
+
+  void open_read(std::istream *source, bool owns_source,
+                 std::streamsize source_length = -1);
+  void close_read();
+
+  void open_write(std::ostream *dest, bool owns_dest, int compression_level);
+  void close_write();
+
+  virtual std::streampos seekoff(std::streamoff off, ios_seekdir dir, ios_openmode which);
+  virtual std::streampos seekpos(std::streampos pos, ios_openmode which);
+
+protected:
+  virtual int overflow(int c);
+  virtual int sync();
+  virtual int underflow();
+
+private:
+  size_t read_chars(char *start, size_t length);
+  void write_chars(const char *start, size_t length);
+  void flush_dest(size_t result, const char *function);
+  void show_lz4_error(const char *function, size_t error_code);
+
+private:
+  std::istream *_source;
+  std::streamsize _source_length = -1;
+  std::streamsize _source_bytes_left = -1;
+  bool _owns_source;
+
+  std::ostream *_dest;
+  bool _owns_dest;
+
+  LZ4F_dctx *_dctx;
+  LZ4F_cctx *_cctx;
+
+  // The number of uncompressed bytes returned by read_chars() so far.
+  size_t _total_out;
+  bool _read_eof;
+
+  char *_buffer;
+
+  // Holds compressed input that LZ4 has not yet consumed.
+  enum {
+    decompress_buffer_size = 16384
+  };
+  char _decompress_buffer[decompress_buffer_size];
+  size_t _in_pos;
+  size_t _in_size;
+
+  // Holds compressed output on its way to the dest stream.  It is sized by
+  // LZ4F_compressBound() to take the result of compressing a full _buffer.
+  char *_compress_buffer;
+  size_t _compress_buffer_size;
+};
+
+#endif  // HAVE_LZ4
+
+#endif
@@ -18,16 +18,28 @@
 #include "streamReader.h"
 #include "datagram.h"
 #include "zStream.h"
+#include "zstdStream.h"
+#include "lz4Stream.h"
 #include "encryptStream.h"
 #include "virtualFileSystem.h"
 #include "virtualFile.h"
+#include "patomic.h"
 
 #include <algorithm>
 #include <iterator>
+#include <sstream>
 #include <time.h>
 
+#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
+#include <thread>
+#endif
+
 #include "openSSLWrapper.h"
 
+#ifdef HAVE_ZSTD
+#include <zdict.h>
+#endif
+
 using std::ios;
 using std::iostream;
 using std::istream;
@@ -50,8 +62,11 @@ const size_t Multifile::_header_size = 6;
 // version may still be read.
 const int Multifile::_current_major_ver = 1;
 
-const int Multifile::_current_minor_ver = 1;
+const int Multifile::_current_minor_ver = 2;
 // Bumped to version 1.1 on 6806 to add timestamps.
+// Bumped to version 1.2 on 2026-10-18 to add zstd and LZ4 compression.  A
+// Multifile that uses neither, and has no zstd dictionary, is still written
+// as version 1.1, so that older readers can read it.
 
 // To confirm that the supplied password matches, we write the Mutifile magic
 // header at the beginning of the encrypted stream.  I suppose this does
@@ -73,7 +88,8 @@ const size_t Multifile::_encrypt_header_size = 6;
  * version number uint32     Scale factor.  This scales all address references
  * within the file.  Normally 1, this may be set larger to support Multifiles
  * larger than 4GB. uint32     An overall modification timestamp for the
- * entire multifile.
+ * entire multifile.  uint32     The length in bytes of the zstd dictionary
+ * (version 1.2 and later).  char[n]    The zstd dictionary itself.
  */
 
 /*
@@ -89,7 +105,9 @@ const size_t Multifile::_encrypt_header_size = 6;
  * subfile's data record.  uint16     The Subfile::_flags member.  [uint32]
  * The original, uncompressed and unencrypted length of the subfile, if it is
  * compressed or encrypted.  This field is only present if one or both of the
- * SF_compressed or SF_encrypted bits are set in _flags.  uint32     A
+ * SF_compressed or SF_encrypted bits are set in _flags.  If SF_compressed is
+ * set, the SF_zstd or SF_lz4 bits select the algorithm; zlib is used if
+ * neither is set.  uint32     A
  * modification timestamp for the subfile.  uint16     The length in bytes of
  * the subfile's name.  char[n]    The subfile's name.  (3) Zero or more data
  * entries, one for each subfile.  These may appear at any point within the
@@ -115,6 +133,13 @@ Multifile() :
               "be loaded quickly, without paying the cost of an expensive hash on "
               "each subfile in order to decrypt it."));
 
+  ConfigVariableInt multifile_num_threads
+    ("multifile-num-threads", 0,
+     PRC_DESC("The number of threads a Multifile uses to compress and encrypt "
+              "new subfiles while writing, and to extract or verify subfiles "
+              "in bulk.  Set this to 0 to use one thread per CPU core, or 1 to "
+              "do everything in the calling thread."));
+
   _read = nullptr;
   _write = nullptr;
   _offset = 0;
@@ -128,8 +153,12 @@ Multifile() :
   _record_timestamp = true;
   _scale_factor = 1;
   _new_scale_factor = 1;
+  _compression_type = CT_zlib;
   _encryption_flag = false;
   _encryption_iteration_count = multifile_encryption_iteration_count;
+  _num_threads = 1;
+  set_num_threads(multifile_num_threads);
+  _name_index_valid = true;
   _file_major_ver = 0;
   _file_minor_ver = 0;
 
@@ -353,6 +382,7 @@ close() {
   _timestamp_dirty = false;
   _scale_factor = 1;
   _new_scale_factor = 1;
+  _zstd_dictionary.clear();
   _encryption_flag = false;
   _file_major_ver = 0;
   _file_minor_ver = 0;
@@ -400,6 +430,113 @@ set_scale_factor(size_t scale_factor) {
   _new_scale_factor = scale_factor;
 }
 
+/**
+ * Specifies a dictionary to compress zstd subfiles with; see
+ * set_compression_type().  A dictionary trained on typical subfile contents
+ * (see train_zstd_dictionary()) greatly improves the compression of many
+ * small, similar subfiles, such as bam files.  The dictionary is stored in
+ * the Multifile header, and is applied to every zstd subfile.
+ *
+ * Since the subfiles already in the Multifile depend on the dictionary they
+ * were compressed with, this may only be called on a newly-created
+ * Multifile, before anything has been written to it.
+ */
+void Multifile::
+set_zstd_dictionary(const vector_uchar &dictionary) {
+  nassertv(is_write_valid());
+  nassertv(_next_index == (streampos)0);
+  _zstd_dictionary = dictionary;
+}
+
+/**
+ * Sets the number of threads that flush() uses to compress and encrypt new
+ * subfiles, and that extract_subfiles() and verify_subfiles() use to read
+ * them back.  A value of 0 means one thread per CPU core.  The Multifile's
+ * on-disk format is the same regardless of this setting.
+ */
+void Multifile::
+set_num_threads(int num_threads) {
+  if (num_threads <= 0) {
+#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
+    num_threads = max((int)std::thread::hardware_concurrency(), 1);
+#else
+    num_threads = 1;
+#endif
+  }
+  _num_threads = num_threads;
+}
+
+/**
+ * Trains a zstd dictionary of at most max_size bytes on the subfiles that
+ * have been added by filename but not yet written, and makes it the
+ * dictionary for this Multifile, as if by set_zstd_dictionary().  Returns
+ * true on success, false if zstd is not available, there are too few samples
+ * or training fails.
+ */
+bool Multifile::
+train_zstd_dictionary(size_t max_size) {
+  nassertr(is_write_valid(), false);
+  nassertr(_next_index == (streampos)0, false);
+
+#ifndef HAVE_ZSTD
+  express_cat.warning()
+    << "zstd not compiled in; cannot train a dictionary.\n";
+  return false;
+
+#else  // HAVE_ZSTD
+  // Concatenate the contents of the pending subfiles.  zstd only looks at
+  // the first 128 KB of each sample anyway.
+  static const size_t max_sample_size = 128 * 1024;
+  vector_uchar samples;
+  pvector<size_t> sample_sizes;
+
+  for (Subfile *subfile : _new_subfiles) {
+    if (subfile->_source_filename.empty()) {
+      continue;
+    }
+    pifstream in;
+    if (!subfile->_source_filename.open_read(in)) {
+      continue;
+    }
+    size_t start = samples.size();
+    samples.resize(start + max_sample_size);
+    in.read((char *)samples.data() + start, max_sample_size);
+    size_t count = (size_t)in.gcount();
+    samples.resize(start + count);
+    if (count != 0) {
+      sample_sizes.push_back(count);
+    }
+  }
+
+  if (sample_sizes.size() < 8) {
+    express_cat.warning()
+      << "Too few subfiles to train a zstd dictionary.\n";
+    return false;
+  }
+
+  vector_uchar dictionary(max_size);
+  size_t result = ZDICT_trainFromBuffer(dictionary.data(), max_size,
+                                        samples.data(), sample_sizes.data(),
+                                        (unsigned int)sample_sizes.size());
+  if (ZDICT_isError(result)) {
+    express_cat.warning()
+      << "Unable to train zstd dictionary: "
+      << ZDICT_getErrorName(result) << "\n";
+    return false;
+  }
+
+  dictionary.resize(result);
+  _zstd_dictionary = std::move(dictionary);
+
+  if (express_cat.is_debug()) {
+    express_cat.debug()
+      << "Trained " << result << "-byte zstd dictionary on "
+      << sample_sizes.size() << " subfiles.\n";
+  }
+  return true;
+#endif  // HAVE_ZSTD
+}
+
 /**
  * Adds a file on disk as a subfile to the Multifile.  The file named by
  * filename will be read and added to the Multifile at the next call to
@@ -1138,9 +1275,10 @@ flush() {
     }
 
   } else {
-    if (_file_minor_ver != _current_minor_ver) {
+    if (_file_minor_ver < 1 || (_file_minor_ver < 2 && needs_minor_ver_2())) {
       // If we *do* have an index already, but this is an old version
-      // multifile, we have to completely rewrite it anyway.
+      // multifile, or we are adding subfiles that an older version can't
+      // describe, we have to completely rewrite it anyway.
       return repack();
     }
   }
@@ -1200,30 +1338,44 @@ flush() {
     nassertr(_next_index == _write->tellp(), false);
     _next_index = pad_to_streampos(_next_index);
 
-    // All right, now write out each subfile's data.
-    for (pi = _new_subfiles.begin(); pi != _new_subfiles.end(); ++pi) {
-      Subfile *subfile = (*pi);
+    // All right, now write out each subfile's data.  With more than one
+    // thread, the subfiles are compressed and encrypted in memory a batch at
+    // a time, in parallel, and then written out in order; the batches keep
+    // the memory held by the packed data bounded.
+    size_t batch_size = (_num_threads > 1) ? (size_t)_num_threads * 4 : _new_subfiles.size();
+    for (size_t bi = 0; bi < _new_subfiles.size(); bi += batch_size) {
+      size_t batch_end = min(bi + batch_size, _new_subfiles.size());
+      if (_num_threads > 1) {
+        Subfile **batch = &_new_subfiles[bi];
+        run_parallel(batch_end - bi, [&] (size_t i) {
+          batch[i]->pack_data(this);
+        });
+      }
 
-      if (_read != nullptr) {
-        _read->acquire();
-        _next_index = subfile->write_data(*_write, _read->get_istream(),
-                                          _next_index, this);
-        _read->release();
+      for (size_t i = bi; i < batch_end; ++i) {
+        Subfile *subfile = _new_subfiles[i];
 
-      } else {
-        _next_index = subfile->write_data(*_write, nullptr, _next_index, this);
-      }
+        if (_read != nullptr) {
+          _read->acquire();
+          _next_index = subfile->write_data(*_write, _read->get_istream(),
+                                            _next_index, this);
+          _read->release();
 
-      nassertr(_next_index == _write->tellp(), false);
-      _next_index = pad_to_streampos(_next_index);
-      if (subfile->is_data_invalid()) {
-        wrote_ok = false;
-      }
+        } else {
+          _next_index = subfile->write_data(*_write, nullptr, _next_index, this);
+        }
+
+        nassertr(_next_index == _write->tellp(), false);
+        _next_index = pad_to_streampos(_next_index);
+        if (subfile->is_data_invalid()) {
+          wrote_ok = false;
+        }
 
-      if (!subfile->is_cert_special()) {
-        _last_data_byte = max(_last_data_byte, subfile->get_last_byte_pos());
+        if (!subfile->is_cert_special()) {
+          _last_data_byte = max(_last_data_byte, subfile->get_last_byte_pos());
+        }
+        nassertr(_next_index == _write->tellp(), false);
       }
-      nassertr(_next_index == _write->tellp(), false);
     }
 
     // Now go back and fill in the proper addresses for the data start.  We
@@ -1238,6 +1390,10 @@ flush() {
     _new_subfiles.clear();
   }
 
+  if (!_name_index_valid) {
+    build_name_index();
+  }
+
   // Also update the overall timestamp.
   if (_timestamp_dirty) {
     nassertr(!_write->fail(), false);
@@ -1367,6 +1523,14 @@ int Multifile::
 find_subfile(const string &subfile_name) const {
   Subfile find_subfile;
   find_subfile._name = standardize_subfile_name(subfile_name);
+  if (_name_index_valid) {
+    NameIndex::const_iterator ni = _name_index.find(find_subfile._name);
+    if (ni == _name_index.end()) {
+      return -1;
+    }
+    return (*ni).second;
+  }
+
   Subfiles::const_iterator fi;
   fi = _subfiles.find(&find_subfile);
   if (fi == _subfiles.end()) {
@@ -1383,6 +1547,13 @@ find_subfile(const string &subfile_name) const {
  */
 bool Multifile::
 has_directory(const string &subfile_name) const {
+  if (_name_index_valid) {
+    if (subfile_name.empty()) {
+      return !_subfiles.empty();
+    }
+    return _directories.find(subfile_name) != _directories.end();
+  }
+
   string prefix = subfile_name;
   if (!prefix.empty()) {
     prefix += '/';
@@ -1463,6 +1634,7 @@ remove_subfile(int index) {
   subfile->_flags |= SF_deleted;
   _removed_subfiles.push_back(subfile);
   _subfiles.erase(_subfiles.begin() + index);
+  _name_index_valid = false;
 
   _timestamp = time(nullptr);
   _timestamp_dirty = true;
@@ -1519,6 +1691,23 @@ is_subfile_compressed(int index) const {
   return (_subfiles[index]->_flags & SF_compressed) != 0;
 }
 
+/**
+ * Returns the algorithm that the indicated subfile has been compressed with.
+ * This is only meaningful if is_subfile_compressed() returns true.
+ */
+Multifile::CompressionType Multifile::
+get_subfile_compression_type(int index) const {
+  nassertr(index >= 0 && index < (int)_subfiles.size(), CT_zlib);
+  int flags = _subfiles[index]->_flags;
+  if ((flags & SF_zstd) != 0) {
+    return CT_zstd;
+  } else if ((flags & SF_lz4) != 0) {
+    return CT_lz4;
+  } else {
+    return CT_zlib;
+  }
+}
+
 /**
  * Returns true if the indicated subfile has been encrypted when stored within
  * the archive, false otherwise.
@@ -1704,6 +1893,90 @@ extract_subfile_to(int index, ostream &out) {
   return (!out.fail());
 }
 
+/**
+ * Extracts all of the subfiles to the indicated directory, each to the
+ * filename given by its subfile name.  The subfiles are decompressed and
+ * written by as many threads as specified by set_num_threads().  Returns true
+ * if every subfile was extracted successfully, false if any failed.
+ */
+bool Multifile::
+extract_subfiles(const Filename &dirname) {
+  nassertr(is_read_valid(), false);
+
+  // Make sure any pending subfiles are written first, so that the worker
+  // threads only need to read.
+  if (!_new_subfiles.empty() && !flush()) {
+    return false;
+  }
+
+  patomic<int> num_failed(0);
+  run_parallel(_subfiles.size(), [&] (size_t i) {
+    Filename filename(dirname, _subfiles[i]->_name);
+    if (!extract_subfile((int)i, filename)) {
+      ++num_failed;
+    }
+  });
+
+  if (num_failed != 0) {
+    express_cat.info()
+      << "Failed to extract " << num_failed << " subfiles from "
+      << _multifile_name << ".\n";
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Reads back every subfile in the Multifile, decrypting and decompressing it
+ * as necessary, and confirms that each one can be read in its entirety and
+ * has the expected length.  The subfiles are checked by as many threads as
+ * specified by set_num_threads().  Returns the number of subfiles that failed
+ * the check; 0 means the Multifile is intact.
+ *
+ * This does not check signatures; see get_num_signatures() for that.
+ */
+int Multifile::
+verify_subfiles() {
+  nassertr(is_read_valid(), -1);
+
+  if (!_new_subfiles.empty() && !flush()) {
+    return -1;
+  }
+
+  patomic<int> num_failed(0);
+  run_parallel(_subfiles.size(), [&] (size_t i) {
+    Subfile *subfile = _subfiles[i];
+    istream *in = open_read_subfile(subfile);
+    if (in == nullptr) {
+      ++num_failed;
+      return;
+    }
+
+    static const size_t buffer_size = 4096;
+    char buffer[buffer_size];
+
+    size_t length = 0;
+    in->read(buffer, buffer_size);
+    size_t count = in->gcount();
+    while (count != 0) {
+      length += count;
+      in->read(buffer, buffer_size);
+      count = in->gcount();
+    }
+
+    bool failed = (in->fail() && !in->eof());
+    close_read_subfile(in);
+
+    if (failed || length != subfile->_uncompressed_length) {
+      express_cat.info()
+        << "Subfile " << subfile->_name << " is corrupt.\n";
+      ++num_failed;
+    }
+  });
+
+  return num_failed;
+}
+
 /**
  * Performs a byte-for-byte comparison of the indicated file on disk with the
  * nth subfile.  Returns true if the files are equivalent, or false if they
@@ -1990,14 +2263,40 @@ pad_to_streampos(streampos fpos) {
 void Multifile::
 add_new_subfile(Subfile *subfile, int compression_level) {
   if (compression_level != 0) {
+    switch (_compression_type) {
+    case CT_zstd:
+#ifndef HAVE_ZSTD
+      express_cat.warning()
+        << "zstd not compiled in; cannot generate zstd-compressed multifiles.\n";
+      compression_level = 0;
+#else  // HAVE_ZSTD
+      subfile->_flags |= SF_compressed | SF_zstd;
+      subfile->_compression_level = compression_level;
+#endif  // HAVE_ZSTD
+      break;
+
+    case CT_lz4:
+#ifndef HAVE_LZ4
+      express_cat.warning()
+        << "LZ4 not compiled in; cannot generate LZ4-compressed multifiles.\n";
+      compression_level = 0;
+#else  // HAVE_LZ4
+      subfile->_flags |= SF_compressed | SF_lz4;
+      subfile->_compression_level = compression_level;
+#endif  // HAVE_LZ4
+      break;
+
+    default:
 #ifndef HAVE_ZLIB
-    express_cat.warning()
-      << "zlib not compiled in; cannot generated compressed multifiles.\n";
-    compression_level = 0;
+      express_cat.warning()
+        << "zlib not compiled in; cannot generated compressed multifiles.\n";
+      compression_level = 0;
 #else  // HAVE_ZLIB
-    subfile->_flags |= SF_compressed;
-    subfile->_compression_level = compression_level;
+      subfile->_flags |= SF_compressed;
+      subfile->_compression_level = compression_level;
 #endif  // HAVE_ZLIB
+      break;
+    }
   }
 
 #ifdef HAVE_OPENSSL
@@ -2013,6 +2312,7 @@ add_new_subfile(Subfile *subfile, int compression_level) {
   }
 
   std::pair<Subfiles::iterator, bool> insert_result = _subfiles.insert(subfile);
+  _name_index_valid = false;
   if (!insert_result.second) {
     // Hmm, unable to insert.  There must already be a subfile by that name.
     // Remove the old one.
@@ -2077,7 +2377,30 @@ open_read_subfile(Subfile *subfile) {
 #endif  // HAVE_OPENSSL
   }
 
-  if ((subfile->_flags & SF_compressed) != 0) {
+  if ((subfile->_flags & (SF_compressed | SF_zstd)) == (SF_compressed | SF_zstd)) {
+#ifndef HAVE_ZSTD
+    express_cat.error()
+      << "zstd not compiled in; cannot read zstd-compressed multifiles.\n";
+    delete stream;
+    return nullptr;
+#else  // HAVE_ZSTD
+    IZstdDecompressStream *wrapper = new IZstdDecompressStream;
+    wrapper->open(stream, true, -1, _zstd_dictionary);
+    stream = wrapper;
+#endif  // HAVE_ZSTD
+
+  } else if ((subfile->_flags & (SF_compressed | SF_lz4)) == (SF_compressed | SF_lz4)) {
+#ifndef HAVE_LZ4
+    express_cat.error()
+      << "LZ4 not compiled in; cannot read LZ4-compressed multifiles.\n";
+    delete stream;
+    return nullptr;
+#else  // HAVE_LZ4
+    ILz4DecompressStream *wrapper = new ILz4DecompressStream(stream, true);
+    stream = wrapper;
+#endif  // HAVE_LZ4
+
+  } else if ((subfile->_flags & SF_compressed) != 0) {
 #ifndef HAVE_ZLIB
     express_cat.error()
       << "zlib not compiled in; cannot read compressed multifiles.\n";
@@ -2100,6 +2423,42 @@ open_read_subfile(Subfile *subfile) {
   return stream;
 }
 
+/**
+ * Calls the indicated function once for each index from 0 to count - 1,
+ * spread across up to get_num_threads() threads, one of which is the calling
+ * thread.  Returns when all of the calls have completed.
+ */
+void Multifile::
+run_parallel(size_t count, const std::function<void(size_t)> &func) const {
+#if defined(HAVE_THREADS) && !defined(SIMPLE_THREADS)
+  size_t num_threads = min((size_t)_num_threads, count);
+  if (num_threads > 1) {
+    patomic<size_t> next(0);
+    auto worker = [&] () {
+      size_t i;
+      while ((i = next++) < count) {
+        func(i);
+      }
+    };
+
+    pvector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (size_t ti = 1; ti < num_threads; ++ti) {
+      threads.emplace_back(worker);
+    }
+    worker();
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+    return;
+  }
+#endif  // HAVE_THREADS && !SIMPLE_THREADS
+
+  for (size_t i = 0; i < count; ++i) {
+    func(i);
+  }
+}
+
 /**
  * Returns the standard form of the subfile name.
  */
@@ -2155,6 +2514,39 @@ clear_subfiles() {
     delete subfile;
   }
   _subfiles.clear();
+
+  _name_index.clear();
+  _directories.clear();
+  _name_index_valid = true;
+}
+
+/**
+ * Rebuilds the hashed tables used by find_subfile() and has_directory() from
+ * the current list of subfiles.  This is done once when the index is read,
+ * so that looking up a name costs the same no matter how many subfiles there
+ * are.
+ */
+void Multifile::
+build_name_index() {
+  _name_index.clear();
+  _directories.clear();
+
+  for (size_t i = 0; i < _subfiles.size(); ++i) {
+    const string &name = _subfiles[i]->_name;
+    _name_index[name] = (int)i;
+
+    // Record each of the directories the subfile is in.  Once we reach one
+    // that's already recorded, its parents are too.
+    size_t slash = name.rfind('/');
+    while (slash != string::npos && slash != 0) {
+      if (!_directories.insert(name.substr(0, slash)).second) {
+        break;
+      }
+      slash = name.rfind('/', slash - 1);
+    }
+  }
+
+  _name_index_valid = true;
 }
 
 /**
@@ -2254,6 +2646,22 @@ read_index() {
     _timestamp_dirty = false;
   }
 
+  _zstd_dictionary.clear();
+  if (_file_minor_ver >= 2) {
+    size_t dictionary_size = reader.get_uint32();
+    if (dictionary_size != 0) {
+      _zstd_dictionary.resize(dictionary_size);
+      read->read((char *)_zstd_dictionary.data(), dictionary_size);
+    }
+    if (read->eof() || read->fail()) {
+      express_cat.info()
+        << _multifile_name << " header is truncated.\n";
+      _read->release();
+      close();
+      return false;
+    }
+  }
+
   // Now read the index out.
   streampos curr_pos = read->tellg() - _offset;
   _next_index = normalize_streampos(curr_pos);
@@ -2330,6 +2738,8 @@ read_index() {
 
   delete subfile;
   _read->release();
+
+  build_name_index();
   return true;
 }
 
@@ -2339,15 +2749,15 @@ read_index() {
 bool Multifile::
 write_header() {
   _file_major_ver = _current_major_ver;
-  _file_minor_ver = _current_minor_ver;
+  _file_minor_ver = needs_minor_ver_2() ? 2 : 1;
 
   nassertr(_write != nullptr, false);
   nassertr(_write->tellp() == (streampos)0, false);
   _write->write(_header_prefix.data(), _header_prefix.size());
   _write->write(_header, _header_size);
   StreamWriter writer(_write, false);
-  writer.add_int16(_current_major_ver);
-  writer.add_int16(_current_minor_ver);
+  writer.add_int16(_file_major_ver);
+  writer.add_int16(_file_minor_ver);
   writer.add_uint32(_scale_factor);
 
   if (_record_timestamp) {
@@ -2357,6 +2767,13 @@ write_header() {
     _timestamp_dirty = false;
   }
 
+  if (_file_minor_ver >= 2) {
+    writer.add_uint32((uint32_t)_zstd_dictionary.size());
+    if (!_zstd_dictionary.empty()) {
+      _write->write((const char *)_zstd_dictionary.data(), _zstd_dictionary.size());
+    }
+  }
+
   _next_index = _write->tellp();
   _next_index = pad_to_streampos(_next_index);
   _last_index = 0;
@@ -2371,6 +2788,29 @@ write_header() {
   return true;
 }
 
+/**
+ * Returns true if the Multifile must be written as version 1.2: that is, if
+ * it has a zstd dictionary, or any of its subfiles, old or new, are
+ * compressed with zstd or LZ4.
+ */
+bool Multifile::
+needs_minor_ver_2() const {
+  if (!_zstd_dictionary.empty()) {
+    return true;
+  }
+  for (const Subfile *subfile : _subfiles) {
+    if ((subfile->_flags & (SF_zstd | SF_lz4)) != 0) {
+      return true;
+    }
+  }
+  for (const Subfile *subfile : _new_subfiles) {
+    if ((subfile->_flags & (SF_zstd | SF_lz4)) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 /**
  * Walks through the list of _cert_special entries in the Multifile, moving
  * any valid signatures found to _signatures.  After this call, _cert_special
@@ -2618,7 +3058,7 @@ write_data(ostream &write, istream *read, streampos fpos,
 
   istream *source = _source;
   pifstream source_file;
-  if (source == nullptr && !_source_filename.empty()) {
+  if (!_packed && source == nullptr && !_source_filename.empty()) {
     // If we have a filename, open it up and read that.
     if (!_source_filename.open_read(source_file)) {
       // Unable to open the source file.
@@ -2632,7 +3072,15 @@ write_data(ostream &write, istream *read, streampos fpos,
     }
   }
 
-  if (source == nullptr) {
+  if (_packed) {
+    // The data was already compressed and encrypted by pack_data(), possibly
+    // in another thread.  Just copy it in.
+    write.write(_packed_data.data(), _packed_data.size());
+    _data_length = _packed_data.size();
+    _packed_data = string();
+    _packed = false;
+
+  } else if (source == nullptr) {
     // We don't have any source data.  Perhaps we're reading from an already-
     // packed Subfile (e.g.  during repack()).
     if (read == nullptr) {
@@ -2657,41 +3105,11 @@ write_data(ostream &write, istream *read, streampos fpos,
     }
   } else {
     // We do have source data.  Copy it in, and also measure its length.
-    ostream *putter = &write;
-    bool delete_putter = false;
-
-#ifndef HAVE_OPENSSL
-    // Without OpenSSL, we can't support encryption.  The flag had better not
-    // be set.
-    nassertr((_flags & SF_encrypted) == 0, fpos);
-
-#else  // HAVE_OPENSSL
-    if ((_flags & SF_encrypted) != 0) {
-      // Write it encrypted.
-      OEncryptStream *encrypt = new OEncryptStream;
-      encrypt->set_iteration_count(multifile->_encryption_iteration_count);
-      encrypt->open(putter, delete_putter, multifile->_encryption_password);
-
-      putter = encrypt;
-      delete_putter = true;
-
-      // Also write the encrypt_header to the beginning of the encrypted
-      // stream, so we can validate the password on decryption.
-      putter->write(_encrypt_header, _encrypt_header_size);
+    ostream *putter = open_pack_stream(write, multifile);
+    if (putter == nullptr) {
+      return fpos;
     }
-#endif  // HAVE_OPENSSL
-
-#ifndef HAVE_ZLIB
-    // Without ZLIB, we can't support compression.  The flag had better not be
-    // set.
-    nassertr((_flags & SF_compressed) == 0, fpos);
-#else  // HAVE_ZLIB
-    if ((_flags & SF_compressed) != 0) {
-      // Write it compressed.
-      putter = new OCompressStream(putter, delete_putter, _compression_level);
-      delete_putter = true;
-    }
-#endif  // HAVE_ZLIB
+    bool delete_putter = (putter != &write);
 
     streampos write_start = fpos;
     _uncompressed_length = 0;
@@ -2796,6 +3214,134 @@ write_data(ostream &write, istream *read, streampos fpos,
   return fpos + (streampos)_data_length;
 }
 
+/**
+ * Compresses and encrypts the contents of the Subfile's source file into
+ * memory, ahead of the call to write_data(), which will then simply copy the
+ * result into the Multifile.  This does not touch the Multifile's streams, so
+ * it may be called for several Subfiles at once from different threads.
+ *
+ * Returns true if the data was packed, or false if the Subfile isn't eligible
+ * or its source can't be read, in which case write_data() will deal with it
+ * as usual.
+ */
+bool Multifile::Subfile::
+pack_data(Multifile *multifile) {
+  if (_packed || _source != nullptr || _source_filename.empty() ||
+      is_cert_special()) {
+    return false;
+  }
+
+  pifstream source_file;
+  if (!_source_filename.open_read(source_file)) {
+    return false;
+  }
+
+  ostringstream packed;
+  ostream *putter = open_pack_stream(packed, multifile);
+  if (putter == nullptr) {
+    return false;
+  }
+
+  static const size_t buffer_size = 4096;
+  char buffer[buffer_size];
+
+  size_t uncompressed_length = 0;
+  source_file.read(buffer, buffer_size);
+  size_t count = source_file.gcount();
+  while (count != 0) {
+    uncompressed_length += count;
+    putter->write(buffer, count);
+    source_file.read(buffer, buffer_size);
+    count = source_file.gcount();
+  }
+
+  if (putter != &packed) {
+    delete putter;
+  }
+  if (source_file.bad() || packed.fail()) {
+    return false;
+  }
+
+  _packed_data = packed.str();
+  _uncompressed_length = uncompressed_length;
+  _packed = true;
+  return true;
+}
+
+/**
+ * Wraps the indicated stream in the encryption and compression layers called
+ * for by the Subfile's flags, and returns the stream that the Subfile's
+ * contents should be written to.  If this is not the same pointer as the
+ * indicated stream, the caller must delete it when it is done writing.
+ * Returns NULL if the required codec is not available.
+ */
+ostream *Multifile::Subfile::
+open_pack_stream(ostream &write, Multifile *multifile) {
+  ostream *putter = &write;
+  bool delete_putter = false;
+
+#ifndef HAVE_OPENSSL
+  // Without OpenSSL, we can't support encryption.  The flag had better not
+  // be set.
+  nassertr((_flags & SF_encrypted) == 0, nullptr);
+
+#else  // HAVE_OPENSSL
+  if ((_flags & SF_encrypted) != 0) {
+    // Write it encrypted.
+    OEncryptStream *encrypt = new OEncryptStream;
+    encrypt->set_iteration_count(multifile->_encryption_iteration_count);
+    encrypt->open(putter, delete_putter, multifile->_encryption_password);
+
+    putter = encrypt;
+    delete_putter = true;
+
+    // Also write the encrypt_header to the beginning of the encrypted
+    // stream, so we can validate the password on decryption.
+    putter->write(_encrypt_header, _encrypt_header_size);
+  }
+#endif  // HAVE_OPENSSL
+
+  if ((_flags & (SF_compressed | SF_zstd)) == (SF_compressed | SF_zstd)) {
+#ifndef HAVE_ZSTD
+    nassert_raise("zstd not compiled in");
+    return nullptr;
+#else  // HAVE_ZSTD
+    // Write it compressed with zstd, using the Multifile's dictionary.
+    OZstdCompressStream *compress = new OZstdCompressStream;
+    compress->open(putter, delete_putter, _compression_level,
+                   multifile->_zstd_dictionary);
+    putter = compress;
+    delete_putter = true;
+#endif  // HAVE_ZSTD
+
+  } else if ((_flags & (SF_compressed | SF_lz4)) == (SF_compressed | SF_lz4)) {
+#ifndef HAVE_LZ4
+    nassert_raise("LZ4 not compiled in");
+    return nullptr;
+#else  // HAVE_LZ4
+    // Write it compressed with LZ4.
+    putter = new OLz4CompressStream(putter, delete_putter, _compression_level);
+    delete_putter = true;
+#endif  // HAVE_LZ4
+
+  } else {
+#ifndef HAVE_ZLIB
+    // Without ZLIB, we can't support compression.  The flag had better not
+    // be set.
+    nassertr((_flags & SF_compressed) == 0, nullptr);
+#else  // HAVE_ZLIB
+    if ((_flags & SF_compressed) != 0) {
+      // Write it compressed.
+      putter = new OCompressStream(putter, delete_putter, _compression_level);
+      delete_putter = true;
+    }
+#endif  // HAVE_ZLIB
+  }
+
+
+  return putter;
+}
+
 /**
  * Seeks within the indicate pfstream back to the index record and rewrites
  * just the _data_start and _data_length part of the index record.
@@ -24,8 +24,12 @@
 #include "indirectLess.h"
 #include "referenceCount.h"
 #include "pvector.h"
+#include "pmap.h"
+#include "pset.h"
 #include "vector_uchar.h"
 
+#include <functional>
+
 #ifdef HAVE_OPENSSL
 typedef struct x509_st X509;
 typedef struct evp_pkey_st EVP_PKEY;
@@ -36,6 +40,12 @@ typedef struct evp_pkey_st EVP_PKEY;
  */
 class EXPCL_PANDA_EXPRESS Multifile : public ReferenceCount {
 PUBLISHED:
+  enum CompressionType {
+    CT_zlib,
+    CT_zstd,
+    CT_lz4,
+  };
+
   Multifile();
   Multifile(const Multifile &copy) = delete;
   ~Multifile();
@@ -67,6 +77,16 @@ PUBLISHED:
   void set_scale_factor(size_t scale_factor);
   INLINE size_t get_scale_factor() const;
 
+  INLINE void set_compression_type(CompressionType type);
+  INLINE CompressionType get_compression_type() const;
+
+  void set_zstd_dictionary(const vector_uchar &dictionary);
+  INLINE const vector_uchar &get_zstd_dictionary() const;
+  bool train_zstd_dictionary(size_t max_size = 112640);
+
+  void set_num_threads(int num_threads);
+  INLINE int get_num_threads() const;
+
   INLINE void set_encryption_flag(bool flag);
   INLINE bool get_encryption_flag() const;
 
@@ -120,6 +140,7 @@ PUBLISHED:
   size_t get_subfile_length(int index) const;
   time_t get_subfile_timestamp(int index) const;
   bool is_subfile_compressed(int index) const;
+  CompressionType get_subfile_compression_type(int index) const;
   bool is_subfile_encrypted(int index) const;
   bool is_subfile_text(int index) const;
 
@@ -133,6 +154,8 @@ PUBLISHED:
   BLOCKING bool extract_subfile(int index, const Filename &filename);
   BLOCKING bool extract_subfile_to(int index, std::ostream &out);
   BLOCKING bool compare_subfile(int index, const Filename &filename);
+  BLOCKING bool extract_subfiles(const Filename &dirname);
+  BLOCKING int verify_subfiles();
 
   void output(std::ostream &out) const;
   void ls(std::ostream &out = std::cout) const;
@@ -175,6 +198,8 @@ private:
     SF_encrypted      = 0x0010,
     SF_signature      = 0x0020,
     SF_text           = 0x0040,
+    SF_zstd           = 0x0080,  // With SF_compressed: zstd instead of zlib.
+    SF_lz4            = 0x0100,  // With SF_compressed: LZ4 instead of zlib.
   };
 
   class Subfile {
@@ -187,6 +212,8 @@ private:
                           Multifile *multifile);
     std::streampos write_data(std::ostream &write, std::istream *read, std::streampos fpos,
                          Multifile *multifile);
+    bool pack_data(Multifile *multifile);
+    std::ostream *open_pack_stream(std::ostream &write, Multifile *multifile);
     void rewrite_index_data_start(std::ostream &write, Multifile *multifile);
     void rewrite_index_flags(std::ostream &write);
     INLINE bool is_deleted() const;
@@ -206,6 +233,8 @@ private:
     Filename _source_filename;
     int _flags;
     int _compression_level;  // Not preserved on disk.
+    bool _packed;
+    std::string _packed_data;  // Filled in by pack_data().
 #ifdef HAVE_OPENSSL
     EVP_PKEY *_pkey;         // Not preserved on disk.
 #endif // HAVE_OPENSSL
@@ -219,10 +248,13 @@ private:
   void add_new_subfile(Subfile *subfile, int compression_level);
   std::istream *open_read_subfile(Subfile *subfile);
   std::string standardize_subfile_name(const std::string &subfile_name) const;
+  void run_parallel(size_t count, const std::function<void(size_t)> &func) const;
+  void build_name_index();
 
   void clear_subfiles();
   bool read_index();
   bool write_header();
+  bool needs_minor_ver_2() const;
 
   void check_signatures();
 
@@ -235,6 +267,16 @@ private:
   PendingSubfiles _removed_subfiles;
   PendingSubfiles _cert_special;
 
+  // Hashed lookup tables for find_subfile() and has_directory(), built from
+  // _subfiles whenever the index is read or flushed.  While subfiles are
+  // being added or removed, they are out of date, and we fall back to
+  // searching _subfiles directly.
+  typedef pflat_hash_map<std::string, int, string_hash> NameIndex;
+  NameIndex _name_index;
+  typedef pflat_hash_set<std::string, string_hash> Directories;
+  Directories _directories;
+  bool _name_index_valid;
+
 #ifdef HAVE_OPENSSL
   typedef pvector<CertChain> Certificates;
   Certificates _signatures;
@@ -255,6 +297,10 @@ private:
   size_t _scale_factor;
   size_t _new_scale_factor;
 
+  CompressionType _compression_type;
+  vector_uchar _zstd_dictionary;
+  int _num_threads;
+
   bool _encryption_flag;
   std::string _encryption_password;
   std::string _encryption_algorithm;
@@ -13,6 +13,8 @@
 #include "fileReference.cxx"
 #include "hashGeneratorBase.cxx"
 #include "hashVal.cxx"
+#include "lz4Stream.cxx"
+#include "lz4StreamBuf.cxx"
 #include "memoryInfo.cxx"
 #include "memoryUsage.cxx"
 #include "memoryUsagePointerCounts.cxx"
@@ -15,6 +15,7 @@
 #include "virtualFile.cxx"
 #include "virtualFileComposite.cxx"
 #include "virtualFileList.cxx"
+#include "virtualFileMapping.cxx"
 #include "virtualFileMount.cxx"
 #include "virtualFileMountAndroidAsset.cxx"
 #include "virtualFileMountMultifile.cxx"
@@ -31,4 +32,6 @@
 #include "windowsRegistry.cxx"
 #include "zStream.cxx"
 #include "zStreamBuf.cxx"
+#include "zstdStream.cxx"
+#include "zstdStreamBuf.cxx"
 #include "zipArchive.cxx"
@@ -431,6 +431,25 @@ simple_read_file(istream *in, vector_uchar &result, size_t max_bytes) {
   return (!in->fail() || in->eof());
 }
 
+/**
+ * Returns the contents of the file as a read-only block of memory, or NULL if
+ * the file cannot be read.  Where possible, the file is mapped into memory
+ * directly from disk instead of being copied into a buffer; see
+ * VirtualFileMapping.
+ *
+ * If auto_unwrap is true, an explicitly-named .pz/.gz file is automatically
+ * decompressed, in which case the decompressed contents are always returned
+ * in a buffer.
+ */
+PT(VirtualFileMapping) VirtualFile::
+map_file(bool auto_unwrap) const {
+  vector_uchar buffer;
+  if (!read_file(buffer, auto_unwrap)) {
+    return nullptr;
+  }
+  return new VirtualFileMapping(std::move(buffer));
+}
+
 /**
  * Fills file_list up with the list of files that are within this directory,
  * excluding those whose basenames are listed in mount_points.  Returns true
@@ -22,6 +22,7 @@
 #include "typedReferenceCount.h"
 #include "ordered_vector.h"
 #include "vector_uchar.h"
+#include "virtualFileMapping.h"
 
 class VirtualFileMount;
 class VirtualFileList;
@@ -88,6 +89,8 @@ public:
   virtual bool read_file(vector_uchar &result, bool auto_unwrap) const;
   virtual bool write_file(const unsigned char *data, size_t data_size, bool auto_wrap);
 
+  virtual PT(VirtualFileMapping) map_file(bool auto_unwrap) const;
+
   static bool simple_read_file(std::istream *stream, vector_uchar &result);
   static bool simple_read_file(std::istream *stream, vector_uchar &result, size_t max_bytes);
 
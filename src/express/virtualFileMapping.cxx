@@ -0,0 +1,160 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file virtualFileMapping.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "virtualFileMapping.h"
+#include "config_express.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN 1
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+TypeHandle VirtualFileMapping::_type_handle;
+
+/**
+ * Creates a mapping that holds the contents of a file that could not be
+ * mapped from disk.
+ */
+VirtualFileMapping::
+VirtualFileMapping(vector_uchar &&buffer) :
+  _buffer(std::move(buffer)),
+  _view(nullptr),
+  _view_size(0)
+{
+  _data = _buffer.data();
+  _size = _buffer.size();
+}
+
+/**
+ * Takes ownership of a view that was mapped by map_region().
+ */
+VirtualFileMapping::
+VirtualFileMapping(const Filename &filename, void *view, size_t view_size,
+                   size_t offset, size_t size) :
+  _data((const unsigned char *)view + offset),
+  _size(size),
+  _filename(filename),
+  _view(view),
+  _view_size(view_size)
+{
+}
+
+/**
+ *
+ */
+VirtualFileMapping::
+~VirtualFileMapping() {
+  if (_view != nullptr) {
+#ifdef _WIN32
+    UnmapViewOfFile(_view);
+#else
+    munmap(_view, _view_size);
+#endif
+  }
+}
+
+/**
+ * Maps the indicated range of bytes of the indicated physical file on disk
+ * into memory, read-only.  Returns NULL if the file could not be mapped, in
+ * which case the caller should read the file instead.
+ */
+PT(VirtualFileMapping) VirtualFileMapping::
+map_region(const Filename &filename, std::streampos start, size_t size) {
+  if (size == 0 || start < 0) {
+    return nullptr;
+  }
+
+#ifdef _WIN32
+  std::wstring os_filename = filename.to_os_specific_w();
+  HANDLE file = CreateFileW(os_filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+                            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    return nullptr;
+  }
+
+  // Make sure the region is actually within the file; touching a mapped page
+  // beyond the end of the file is an access violation.
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) ||
+      (uint64_t)file_size.QuadPart < (uint64_t)start + size) {
+    CloseHandle(file);
+    return nullptr;
+  }
+
+  HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  CloseHandle(file);
+  if (mapping == nullptr) {
+    return nullptr;
+  }
+
+  // A view must begin on a multiple of the allocation granularity.
+  SYSTEM_INFO sysinfo;
+  GetSystemInfo(&sysinfo);
+  uint64_t offset = (uint64_t)start;
+  size_t page_offset = (size_t)(offset % sysinfo.dwAllocationGranularity);
+  offset -= page_offset;
+
+  size_t view_size = size + page_offset;
+  void *view = MapViewOfFile(mapping, FILE_MAP_READ, (DWORD)(offset >> 32),
+                             (DWORD)(offset & 0xffffffff), view_size);
+  // The view keeps the mapping object alive.
+  CloseHandle(mapping);
+  if (view == nullptr) {
+    return nullptr;
+  }
+
+#else
+  std::string os_filename = filename.to_os_specific();
+  int fd = open(os_filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return nullptr;
+  }
+
+  // Make sure the region is actually within the file; touching a mapped page
+  // beyond the end of the file raises SIGBUS.
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) ||
+      (uint64_t)st.st_size < (uint64_t)start + size) {
+    close(fd);
+    return nullptr;
+  }
+
+  // A view must begin on a page boundary.
+  static const size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+  uint64_t offset = (uint64_t)start;
+  size_t page_offset = (size_t)(offset % page_size);
+  offset -= page_offset;
+
+  size_t view_size = size + page_offset;
+  void *view = mmap(nullptr, view_size, PROT_READ, MAP_PRIVATE, fd, (off_t)offset);
+  // The mapping remains valid after the descriptor is closed.
+  close(fd);
+  if (view == MAP_FAILED) {
+    return nullptr;
+  }
+#endif
+
+  if (express_cat.is_debug()) {
+    express_cat.debug()
+      << "Mapped " << size << " bytes at " << start << " of " << filename << "\n";
+  }
+
+  return new VirtualFileMapping(filename, view, view_size, page_offset, size);
+}
@@ -0,0 +1,88 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file virtualFileMapping.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef VIRTUALFILEMAPPING_H
+#define VIRTUALFILEMAPPING_H
+
+#include "pandabase.h"
+
+#include "typedReferenceCount.h"
+#include "filename.h"
+#include "pointerTo.h"
+#include "vector_uchar.h"
+
+/**
+ * The read-only contents of a file returned by VirtualFile::map_file().
+ *
+ * When the file (or an uncompressed, unencrypted Multifile subfile) exists as
+ * a range of bytes within a file on disk, that range is mapped directly into
+ * memory, and its pages are only read in from disk as they are touched.
+ * Otherwise, the contents of the file are read into a buffer held by this
+ * object.  Either way, the data remains valid as long as this object exists.
+ */
+class EXPCL_PANDA_EXPRESS VirtualFileMapping : public TypedReferenceCount {
+public:
+  explicit VirtualFileMapping(vector_uchar &&buffer);
+  virtual ~VirtualFileMapping();
+
+  static PT(VirtualFileMapping) map_region(const Filename &filename,
+                                           std::streampos start, size_t size);
+
+  INLINE const unsigned char *get_data() const;
+
+PUBLISHED:
+  INLINE size_t get_size() const;
+  INLINE bool is_mapped() const;
+  INLINE const Filename &get_filename() const;
+
+  MAKE_PROPERTY(size, get_size);
+  MAKE_PROPERTY(mapped, is_mapped);
+  MAKE_PROPERTY(filename, get_filename);
+
+private:
+  VirtualFileMapping(const Filename &filename, void *view, size_t view_size,
+                     size_t offset, size_t size);
+
+  const unsigned char *_data;
+  size_t _size;
+
+  // Only used if the file could not be mapped.
+  vector_uchar _buffer;
+
+  // The mapped view, which begins at the page boundary at or before the
+  // start of the data.  Null if the file could not be mapped.
+  Filename _filename;
+  void *_view;
+  size_t _view_size;
+
+public:
+  static TypeHandle get_class_type() {
+    return _type_handle;
+  }
+  static void init_type() {
+    TypedReferenceCount::init_type();
+    register_type(_type_handle, "VirtualFileMapping",
+                  TypedReferenceCount::get_class_type());
+  }
+  virtual TypeHandle get_type() const {
+    return get_class_type();
+  }
+  virtual TypeHandle force_init_type() {init_type(); return get_class_type();}
+
+private:
+  static TypeHandle _type_handle;
+};
+
+#include "virtualFileMapping.I"
+
+#endif
@@ -15,6 +15,10 @@
 #include "virtualFileSimple.h"
 #include "virtualFileSystem.h"
 #include "zStream.h"
+#include "zstdStream.h"
+#include "lz4Stream.h"
+#include "configVariableBool.h"
+#include "configVariableInt.h"
 
 using std::iostream;
 using std::istream;
@@ -23,6 +27,18 @@ using std::string;
 
 TypeHandle VirtualFileMount::_type_handle;
 
+static ConfigVariableBool vfs_mmap
+("vfs-mmap", true,
+ PRC_DESC("Set this true to allow VirtualFile::map_file() to map files and "
+          "uncompressed, unencrypted multifile subfiles directly from disk "
+          "into memory.  If this is false, or a file cannot be mapped, the "
+          "file is read into a buffer instead."));
+
+static ConfigVariableInt vfs_mmap_min_size
+("vfs-mmap-min-size", 65536,
+ PRC_DESC("Files smaller than this many bytes are read into a buffer by "
+          "VirtualFile::map_file() rather than mapped, since mapping a small "
+          "file costs more than reading it."));
 
 /**
  *
@@ -123,6 +139,16 @@ is_writable(const Filename &file) const {
   return false;
 }
 
+/**
+ * Returns true if the set of files within this mount cannot change for as
+ * long as it is mounted, so that the VirtualFileSystem may remember where it
+ * found a file.  The default is false.
+ */
+bool VirtualFileMount::
+is_immutable() const {
+  return false;
+}
+
 /**
  * Fills up the indicated pvector with the contents of the file, if it is a
  * regular file.  Returns true on success, false otherwise.
@@ -180,24 +206,68 @@ write_file(const Filename &file, bool do_compress,
   return okflag;
 }
 
+/**
+ * Returns the contents of the indicated file as a read-only block of memory,
+ * or NULL if the file cannot be read.  If the mount can report the file as a
+ * range of a physical file on disk (see get_system_info()), that range is
+ * mapped into memory; otherwise the file is read into a buffer.
+ */
+PT(VirtualFileMapping) VirtualFileMount::
+map_file(const Filename &file) {
+  SubfileInfo info;
+  if (vfs_mmap && get_system_info(file, info) &&
+      info.get_size() >= (std::streamsize)vfs_mmap_min_size) {
+    PT(VirtualFileMapping) mapping =
+      VirtualFileMapping::map_region(info.get_filename(), info.get_start(), (size_t)info.get_size());
+    if (mapping != nullptr) {
+      return mapping;
+    }
+  }
+
+  vector_uchar buffer;
+  if (!read_file(file, false, buffer)) {
+    return nullptr;
+  }
+  return new VirtualFileMapping(std::move(buffer));
+}
+
 /**
  * Opens the file for reading.  Returns a newly allocated istream on success
  * (which you should eventually delete when you are done reading). Returns
  * NULL on failure.
  *
- * If do_uncompress is true, the file is also decompressed on-the-fly using
- * zlib.
+ * If do_uncompress is true, the file is also decompressed on-the-fly, using
+ * zstd for a .zst file, LZ4 for a .lz4 file, or zlib otherwise.
  */
 istream *VirtualFileMount::
 open_read_file(const Filename &file, bool do_uncompress) const {
   istream *result = open_read_file(file);
+  if (result == nullptr || !do_uncompress) {
+    return result;
+  }
 
-#ifdef HAVE_ZLIB
-  if (result != nullptr && do_uncompress) {
-    // We have to slip in a layer to decompress the file on the fly.
-    IDecompressStream *wrapper = new IDecompressStream(result, true);
-    result = wrapper;
+  // We have to slip in a layer to decompress the file on the fly.
+  std::string extension = file.get_extension();
+#ifdef HAVE_ZSTD
+  if (extension == "zst") {
+    return new IZstdDecompressStream(result, true);
+  }
+#endif  // HAVE_ZSTD
+#ifdef HAVE_LZ4
+  if (extension == "lz4") {
+    return new ILz4DecompressStream(result, true);
   }
+#endif  // HAVE_LZ4
+  if (extension == "zst" || extension == "lz4") {
+    express_cat.error()
+      << "Cannot decompress " << file << "; support for this compression "
+      << "format is not compiled in.\n";
+    close_read_file(result);
+    return nullptr;
+  }
+
+#ifdef HAVE_ZLIB
+  result = new IDecompressStream(result, true);
 #endif  // HAVE_ZLIB
 
   return result;
@@ -229,18 +299,38 @@ open_write_file(const Filename &file, bool truncate) {
  * (which you should eventually delete when you are done writing). Returns
  * NULL on failure.
  *
- * If do_compress is true, the file is also compressed on-the-fly using zlib.
+ * If do_compress is true, the file is also compressed on-the-fly, using zstd
+ * for a .zst file, LZ4 for a .lz4 file, or zlib otherwise.
  */
 ostream *VirtualFileMount::
 open_write_file(const Filename &file, bool do_compress, bool truncate) {
   ostream *result = open_write_file(file, truncate);
+  if (result == nullptr || !do_compress) {
+    return result;
+  }
 
-#ifdef HAVE_ZLIB
-  if (result != nullptr && do_compress) {
-    // We have to slip in a layer to compress the file on the fly.
-    OCompressStream *wrapper = new OCompressStream(result, true);
-    result = wrapper;
+  // We have to slip in a layer to compress the file on the fly.
+  std::string extension = file.get_extension();
+#ifdef HAVE_ZSTD
+  if (extension == "zst") {
+    return new OZstdCompressStream(result, true);
+  }
+#endif  // HAVE_ZSTD
+#ifdef HAVE_LZ4
+  if (extension == "lz4") {
+    return new OLz4CompressStream(result, true);
   }
+#endif  // HAVE_LZ4
+  if (extension == "zst" || extension == "lz4") {
+    express_cat.error()
+      << "Cannot compress " << file << "; support for this compression "
+      << "format is not compiled in.\n";
+    close_write_file(result);
+    return nullptr;
+  }
+
+#ifdef HAVE_ZLIB
+  result = new OCompressStream(result, true);
 #endif  // HAVE_ZLIB
 
   return result;
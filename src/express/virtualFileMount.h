@@ -52,11 +52,13 @@ public:
   virtual bool is_directory(const Filename &file) const=0;
   virtual bool is_regular_file(const Filename &file) const=0;
   virtual bool is_writable(const Filename &file) const;
+  virtual bool is_immutable() const;
 
   virtual bool read_file(const Filename &file, bool do_uncompress,
                          vector_uchar &result) const;
   virtual bool write_file(const Filename &file, bool do_compress,
                           const unsigned char *data, size_t data_size);
+  virtual PT(VirtualFileMapping) map_file(const Filename &file);
 
   virtual std::istream *open_read_file(const Filename &file) const=0;
   std::istream *open_read_file(const Filename &file, bool do_uncompress) const;
@@ -53,6 +53,15 @@ is_regular_file(const Filename &file) const {
   return (_multifile->find_subfile(file) >= 0);
 }
 
+/**
+ * Returns true if the set of files within this mount cannot change.  This is
+ * the case when the Multifile has been opened only for reading.
+ */
+bool VirtualFileMountMultifile::
+is_immutable() const {
+  return !_multifile->is_write_valid();
+}
+
 /**
  * Fills up the indicated pvector with the contents of the file, if it is a
  * regular file.  Returns true on success, false otherwise.
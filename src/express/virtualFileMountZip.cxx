@@ -56,6 +56,15 @@ is_regular_file(const Filename &file) const {
   return (_archive->find_subfile(path) >= 0);
 }
 
+/**
+ * Returns true if the set of files within this mount cannot change.  This is
+ * the case when the archive has been opened only for reading.
+ */
+bool VirtualFileMountZip::
+is_immutable() const {
+  return !_archive->is_write_valid();
+}
+
 /**
  * Fills up the indicated pvector with the contents of the file, if it is a
  * regular file.  Returns true on success, false otherwise.
@@ -23,6 +23,17 @@ using std::string;
 
 TypeHandle VirtualFileSimple::_type_handle;
 
+/**
+ * Returns true if the indicated extension marks a compressed file that
+ * should be automatically unwrapped on reading (or wrapped on writing, if
+ * for_read is false): .pz and .gz for zlib, .zst for zstd and .lz4 for LZ4.
+ * We don't write .gz files, since we don't write the gzip header.
+ */
+static bool
+is_compressed_extension(const std::string &extension, bool for_read) {
+  return extension == "pz" || (for_read && extension == "gz") ||
+         extension == "zst" || extension == "lz4";
+}
 
 /**
  * Returns the VirtualFileSystem this file is associated with.
@@ -200,18 +211,17 @@ copy_file(VirtualFile *new_file) {
  * (which you should eventually delete when you are done reading). Returns
  * NULL on failure.
  *
- * If auto_unwrap is true, an explicitly-named .pz/.gz file is automatically
- * decompressed and the decompressed contents are returned.  This is different
- * than vfs-implicit-pz, which will automatically decompress a file if the
- * extension .pz is *not* given.
+ * If auto_unwrap is true, an explicitly-named .pz/.gz/.zst/.lz4 file is
+ * automatically decompressed and the decompressed contents are returned.
+ * This is different than vfs-implicit-pz, which will automatically
+ * decompress a file if the extension .pz is *not* given.
  */
 istream *VirtualFileSimple::
 open_read_file(bool auto_unwrap) const {
 
   // Will we be automatically unwrapping a .pz file?
   bool do_uncompress = (_implicit_pz_file ||
-    (auto_unwrap && (_local_filename.get_extension() == "pz" ||
-                     _local_filename.get_extension() == "gz")));
+    (auto_unwrap && is_compressed_extension(_local_filename.get_extension(), true)));
 
   Filename local_filename(_local_filename);
   if (do_uncompress) {
@@ -238,14 +248,14 @@ close_read_file(istream *stream) const {
  * (which you should eventually delete when you are done writing). Returns
  * NULL on failure.
  *
- * If auto_wrap is true, an explicitly-named .pz file is automatically
- * compressed while writing.  If truncate is true, the file is truncated to
- * zero length before writing.
+ * If auto_wrap is true, an explicitly-named .pz/.zst/.lz4 file is
+ * automatically compressed while writing.  If truncate is true, the file is
+ * truncated to zero length before writing.
  */
 ostream *VirtualFileSimple::
 open_write_file(bool auto_wrap, bool truncate) {
   // Will we be automatically wrapping a .pz file?
-  bool do_compress = (_implicit_pz_file || (auto_wrap && _local_filename.get_extension() == "pz"));
+  bool do_compress = (_implicit_pz_file || (auto_wrap && is_compressed_extension(_local_filename.get_extension(), false)));
 
   Filename local_filename(_local_filename);
   if (do_compress) {
@@ -381,8 +391,7 @@ read_file(vector_uchar &result, bool auto_unwrap) const {
 
   // Will we be automatically unwrapping a .pz file?
   bool do_uncompress = (_implicit_pz_file ||
-    (auto_unwrap && (_local_filename.get_extension() == "pz" ||
-                     _local_filename.get_extension() == "gz")));
+    (auto_unwrap && is_compressed_extension(_local_filename.get_extension(), true)));
 
   Filename local_filename(_local_filename);
   if (do_uncompress) {
@@ -393,6 +402,26 @@ read_file(vector_uchar &result, bool auto_unwrap) const {
   return _mount->read_file(local_filename, do_uncompress, result);
 }
 
+/**
+ * Returns the contents of the file as a read-only block of memory, mapped
+ * directly from disk where possible.  Returns NULL if the file cannot be
+ * read.
+ */
+PT(VirtualFileMapping) VirtualFileSimple::
+map_file(bool auto_unwrap) const {
+
+  // Will we be automatically unwrapping a .pz file?
+  bool do_uncompress = (_implicit_pz_file ||
+    (auto_unwrap && is_compressed_extension(_local_filename.get_extension(), true)));
+
+  if (do_uncompress) {
+    // The decompressed contents don't exist anywhere on disk.
+    return VirtualFile::map_file(auto_unwrap);
+  }
+
+  return _mount->map_file(_local_filename);
+}
+
 /**
  * Writes the indicated data to the file, if it is writable.  Returns true on
  * success, false otherwise.
@@ -400,7 +429,7 @@ read_file(vector_uchar &result, bool auto_unwrap) const {
 bool VirtualFileSimple::
 write_file(const unsigned char *data, size_t data_size, bool auto_wrap) {
   // Will we be automatically wrapping a .pz file?
-  bool do_compress = (_implicit_pz_file || (auto_wrap && _local_filename.get_extension() == "pz"));
+  bool do_compress = (_implicit_pz_file || (auto_wrap && is_compressed_extension(_local_filename.get_extension(), false)));
 
   Filename local_filename(_local_filename);
   if (do_compress) {
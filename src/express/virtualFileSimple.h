@@ -33,6 +33,7 @@ public:
 PUBLISHED:
   virtual VirtualFileSystem *get_file_system() const;
   INLINE VirtualFileMount *get_mount() const;
+  INLINE const Filename &get_local_filename() const;
   virtual Filename get_filename() const;
 
   virtual bool has_file() const;
@@ -64,6 +65,7 @@ public:
   virtual bool atomic_read_contents(std::string &contents) const;
 
   virtual bool read_file(vector_uchar &result, bool auto_unwrap) const;
+  virtual PT(VirtualFileMapping) map_file(bool auto_unwrap) const;
   virtual bool write_file(const unsigned char *data, size_t data_size, bool auto_wrap);
 
 protected:
@@ -74,10 +74,18 @@ VirtualFileSystem() :
             "will implicitly retrieve a file named 'dirname/mytex.jpg' "
             "within the multifile /c/files/foo.mf, even if the multifile "
             "has not already been mounted.  This makes all of your multifiles "
-            "act like directories."))
+            "act like directories.")),
+  vfs_path_cache_size
+  ("vfs-path-cache-size", 16384,
+   PRC_DESC("The maximum number of paths for which the VirtualFileSystem "
+            "remembers the mount point that the file was found in.  This "
+            "speeds up repeated lookups when many multifiles are mounted.  "
+            "Only files found behind read-only multifiles and zip archives "
+            "are remembered.  Set this to 0 to disable the cache."))
 {
   _cwd = "/";
   _mount_seq = 0;
+  _path_cache_seq = 0;
 }
 
 /**
@@ -1310,11 +1318,37 @@ do_get_file(const Filename &filename, int open_flags) const {
   // Also transparently look for a regular file suffixed .pz.
   Filename strpath_pz = strpath + ".pz";
 
-  // Now scan all the mount points, from the back (since later mounts override
-  // more recent ones), until a match is found.
   PT(VirtualFile) found_file = nullptr;
   VirtualFileComposite *composite_file = nullptr;
 
+  // If we've looked up this path before, go straight to the mount it was
+  // found in.  We still ask the mount for it, in case the file has since
+  // been removed.
+  bool use_cache = (open_flags & ~OF_status_only) == 0 && vfs_path_cache_size > 0;
+  if (use_cache) {
+    if (_path_cache_seq != _mount_seq) {
+      _path_cache.clear();
+      _path_cache_seq = _mount_seq;
+    }
+    PathCache::const_iterator ci = _path_cache.find(strpath.get_fullpath());
+    if (ci != _path_cache.end()) {
+      const CachedPath &cached = (*ci).second;
+      if (consider_match(found_file, composite_file, cached._mount,
+                         cached._local_filename, pathname,
+                         cached._implicit_pz_file, open_flags) &&
+          !found_file->is_directory()) {
+        return found_file;
+      }
+      found_file = nullptr;
+      _path_cache.erase(ci);
+    }
+  }
+
+  // Now scan all the mount points, from the back (since later mounts override
+  // more recent ones), until a match is found.  The result may be cached only
+  // if none of the mounts we pass over on the way can change.
+  bool cacheable = use_cache;
+
   // We use an index instead of an iterator, since the vector might change if
   // implicit mounts are added during this loop.
   unsigned int start_seq = _mount_seq;
@@ -1331,20 +1365,30 @@ do_get_file(const Filename &filename, int open_flags) const {
                          false, open_flags)) {
         return found_file;
       }
+      cacheable = false;
+
     } else if (mount_point.empty()) {
       // This is the root mount point; all files are in here.
       if (consider_match(found_file, composite_file, mount, strpath,
                          pathname, false, open_flags)) {
+        if (cacheable && !found_file->is_directory()) {
+          record_path(strpath, mount, strpath, false);
+        }
         return found_file;
       }
 #ifdef HAVE_ZLIB
       if (vfs_implicit_pz) {
         if (consider_match(found_file, composite_file, mount, strpath_pz,
                            pathname, true, open_flags)) {
+          if (cacheable && mount->is_immutable() &&
+              !found_file->is_directory()) {
+            record_path(strpath, mount, strpath_pz, true);
+          }
           return found_file;
         }
       }
 #endif  // HAVE_ZLIB
+      cacheable = cacheable && mount->is_immutable();
 
     } else if (strpath.length() > mount_point.length() &&
                mount_point == strpath.substr(0, mount_point.length()) &&
@@ -1354,6 +1398,9 @@ do_get_file(const Filename &filename, int open_flags) const {
       Filename local_filename_pz = strpath_pz.substr(mount_point.length() + 1);
       if (consider_match(found_file, composite_file, mount, local_filename,
                          pathname, false, open_flags)) {
+        if (cacheable && !found_file->is_directory()) {
+          record_path(strpath, mount, local_filename, false);
+        }
         return found_file;
       }
 #ifdef HAVE_ZLIB
@@ -1361,10 +1408,15 @@ do_get_file(const Filename &filename, int open_flags) const {
         // Bingo!
         if (consider_match(found_file, composite_file, mount, local_filename_pz,
                            pathname, true, open_flags)) {
+          if (cacheable && mount->is_immutable() &&
+              !found_file->is_directory()) {
+            record_path(strpath, mount, local_filename_pz, true);
+          }
           return found_file;
         }
       }
 #endif  // HAVE_ZLIB
+      cacheable = cacheable && mount->is_immutable();
     }
 
     // If we discover that a file has been implicitly mounted during one of
@@ -1372,6 +1424,7 @@ do_get_file(const Filename &filename, int open_flags) const {
     if (start_seq != _mount_seq) {
       start_seq = _mount_seq;
       i = _mounts.size();
+      cacheable = use_cache;
     }
   }
 
@@ -1470,6 +1523,31 @@ consider_match(PT(VirtualFile) &found_file, VirtualFileComposite *&composite_fil
   return false;
 }
 
+/**
+ * Remembers that the indicated path, which was just looked up, was found in
+ * the indicated mount, so that do_get_file() can go straight there next time.
+ *
+ * Assumes the lock is already held.
+ */
+void VirtualFileSystem::
+record_path(const Filename &strpath, VirtualFileMount *mount,
+            const Filename &local_filename, bool implicit_pz_file) const {
+  if (_path_cache_seq != _mount_seq) {
+    _path_cache.clear();
+    _path_cache_seq = _mount_seq;
+  }
+  if (_path_cache.size() >= (size_t)vfs_path_cache_size) {
+    // Rather than tracking which entries are least recently used, just start
+    // over; the common paths will quickly be found again.
+    _path_cache.clear();
+  }
+
+  CachedPath &cached = _path_cache[strpath.get_fullpath()];
+  cached._mount = mount;
+  cached._local_filename = local_filename;
+  cached._implicit_pz_file = implicit_pz_file;
+}
+
 /**
  * The indicated filename was not found.  Check to see if it is using an
  * implicit reference to a .mf file as a directory, that hasn't already been
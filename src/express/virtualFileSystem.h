@@ -25,6 +25,7 @@
 #include "config_express.h"
 #include "mutexImpl.h"
 #include "pvector.h"
+#include "pmap.h"
 #include "zipArchive.h"
 
 class Multifile;
@@ -123,6 +124,7 @@ public:
   INLINE bool read_file(const Filename &filename, std::string &result, bool auto_unwrap) const;
   INLINE bool read_file(const Filename &filename, vector_uchar &result, bool auto_unwrap) const;
   INLINE bool write_file(const Filename &filename, const unsigned char *data, size_t data_size, bool auto_wrap);
+  INLINE PT(VirtualFileMapping) map_file(const Filename &filename, bool auto_unwrap) const;
 
   void scan_mount_points(vector_string &names, const Filename &path) const;
 
@@ -148,6 +150,7 @@ public:
   ConfigVariableBool vfs_case_sensitive;
   ConfigVariableBool vfs_implicit_pz;
   ConfigVariableBool vfs_implicit_mf;
+  ConfigVariableInt vfs_path_cache_size;
 
 private:
   Filename normalize_mount_point(const Filename &mount_point) const;
@@ -159,12 +162,28 @@ private:
                       const Filename &original_filename, bool implicit_pz_file,
                       int open_flags) const;
   bool consider_mount_mf(const Filename &filename);
+  void record_path(const Filename &strpath, VirtualFileMount *mount,
+                   const Filename &local_filename, bool implicit_pz_file) const;
 
   mutable MutexImpl _lock;
   typedef pvector<PT(VirtualFileMount) > Mounts;
   Mounts _mounts;
   unsigned int _mount_seq;
 
+  // Remembers which mount each recently looked-up path was found in, so that
+  // looking it up again doesn't need to probe every mount.  This is emptied
+  // whenever _mount_seq changes.  The mount pointers are not reference
+  // counted; they are never used once the mount has gone away.
+  class CachedPath {
+  public:
+    VirtualFileMount *_mount;
+    Filename _local_filename;
+    bool _implicit_pz_file;
+  };
+  typedef pflat_hash_map<std::string, CachedPath, string_hash> PathCache;
+  mutable PathCache _path_cache;
+  mutable unsigned int _path_cache_seq;
+
   Filename _cwd;
 
   static VirtualFileSystem *_global_ptr;
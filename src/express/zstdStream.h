@@ -0,0 +1,93 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file zstdStream.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef ZSTDSTREAM_H
+#define ZSTDSTREAM_H
+
+#include "pandabase.h"
+
+// This module is not compiled if zstd is not available.
+#ifdef HAVE_ZSTD
+
+#include "zstdStreamBuf.h"
+#include "vector_uchar.h"
+
+/**
+ * An input stream object that uses zstd to decompress the input from another
+ * source stream on-the-fly.  This is the zstd equivalent of
+ * IDecompressStream.
+ *
+ * If the data was compressed with a dictionary, the same dictionary must be
+ * supplied to open().
+ *
+ * Seeking is not supported, except back to the beginning.
+ */
+class EXPCL_PANDA_EXPRESS IZstdDecompressStream : public std::istream {
+PUBLISHED:
+  INLINE IZstdDecompressStream();
+  INLINE explicit IZstdDecompressStream(std::istream *source, bool owns_source,
+                                        std::streamsize source_length = -1);
+
+#if _MSC_VER >= 1800
+  INLINE IZstdDecompressStream(const IZstdDecompressStream &copy) = delete;
+#endif
+
+  INLINE IZstdDecompressStream &open(std::istream *source, bool owns_source,
+                                     std::streamsize source_length = -1);
+  INLINE IZstdDecompressStream &close();
+
+public:
+  INLINE IZstdDecompressStream &open(std::istream *source, bool owns_source,
+                                     std::streamsize source_length,
+                                     const vector_uchar &dictionary);
+
+private:
+  ZstdStreamBuf _buf;
+};
+
+/**
+ * An output stream object that uses zstd to compress data to another
+ * destination stream on-the-fly.  This is the zstd equivalent of
+ * OCompressStream.
+ *
+ * Seeking is not supported.
+ */
+class EXPCL_PANDA_EXPRESS OZstdCompressStream : public std::ostream {
+PUBLISHED:
+  INLINE OZstdCompressStream();
+  INLINE explicit OZstdCompressStream(std::ostream *dest, bool owns_dest,
+                                      int compression_level = 3);
+
+#if _MSC_VER >= 1800
+  INLINE OZstdCompressStream(const OZstdCompressStream &copy) = delete;
+#endif
+
+  INLINE OZstdCompressStream &open(std::ostream *dest, bool owns_dest,
+                                   int compression_level = 3);
+  INLINE OZstdCompressStream &close();
+
+public:
+  INLINE OZstdCompressStream &open(std::ostream *dest, bool owns_dest,
+                                   int compression_level,
+                                   const vector_uchar &dictionary);
+
+private:
+  ZstdStreamBuf _buf;
+};
+
+#include "zstdStream.I"
+
+#endif  // HAVE_ZSTD
+
+
+#endif
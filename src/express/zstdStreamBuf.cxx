@@ -0,0 +1,419 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file zstdStreamBuf.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "zstdStreamBuf.h"
+
+#ifdef HAVE_ZSTD
+
+#include "pnotify.h"
+#include "config_express.h"
+
+using std::ios;
+using std::streamoff;
+using std::streampos;
+
+/**
+ *
+ */
+ZstdStreamBuf::
+ZstdStreamBuf() {
+  _source = nullptr;
+  _owns_source = false;
+  _dest = nullptr;
+  _owns_dest = false;
+  _dctx = nullptr;
+  _cctx = nullptr;
+  _total_out = 0;
+  _read_eof = true;
+  _in.src = _decompress_buffer;
+  _in.size = 0;
+  _in.pos = 0;
+
+  _buffer = (char *)PANDA_MALLOC_ARRAY(4096);
+  char *ebuf = _buffer + 4096;
+  setg(_buffer, ebuf, ebuf);
+  setp(_buffer, ebuf);
+}
+
+/**
+ *
+ */
+ZstdStreamBuf::
+~ZstdStreamBuf() {
+  close_read();
+  close_write();
+  PANDA_FREE_ARRAY(_buffer);
+}
+
+/**
+ * Attaches the indicated source stream of zstd-compressed data.  If a
+ * dictionary is given, it must be the same one the data was compressed with;
+ * it is copied, so it need not persist.
+ */
+void ZstdStreamBuf::
+open_read(std::istream *source, bool owns_source, std::streamsize source_length,
+          const unsigned char *dictionary, size_t dictionary_size) {
+  _source = source;
+  _source_length = source_length;
+  _source_bytes_left = source_length;
+  _owns_source = owns_source;
+  _total_out = 0;
+  _read_eof = false;
+  _in.src = _decompress_buffer;
+  _in.size = 0;
+  _in.pos = 0;
+
+  _dctx = ZSTD_createDCtx();
+  if (_dctx == nullptr) {
+    express_cat.warning()
+      << "Unable to create zstd decompression context.\n";
+    close_read();
+    return;
+  }
+
+  if (dictionary != nullptr && dictionary_size != 0) {
+    size_t result = ZSTD_DCtx_loadDictionary(_dctx, dictionary, dictionary_size);
+    if (ZSTD_isError(result)) {
+      show_zstd_error("ZSTD_DCtx_loadDictionary", result);
+      close_read();
+      return;
+    }
+  }
+  thread_consider_yield();
+}
+
+/**
+ *
+ */
+void ZstdStreamBuf::
+close_read() {
+  _source_bytes_left = 0;
+  _read_eof = true;
+
+  if (_dctx != nullptr) {
+    ZSTD_freeDCtx(_dctx);
+    _dctx = nullptr;
+  }
+
+  if (_source != nullptr) {
+    if (_owns_source) {
+      delete _source;
+      _owns_source = false;
+    }
+    _source = nullptr;
+  }
+}
+
+/**
+ * Attaches the indicated destination stream, which will receive zstd-
+ * compressed data.  If a dictionary is given, the same dictionary will be
+ * required to decompress the data again.
+ */
+void ZstdStreamBuf::
+open_write(std::ostream *dest, bool owns_dest, int compression_level,
+           const unsigned char *dictionary, size_t dictionary_size) {
+  _dest = dest;
+  _owns_dest = owns_dest;
+
+  _cctx = ZSTD_createCCtx();
+  if (_cctx == nullptr) {
+    express_cat.warning()
+      << "Unable to create zstd compression context.\n";
+    close_write();
+    return;
+  }
+
+  size_t result = ZSTD_CCtx_setParameter(_cctx, ZSTD_c_compressionLevel, compression_level);
+  if (ZSTD_isError(result)) {
+    show_zstd_error("ZSTD_CCtx_setParameter", result);
+  }
+
+  // Record a checksum, so that corruption is detected on decompression.
+  ZSTD_CCtx_setParameter(_cctx, ZSTD_c_checksumFlag, 1);
+
+  if (dictionary != nullptr && dictionary_size != 0) {
+    result = ZSTD_CCtx_loadDictionary(_cctx, dictionary, dictionary_size);
+    if (ZSTD_isError(result)) {
+      show_zstd_error("ZSTD_CCtx_loadDictionary", result);
+      close_write();
+      return;
+    }
+  }
+  thread_consider_yield();
+}
+
+/**
+ *
+ */
+void ZstdStreamBuf::
+close_write() {
+  if (_dest != nullptr) {
+    if (_cctx != nullptr) {
+      size_t n = pptr() - pbase();
+      write_chars(pbase(), n, ZSTD_e_end);
+      pbump(-(int)n);
+
+      ZSTD_freeCCtx(_cctx);
+      _cctx = nullptr;
+    }
+    thread_consider_yield();
+
+    if (_owns_dest) {
+      delete _dest;
+      _owns_dest = false;
+    }
+    _dest = nullptr;
+  }
+}
+
+/**
+ * Implements seeking within the stream.  ZstdStreamBuf only allows seeking
+ * back to the beginning of the stream.
+ */
+streampos ZstdStreamBuf::
+seekoff(streamoff off, ios_seekdir dir, ios_openmode which) {
+  if (which != ios::in || _source == nullptr) {
+    // We can only do this with the input stream.
+    return -1;
+  }
+
+  // Determine the current position.
+  size_t n = egptr() - gptr();
+  streampos gpos = _total_out - n;
+
+  // Implement tellg() and seeks to current position.
+  if ((dir == ios::cur && off == 0) ||
+      (dir == ios::beg && off == gpos)) {
+    return gpos;
+  }
+
+  if (off != 0 || dir != ios::beg) {
+    // We only know how to reposition to the beginning.
+    return -1;
+  }
+
+  gbump(n);
+
+  if (_source->rdbuf()->pubseekpos(0, ios::in) == (streampos)0) {
+    _source->clear();
+    _source_bytes_left = _source_length;
+    _total_out = 0;
+    _read_eof = (_dctx == nullptr);
+    _in.size = 0;
+    _in.pos = 0;
+    if (_dctx != nullptr) {
+      // This keeps the dictionary, if any.
+      ZSTD_DCtx_reset(_dctx, ZSTD_reset_session_only);
+    }
+    return 0;
+  }
+
+  return -1;
+}
+
+/**
+ * Implements seeking within the stream.  ZstdStreamBuf only allows seeking
+ * back to the beginning of the stream.
+ */
+streampos ZstdStreamBuf::
+seekpos(streampos pos, ios_openmode which) {
+  return seekoff(pos, ios::beg, which);
+}
+
+/**
+ * Called by the system ostream implementation when its internal buffer is
+ * filled, plus one character.
+ */
+int ZstdStreamBuf::
+overflow(int ch) {
+  size_t n = pptr() - pbase();
+  if (n != 0) {
+    write_chars(pbase(), n, ZSTD_e_continue);
+    pbump(-(int)n);
+  }
+
+  if (ch != EOF) {
+    // Write one more character.
+    char c = ch;
+    write_chars(&c, 1, ZSTD_e_continue);
+  }
+
+  return 0;
+}
+
+/**
+ * Called by the system iostream implementation to implement a flush
+ * operation.
+ */
+int ZstdStreamBuf::
+sync() {
+  if (_source != nullptr) {
+    size_t n = egptr() - gptr();
+    gbump(n);
+  }
+
+  if (_dest != nullptr) {
+    size_t n = pptr() - pbase();
+    write_chars(pbase(), n, ZSTD_e_flush);
+    pbump(-(int)n);
+    _dest->flush();
+  }
+
+  return 0;
+}
+
+/**
+ * Called by the system istream implementation when its internal buffer needs
+ * more characters.
+ */
+int ZstdStreamBuf::
+underflow() {
+  // Sometimes underflow() is called even if the buffer is not empty.
+  if (gptr() >= egptr()) {
+    size_t buffer_size = egptr() - eback();
+    gbump(-(int)buffer_size);
+
+    size_t num_bytes = buffer_size;
+    size_t read_count = read_chars(gptr(), buffer_size);
+
+    if (read_count != num_bytes) {
+      // Oops, we didn't read what we thought we would.
+      if (read_count == 0) {
+        gbump(num_bytes);
+        return EOF;
+      }
+
+      // Slide what we did read to the top of the buffer.
+      nassertr(read_count < num_bytes, EOF);
+      size_t delta = num_bytes - read_count;
+      memmove(gptr() + delta, gptr(), read_count);
+      gbump(delta);
+    }
+  }
+
+  return (unsigned char)*gptr();
+}
+
+/**
+ * Gets some characters from the source stream.
+ */
+size_t ZstdStreamBuf::
+read_chars(char *start, size_t length) {
+  if (_read_eof || _dctx == nullptr) {
+    return 0;
+  }
+
+  ZSTD_outBuffer out;
+  out.dst = start;
+  out.size = length;
+  out.pos = 0;
+
+  while (out.pos < out.size) {
+    bool source_eof = (_source_bytes_left == 0 || _source->eof() || _source->fail());
+    if (_in.pos >= _in.size && !source_eof) {
+      std::streamsize read_count;
+      if (_source_bytes_left >= 0) {
+        // Don't read more than the specified limit.
+        _source->read(_decompress_buffer,
+          std::min(_source_bytes_left, (std::streamsize)decompress_buffer_size));
+        read_count = _source->gcount();
+        _source_bytes_left -= read_count;
+      } else {
+        _source->read(_decompress_buffer, decompress_buffer_size);
+        read_count = _source->gcount();
+      }
+      _in.src = _decompress_buffer;
+      _in.size = (size_t)read_count;
+      _in.pos = 0;
+    }
+
+    size_t prev_out = out.pos;
+    size_t prev_in = _in.pos;
+    size_t result = ZSTD_decompressStream(_dctx, &out, &_in);
+    thread_consider_yield();
+
+    if (ZSTD_isError(result)) {
+      show_zstd_error("ZSTD_decompressStream", result);
+      _read_eof = true;
+      break;
+    }
+
+    if (out.pos == prev_out && _in.pos == prev_in && _in.pos >= _in.size) {
+      // No progress is possible without more input, and there is no more
+      // input.  If the last frame was not complete (result != 0), the input
+      // stream was truncated.
+      if (result != 0) {
+        express_cat.warning()
+          << "zstd stream is truncated.\n";
+      }
+      _read_eof = true;
+      break;
+    }
+  }
+
+  _total_out += out.pos;
+  return out.pos;
+}
+
+/**
+ * Sends some characters to the dest stream.  The mode parameter is passed to
+ * ZSTD_compressStream2().
+ */
+void ZstdStreamBuf::
+write_chars(const char *start, size_t length, ZSTD_EndDirective mode) {
+  static const size_t compress_buffer_size = 4096;
+  char compress_buffer[compress_buffer_size];
+
+  ZSTD_inBuffer in;
+  in.src = start;
+  in.size = length;
+  in.pos = 0;
+
+  bool finished;
+  do {
+    ZSTD_outBuffer out;
+    out.dst = compress_buffer;
+    out.size = compress_buffer_size;
+    out.pos = 0;
+
+    size_t remaining = ZSTD_compressStream2(_cctx, &out, &in, mode);
+    if (ZSTD_isError(remaining)) {
+      show_zstd_error("ZSTD_compressStream2", remaining);
+      return;
+    }
+    if (out.pos != 0) {
+      _dest->write(compress_buffer, out.pos);
+    }
+    thread_consider_yield();
+
+    if (mode == ZSTD_e_continue) {
+      finished = (in.pos == in.size);
+    } else {
+      // When flushing or ending the frame, keep going until zstd reports
+      // that it has nothing left to write.
+      finished = (remaining == 0);
+    }
+  } while (!finished);
+}
+
+/**
+ * Reports a recent error code returned by zstd.
+ */
+void ZstdStreamBuf::
+show_zstd_error(const char *function, size_t error_code) {
+  express_cat.warning()
+    << "zstd error in " << function << ": "
+    << ZSTD_getErrorName(error_code) << "\n";
+}
+
+#endif  // HAVE_ZSTD
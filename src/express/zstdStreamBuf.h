@@ -0,0 +1,90 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file zstdStreamBuf.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef ZSTDSTREAMBUF_H
+#define ZSTDSTREAMBUF_H
+
+#include "pandabase.h"
+
+// This module is not compiled if zstd is not available.
+#ifdef HAVE_ZSTD
+
+#include <zstd.h>
+
+/**
+ * The streambuf object that implements IZstdDecompressStream and
+ * OZstdCompressStream.
+ */
+class EXPCL_PANDA_EXPRESS ZstdStreamBuf : public std::streambuf {
+public:
+  ZstdStreamBuf();
+  virtual ~ZstdStreamBuf();
+
+  void open_read(std::istream *source, bool owns_source,
+                 std::streamsize source_length = -1,
+                 const unsigned char *dictionary = nullptr,
+                 size_t dictionary_size = 0);
+  void close_read();
+
+  void open_write(std::ostream *dest, bool owns_dest, int compression_level,
+                  const unsigned char *dictionary = nullptr,
+                  size_t dictionary_size = 0);
+  void close_write();
+
+  virtual std::streampos seekoff(std::streamoff off, ios_seekdir dir, ios_openmode which);
+  virtual std::streampos seekpos(std::streampos pos, ios_openmode which);
+
+protected:
+  virtual int overflow(int c);
+  virtual int sync();
+  virtual int underflow();
+
+private:
+  size_t read_chars(char *start, size_t length);
+  void write_chars(const char *start, size_t length, ZSTD_EndDirective mode);
+  void show_zstd_error(const char *function, size_t error_code);
+
+private:
+  std::istream *_source;
+  std::streamsize _source_length = -1;
+  std::streamsize _source_bytes_left = -1;
+  bool _owns_source;
+
+  std::ostream *_dest;
+  bool _owns_dest;
+
+  ZSTD_DCtx *_dctx;
+  ZSTD_CCtx *_cctx;
+
+  // The number of uncompressed bytes returned by read_chars() so far.
+  size_t _total_out;
+
+  // Set when the end of the last frame has been reached, or an error has
+  // occurred.
+  bool _read_eof;
+
+  char *_buffer;
+
+  // As in ZStreamBuf, we need to hold on to the compressed input between
+  // calls to read_chars(), since zstd might not consume all of it at once.
+  // zstd prefers to be handed input in fairly large blocks.
+  enum {
+    decompress_buffer_size = 16384
+  };
+  char _decompress_buffer[decompress_buffer_size];
+  ZSTD_inBuffer _in;
+};
+
+#endif  // HAVE_ZSTD
+
+#endif
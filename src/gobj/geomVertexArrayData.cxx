@@ -24,6 +24,7 @@
 #include "simpleAllocator.h"
 #include "vertexDataBuffer.h"
 #include "pbitops.h"
+#include "pipeline.h"
 
 using std::max;
 using std::min;
@@ -528,6 +529,12 @@ write_datagram(BamWriter *manager, Datagram &dg, void *extra_data) const {
 
   dg.add_uint32(_buffer.get_size());
 
+  if (manager->get_file_minor_ver() >= 2) {
+    // Align the data within the file, so that it may be referenced in place
+    // when the file is memory-mapped.
+    manager->write_alignment_padding(dg, MEMORY_HOOK_ALIGNMENT);
+  }
+
   if (manager->get_file_endian() == BamWriter::BE_native) {
     // For native endianness, we only have to write the data directly.
     dg.append_data(_buffer.get_read_pointer(true), _buffer.get_size());
@@ -550,13 +557,42 @@ fillin(DatagramIterator &scan, BamReader *manager, void *extra_data) {
   _usage_hint = (UsageHint)scan.get_uint8();
 
   size_t size = scan.get_uint32();
-  _buffer.unclean_realloc(size);
-  _buffer.set_size(size);
 
-  const unsigned char *source_data =
-    (const unsigned char *)scan.get_datagram().get_data();
-  memcpy(_buffer.get_write_pointer(), source_data + scan.get_current_index(), size);
-  scan.skip_bytes(size);
+  if (manager->get_file_minor_ver() >= 2) {
+    manager->skip_alignment_padding(scan);
+  }
+
+  PT(VirtualFileMapping) mapping;
+  const unsigned char *mapped_data = nullptr;
+  if (manager->get_file_endian() == BamReader::BE_native &&
+      manager->get_mapped_data(scan, size, MEMORY_HOOK_ALIGNMENT, mapping, mapped_data)) {
+    // The file is memory-mapped, so we can reference the data in place
+    // rather than copying it.
+    _buffer.set_mapped_data(mapping, mapped_data, size);
+
+  } else {
+    _buffer.unclean_realloc(size);
+    _buffer.set_size(size);
+    unsigned char *dest = _buffer.get_write_pointer();
+
+    if (manager->get_file_endian() == BamReader::BE_native &&
+        _independent_lru.get_max_size() == (size_t)-1 &&
+        Pipeline::get_render_pipeline()->get_num_stages() == 1) {
+      // Copying the data out may be left for the BamReader to do in parallel
+      // with the other large arrays in the file.  This is only safe if
+      // nothing can evict or copy the buffer before then, and if we don't
+      // need to look at the data ourselves.
+      manager->defer_decode(scan, size, [dest, size] (DatagramIterator &scan) {
+        scan.extract_bytes(dest, size);
+      });
+
+    } else {
+      scan.extract_bytes(dest, size);
+    }
+  }
+  if (mapped_data != nullptr) {
+    scan.skip_bytes(size);
+  }
 
   bool endian_reversed = false;
 
@@ -10888,8 +10888,12 @@ do_fillin_rawdata(CData *cdata, DatagramIterator &scan, BamReader *manager) {
     }
 
     if (!textures_header_only) {
+      // The image data may be copied out by the BamReader later, possibly in
+      // parallel with other large payloads in the file.
       PTA_uchar image = PTA_uchar::empty_array(u_size, get_class_type());
-      scan.extract_bytes(image.p(), u_size);
+      manager->defer_decode(scan, u_size, [image, u_size] (DatagramIterator &scan) {
+        scan.extract_bytes((unsigned char *)image.p(), u_size);
+      });
       cdata->_ram_images[n]._image = image;
 
     } else {
@@ -39,6 +39,8 @@ operator = (const VertexDataBuffer &copy) {
   _size = copy._size;
   _reserved_size = copy._size;
   _block = copy._block;
+  _mapping = copy._mapping;
+  _mapped_data = copy._mapped_data;
   nassertv(_reserved_size >= _size);
 }
 
@@ -55,6 +57,8 @@ swap(VertexDataBuffer &other) {
   size_t reserved_size = _reserved_size;
 
   _block.swap(other._block);
+  _mapping.swap(other._mapping);
+  std::swap(_mapped_data, other._mapped_data);
 
   _resident_data = other._resident_data;
   _size = other._size;
@@ -119,8 +123,10 @@ do_unclean_realloc(size_t reserved_size) {
         << this << ".unclean_realloc(" << reserved_size << ")\n";
     }
 
-    // If we're paged out, discard the page.
+    // If we're paged out or mapped, discard the page or mapping.
     _block = nullptr;
+    _mapping.clear();
+    _mapped_data = nullptr;
 
     if (_resident_data != nullptr) {
       nassertv(_reserved_size != 0);
@@ -151,8 +157,9 @@ do_unclean_realloc(size_t reserved_size) {
  */
 void VertexDataBuffer::
 do_page_out(VertexDataBook &book) {
-  if (_block != nullptr || _reserved_size == 0) {
-    // We're already paged out.
+  if (_block != nullptr || _mapped_data != nullptr || _reserved_size == 0) {
+    // We're already paged out, or we're mapped, in which case the data
+    // doesn't occupy independent memory anyway.
     return;
   }
   nassertv(_resident_data != nullptr);
@@ -194,11 +201,47 @@ do_page_in() {
     return;
   }
 
-  nassertv(_block != nullptr);
   nassertv(_reserved_size == _size);
 
+  if (_mapped_data != nullptr) {
+    // Copy the data out of the mapping.  We don't need the mapping any more
+    // after this.
+    _resident_data = (unsigned char *)get_class_type().allocate_array(_size);
+    nassertv(_resident_data != nullptr);
+
+    memcpy(_resident_data, _mapped_data, _size);
+    _mapping.clear();
+    _mapped_data = nullptr;
+    return;
+  }
+
+  nassertv(_block != nullptr);
+
   _resident_data = (unsigned char *)get_class_type().allocate_array(_size);
   nassertv(_resident_data != nullptr);
 
   memcpy(_resident_data, _block->get_pointer(true), _size);
 }
+
+/**
+ * Makes the buffer a read-only view of the indicated size bytes of data
+ * within the memory-mapped file, which must be aligned to
+ * MEMORY_HOOK_ALIGNMENT.  The buffer keeps a reference to the mapping for as
+ * long as it refers to the data; the data is copied into independent memory
+ * the first time the buffer is modified.
+ */
+void VertexDataBuffer::
+set_mapped_data(VirtualFileMapping *mapping, const unsigned char *data,
+                size_t size) {
+  LightMutexHolder holder(_lock);
+  nassertv(((uintptr_t)data % MEMORY_HOOK_ALIGNMENT) == 0);
+
+  do_unclean_realloc(0);
+  if (size != 0) {
+    nassertv(mapping != nullptr && data != nullptr);
+    _mapping = mapping;
+    _mapped_data = data;
+    _size = size;
+    _reserved_size = size;
+  }
+}
@@ -19,6 +19,7 @@
 #include "vertexDataBlock.h"
 #include "pointerTo.h"
 #include "virtualFile.h"
+#include "virtualFileMapping.h"
 #include "pStatCollector.h"
 #include "lightMutex.h"
 #include "lightMutexHolder.h"
@@ -27,7 +28,7 @@
  * A block of bytes that stores the actual raw vertex data referenced by a
  * GeomVertexArrayData object.
  *
- * At any point, a buffer may be in any of two states:
+ * At any point, a buffer may be in any of three states:
  *
  * independent - the buffer's memory is resident, and owned by the
  * VertexDataBuffer object itself (in _resident_data).  In this state,
@@ -39,6 +40,11 @@
  * memory is considered read-only.  In this state, _reserved_size will always
  * equal _size.
  *
+ * mapped - the buffer's memory is a read-only view into a memory-mapped file
+ * (typically a bam file), which is kept open by _mapping.  As with the paged
+ * state, _reserved_size will always equal _size, and any attempt to modify
+ * the buffer copies it into independent memory first.
+ *
  * VertexDataBuffers start out in independent state.  They get moved to paged
  * state when their owning GeomVertexArrayData objects get evicted from the
  * _independent_lru.  They can get moved back to independent state if they are
@@ -69,6 +75,10 @@ public:
 
   INLINE void page_out(VertexDataBook &book);
 
+  void set_mapped_data(VirtualFileMapping *mapping,
+                       const unsigned char *data, size_t size);
+  INLINE bool is_mapped() const;
+
   void swap(VertexDataBuffer &other);
 
 private:
@@ -82,6 +92,8 @@ private:
   size_t _size;
   size_t _reserved_size;
   PT(VertexDataBlock) _block;
+  PT(VirtualFileMapping) _mapping;
+  const unsigned char *_mapped_data;
   LightMutex _lock;
 
 public:
@@ -3,7 +3,7 @@
 
   #define BUILDING_DLL BUILDING_PANDA_JOBSYSTEM
 
-  #define LOCAL_LIBS pipeline pstatclient mathutil express
+  #define LOCAL_LIBS pipeline pstatclient mathutil putil event express
 
   #define HEADERS \
     config_jobsystem.h \
@@ -17,6 +17,8 @@
 #include "pStatCollector.h"
 #include "pStatTimer.h"
 #include "virtualFileSystem.h"
+#include "bamReader.h"
+#include "asyncTaskChain.h"
 
 static PStatCollector parallel_proc_pcollector("JobSystem:ParallelProcess");
 static PStatCollector schedule_pcollector("JobSystem:Schedule");
@@ -26,6 +28,7 @@ static PStatCollector wait_job_pcollector("JobSystem:WaitJob");
 static PStatCollector exec_job_pcollector("JobSystem:ExecuteJobWhileWaiting");
 
 JobSystem *JobSystem::_global_ptr = nullptr;
+JobSystem *JobSystem::_task_chain_system = nullptr;
 
 /**
  *
@@ -67,9 +70,62 @@ initialize() {
     _worker_threads.push_back(thread);
   }
 
+  if (num_workers > 0) {
+    // Let bam files decode their large payloads on the worker threads.
+    BamReader::set_parallel_func(&bam_parallel_process);
+
+    // Let task chains that ask for it run their tasks on the worker threads.
+    if (_task_chain_system == nullptr) {
+      _task_chain_system = this;
+      AsyncTaskChain::set_job_func(&task_chain_job);
+    }
+  }
+
   _initialized = true;
 }
 
+/**
+ * Installed on the BamReader to run its deferred payload decodes in parallel
+ * on the global job system.  As with task_chain_job(), only the worker threads
+ * and the main thread may push jobs; bam files read on any other thread, such
+ * as a Loader thread, decode their payloads inline.
+ */
+void JobSystem::
+bam_parallel_process(int count, const std::function<void(int)> &func) {
+  Thread *thread = Thread::get_current_thread();
+  if (_global_ptr == nullptr ||
+      (thread != Thread::get_main_thread() &&
+       thread->get_type() != JobWorkerThread::get_class_type())) {
+    for (int i = 0; i < count; ++i) {
+      func(i);
+    }
+    return;
+  }
+
+  // The items are split up among the workers by the ParallelProcessJob.
+  _global_ptr->parallel_process(count, func);
+}
+
+/**
+ * Installed on AsyncTaskChain to run the tasks of chains that use the job
+ * system.  Only the worker threads and the main thread may push jobs, since
+ * each of them owns a queue; other threads return false, and the chain picks
+ * the work up again on its next poll from the main thread.
+ */
+bool JobSystem::
+task_chain_job(void (*func)(void *), void *data) {
+  Thread *thread = Thread::get_current_thread();
+  if (thread != Thread::get_main_thread() &&
+      thread->get_type() != JobWorkerThread::get_class_type()) {
+    return false;
+  }
+
+  _task_chain_system->schedule(new GenericJob([func, data] () {
+    (*func)(data);
+  }));
+  return true;
+}
+
 /**
  *
  */
@@ -228,7 +284,7 @@ wait_job(Job *job, Thread *thread) {
       if (job2->unref()) {
         job2->set_state(Job::S_complete);
       } else {
-        delete job;
+        delete job2;
       }
 
       //push_event(JobSystemEvent::ET_finish_job);
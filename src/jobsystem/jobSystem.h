@@ -114,7 +114,11 @@ public:
   JobSystemEvent *_events_tail;
 
 private:
+  static void bam_parallel_process(int count, const std::function<void(int)> &func);
+  static bool task_chain_job(void (*func)(void *), void *data);
+
   static JobSystem *_global_ptr;
+  static JobSystem *_task_chain_system;
 };
 
 extern thread_local int js_steal_idx;
@@ -509,6 +509,20 @@ write_datagram_fixed(Datagram &destination) const {
  */
 void FLOATNAME(LMatrix4)::
 read_datagram_fixed(DatagramIterator &scan) {
+  if (scan.has_remaining(16 * sizeof(FLOATTYPE))) {
+    // The whole matrix is there; no need to check each component.
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 4; ++j) {
+#if FLOATTOKEN == 'f'
+        set_cell(i, j, scan.get_float32_unchecked());
+#else
+        set_cell(i, j, scan.get_float64_unchecked());
+#endif
+      }
+    }
+    return;
+  }
+
   for (int i = 0; i < 4; ++i) {
     for (int j = 0; j < 4; ++j) {
 #if FLOATTOKEN == 'f'
@@ -539,6 +553,18 @@ write_datagram(Datagram &destination) const {
  */
 void FLOATNAME(LMatrix4)::
 read_datagram(DatagramIterator &scan) {
+  size_t component_size = scan.get_datagram().get_stdfloat_double()
+    ? sizeof(PN_float64) : sizeof(PN_float32);
+  if (scan.has_remaining(16 * component_size)) {
+    // The whole matrix is there; no need to check each component.
+    for (int i = 0; i < 4; ++i) {
+      for (int j = 0; j < 4; ++j) {
+        set_cell(i, j, scan.get_stdfloat_unchecked());
+      }
+    }
+    return;
+  }
+
   for (int i = 0; i < 4; ++i) {
     for (int j = 0; j < 4; ++j) {
       set_cell(i, j, scan.get_stdfloat());
@@ -16,6 +16,7 @@
     mapData.h mapData.I \
     mapEntity.h mapEntity.I \
     mapLightingEffect.h mapLightingEffect.I \
+    mapOcclusionBuffer.h mapOcclusionBuffer.I \
     mapRender.h mapRender.I \
     mapRoot.h mapRoot.I \
     spatialPartition.h spatialPartition.I \
@@ -31,6 +32,7 @@
     mapData.cxx \
     mapEntity.cxx \
     mapLightingEffect.cxx \
+    mapOcclusionBuffer.cxx \
     mapRender.cxx \
     mapRoot.cxx \
     spatialPartition.cxx \
@@ -301,6 +301,7 @@ cull_callback(CullTraverser *trav, CullTraverserData &data) {
   PStatTimer timer(dvn_trav_pcollector);
 
   const BitArray &pvs = mtrav->_pvs;
+  const MapOcclusionBuffer *occlusion = mtrav->_occlusion_buffer;
   //int num_visgroups = mtrav->_data->get_num_clusters();
 
   SimpleHashMap<ChildInfo *, std::nullptr_t, pointer_hash> traversed;
@@ -328,6 +329,11 @@ cull_callback(CullTraverser *trav, CullTraverserData &data) {
     for (size_t j = 0; j < children.size(); ++j) {
       ChildInfo *child = children.get_key(j);
       if (traversed.find(child) == -1) {
+        if (occlusion != nullptr && !occlusion->is_bounds_visible(child->_node->get_bounds())) {
+          // Hidden behind the map's occluders.
+          traversed.store(child, nullptr);
+          continue;
+        }
         {
           //PStatTimer timer2(dvn_trav_node_pcollector);
           trav->traverse_down(data, child->_node);
@@ -22,9 +22,26 @@
 #include "textureAttrib.h"
 #include "textureStage.h"
 #include "shaderAttrib.h"
+#include "mapLightingEffect.h"
+#include "light.h"
+#include "pointLight.h"
+#include "spotlight.h"
+#include "configVariableInt.h"
+#include "config_map.h"
+#include "patomic.h"
 
 IMPLEMENT_CLASS(MapCullTraverser);
 
+static ConfigVariableInt map_lighting_max_sector_lights
+  ("map-lighting-max-sector-lights", 128,
+   PRC_DESC("Specifies the maximum number of lights that can be binned into a "
+            "single view frustum sector for the purpose of selecting lights "
+            "for MapLightingEffect nodes.  If more lights than this reach a "
+            "sector, the ones nearest to the sector are kept, and a warning "
+            "is printed the first time it happens."));
+
+static patomic<bool> warned_sector_overflow(false);
+
 /**
  *
  */
@@ -32,7 +49,12 @@ MapCullTraverser::
 MapCullTraverser(const CullTraverser &copy, MapData *data) :
   CullTraverser(copy),
   _data(data),
-  _view_cluster(-1)
+  _view_cluster(-1),
+  _occlusion_buffer(nullptr),
+  _built_light_bins(false),
+  _light_culler(nullptr),
+  _num_binned_lights(0),
+  _bin_light_stamp(0)
 {
 }
 
@@ -64,3 +86,115 @@ determine_view_cluster(const LPoint3 &camera_pos) {
     }
   }
 }
+
+/**
+ * Bins the static lights of the map and the current set of dynamic lights
+ * into the view frustum sectors of the display region's qpLightCuller, if
+ * that has not already been done during this traversal.  Returns true if the
+ * light bins are available, or false if there is no light culler for the
+ * current display region, in which case lights should be selected without
+ * the clustered grid.
+ */
+bool MapCullTraverser::
+check_light_bins() {
+  if (_built_light_bins) {
+    return _light_culler != nullptr;
+  }
+  _built_light_bins = true;
+
+  const qpLightCuller *culler = _scene_setup->get_light_culler();
+  if (culler == nullptr || culler->get_num_sectors() == 0 || _data == nullptr) {
+    return false;
+  }
+
+  const LMatrix4 *world_to_view = _scene_setup->get_camera_path().get_net_transform()->get_inverse_mat();
+  if (world_to_view == nullptr) {
+    return false;
+  }
+  _light_world_to_view = *world_to_view;
+
+  _data->check_lighting_pvs();
+
+  _bin_light_nodes.clear();
+  _bin_light_indices.clear();
+  _bin_light_spheres.clear();
+
+  // Static lights of the map.
+  for (size_t i = 0; i < _data->_lights.size(); ++i) {
+    const LVecBase4 &sphere = _data->_light_spheres[i];
+    if (sphere[3] < 0.0f) {
+      // Directional light.
+      continue;
+    }
+    _bin_light_nodes.push_back(_data->_lights[i].node());
+    _bin_light_indices.push_back((int)i);
+    _bin_light_spheres.push_back(sphere);
+  }
+
+  // Dynamic lights.
+  NodePath dyn_root = MapLightingEffect::get_dynamic_light_root();
+  if (!dyn_root.is_empty()) {
+    PandaNode::Children dyn_lights = dyn_root.node()->get_children();
+    for (int i = 0; i < dyn_lights.get_num_children(); ++i) {
+      PandaNode *child = dyn_lights.get_child(i);
+      Light *light = child->as_light();
+      if (light == nullptr) {
+        continue;
+      }
+
+      PN_stdfloat max_distance;
+      if (light->get_light_type() == Light::LT_point) {
+        max_distance = DCAST(PointLight, child)->get_max_distance();
+      } else if (light->get_light_type() == Light::LT_spot) {
+        max_distance = DCAST(Spotlight, child)->get_max_distance();
+      } else {
+        // This light type is not supported for dynamic lights.
+        continue;
+      }
+
+      _bin_light_nodes.push_back(child);
+      _bin_light_indices.push_back(-1);
+      _bin_light_spheres.push_back(LVecBase4(child->get_transform()->get_pos(), max_distance));
+    }
+  }
+
+  // Move the lights with an infinite range to the end of the list.  Binning
+  // them would put them in every sector, where they would crowd out the
+  // nearby lights, so they skip the grid and are considered for every node,
+  // as they would be without the grid.
+  _num_binned_lights = 0;
+  for (size_t i = 0; i < _bin_light_spheres.size(); ++i) {
+    if (cinf(_bin_light_spheres[i][3])) {
+      continue;
+    }
+    if ((size_t)_num_binned_lights != i) {
+      std::swap(_bin_light_nodes[i], _bin_light_nodes[_num_binned_lights]);
+      std::swap(_bin_light_indices[i], _bin_light_indices[_num_binned_lights]);
+      std::swap(_bin_light_spheres[i], _bin_light_spheres[_num_binned_lights]);
+    }
+    ++_num_binned_lights;
+  }
+
+  culler->bin_spheres(_light_world_to_view, _bin_light_spheres.data(),
+                      _num_binned_lights, _light_bins,
+                      map_lighting_max_sector_lights);
+
+  if (_light_bins._num_overflowed != 0) {
+    if (!warned_sector_overflow.exchange(true)) {
+      map_cat.warning()
+        << _light_bins._num_overflowed << " light grid sectors overlap more than "
+        << map_lighting_max_sector_lights << " lights; only the nearest lights "
+        << "are kept in those sectors.  Consider raising "
+        << "map-lighting-max-sector-lights.\n";
+    } else if (map_cat.is_debug()) {
+      map_cat.debug()
+        << _light_bins._num_overflowed << " light grid sectors overflowed.\n";
+    }
+  }
+
+  _bin_light_marks.assign(_bin_light_nodes.size(), 0);
+  _bin_light_stamp = 0;
+
+  _light_culler = culler;
+  return true;
+}
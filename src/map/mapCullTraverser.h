@@ -16,8 +16,11 @@
 
 #include "pandabase.h"
 #include "cullTraverser.h"
+#include "qpLightCuller.h"
+#include "vector_int.h"
 
 class MapData;
+class MapOcclusionBuffer;
 
 /**
  * This is a special kind of CullTraverser that is utilized by the map system.
@@ -37,6 +40,8 @@ PUBLISHED:
   void determine_view_cluster(const LPoint3 &camera_pos);
 
 public:
+  bool check_light_bins();
+
   // What cluster does the camera currently reside in?  Determined before
   // traversal starts.
   int _view_cluster;
@@ -46,6 +51,32 @@ public:
   BitArray _pvs;
 
   MapData *_data;
+
+  // Software occlusion buffer rendered from the camera before the traversal,
+  // or nullptr if occlusion culling is not enabled for this camera.
+  const MapOcclusionBuffer *_occlusion_buffer;
+
+  // The map's lights binned into the view frustum sectors of the display
+  // region's light culler.  Built on demand the first time a
+  // MapLightingEffect needs to select lights during this traversal.
+  bool _built_light_bins;
+  const qpLightCuller *_light_culler;
+  LMatrix4 _light_world_to_view;
+  qpLightCuller::SectorBins _light_bins;
+  // For each binned light, the light node and the index into the map's
+  // static light list, or -1 if it is a dynamic light.  The first
+  // _num_binned_lights lights are binned into the sectors.  The rest have an
+  // infinite range, which would put them in every sector, so they are
+  // considered for every node instead.
+  pvector<PandaNode *> _bin_light_nodes;
+  vector_int _bin_light_indices;
+  pvector<LVecBase4> _bin_light_spheres;
+  int _num_binned_lights;
+
+  // Scratch data for per-object light selection.
+  vector_int _bin_sectors;
+  vector_int _bin_light_marks;
+  int _bin_light_stamp;
 };
 
 
@@ -22,7 +22,12 @@
 #include "material.h"
 #include "light.h"
 #include "directionalLight.h"
+#include "pointLight.h"
+#include "spotlight.h"
 #include "config_map.h"
+#include "geomVertexReader.h"
+#include "transformState.h"
+#include "lightMutexHolder.h"
 
 IMPLEMENT_CLASS(MapData);
 
@@ -512,25 +517,159 @@ build_trace_scene() {
   }
 }
 
+/**
+ * Adds the triangles of the indicated Geom as an occluder for software
+ * occlusion culling.  This can be used to designate geometry outside of the
+ * world model as an occluder, such as large static props.  If a transform is
+ * given, the vertices are transformed by it into world space.
+ */
+void MapData::
+add_occluder(const Geom *geom, const TransformState *net_transform) {
+  PT(Geom) dgeom = geom->decompose();
+  if (dgeom->get_primitive_type() != Geom::PT_polygons) {
+    return;
+  }
+
+  LMatrix4 mat = LMatrix4::ident_mat();
+  if (net_transform != nullptr) {
+    mat = net_transform->get_mat();
+  }
+
+  MapOccluder occ;
+  occ._mins.set(1e24, 1e24, 1e24);
+  occ._maxs.set(-1e24, -1e24, -1e24);
+
+  const GeomVertexData *vdata = dgeom->get_vertex_data();
+  GeomVertexReader reader(vdata, InternalName::get_vertex());
+  int num_rows = vdata->get_num_rows();
+  occ._vertices.reserve(num_rows);
+  for (int i = 0; i < num_rows; ++i) {
+    LPoint3 pos = mat.xform_point(reader.get_data3());
+    occ._vertices.push_back(LCAST(float, pos));
+    occ._mins = occ._mins.fmin(pos);
+    occ._maxs = occ._maxs.fmax(pos);
+  }
+
+  for (int i = 0; i < dgeom->get_num_primitives(); ++i) {
+    const GeomPrimitive *prim = dgeom->get_primitive(i);
+    for (int j = 0; j < prim->get_num_primitives(); ++j) {
+      int start = prim->get_primitive_start(j);
+      occ._indices.push_back(prim->get_vertex(start));
+      occ._indices.push_back(prim->get_vertex(start + 1));
+      occ._indices.push_back(prim->get_vertex(start + 2));
+    }
+  }
+
+  if (!occ._indices.empty()) {
+    _occluders.push_back(std::move(occ));
+  }
+}
+
+/**
+ * Removes all of the occluders from the map, including those added with
+ * add_occluder().  The occluders of the world geometry are derived again by
+ * the next call to check_occluders().
+ */
+void MapData::
+clear_occluders() {
+  LightMutexHolder holder(_build_lock);
+  _occluders.clear();
+  _built_occluders.store(false);
+}
+
+/**
+ * Derives occluder meshes from the opaque geometry of the world model, if
+ * that has not already been done.  Transparent and sky geometry is excluded,
+ * the same as for the ray trace scene.
+ *
+ * This may be called from several cull threads at once.  The first caller
+ * builds the occluders while the others wait for it to finish.
+ */
+void MapData::
+check_occluders() {
+  if (_built_occluders.load(std::memory_order_acquire)) {
+    return;
+  }
+
+  LightMutexHolder holder(_build_lock);
+  if (_built_occluders.load(std::memory_order_relaxed)) {
+    // Another thread built them while we were waiting for the lock.
+    return;
+  }
+
+  if (_models.empty() || _models[0]._geom_node == nullptr) {
+    _built_occluders.store(true, std::memory_order_release);
+    return;
+  }
+
+  const MapModel *model = &_models[0];
+  for (int j = 0; j < model->_geom_node->get_num_geoms(); ++j) {
+    const Geom *geom = model->_geom_node->get_geom(j);
+    const RenderState *state = model->_geom_node->get_geom_state(j);
+    const MaterialAttrib *mattr;
+    state->get_attrib_def(mattr);
+    Material *mat = mattr->get_material();
+    if (mat != nullptr) {
+      if ((mat->_attrib_flags & Material::F_transparency) != 0 && mat->_transparency_mode != 0) {
+        continue;
+      }
+      if (mat->has_tag("compile_sky")) {
+        continue;
+      }
+    }
+    add_occluder(geom);
+  }
+
+  if (map_cat.is_debug()) {
+    size_t num_tris = 0;
+    for (const MapOccluder &occ : _occluders) {
+      num_tris += occ._indices.size() / 3;
+    }
+    map_cat.debug()
+      << "Built " << _occluders.size() << " occluders with " << num_tris
+      << " triangles\n";
+  }
+
+  _built_occluders.store(true, std::memory_order_release);
+}
+
 /**
  *
  */
 void MapData::
 check_lighting_pvs() {
-  if (_built_light_pvs) {
+  if (_built_light_pvs.load(std::memory_order_acquire)) {
+    return;
+  }
+
+  LightMutexHolder holder(_build_lock);
+  if (_built_light_pvs.load(std::memory_order_relaxed)) {
     return;
   }
 
   _light_pvs.resize(_cluster_pvs.size());
   _probe_pvs.resize(_cluster_pvs.size());
   _cube_map_pvs.resize(_cluster_pvs.size());
+  _light_spheres.resize(_lights.size());
 
   for (size_t i = 0; i < _lights.size(); ++i) {
-    if (_lights[i].node()->is_of_type(DirectionalLight::get_class_type())) {
+    PandaNode *node = _lights[i].node();
+    if (node->is_of_type(DirectionalLight::get_class_type())) {
+      _light_spheres[i].set(0.0f, 0.0f, 0.0f, -1.0f);
       continue;
     }
 
-    int cluster = _cluster_tree->get_leaf_value_from_point(_lights[i].get_net_transform()->get_pos());
+    LPoint3 pos = _lights[i].get_net_transform()->get_pos();
+
+    PN_stdfloat max_distance = make_inf((PN_stdfloat)0);
+    if (node->is_of_type(PointLight::get_class_type())) {
+      max_distance = DCAST(PointLight, node)->get_max_distance();
+    } else if (node->is_of_type(Spotlight::get_class_type())) {
+      max_distance = DCAST(Spotlight, node)->get_max_distance();
+    }
+    _light_spheres[i].set(pos[0], pos[1], pos[2], max_distance);
+
+    int cluster = _cluster_tree->get_leaf_value_from_point(pos);
     if (cluster < 0) {
       continue;
     }
@@ -567,5 +706,5 @@ check_lighting_pvs() {
     }
   }
 
-  _built_light_pvs = true;
+  _built_light_pvs.store(true, std::memory_order_release);
 }
@@ -29,6 +29,8 @@
 #include "rayTraceTriangleMesh.h"
 #include "rayTraceScene.h"
 #include "geomVertexArrayData.h"
+#include "patomic.h"
+#include "lightMutex.h"
 
 class SteamAudioSceneData {
 PUBLISHED:
@@ -233,6 +235,24 @@ public:
   vector_int _tri_list;
 };
 
+/**
+ * A triangle mesh in the map that hides objects behind it.  Occluders are
+ * rasterized into a MapOcclusionBuffer each frame to cull objects that the
+ * PVS and view frustum can't.
+ */
+class EXPCL_PANDA_MAP MapOccluder {
+PUBLISHED:
+  INLINE int get_num_vertices() const { return (int)_vertices.size(); }
+  INLINE int get_num_triangles() const { return (int)_indices.size() / 3; }
+  INLINE const LPoint3 &get_mins() const { return _mins; }
+  INLINE const LPoint3 &get_maxs() const { return _maxs; }
+
+public:
+  pvector<LPoint3f> _vertices;
+  vector_int _indices;
+  LPoint3 _mins, _maxs;
+};
+
 class EXPCL_PANDA_MAP MapStaticProp {
 PUBLISHED:
   ~MapStaticProp() = default;
@@ -331,6 +351,12 @@ PUBLISHED:
 
   RayTraceScene *get_trace_scene() const;
 
+  void add_occluder(const Geom *geom, const TransformState *net_transform = nullptr);
+  void clear_occluders();
+  INLINE int get_num_occluders() const;
+  INLINE const MapOccluder *get_occluder(int n) const;
+  void check_occluders();
+
   void check_lighting_pvs();
 
   void build_trace_scene();
@@ -367,13 +393,27 @@ private:
 
   // For each vis cluster, vector of indices into _lights for lights that are
   // in that cluster's PVS.  Same for ambient probes and cube maps.
-  bool _built_light_pvs = false;
+  patomic<bool> _built_light_pvs { false };
   pvector<vector_int> _light_pvs;
   pvector<vector_int> _probe_pvs;
   pvector<vector_int> _cube_map_pvs;
+  // World-space position and maximum distance of each light in _lights.  The
+  // radius is negative for directional lights.  Used to bin the lights into
+  // the clustered light grid.
+  pvector<LVecBase4> _light_spheres;
 
   pvector<MapStaticProp> _static_props;
 
+  // Occluder meshes for software occlusion culling.  These are derived from
+  // the opaque world geometry when the map is loaded, plus any occluders
+  // added explicitly with add_occluder(), and are not written to the bam.
+  patomic<bool> _built_occluders { false };
+
+  // Held while the light PVS or the occluders are built on demand, which may
+  // happen on several cull threads at once.
+  LightMutex _build_lock;
+  pvector<MapOccluder> _occluders;
+
   PT(RayTraceScene) _trace_scene;
   pvector<PT(RayTraceTriangleMesh)> _trace_meshes;
 
@@ -386,6 +426,7 @@ private:
   pvector<PT(PandaNode)> _overlays;
 
   friend class MapLightingEffect;
+  friend class MapCullTraverser;
   friend class MapBuilder;
 };
 
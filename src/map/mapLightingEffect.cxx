@@ -36,6 +36,8 @@
 #include "pointLight.h"
 #include "spotlight.h"
 #include "ordered_vector.h"
+#include "finiteBoundingVolume.h"
+#include "qpLightCuller.h"
 
 IMPLEMENT_CLASS(MapLightingEffect);
 
@@ -43,6 +45,7 @@ static PStatCollector map_lighting_coll("Cull:MapLightingEffect");
 static PStatCollector map_lighting_cubemap_coll("Cull:MapLightingEffect:CubeMap");
 static PStatCollector map_lighting_probe_coll("Cull:MapLightingEffect:Probe");
 static PStatCollector map_lighting_light_cand_coll("Cull:MapLightingEffect:BuildLightCandidates");
+static PStatCollector map_lighting_clustered_cand_coll("Cull:MapLightingEffect:BuildLightCandidates:Clustered");
 static PStatCollector map_lighting_sort_cand_coll("Cull:MapLightingEffect:SortLightCandidates");
 static PStatCollector map_lighting_apply_light_coll("Cull:MapLightingEffect:ApplyLights");
 static ConfigVariableDouble map_lighting_effect_quantize_amount
@@ -71,7 +74,8 @@ MapLightingEffect() :
   _lighting_origin(0.0f, 0.0f, 0.0f),
   _use_position(false),
   _max_lights(4),
-  _last_update(UpdateSeq::old())
+  _last_update(UpdateSeq::old()),
+  _last_clustered(false)
 {
 }
 
@@ -241,15 +245,19 @@ do_cull_callback(CullTraverser *trav, CullTraverserData &data,
     net_pos[2] = quantize(net_pos[2], quantize_amt);
   }
 
-  if (!net_pos.almost_equal(_last_pos) || mdata != _last_map_data || _last_update != _next_update) {
-    // Node moved or map changed.  We need to recompute its lighting
-    // state.
+  Camera *camera = mtrav->get_scene()->get_camera_node();
+  bool camera_changed = _last_clustered &&
+    (_last_camera.was_deleted() || _last_camera != camera);
+
+  if (!net_pos.almost_equal(_last_pos) || mdata != _last_map_data || _last_update != _next_update || camera_changed) {
+    // Node moved, map changed, or the lights were chosen for another camera's
+    // view.  We need to recompute its lighting state.
     _last_pos = net_pos;
     _last_map_data = mdata;
     _last_update = _next_update;
 
     do_compute_lighting(net_transform, mdata, (const GeometricBoundingVolume *)node_reader->get_bounds(),
-                        parent_net_transform);
+                        parent_net_transform, mtrav);
   }
 
   // Lerp the probe color.
@@ -297,7 +305,8 @@ public:
  */
 void MapLightingEffect::
 do_compute_lighting(const TransformState *net_transform, MapData *mdata,
-                    const GeometricBoundingVolume *bounds, const TransformState *parent_net_transform) {
+                    const GeometricBoundingVolume *bounds, const TransformState *parent_net_transform,
+                    MapCullTraverser *trav) {
   // FIXME: This is most definitely slow.
 
   PStatTimer timer(map_lighting_coll);
@@ -477,15 +486,31 @@ do_compute_lighting(const TransformState *net_transform, MapData *mdata,
     }
   }
 
+  // If the display region has a clustered light grid, only consider the
+  // lights binned into the sectors that the node's bounds overlap.
+  // Otherwise, consider every static light in the PVS and every dynamic
+  // light in range.
+  bool clustered = false;
+  if (trav != nullptr && (_flags & (F_static_lights | F_dynamic_lights)) != 0) {
+    clustered = collect_clustered_lights(trav, mdata, bounds, parent_net_transform,
+                                         pos, cluster, lights);
+  }
+  _last_clustered = clustered;
+  if (clustered) {
+    _last_camera = trav->get_scene()->get_camera_node();
+  } else {
+    _last_camera.clear();
+  }
+
   // Now add all non-sun static lights in the PVS of the node position.
-  if (cluster >= 0 && (_flags & F_static_lights)) {
+  if (!clustered && cluster >= 0 && (_flags & F_static_lights)) {
     for (int light_idx : mdata->_light_pvs[cluster]) {
       lights.push_back(LightCandidate(mdata->_lights[light_idx].node(), pos));
     }
   }
 
   // Dynamic lights.
-  if ((_flags & F_dynamic_lights) && !_dynamic_light_root.is_empty()) {
+  if (!clustered && (_flags & F_dynamic_lights) && !_dynamic_light_root.is_empty()) {
     PandaNode::Children dyn_lights = _dynamic_light_root.node()->get_children();
     // Add in dynamic light sources.
     for (int i = 0; i < dyn_lights.get_num_children(); ++i) {
@@ -540,6 +565,126 @@ do_compute_lighting(const TransformState *net_transform, MapData *mdata,
   _lighting_state = state;
 }
 
+/**
+ * Adds the static and dynamic light candidates for the node from the
+ * traverser's clustered light grid.  Only lights binned into the view frustum
+ * sectors overlapped by the node's bounds are considered, so the number of
+ * candidates is bounded by the sector light counts rather than the size of
+ * the light PVS.  Lights with an infinite range are not binned and are always
+ * considered.
+ *
+ * Returns false if the grid is not available or the node's bounds are not
+ * entirely within the view frustum that the sectors cover, in which case the
+ * caller should fall back to considering all lights.
+ */
+bool MapLightingEffect::
+collect_clustered_lights(MapCullTraverser *trav, MapData *mdata,
+                         const GeometricBoundingVolume *bounds,
+                         const TransformState *parent_net_transform,
+                         const LPoint3 &pos, int cluster,
+                         pvector<LightCandidate> &lights) const {
+  if (!trav->check_light_bins()) {
+    return false;
+  }
+
+  PStatTimer timer(map_lighting_clustered_cand_coll);
+
+  // Compute the view-space bounding box of the node.  If the node doesn't
+  // have finite bounds, just use the lighting origin.
+  LPoint3 view_mins, view_maxs;
+  const FiniteBoundingVolume *fbv = nullptr;
+  if (bounds != nullptr && !bounds->is_infinite() && !bounds->is_empty()) {
+    fbv = bounds->as_finite_bounding_volume();
+  }
+  if (fbv != nullptr) {
+    LMatrix4 mat = parent_net_transform->get_mat() * trav->_light_world_to_view;
+    LPoint3 mins = fbv->get_min();
+    LPoint3 maxs = fbv->get_max();
+    LPoint3 center = (mins + maxs) * 0.5f;
+    LVector3 extents = (maxs - mins) * 0.5f;
+    LPoint3 view_center = mat.xform_point(center);
+    LVector3 view_extents(0.0f);
+    for (int j = 0; j < 3; ++j) {
+      for (int i = 0; i < 3; ++i) {
+        view_extents[j] += cabs(mat(i, j)) * extents[i];
+      }
+    }
+    view_mins = view_center - view_extents;
+    view_maxs = view_center + view_extents;
+
+  } else {
+    view_mins = view_maxs = trav->_light_world_to_view.xform_point(pos);
+  }
+
+  // Lights that only reach the part of the node outside the view frustum
+  // aren't in any sector, so don't trust the grid for a partly visible node.
+  if (!trav->_light_culler->contains_box(view_mins, view_maxs)) {
+    return false;
+  }
+
+  trav->_bin_sectors.clear();
+  trav->_light_culler->collect_sectors(view_mins, view_maxs, trav->_bin_sectors);
+  if (trav->_bin_sectors.empty()) {
+    return false;
+  }
+
+  // Adds the indicated light from the traverser's light list if it reaches
+  // the node.
+  auto add_light = [&] (int item) {
+    int light_idx = trav->_bin_light_indices[item];
+    if (light_idx >= 0) {
+      // Static light.  It has to be in the PVS of the node position.
+      if (cluster < 0 || (_flags & F_static_lights) == 0) {
+        return;
+      }
+      const vector_int &pvs = mdata->_light_pvs[cluster];
+      if (!std::binary_search(pvs.begin(), pvs.end(), light_idx)) {
+        return;
+      }
+      lights.push_back(LightCandidate(trav->_bin_light_nodes[item], pos));
+
+    } else {
+      // Dynamic light.  It has to be in range of the node position.
+      if ((_flags & F_dynamic_lights) == 0) {
+        return;
+      }
+      PandaNode *child = trav->_bin_light_nodes[item];
+      PN_stdfloat max_distance = trav->_bin_light_spheres[item][3];
+      PN_stdfloat metric = (pos - child->get_transform()->get_pos()).length_squared();
+      if (metric >= max_distance * max_distance) {
+        return;
+      }
+      lights.push_back(LightCandidate(child, pos, metric));
+    }
+  };
+
+  // Stamp each light as we visit it so lights binned into more than one of
+  // the node's sectors are only added once.
+  int stamp = ++(trav->_bin_light_stamp);
+  const qpLightCuller::SectorBins &bins = trav->_light_bins;
+
+  for (int sector : trav->_bin_sectors) {
+    const int *items = bins.get_items(sector);
+    int num_items = bins.get_num_items(sector);
+    for (int i = 0; i < num_items; ++i) {
+      int item = items[i];
+      if (trav->_bin_light_marks[item] == stamp) {
+        continue;
+      }
+      trav->_bin_light_marks[item] = stamp;
+      add_light(item);
+    }
+  }
+
+  // Lights with an infinite range aren't binned; they reach every node.
+  int num_lights = (int)trav->_bin_light_nodes.size();
+  for (int item = trav->_num_binned_lights; item < num_lights; ++item) {
+    add_light(item);
+  }
+
+  return true;
+}
+
 /**
  *
  */
@@ -594,3 +739,12 @@ void MapLightingEffect::
 clear_dynamic_light_root() {
   _dynamic_light_root.clear();
 }
+
+/**
+ * Returns the node that dynamic lights are parented to, or an empty NodePath
+ * if no dynamic light root has been set.
+ */
+NodePath MapLightingEffect::
+get_dynamic_light_root() {
+  return _dynamic_light_root;
+}
@@ -22,11 +22,15 @@
 #include "renderAttrib.h"
 #include "texture.h"
 #include "nodePath.h"
+#include "camera.h"
+#include "weakPointerTo.h"
 
 class MapAmbientProbe;
 class CullTraverser;
 class CullTraverserData;
 class MapData;
+class MapCullTraverser;
+class LightCandidate;
 
 /**
  * This is a special RenderEffect that applies lighting state to nodes
@@ -60,11 +64,13 @@ PUBLISHED:
 
   void do_compute_lighting(const TransformState *net_transform, MapData *map_data,
                            const GeometricBoundingVolume *node_bounds,
-                           const TransformState *parent_net_transform);
+                           const TransformState *parent_net_transform,
+                           MapCullTraverser *trav = nullptr);
 
   static void mark_stale();
   static void set_dynamic_light_root(NodePath np);
   static void clear_dynamic_light_root();
+  static NodePath get_dynamic_light_root();
 
   ~MapLightingEffect();
 
@@ -85,6 +91,12 @@ private:
                         CPT(TransformState) &node_transform,
                         CPT(RenderState) &node_state);
 
+  bool collect_clustered_lights(MapCullTraverser *trav, MapData *map_data,
+                                const GeometricBoundingVolume *node_bounds,
+                                const TransformState *parent_net_transform,
+                                const LPoint3 &pos, int cluster,
+                                pvector<LightCandidate> &lights) const;
+
   void add_to_linked_list();
   void remove_from_linked_list();
 
@@ -116,6 +128,12 @@ private:
 
   UpdateSeq _last_update;
 
+  // True if the lights were last selected from the clustered light grid of
+  // _last_camera's display region.  That selection depends on the view, so
+  // it must be redone for any other camera.
+  bool _last_clustered;
+  WPT(Camera) _last_camera;
+
   static const MapLightingEffect *_list;
   static UpdateSeq _next_update;
   static NodePath _dynamic_light_root;
@@ -0,0 +1,486 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mapOcclusionBuffer.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "mapOcclusionBuffer.h"
+#include "mapData.h"
+#include "finiteBoundingVolume.h"
+#include "mathutil_simd.h"
+#include "jobSystem.h"
+#include "pStatCollector.h"
+#include "pStatTimer.h"
+
+static PStatCollector occlusion_render_pcollector("Cull:MapOcclusion:Render");
+static PStatCollector occlusion_transform_pcollector("Cull:MapOcclusion:Render:Transform");
+static PStatCollector occlusion_raster_pcollector("Cull:MapOcclusion:Render:Rasterize");
+static PStatCollector occlusion_test_pcollector("Cull:MapOcclusion:Test");
+
+/**
+ *
+ */
+MapOcclusionBuffer::
+MapOcclusionBuffer(int width, int height) :
+  _width(0),
+  _height(0),
+  _tiles_x(0),
+  _tiles_y(0),
+  _world_to_clip(LMatrix4f::ident_mat()),
+  _num_rendered_tris(0)
+{
+  resize(width, height);
+}
+
+/**
+ * Changes the resolution of the buffer.  The dimensions are rounded up to a
+ * multiple of the tile size.  The buffer is cleared.
+ */
+void MapOcclusionBuffer::
+resize(int width, int height) {
+  _tiles_x = std::max(1, (width + tile_width - 1) / tile_width);
+  _tiles_y = std::max(1, (height + tile_height - 1) / tile_height);
+  _width = _tiles_x * tile_width;
+  _height = _tiles_y * tile_height;
+
+  _tile_zmax0.resize(_tiles_x * _tiles_y);
+  _tile_zmax1.resize(_tiles_x * _tiles_y);
+  _tile_mask.resize(_tiles_x * _tiles_y);
+  clear();
+}
+
+/**
+ * Resets every tile to the far plane.
+ */
+void MapOcclusionBuffer::
+clear() {
+  std::fill(_tile_zmax0.begin(), _tile_zmax0.end(), 1.0f);
+  std::fill(_tile_zmax1.begin(), _tile_zmax1.end(), 0.0f);
+  std::fill(_tile_mask.begin(), _tile_mask.end(), 0u);
+  _num_rendered_tris = 0;
+}
+
+/**
+ * Specifies the matrix that transforms world-space points into clip space
+ * for the camera that the buffer is rendered from.  This is the world
+ * transform of the scene composed with the lens projection matrix.
+ */
+void MapOcclusionBuffer::
+set_view(const LMatrix4 &world_to_clip) {
+  _world_to_clip = LCAST(float, world_to_clip);
+}
+
+/**
+ * Clears the buffer and rasterizes all of the map's occluders into it from
+ * the current view.
+ */
+void MapOcclusionBuffer::
+render_occluders(const MapData *data) {
+  PStatTimer timer(occlusion_render_pcollector);
+
+  clear();
+
+  int num_occluders = data->get_num_occluders();
+  _occluder_tris.resize(num_occluders);
+
+  JobSystem *jsys = JobSystem::get_global_ptr();
+
+  // First transform, clip and project the triangles of each occluder.
+  occlusion_transform_pcollector.start();
+  jsys->parallel_process(num_occluders,
+    [this, data] (int i) {
+      _occluder_tris[i].clear();
+      transform_occluder(data->get_occluder(i), _occluder_tris[i]);
+    });
+  occlusion_transform_pcollector.stop();
+
+  for (const ScreenTris &tris : _occluder_tris) {
+    _num_rendered_tris += (int)tris.size();
+  }
+
+  bin_triangles();
+
+  // Now rasterize.  Each job owns a row of tiles, so no two jobs write to
+  // the same tile, and the triangles are merged into each tile in the same
+  // order regardless of scheduling.
+  occlusion_raster_pcollector.start();
+  jsys->parallel_process(_tiles_y,
+    [this] (int tile_y) {
+      for (int i = _row_start[tile_y]; i < _row_start[tile_y + 1]; ++i) {
+        rasterize_tile_row(tile_y, *_row_tris[i]);
+      }
+    });
+  occlusion_raster_pcollector.stop();
+}
+
+/**
+ * Returns true if any part of the indicated world-space box might be visible
+ * past the occluders, or false if it is definitely hidden.
+ */
+bool MapOcclusionBuffer::
+is_box_visible(const LPoint3 &mins, const LPoint3 &maxs) const {
+  PStatTimer timer(occlusion_test_pcollector);
+
+  // Transform the 8 corners of the box into clip space, several at a time.
+  SIMD_NATIVE_ALIGN float cx[8], cy[8], cz[8];
+  SIMD_NATIVE_ALIGN float px[8], py[8], pz[8];
+  for (int i = 0; i < 8; ++i) {
+    px[i] = (i & 1) ? maxs[0] : mins[0];
+    py[i] = (i & 2) ? maxs[1] : mins[1];
+    pz[i] = (i & 4) ? maxs[2] : mins[2];
+  }
+
+  const LMatrix4f &m = _world_to_clip;
+  for (int i = 0; i < 8; i += SIMDFloatVector::num_columns) {
+    SIMDFloatVector x = SIMDFloatVector::load_aligned(px + i);
+    SIMDFloatVector y = SIMDFloatVector::load_aligned(py + i);
+    SIMDFloatVector z = SIMDFloatVector::load_aligned(pz + i);
+
+    SIMDFloatVector rx = x * SIMDFloatVector(m(0, 0)) + y * SIMDFloatVector(m(1, 0)) + z * SIMDFloatVector(m(2, 0)) + SIMDFloatVector(m(3, 0));
+    SIMDFloatVector ry = x * SIMDFloatVector(m(0, 1)) + y * SIMDFloatVector(m(1, 1)) + z * SIMDFloatVector(m(2, 1)) + SIMDFloatVector(m(3, 1));
+    SIMDFloatVector rz = x * SIMDFloatVector(m(0, 2)) + y * SIMDFloatVector(m(1, 2)) + z * SIMDFloatVector(m(2, 2)) + SIMDFloatVector(m(3, 2));
+    SIMDFloatVector rw = x * SIMDFloatVector(m(0, 3)) + y * SIMDFloatVector(m(1, 3)) + z * SIMDFloatVector(m(2, 3)) + SIMDFloatVector(m(3, 3));
+
+    if ((rw <= SIMDFloatVector(1e-5f)).is_any_on()) {
+      // The box crosses the near plane.  We can't project it, so assume it
+      // is visible.
+      return true;
+    }
+
+    SIMDFloatVector inv_w = SIMDFloatVector(1.0f) / rw;
+    rx *= inv_w;
+    ry *= inv_w;
+    rz *= inv_w;
+    memcpy(cx + i, rx.get_data(), sizeof(float) * SIMDFloatVector::num_columns);
+    memcpy(cy + i, ry.get_data(), sizeof(float) * SIMDFloatVector::num_columns);
+    memcpy(cz + i, rz.get_data(), sizeof(float) * SIMDFloatVector::num_columns);
+  }
+
+  float min_x = cx[0], max_x = cx[0];
+  float min_y = cy[0], max_y = cy[0];
+  float min_z = cz[0];
+  for (int i = 1; i < 8; ++i) {
+    min_x = std::min(min_x, cx[i]);
+    max_x = std::max(max_x, cx[i]);
+    min_y = std::min(min_y, cy[i]);
+    max_y = std::max(max_y, cy[i]);
+    min_z = std::min(min_z, cz[i]);
+  }
+
+  // Convert to pixels and depth range.
+  min_x = (min_x * 0.5f + 0.5f) * _width;
+  max_x = (max_x * 0.5f + 0.5f) * _width;
+  min_y = (min_y * 0.5f + 0.5f) * _height;
+  max_y = (max_y * 0.5f + 0.5f) * _height;
+  min_z = min_z * 0.5f + 0.5f;
+
+  if (max_x < 0.0f || max_y < 0.0f || min_x >= _width || min_y >= _height) {
+    // Off-screen.  This is for the view frustum test to decide.
+    return true;
+  }
+
+  // Clamp to the screen before converting to int, since a box close to the
+  // near plane can project far outside of it.
+  int tx0 = (int)(std::max(min_x, 0.0f) / tile_width);
+  int tx1 = (int)(std::min(max_x, (float)(_width - 1)) / tile_width);
+  int ty0 = (int)(std::max(min_y, 0.0f) / tile_height);
+  int ty1 = (int)(std::min(max_y, (float)(_height - 1)) / tile_height);
+
+  // The box is visible if its nearest point is in front of the farthest
+  // depth of any tile it overlaps.
+  SIMDFloatVector vz(min_z);
+  for (int ty = ty0; ty <= ty1; ++ty) {
+    const float *row = &_tile_zmax0[ty * _tiles_x];
+    int tx = tx0;
+    for (; tx + SIMDFloatVector::num_columns - 1 <= tx1; tx += SIMDFloatVector::num_columns) {
+      SIMDFloatVector tz = SIMDFloatVector::load_unaligned(row + tx);
+      if ((vz < tz).is_any_on()) {
+        return true;
+      }
+    }
+    for (; tx <= tx1; ++tx) {
+      if (min_z < row[tx]) {
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+/**
+ * Returns true if any part of the indicated world-space bounding volume
+ * might be visible past the occluders.  Volumes that are not finite are
+ * always considered visible.
+ */
+bool MapOcclusionBuffer::
+is_bounds_visible(const BoundingVolume *bounds) const {
+  if (bounds == nullptr || bounds->is_infinite()) {
+    return true;
+  }
+  if (bounds->is_empty()) {
+    return false;
+  }
+  const FiniteBoundingVolume *fbv = bounds->as_finite_bounding_volume();
+  if (fbv == nullptr) {
+    return true;
+  }
+  return is_box_visible(fbv->get_min(), fbv->get_max());
+}
+
+/**
+ * Transforms the triangles of the indicated occluder into clip space, clips
+ * them against the near plane, and appends the resulting screen-space
+ * triangles to the list.
+ */
+void MapOcclusionBuffer::
+transform_occluder(const MapOccluder *occ, ScreenTris &tris) const {
+  const LMatrix4f &m = _world_to_clip;
+
+  // Reject the occluder if its bounding box is entirely outside one of the
+  // side planes of the frustum.
+  unsigned int all_out = 0x3f;
+  for (int i = 0; i < 8; ++i) {
+    LPoint3f p((i & 1) ? occ->_maxs[0] : occ->_mins[0],
+               (i & 2) ? occ->_maxs[1] : occ->_mins[1],
+               (i & 4) ? occ->_maxs[2] : occ->_mins[2]);
+    LVecBase4f c = LVecBase4f(p, 1.0f) * m;
+    unsigned int out = 0;
+    if (c[0] < -c[3]) out |= 1;
+    if (c[0] > c[3]) out |= 2;
+    if (c[1] < -c[3]) out |= 4;
+    if (c[1] > c[3]) out |= 8;
+    if (c[2] < -c[3]) out |= 16;
+    if (c[2] > c[3]) out |= 32;
+    all_out &= out;
+  }
+  if (all_out != 0) {
+    return;
+  }
+
+  pvector<LPoint4f> clip_verts;
+  clip_verts.resize(occ->_vertices.size());
+  for (size_t i = 0; i < occ->_vertices.size(); ++i) {
+    clip_verts[i] = LVecBase4f(occ->_vertices[i], 1.0f) * m;
+  }
+
+  size_t num_tris = occ->_indices.size() / 3;
+  for (size_t t = 0; t < num_tris; ++t) {
+    const LPoint4f *v[3] = {
+      &clip_verts[occ->_indices[t * 3]],
+      &clip_verts[occ->_indices[t * 3 + 1]],
+      &clip_verts[occ->_indices[t * 3 + 2]]
+    };
+
+    // Signed distance from the near plane.
+    float d[3];
+    int num_in = 0;
+    for (int i = 0; i < 3; ++i) {
+      d[i] = (*v[i])[2] + (*v[i])[3];
+      if (d[i] > 0.0f) {
+        ++num_in;
+      }
+    }
+
+    if (num_in == 0) {
+      continue;
+
+    } else if (num_in == 3) {
+      setup_triangle(*v[0], *v[1], *v[2], tris);
+
+    } else {
+      // Clip the triangle against the near plane.  This produces a polygon
+      // with 3 or 4 vertices.
+      LPoint4f poly[4];
+      int num_poly = 0;
+      for (int i = 0; i < 3; ++i) {
+        int j = (i + 1) % 3;
+        if (d[i] > 0.0f) {
+          poly[num_poly++] = *v[i];
+        }
+        if ((d[i] > 0.0f) != (d[j] > 0.0f)) {
+          float t = d[i] / (d[i] - d[j]);
+          poly[num_poly++] = *v[i] + (*v[j] - *v[i]) * t;
+        }
+      }
+      for (int i = 1; i + 1 < num_poly; ++i) {
+        setup_triangle(poly[0], poly[i], poly[i + 1], tris);
+      }
+    }
+  }
+}
+
+/**
+ * Projects the indicated clip-space triangle into screen space and computes
+ * its edge equations.  The triangle must already be clipped to the near
+ * plane.
+ */
+void MapOcclusionBuffer::
+setup_triangle(const LPoint4f &v0, const LPoint4f &v1, const LPoint4f &v2,
+               ScreenTris &tris) const {
+  LPoint3f s[3];
+  const LPoint4f *v[3] = { &v0, &v1, &v2 };
+  for (int i = 0; i < 3; ++i) {
+    float inv_w = 1.0f / std::max((*v[i])[3], 1e-6f);
+    s[i][0] = ((*v[i])[0] * inv_w * 0.5f + 0.5f) * _width;
+    s[i][1] = ((*v[i])[1] * inv_w * 0.5f + 0.5f) * _height;
+    s[i][2] = (*v[i])[2] * inv_w * 0.5f + 0.5f;
+  }
+
+  float min_x = std::min(s[0][0], std::min(s[1][0], s[2][0]));
+  float max_x = std::max(s[0][0], std::max(s[1][0], s[2][0]));
+  float min_y = std::min(s[0][1], std::min(s[1][1], s[2][1]));
+  float max_y = std::max(s[0][1], std::max(s[1][1], s[2][1]));
+  if (max_x < 0.0f || max_y < 0.0f || min_x >= _width || min_y >= _height) {
+    return;
+  }
+
+  float zmax = std::max(s[0][2], std::max(s[1][2], s[2][2]));
+  if (zmax >= 1.0f) {
+    // Touches the far plane; it can't occlude anything.
+    return;
+  }
+
+  ScreenTri tri;
+  float area = 0.0f;
+  for (int i = 0; i < 3; ++i) {
+    const LPoint3f &p = s[i];
+    const LPoint3f &q = s[(i + 1) % 3];
+    tri._a[i] = p[1] - q[1];
+    tri._b[i] = q[0] - p[0];
+    tri._c[i] = p[0] * q[1] - q[0] * p[1];
+    area += tri._c[i];
+  }
+
+  if (area == 0.0f) {
+    // Degenerate.
+    return;
+  }
+
+  if (area < 0.0f) {
+    // Occluders are two-sided.  Flip the edges so the inside is positive.
+    for (int i = 0; i < 3; ++i) {
+      tri._a[i] = -tri._a[i];
+      tri._b[i] = -tri._b[i];
+      tri._c[i] = -tri._c[i];
+    }
+  }
+
+  tri._zmax = std::max(zmax, 0.0f);
+
+  // A triangle clipped only by the near plane can still reach far outside of
+  // the screen, so clamp before converting to int.
+  tri._tile_x0 = (int)(std::max(min_x, 0.0f) / tile_width);
+  tri._tile_x1 = (int)(std::min(max_x, (float)(_width - 1)) / tile_width);
+  tri._tile_y0 = (int)(std::max(min_y, 0.0f) / tile_height);
+  tri._tile_y1 = (int)(std::min(max_y, (float)(_height - 1)) / tile_height);
+  tris.push_back(tri);
+}
+
+/**
+ * Sorts the screen-space triangles of all occluders into bins by the rows of
+ * tiles that they cover, so that each row only visits its own triangles.
+ * The triangles keep their original order within each bin.
+ */
+void MapOcclusionBuffer::
+bin_triangles() {
+  // Count the triangles of each row first, so that all of the bins can share
+  // one array.
+  _row_start.assign(_tiles_y + 1, 0);
+  for (const ScreenTris &tris : _occluder_tris) {
+    for (const ScreenTri &tri : tris) {
+      for (int ty = tri._tile_y0; ty <= tri._tile_y1; ++ty) {
+        ++_row_start[ty + 1];
+      }
+    }
+  }
+  for (int ty = 0; ty < _tiles_y; ++ty) {
+    _row_start[ty + 1] += _row_start[ty];
+  }
+
+  _row_tris.resize(_row_start[_tiles_y]);
+  _row_fill.assign(_row_start.begin(), _row_start.end() - 1);
+  for (const ScreenTris &tris : _occluder_tris) {
+    for (const ScreenTri &tri : tris) {
+      for (int ty = tri._tile_y0; ty <= tri._tile_y1; ++ty) {
+        _row_tris[_row_fill[ty]++] = &tri;
+      }
+    }
+  }
+}
+
+/**
+ * Rasterizes the indicated triangle into a single row of tiles.
+ */
+void MapOcclusionBuffer::
+rasterize_tile_row(int tile_y, const ScreenTri &tri) {
+  static constexpr float big = 1e30f;
+
+  // For each pixel row in the tile row, find the horizontal span of the
+  // triangle by intersecting the row center with each edge.  Several rows are
+  // done at once.
+  SIMD_NATIVE_ALIGN float span_left[tile_height];
+  SIMD_NATIVE_ALIGN float span_right[tile_height];
+
+  float row_y0 = (float)(tile_y * tile_height) + 0.5f;
+
+  for (int r = 0; r < tile_height; r += SIMDFloatVector::num_columns) {
+    SIMDFloatVector y;
+    for (int i = 0; i < SIMDFloatVector::num_columns; ++i) {
+      y[i] = row_y0 + (float)(r + i);
+    }
+
+    SIMDFloatVector left(-big);
+    SIMDFloatVector right(big);
+
+    for (int e = 0; e < 3; ++e) {
+      // a*x + (b*y + c) >= 0
+      SIMDFloatVector rest = y * SIMDFloatVector(tri._b[e]) + SIMDFloatVector(tri._c[e]);
+      if (tri._a[e] > 0.0f) {
+        left = simd_max(left, -rest / SIMDFloatVector(tri._a[e]));
+
+      } else if (tri._a[e] < 0.0f) {
+        right = simd_min(right, -rest / SIMDFloatVector(tri._a[e]));
+
+      } else {
+        // Horizontal edge.  The whole row is either inside or outside.
+        left = SIMDFloatVector::blend(left, SIMDFloatVector(big), rest < SIMDFloatVector(0.0f));
+      }
+    }
+
+    // Move from pixel edges to pixel centers.
+    left -= SIMDFloatVector(0.5f);
+    right -= SIMDFloatVector(0.5f);
+    memcpy(span_left + r, left.get_data(), sizeof(float) * SIMDFloatVector::num_columns);
+    memcpy(span_right + r, right.get_data(), sizeof(float) * SIMDFloatVector::num_columns);
+  }
+
+  // Now build the coverage mask of each tile from the spans.
+  for (int tile_x = tri._tile_x0; tile_x <= tri._tile_x1; ++tile_x) {
+    float x0 = (float)(tile_x * tile_width);
+    uint64_t coverage = 0u;
+
+    for (int r = 0; r < tile_height; ++r) {
+      float l = std::max(span_left[r] - x0, -1.0f);
+      float rt = std::min(span_right[r] - x0, (float)tile_width);
+      int first = std::max(0, (int)cceil(l));
+      int last = std::min(tile_width - 1, (int)cfloor(rt));
+      if (first > last) {
+        continue;
+      }
+      uint64_t row_bits = ((uint64_t)0xff >> (tile_width - 1 - last)) & ((uint64_t)0xff << first);
+      coverage |= row_bits << (r * tile_width);
+    }
+
+    if (coverage != 0u) {
+      update_tile(tile_y * _tiles_x + tile_x, coverage, tri._zmax);
+    }
+  }
+}
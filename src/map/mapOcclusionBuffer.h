@@ -0,0 +1,110 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mapOcclusionBuffer.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef MAPOCCLUSIONBUFFER_H
+#define MAPOCCLUSIONBUFFER_H
+
+#include "pandabase.h"
+#include "referenceCount.h"
+#include "luse.h"
+#include "pvector.h"
+#include "vector_int.h"
+#include "boundingVolume.h"
+
+class MapData;
+class MapOccluder;
+
+/**
+ * A low-resolution software depth buffer that the occluder geometry of a map
+ * is rasterized into on the CPU each frame.  Object bounds are tested against
+ * it during the cull traversal, before they are recorded into the CullResult.
+ * Unlike occlusion queries, the result is available in the same frame.
+ *
+ * The buffer is divided into 8x8 pixel tiles.  Instead of a depth value per
+ * pixel, each tile stores a 64-bit coverage mask and two conservative maximum
+ * depth values: one for the whole tile, and one for the pixels in the mask.
+ * When the mask fills up, the whole tile takes the depth of the masked layer.
+ * This is the masked occlusion culling scheme of Andersson et al.
+ *
+ * Occluder triangles are transformed and clipped in parallel per occluder,
+ * binned by the rows of tiles they cover, then rasterized in parallel per row
+ * of tiles on the job system.
+ */
+class EXPCL_PANDA_MAP MapOcclusionBuffer : public ReferenceCount {
+PUBLISHED:
+  MapOcclusionBuffer(int width, int height);
+
+  void resize(int width, int height);
+  INLINE int get_width() const;
+  INLINE int get_height() const;
+
+  void clear();
+  void set_view(const LMatrix4 &world_to_clip);
+
+  void render_occluders(const MapData *data);
+
+  bool is_box_visible(const LPoint3 &mins, const LPoint3 &maxs) const;
+  bool is_bounds_visible(const BoundingVolume *bounds) const;
+
+  INLINE int get_num_rendered_triangles() const;
+
+public:
+  static constexpr int tile_width = 8;
+  static constexpr int tile_height = 8;
+
+private:
+  // A triangle projected into screen space and set up for rasterization.
+  class ScreenTri {
+  public:
+    // Edge equations, oriented so that a*x + b*y + c >= 0 on the inside.
+    float _a[3], _b[3], _c[3];
+    // Conservative (farthest) depth of the triangle.
+    float _zmax;
+    // Range of tiles covered by the triangle's bounding rectangle.
+    int _tile_x0, _tile_x1;
+    int _tile_y0, _tile_y1;
+  };
+  typedef pvector<ScreenTri> ScreenTris;
+
+  void transform_occluder(const MapOccluder *occ, ScreenTris &tris) const;
+  void setup_triangle(const LPoint4f &v0, const LPoint4f &v1, const LPoint4f &v2,
+                      ScreenTris &tris) const;
+  void bin_triangles();
+  void rasterize_tile_row(int tile_y, const ScreenTri &tri);
+  INLINE void update_tile(int tile, uint64_t coverage, float zmax);
+
+private:
+  int _width, _height;
+  int _tiles_x, _tiles_y;
+  LMatrix4f _world_to_clip;
+
+  // Tile data is stored as separate arrays so the visibility test can
+  // compare the depth of several tiles at once.
+  pvector<float> _tile_zmax0;
+  pvector<float> _tile_zmax1;
+  pvector<uint64_t> _tile_mask;
+
+  // Screen-space triangles of each occluder, rebuilt each frame.
+  pvector<ScreenTris> _occluder_tris;
+  int _num_rendered_tris;
+
+  // The triangles covering each row of tiles.  The triangles of row n are
+  // _row_tris[_row_start[n]] up to _row_tris[_row_start[n + 1]].
+  vector_int _row_start;
+  vector_int _row_fill;
+  pvector<const ScreenTri *> _row_tris;
+};
+
+#include "mapOcclusionBuffer.I"
+
+#endif // MAPOCCLUSIONBUFFER_H
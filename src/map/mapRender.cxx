@@ -15,16 +15,38 @@
 #include "mapData.h"
 #include "mapCullTraverser.h"
 #include "sceneSetup.h"
+#include "camera.h"
+#include "lens.h"
+#include "lightMutexHolder.h"
+#include "configVariableBool.h"
+#include "configVariableInt.h"
 
 IMPLEMENT_CLASS(MapRender);
 
+static ConfigVariableBool map_occlusion_cull
+  ("map-occlusion-cull", false,
+   PRC_DESC("Set this true to enable software occlusion culling of static "
+            "props and dynamic nodes against the opaque world geometry of "
+            "the map.  The occluders are rasterized on the CPU into a "
+            "low-resolution depth buffer each frame for each camera with a "
+            "perspective lens."));
+
+static ConfigVariableInt map_occlusion_buffer_width
+  ("map-occlusion-buffer-width", 256,
+   PRC_DESC("Specifies the width in pixels of the software occlusion buffer."));
+
+static ConfigVariableInt map_occlusion_buffer_height
+  ("map-occlusion-buffer-height", 128,
+   PRC_DESC("Specifies the height in pixels of the software occlusion buffer."));
+
 /**
  *
  */
 MapRender::
 MapRender(const std::string &name) :
   PandaNode(name),
-  _map_data(nullptr)
+  _map_data(nullptr),
+  _occlusion_lock("map-render-occlusion-lock")
 {
   set_cull_callback();
 }
@@ -52,6 +74,9 @@ cull_callback(CullTraverser *trav, CullTraverserData &data) {
   MapCullTraverser mtrav(*trav, _map_data);
   mtrav.local_object();
   mtrav.determine_view_cluster(pos);
+  if (map_occlusion_cull && _map_data != nullptr && mtrav._view_cluster >= 0) {
+    mtrav._occlusion_buffer = render_occlusion_buffer(scene);
+  }
   mtrav.traverse_below(data);
   mtrav.end_traverse();
 
@@ -59,3 +84,68 @@ cull_callback(CullTraverser *trav, CullTraverserData &data) {
   // below.
   return false;
 }
+
+/**
+ * Returns the software occlusion buffer that was last rendered for the
+ * indicated camera in the indicated display region, or nullptr if occlusion
+ * culling has not been performed for that camera and display region.
+ */
+MapOcclusionBuffer *MapRender::
+get_occlusion_buffer(Camera *cam, DisplayRegion *dr) {
+  LightMutexHolder holder(_occlusion_lock);
+  CameraOcclusionBuffers::const_iterator it = _occlusion_buffers.find(OcclusionBufferKey(cam, dr));
+  if (it != _occlusion_buffers.end() &&
+      !(*it).first.first.was_deleted() && !(*it).first.second.was_deleted()) {
+    return (*it).second;
+  }
+  return nullptr;
+}
+
+/**
+ * Rasterizes the occluders of the map into the occlusion buffer of the
+ * scene's camera and display region.  Returns the buffer, or nullptr if
+ * occlusion culling can't be performed for the camera.
+ *
+ * A display region is only culled by one thread at a time, so the buffer
+ * belongs to the calling thread until the traversal is finished.
+ */
+MapOcclusionBuffer *MapRender::
+render_occlusion_buffer(SceneSetup *scene) {
+  const Lens *lens = scene->get_lens();
+  if (lens == nullptr || !lens->is_perspective()) {
+    return nullptr;
+  }
+
+  _map_data->check_occluders();
+  if (_map_data->get_num_occluders() == 0) {
+    return nullptr;
+  }
+
+  OcclusionBufferKey key(scene->get_camera_node(), scene->get_display_region());
+  MapOcclusionBuffer *buffer;
+  {
+    LightMutexHolder holder(_occlusion_lock);
+
+    // Drop the buffers of cameras and display regions that have been
+    // deleted, so that they don't pile up, and so that a new camera allocated
+    // at the same address doesn't pick up a stale buffer.
+    CameraOcclusionBuffers::iterator it = _occlusion_buffers.begin();
+    while (it != _occlusion_buffers.end()) {
+      if ((*it).first.first.was_deleted() || (*it).first.second.was_deleted()) {
+        it = _occlusion_buffers.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    PT(MapOcclusionBuffer) &entry = _occlusion_buffers[key];
+    if (entry == nullptr) {
+      entry = new MapOcclusionBuffer(map_occlusion_buffer_width, map_occlusion_buffer_height);
+    }
+    buffer = entry;
+  }
+
+  buffer->set_view(scene->get_world_transform()->get_mat() * lens->get_projection_mat());
+  buffer->render_occluders(_map_data);
+  return buffer;
+}
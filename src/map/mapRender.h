@@ -18,9 +18,15 @@
 #include "pandaNode.h"
 #include "nodePath.h"
 #include "pmap.h"
+#include "pointerTo.h"
+#include "weakPointerTo.h"
+#include "camera.h"
+#include "displayRegion.h"
+#include "lightMutex.h"
+#include "mapOcclusionBuffer.h"
 
 class MapData;
-class Camera;
+class SceneSetup;
 
 /**
  * This node is intended to be used as the root of the 3-D scene graph when
@@ -41,14 +47,29 @@ PUBLISHED:
   INLINE void clear_map_data();
   INLINE MapData *get_map_data() const;
 
+  MapOcclusionBuffer *get_occlusion_buffer(Camera *cam, DisplayRegion *dr);
+
 public:
   virtual bool cull_callback(CullTraverser *trav, CullTraverserData &data) override;
 
+private:
+  MapOcclusionBuffer *render_occlusion_buffer(SceneSetup *scene);
+
 private:
   MapData *_map_data;
 
   typedef pmap<Camera *, NodePath> CameraPVSCenters;
   CameraPVSCenters _pvs_centers;
+
+  // Software occlusion buffer for each camera and display region, reused
+  // across frames.  Each display region gets its own buffer, since two
+  // display regions that share a camera may be culled at the same time.  The
+  // entries of deleted cameras and display regions are removed by
+  // render_occlusion_buffer().
+  typedef std::pair<WPT(Camera), WPT(DisplayRegion)> OcclusionBufferKey;
+  typedef pmap<OcclusionBufferKey, PT(MapOcclusionBuffer)> CameraOcclusionBuffers;
+  CameraOcclusionBuffers _occlusion_buffers;
+  LightMutex _occlusion_lock;
 };
 
 #include "mapRender.I"
@@ -29,9 +29,22 @@
 #include "material.h"
 #include "materialParamTexture.h"
 #include "jobSystem.h"
+#include "mapOcclusionBuffer.h"
+#include "boundingHexahedron.h"
+#include "finiteBoundingVolume.h"
+#include "mathutil_simd.h"
+#include "configVariableInt.h"
 
 IMPLEMENT_CLASS(StaticPartitionedObjectNode);
 
+static ConfigVariableInt static_prop_cull_objects_per_job
+  ("static-prop-cull-objects-per-job", 256,
+   PRC_DESC("When a StaticPartitionedObjectNode has more than twice this many "
+            "objects in the PVS of the camera, the visibility tests and state "
+            "composition of the objects are split across job threads in groups "
+            "of this many objects.  Set this to 0 to always cull the objects "
+            "on the calling thread."));
+
 /**
  *
  */
@@ -53,6 +66,19 @@ add_object(GeomNode *node) {
   Object obj;
   obj._bounds = node->get_bounds();
   obj._last_trav_counter = -1;
+
+  const FiniteBoundingVolume *fbv = obj._bounds->as_finite_bounding_volume();
+  if (fbv != nullptr && !fbv->is_empty() && !fbv->is_infinite()) {
+    LPoint3f mins = LCAST(float, fbv->get_min());
+    LPoint3f maxs = LCAST(float, fbv->get_max());
+    obj._center = (mins + maxs) * 0.5f;
+    obj._extents = (maxs - mins) * 0.5f;
+  } else {
+    // We don't know where it is, so never let the frustum test reject it.
+    obj._center.set(0.0f, 0.0f, 0.0f);
+    obj._extents.set(1e30f, 1e30f, 1e30f);
+  }
+
   for (int i = 0; i < node->get_num_geoms(); ++i) {
     GeomEntry geom;
     geom._geom = node->get_geom(i);
@@ -127,37 +153,8 @@ add_for_draw(CullTraverser *trav, CullTraverserData &data) {
   }
   _cam_geoms_lock.release();
 
-  //JobSystem *jsys = JobSystem::get_global_ptr();
-
-  if (cam_data->_view_cluster == view_cluster) {
-    const TransformState *trans = trav->get_scene()->get_cs_world_transform();
-    Thread *current_thread = trav->get_current_thread();
-    // Same view cluster as before.
-    // Zoom through cached object list.
-
-    //jsys->parallel_process(cam_data._geoms.size(),
-    //  [&] (int i) {
-      //for (int i = 0; i < (int)cam_data._geoms.size(); ++i) {
-      for (const Object *obj : cam_data->_geoms) {
-        //const Object *obj = cam_data._geoms[i];
-        if (data._view_frustum != nullptr) {
-          if (!obj->_bounds->contains(data._view_frustum)) {
-            continue;
-          }
-        }
-
-        for (const GeomEntry &geom : obj->_geoms) {
-          CPT(RenderState) state = data._state->compose(geom._state);
-          CullableObject cobj(geom._geom, std::move(state), trans, current_thread);
-          trav->get_cull_handler()->record_object(&cobj, trav);
-        }
-      }
-    //);
-
-  } else {
-    // Camera changed clusters.
-    //++_trav_counter;
-
+  if (cam_data->_view_cluster != view_cluster) {
+    // Camera changed clusters.  Rebuild the list of objects in the PVS.
     cam_data->_geoms.clear();
     cam_data->_view_cluster = view_cluster;
 
@@ -177,12 +174,184 @@ add_for_draw(CullTraverser *trav, CullTraverserData &data) {
       for (Object *obj : objects) {
         auto ret = traversed.insert(obj);
         if (ret.second) {
-          add_object_for_draw(trav, data, obj);
           cam_data->_geoms.push_back(obj);
         }
       }
     }
+
+    cam_data->build_cache();
+  }
+
+  if (cam_data->_parent_state != data._state) {
+    // The state above us changed, so the cached composed states are no
+    // longer valid.
+    cam_data->_parent_state = data._state;
+    std::fill(cam_data->_states.begin(), cam_data->_states.end(), nullptr);
+  }
+
+  int num_objects = (int)cam_data->_geoms.size();
+  const MapOcclusionBuffer *occlusion = mtrav->_occlusion_buffer;
+
+  int per_job = static_prop_cull_objects_per_job;
+  if (per_job > 0 && num_objects > per_job * 2) {
+    // Keep each group aligned to the SIMD width.
+    per_job = ((per_job + SIMDFloatVector::num_columns - 1) / SIMDFloatVector::num_columns) * SIMDFloatVector::num_columns;
+    int num_jobs = (num_objects + per_job - 1) / per_job;
+    JobSystem *jsys = JobSystem::get_global_ptr();
+    jsys->parallel_process(num_jobs,
+      [&] (int i) {
+        int begin = i * per_job;
+        int end = std::min(begin + per_job, num_objects);
+        cull_cached_objects(cam_data, data, occlusion, begin, end);
+      }
+    );
+
+  } else {
+    cull_cached_objects(cam_data, data, occlusion, 0, num_objects);
+  }
+
+  // The CullHandler is not thread-safe, so the surviving objects are
+  // recorded here, on the cull thread.
+  const TransformState *trans = trav->get_scene()->get_cs_world_transform();
+  Thread *current_thread = trav->get_current_thread();
+  CullHandler *handler = trav->get_cull_handler();
+
+  for (int i = 0; i < num_objects; ++i) {
+    if (!cam_data->_visible[i]) {
+      continue;
+    }
+
+    const Object *obj = cam_data->_geoms[i];
+    const CPT(RenderState) *states = &cam_data->_states[cam_data->_state_offsets[i]];
+    for (size_t j = 0; j < obj->_geoms.size(); ++j) {
+      CullableObject cobj(obj->_geoms[j]._geom, states[j], trans, current_thread);
+      handler->record_object(&cobj, trav);
+    }
+  }
+}
+
+/**
+ * Runs the view frustum and occlusion tests on the indicated range of the
+ * camera's cached objects, and composes the states of the ones that pass.
+ * The range must begin on a multiple of the SIMD width.  This may be called
+ * for different ranges from several threads at once.
+ */
+void StaticPartitionedObjectNode::
+cull_cached_objects(CamData *cam_data, CullTraverserData &data,
+                    const MapOcclusionBuffer *occlusion, int begin, int end) {
+  unsigned char *visible = cam_data->_visible.data();
+
+  const GeometricBoundingVolume *view_frustum = data._view_frustum;
+  if (view_frustum == nullptr || view_frustum->is_infinite()) {
+    std::fill(visible + begin, visible + end, 1);
+
+  } else if (view_frustum->is_exact_type(BoundingHexahedron::get_class_type()) &&
+             !view_frustum->is_empty()) {
+    const BoundingHexahedron *hex = (const BoundingHexahedron *)view_frustum;
+
+    // The planes of the hexahedron face outward.  A box is outside the
+    // frustum if it is entirely in front of any one plane.
+    SIMDFloatVector plane_a[6], plane_b[6], plane_c[6], plane_d[6];
+    SIMDFloatVector abs_a[6], abs_b[6], abs_c[6];
+    for (int p = 0; p < 6; ++p) {
+      LPlane plane = hex->get_plane(p);
+      plane_a[p] = (float)plane[0];
+      plane_b[p] = (float)plane[1];
+      plane_c[p] = (float)plane[2];
+      plane_d[p] = (float)plane[3];
+      abs_a[p] = (float)std::abs(plane[0]);
+      abs_b[p] = (float)std::abs(plane[1]);
+      abs_c[p] = (float)std::abs(plane[2]);
+    }
+
+    for (int i = begin; i < end; i += SIMDFloatVector::num_columns) {
+      SIMDFloatVector cx = SIMDFloatVector::load_unaligned(&cam_data->_center_x[i]);
+      SIMDFloatVector cy = SIMDFloatVector::load_unaligned(&cam_data->_center_y[i]);
+      SIMDFloatVector cz = SIMDFloatVector::load_unaligned(&cam_data->_center_z[i]);
+      SIMDFloatVector ex = SIMDFloatVector::load_unaligned(&cam_data->_extent_x[i]);
+      SIMDFloatVector ey = SIMDFloatVector::load_unaligned(&cam_data->_extent_y[i]);
+      SIMDFloatVector ez = SIMDFloatVector::load_unaligned(&cam_data->_extent_z[i]);
+
+      SIMDFloatVector outside(0.0f);
+      for (int p = 0; p < 6; ++p) {
+        SIMDFloatVector dist = cx * plane_a[p] + cy * plane_b[p] + cz * plane_c[p] + plane_d[p];
+        SIMDFloatVector radius = ex * abs_a[p] + ey * abs_b[p] + ez * abs_c[p];
+        outside |= (dist > radius);
+      }
+
+      int outside_bits = simd_test_sign(*outside);
+      int count = std::min((int)SIMDFloatVector::num_columns, end - i);
+      for (int j = 0; j < count; ++j) {
+        visible[i + j] = (outside_bits & (1 << j)) == 0;
+      }
+    }
+
+  } else {
+    for (int i = begin; i < end; ++i) {
+      visible[i] = cam_data->_geoms[i]->_bounds->contains(view_frustum) != 0;
+    }
+  }
+
+  const RenderState *parent_state = cam_data->_parent_state;
+
+  for (int i = begin; i < end; ++i) {
+    if (!visible[i]) {
+      continue;
+    }
+
+    if (occlusion != nullptr) {
+      LPoint3 center(cam_data->_center_x[i], cam_data->_center_y[i], cam_data->_center_z[i]);
+      LVector3 extents(cam_data->_extent_x[i], cam_data->_extent_y[i], cam_data->_extent_z[i]);
+      if (!occlusion->is_box_visible(center - extents, center + extents)) {
+        visible[i] = 0;
+        continue;
+      }
+    }
+
+    const Object *obj = cam_data->_geoms[i];
+    CPT(RenderState) *states = &cam_data->_states[cam_data->_state_offsets[i]];
+    for (size_t j = 0; j < obj->_geoms.size(); ++j) {
+      if (states[j] == nullptr) {
+        states[j] = parent_state->compose(obj->_geoms[j]._state);
+      }
+    }
+  }
+}
+
+/**
+ * Rebuilds the SoA bounds and the composed state slots for the current list
+ * of objects.
+ */
+void StaticPartitionedObjectNode::CamData::
+build_cache() {
+  int num_objects = (int)_geoms.size();
+  int padded = ((num_objects + SIMDFloatVector::num_columns - 1) / SIMDFloatVector::num_columns) * SIMDFloatVector::num_columns;
+
+  _center_x.assign(padded, 0.0f);
+  _center_y.assign(padded, 0.0f);
+  _center_z.assign(padded, 0.0f);
+  _extent_x.assign(padded, 0.0f);
+  _extent_y.assign(padded, 0.0f);
+  _extent_z.assign(padded, 0.0f);
+  _state_offsets.resize(num_objects);
+  _visible.assign(num_objects, 0);
+
+  int num_states = 0;
+  for (int i = 0; i < num_objects; ++i) {
+    const Object *obj = _geoms[i];
+    _center_x[i] = obj->_center[0];
+    _center_y[i] = obj->_center[1];
+    _center_z[i] = obj->_center[2];
+    _extent_x[i] = obj->_extents[0];
+    _extent_y[i] = obj->_extents[1];
+    _extent_z[i] = obj->_extents[2];
+    _state_offsets[i] = num_states;
+    num_states += (int)obj->_geoms.size();
   }
+
+  _states.clear();
+  _states.resize(num_states);
+  _parent_state = nullptr;
 }
 
 /**
@@ -196,6 +365,11 @@ add_object_for_draw(CullTraverser *trav, CullTraverserData &data, const Object *
     }
   }
 
+  const MapOcclusionBuffer *occlusion = ((MapCullTraverser *)trav)->_occlusion_buffer;
+  if (occlusion != nullptr && !occlusion->is_bounds_visible(obj->_bounds)) {
+    return;
+  }
+
   Thread *current_thread = trav->get_current_thread();
 
   const TransformState *trans = trav->get_scene()->get_cs_world_transform();
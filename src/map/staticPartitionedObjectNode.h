@@ -23,8 +23,10 @@
 #include "weakPointerTo.h"
 #include "lightMutex.h"
 #include "pointerTo.h"
+#include "vector_int.h"
 
 class SpatialPartition;
+class MapOcclusionBuffer;
 
 /**
  * This is a special kind of node optimized for the specific case of
@@ -65,6 +67,9 @@ private:
   public:
     pvector<GeomEntry> _geoms;
     CPT(BoundingVolume) _bounds;
+    // Axis-aligned box around _bounds, as center and half-extents.
+    LPoint3f _center;
+    LVector3f _extents;
     int _last_trav_counter;
   };
 
@@ -72,8 +77,27 @@ private:
   public:
     CamData() = default;
 
+    void build_cache();
+
     int _view_cluster = -1;
     pvector<Object *> _geoms;
+
+    // Bounding boxes of the objects in _geoms, stored as separate arrays so
+    // the frustum test can run on several objects at once.  The arrays are
+    // padded out to a multiple of the SIMD width.
+    pvector<float> _center_x, _center_y, _center_z;
+    pvector<float> _extent_x, _extent_y, _extent_z;
+
+    // The states of the Geoms of each object in _geoms, composed with
+    // _parent_state.  _state_offsets gives the index of the first state of
+    // each object.  Entries are composed on demand and thrown away when the
+    // parent state changes.
+    CPT(RenderState) _parent_state;
+    pvector<CPT(RenderState)> _states;
+    vector_int _state_offsets;
+
+    // Result of the visibility test on each object this frame.
+    pvector<unsigned char> _visible;
   };
 
   pvector<Object> _objects;
@@ -88,6 +112,8 @@ private:
   int _trav_counter;
 
   void add_object_for_draw(CullTraverser *trav, CullTraverserData &data, const Object *object);
+  void cull_cached_objects(CamData *cam_data, CullTraverserData &data,
+                           const MapOcclusionBuffer *occlusion, int begin, int end);
 };
 
 #include "staticPartitionedObjectNode.I"
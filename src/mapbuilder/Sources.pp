@@ -16,6 +16,7 @@
     //area.h area.I \
     config_mapbuilder.h \
     lightBuilder.h lightBuilder.I \
+    mapBuildCache.h mapBuildCache.I \
     mapBuilder.h mapBuilder.I \
     mapBuildOptions.h mapBuildOptions.I \
     mapObjects.h mapObjects.I \
@@ -32,6 +33,7 @@
     //area.cxx \
     config_mapbuilder.cxx \
     lightBuilder.cxx \
+    mapBuildCache.cxx \
     mapBuilder.cxx \
     mapBuildOptions.cxx \
     mapObjects.cxx \
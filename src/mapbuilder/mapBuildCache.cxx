@@ -0,0 +1,267 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mapBuildCache.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "mapBuildCache.h"
+#include "config_mapbuilder.h"
+#include "config_putil.h"
+#include "virtualFileSystem.h"
+#include "bamFile.h"
+#include "bamWriter.h"
+#include "streamReader.h"
+#include "streamWriter.h"
+#include "string_utils.h"
+
+// Identifies a build cache entry file.  Bump the version whenever the
+// layout of the entry file itself changes.
+static const char cache_magic[4] = { 'p', 'm', 'b', 'c' };
+static const uint32_t cache_version = 1;
+
+// The version of the code behind each cached stage, which is part of the key
+// of every entry of that stage.  The input hash only covers the data that
+// goes into a stage, not the code that processes it, so bump the stage's
+// version whenever a change to that code changes its results: LightBuilder
+// for "lighting", VisBuilderBSP for "vis", and the Steam Audio bake for
+// "steam-audio".
+// Otherwise builds will quietly keep using results made by the old code.
+static const struct {
+  const char *_stage;
+  uint32_t _version;
+} stage_versions[] = {
+  { "vis", 1 },
+  { "lighting", 1 },
+  { "steam-audio", 1 },
+};
+
+/**
+ * Returns the code version of the indicated stage, from the table above.
+ */
+static uint32_t
+get_stage_version(const std::string &stage) {
+  for (const auto &entry : stage_versions) {
+    if (stage == entry._stage) {
+      return entry._version;
+    }
+  }
+  nassert_raise("stage " + stage + " has no entry in stage_versions");
+  return 0;
+}
+
+/**
+ *
+ */
+MapBuildCache::
+MapBuildCache() {
+}
+
+/**
+ * Returns the filename of the cache entry for the indicated stage and input
+ * hash.  The code version of the stage is part of the name, so entries that
+ * were written by an older version of the stage are never looked at.
+ */
+Filename MapBuildCache::
+get_entry_filename(const std::string &stage, const HashVal &hash) const {
+  return Filename(_directory, stage + "-v" + format_string(get_stage_version(stage)) +
+                  "-" + hash.as_hex() + ".mbc");
+}
+
+/**
+ * Looks up the entry for the indicated stage and input hash.  If it exists,
+ * fills in the plain data and objects that were stored with it and returns
+ * true.  Returns false if there is no valid entry.
+ */
+bool MapBuildCache::
+read_entry(const std::string &stage, const HashVal &hash,
+           Datagram &data, Objects &objects) const {
+  if (!is_enabled()) {
+    return false;
+  }
+
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  Filename filename = get_entry_filename(stage, hash);
+  if (!vfs->exists(filename)) {
+    return false;
+  }
+
+  std::istream *in = vfs->open_read_file(filename, false);
+  if (in == nullptr) {
+    return false;
+  }
+
+  bool okay = false;
+  objects.clear();
+
+  {
+    StreamReader reader(in, false);
+
+    unsigned char magic[4];
+    if (reader.extract_bytes(magic, 4) == 4 &&
+        memcmp(magic, cache_magic, 4) == 0 &&
+        reader.get_uint32() == cache_version &&
+        reader.get_uint32() == get_stage_version(stage)) {
+
+      size_t length = reader.get_uint32();
+      std::string buffer(length, '\0');
+      if (reader.extract_bytes((unsigned char *)&buffer[0], length) == length) {
+        data = Datagram(buffer.data(), length);
+      }
+      size_t num_objects = reader.get_uint32();
+
+      BamFile bam;
+      if (!in->fail() && bam.open_read(*in, filename, false)) {
+        pvector<TypedWritable *> read_objects;
+        while (read_objects.size() < num_objects) {
+          TypedWritable *object = bam.read_object();
+          if (object == nullptr) {
+            break;
+          }
+          read_objects.push_back(object);
+        }
+
+        if (read_objects.size() == num_objects && bam.resolve()) {
+          for (TypedWritable *object : read_objects) {
+            objects.push_back(DCAST(TypedWritableReferenceCount, object));
+          }
+          okay = true;
+        }
+      }
+    }
+  }
+
+  vfs->close_read_file(in);
+
+  if (!okay) {
+    mapbuilder_cat.warning()
+      << "Ignoring invalid build cache entry " << filename << "\n";
+    data.clear();
+    objects.clear();
+
+  } else {
+    mapbuilder_cat.info()
+      << "Using cached " << stage << " results from " << filename << "\n";
+  }
+
+  return okay;
+}
+
+/**
+ * Stores the indicated plain data and objects as the entry for the indicated
+ * stage and input hash.  Returns true on success.
+ */
+bool MapBuildCache::
+write_entry(const std::string &stage, const HashVal &hash,
+            const Datagram &data, const Objects &objects) const {
+  if (!is_enabled()) {
+    return false;
+  }
+
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  vfs->make_directory_full(_directory);
+
+  // Write to a temporary file first, so an interrupted build doesn't leave
+  // behind a truncated entry.
+  Filename filename = get_entry_filename(stage, hash);
+  Filename temp_filename = filename.get_fullpath() + ".tmp";
+
+  std::ostream *out = vfs->open_write_file(temp_filename, false, true);
+  if (out == nullptr) {
+    mapbuilder_cat.warning()
+      << "Unable to write build cache entry " << temp_filename << "\n";
+    return false;
+  }
+
+  bool okay = true;
+
+  {
+    StreamWriter writer(out, false);
+    writer.append_data(cache_magic, 4);
+    writer.add_uint32(cache_version);
+    writer.add_uint32(get_stage_version(stage));
+    writer.add_uint32((uint32_t)data.get_length());
+    writer.append_data(data.get_data(), data.get_length());
+    writer.add_uint32((uint32_t)objects.size());
+
+    BamFile bam;
+    if (!bam.open_write(*out, temp_filename, false)) {
+      okay = false;
+
+    } else {
+      // Keep texture and material references as they are, like the final
+      // map output does.
+      bam.get_writer()->set_file_texture_mode(BamWriter::BTM_unchanged);
+      bam.get_writer()->set_file_material_mode(BamWriter::BTM_unchanged);
+      for (TypedWritableReferenceCount *object : objects) {
+        if (!bam.write_object(object)) {
+          okay = false;
+          break;
+        }
+      }
+      bam.close();
+    }
+
+    okay = okay && !out->fail();
+  }
+
+  vfs->close_write_file(out);
+
+  if (okay) {
+    vfs->delete_file(filename);
+    okay = vfs->rename_file(temp_filename, filename);
+  }
+
+  if (!okay) {
+    mapbuilder_cat.warning()
+      << "Failed to write build cache entry " << filename << "\n";
+    vfs->delete_file(temp_filename);
+  }
+
+  return okay;
+}
+
+/**
+ * Returns the hash of the contents of the indicated Datagram.  The inputs to
+ * a stage are packed into a Datagram and hashed with this.
+ */
+HashVal MapBuildCache::
+hash_datagram(const Datagram &data) {
+  HashVal hash;
+  hash.hash_buffer((const char *)data.get_data(), data.get_length());
+  return hash;
+}
+
+/**
+ * Adds the name and a hash of the contents of the indicated file, searched
+ * for along the model path, to the Datagram of stage inputs.  A file that
+ * can't be found hashes to zero.
+ */
+void MapBuildCache::
+add_file_hash(Datagram &data, const Filename &filename) {
+  data.add_string(filename.get_fullpath());
+
+  Filename fullpath = filename;
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  vfs->resolve_filename(fullpath, get_model_path());
+
+  FileHashes::const_iterator it = _file_hashes.find(fullpath.get_fullpath());
+  if (it != _file_hashes.end()) {
+    (*it).second.write_datagram(data);
+    return;
+  }
+
+  HashVal hash;
+  std::string contents;
+  if (vfs->read_file(fullpath, contents, true)) {
+    hash.hash_string(contents);
+  }
+  _file_hashes[fullpath.get_fullpath()] = hash;
+  hash.write_datagram(data);
+}
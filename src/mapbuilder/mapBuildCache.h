@@ -0,0 +1,71 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file mapBuildCache.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef MAPBUILDCACHE_H
+#define MAPBUILDCACHE_H
+
+#include "pandabase.h"
+#include "filename.h"
+#include "hashVal.h"
+#include "datagram.h"
+#include "typedWritableReferenceCount.h"
+#include "pointerTo.h"
+#include "pvector.h"
+#include "pmap.h"
+
+/**
+ * An on-disk cache of the results of individual MapBuilder stages.
+ *
+ * Each entry is keyed by the name of the stage and a hash of everything that
+ * went into the stage: the relevant geometry, entities, material and model
+ * files, and build options.  If a later build of the same or another map
+ * hashes the same inputs for a stage, the stage's results are loaded from
+ * the cache instead of being computed again.  The key also includes a code
+ * version for each stage, which must be bumped in mapBuildCache.cxx whenever
+ * a change to the stage's code changes its results.
+ *
+ * An entry consists of a Datagram of plain data, followed by a list of
+ * objects that are written to and read back from a Bam stream.
+ */
+class EXPCL_PANDA_MAPBUILDER MapBuildCache {
+public:
+  typedef pvector<PT(TypedWritableReferenceCount)> Objects;
+
+  MapBuildCache();
+
+  INLINE void set_directory(const Filename &dirname);
+  INLINE const Filename &get_directory() const;
+  INLINE bool is_enabled() const;
+
+  Filename get_entry_filename(const std::string &stage, const HashVal &hash) const;
+
+  bool read_entry(const std::string &stage, const HashVal &hash,
+                  Datagram &data, Objects &objects) const;
+  bool write_entry(const std::string &stage, const HashVal &hash,
+                   const Datagram &data, const Objects &objects) const;
+
+  static HashVal hash_datagram(const Datagram &data);
+  void add_file_hash(Datagram &data, const Filename &filename);
+
+private:
+  Filename _directory;
+
+  // Hashes of the material and model files referenced by the map, so each
+  // file is only read once per build.
+  typedef pmap<std::string, HashVal> FileHashes;
+  FileHashes _file_hashes;
+};
+
+#include "mapBuildCache.I"
+
+#endif // MAPBUILDCACHE_H
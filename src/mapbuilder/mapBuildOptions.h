@@ -91,6 +91,12 @@ PUBLISHED:
   INLINE void set_steam_audio_pathing(bool flag);
   INLINE bool get_steam_audio_pathing() const;
 
+  INLINE void set_use_build_cache(bool flag);
+  INLINE bool get_use_build_cache() const;
+
+  INLINE void set_build_cache_directory(const Filename &dirname);
+  INLINE const Filename &get_build_cache_directory() const;
+
 public:
   Filename _input_filename;
   Filename _output_filename;
@@ -114,6 +120,11 @@ public:
   PN_stdfloat _mesh_group_size;
 
   int _light_num_rays_per_sample;
+
+  // Reuse the results of build stages whose inputs haven't changed since a
+  // previous build.
+  bool _use_build_cache;
+  Filename _build_cache_directory;
 };
 
 #include "mapBuildOptions.I"
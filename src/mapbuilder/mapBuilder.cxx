@@ -69,6 +69,7 @@
 #include "decalProjector.h"
 #include "string_utils.h"
 #include "look_at.h"
+#include "datagramIterator.h"
 
 #include <stack>
 
@@ -178,6 +179,14 @@ build() {
 
   // Source map file is read in.
 
+  if (_options.get_use_build_cache()) {
+    Filename cache_dir = _options.get_build_cache_directory();
+    if (cache_dir.empty()) {
+      cache_dir = Filename(_options._output_filename.get_dirname(), ".mapcache");
+    }
+    _cache.set_directory(cache_dir);
+  }
+
   _out_data = new MapData;
   _out_top = new ModelRoot(_source_map->_filename.get_basename_wo_extension());
   _out_node = new MapRoot(_out_data);
@@ -367,6 +376,17 @@ build() {
 
   case MapBuildOptions::VT_bsp:
     {
+      if (_cache.is_enabled()) {
+        _vis_hash = hash_vis_inputs();
+        if (read_vis_cache(_vis_hash)) {
+          break;
+        }
+      }
+
+      // The VisBuilder moves 3-D skybox polygons out of the world mesh, so
+      // remember the original order for the cache.
+      pvector<PT(MapGeom)> world_polys = _meshes[0]->_polys;
+
       VisBuilderBSP vis;
       vis._builder = this;
       vis._hint_split = false;
@@ -508,6 +528,10 @@ build() {
         }
       }
 
+      if (_cache.is_enabled() && !vis._is_leaked) {
+        write_vis_cache(_vis_hash, world_polys);
+      }
+
 #if 0
       // Put leaf bounds in there
       LineSegs segs("leaves");
@@ -620,6 +644,10 @@ build() {
     break;
   }
 
+  if (_cache.is_enabled()) {
+    _geometry_hash = hash_geometry_inputs();
+  }
+
   PT(GeomVertexArrayFormat) arr = new GeomVertexArrayFormat;
   arr->add_column(InternalName::get_vertex(), 3, GeomEnums::NT_stdfloat, GeomEnums::C_point);
   arr->add_column(InternalName::get_normal(), 3, GeomEnums::NT_stdfloat, GeomEnums::C_normal);
@@ -781,6 +809,14 @@ bake_steam_audio() {
   return EC_ok;
 #else
 
+  HashVal audio_hash;
+  if (_cache.is_enabled()) {
+    audio_hash = hash_steam_audio_inputs();
+    if (read_steam_audio_cache(audio_hash)) {
+      return EC_ok;
+    }
+  }
+
   IPLContext context = nullptr;
   IPLContextSettings ctx_settings{};
   ctx_settings.version = STEAMAUDIO_VERSION;
@@ -1220,6 +1256,10 @@ bake_steam_audio() {
     mapbuilder_cat.info()
       << "IPL refl probe data size: " << batch_data.size() << " bytes\n";
 
+    if (_cache.is_enabled()) {
+      write_steam_audio_cache(audio_hash);
+    }
+
     iplProbeBatchRelease(&batch);
     iplSerializedObjectRelease(&batch_obj);
   }
@@ -1901,150 +1941,6 @@ build_lighting() {
   // Works better with the physically based camera.
   static constexpr PN_stdfloat light_scale_factor = 1.0f;//5000.0f;
 
-  // Add map polygons to lightmapper.
-  for (size_t i = 0; i < _meshes.size(); i++) {
-    MapMesh *mesh = _meshes[i];
-    int ent_index = mesh->_entity;
-    MapEntitySrc *ent = _source_map->_entities[ent_index];
-    bool ent_has_disable_shadows = false;
-    if (ent->_properties.find("disableshadows") != ent->_properties.end()) {
-      ent_has_disable_shadows = (bool)atoi(ent->_properties["disableshadows"].c_str());
-    }
-
-    for (size_t j = 0; j < mesh->_polys.size(); j++) {
-      MapGeom *poly = mesh->_polys[j];
-
-      bool is_sky = false;
-      bool occluder = false;
-
-      Material *mat = poly->get_material();
-
-      if (mat != nullptr) {
-        if (mat->has_tag("compile_trigger")) {
-          continue;
-        } else if (mat->has_tag("compile_sky")) {
-          is_sky = true;
-          occluder = true;
-        } else if (mat->has_tag("compile_nodraw")) {
-          occluder = true;
-        }
-      }
-
-      if (!occluder && poly->has_geom()) {
-        NodePath geom_np(poly->get_geom_node());
-
-        uint32_t contents = 0;
-        if (mat != nullptr) {
-          if (mat->has_tag("compile_water")) {
-            // Water don't block or reflect light, but we want a lightmap for it.
-            contents |= LightBuilder::C_dont_block_light;
-            contents |= LightBuilder::C_dont_reflect_light;
-          }
-        }
-        if (ent_has_disable_shadows) {
-          contents |= LightBuilder::C_dont_block_light | LightBuilder::C_dont_reflect_light;
-        }
-
-        GeomNode *pgn = poly->get_geom_node();
-        int pgi = poly->get_geom_index();
-
-        builder.add_geom(pgn->get_geom(pgi),
-                        pgn->get_geom_state(pgi),
-                        geom_np.get_net_transform(), poly->get_lightmap_size(),
-                        pgn, pgi, contents);
-
-      } else if (!poly->has_index() && occluder) {
-        // Add sky triangles as occluders (not lightmapped) with the sky
-        // contents, so rays that hit them bring in the sky/sun color.
-        // This also adds nodraw to block light (consistent with source).
-        Winding w;
-        poly->get_winding(w);
-        for (size_t ipoint = 1; ipoint < (w.get_num_points() - 1); ++ipoint) {
-          LightBuilder::OccluderTri otri;
-          otri.a = w.get_point(ipoint + 1);
-          otri.b = w.get_point(ipoint);
-          otri.c = w.get_point(0);
-          otri.contents = is_sky ? LightBuilder::C_sky : LightBuilder::C_none;
-          builder._occluder_tris.push_back(std::move(otri));
-        }
-      }
-    }
-  }
-
-  // Now get static props.
-  for (int i = 0; i < _out_data->get_num_static_props(); i++) {
-    MapStaticProp *sprop = (MapStaticProp *)_out_data->get_static_prop(i);
-
-    PT(PandaNode) prop_model_node = Loader::get_global_ptr()->load_sync(sprop->get_model_filename());
-    if (prop_model_node == nullptr) {
-      continue;
-    }
-    ModelRoot *prop_mdl_root = DCAST(ModelRoot, prop_model_node);
-    NodePath prop_model(prop_model_node);
-    prop_model.set_pos(sprop->get_pos());
-    prop_model.set_hpr(sprop->get_hpr());
-    int skin = sprop->get_skin();
-    if (skin >= 0 && skin < prop_mdl_root->get_num_material_groups()) {
-      prop_mdl_root->set_active_material_group(skin);
-    }
-
-    prop_model.flatten_light();
-
-    // Get all the Geoms.
-    // If there's an LOD, only get Geoms from the lowest LOD level.
-    NodePath lod = prop_model.find("**/+LODNode");
-    if (!lod.is_empty()) {
-      prop_model = lod.get_child(0);
-    }
-
-    pvector<std::pair<CPT(Geom), CPT(RenderState)>> geoms;
-    r_collect_geoms(prop_model.node(), geoms);
-
-    sprop->_geom_vertex_lighting.resize(geoms.size());
-
-    if ((sprop->_flags & MapStaticProp::F_no_vertex_lighting)) {
-      continue;
-    }
-
-    // Now add the triangles from all the geoms as occluders.
-    for (int j = 0; j < (int)geoms.size(); ++j) {
-      CPT(Geom) geom = geoms[j].first;
-      CPT(RenderState) state = geoms[j].second;
-
-      bool cast_shadows = (sprop->_flags & MapStaticProp::F_no_shadows) == 0;
-
-      // Exclude triangles with transparency enabled.
-      const TransparencyAttrib *trans;
-      state->get_attrib_def(trans);
-      if (trans->get_mode() != TransparencyAttrib::M_none) {
-        cast_shadows = false;
-      }
-      if (state->has_attrib(AlphaTestAttrib::get_class_slot())) {
-        cast_shadows = false;
-      }
-      const MaterialAttrib *mattr;
-      state->get_attrib_def(mattr);
-      Material *mat = mattr->get_material();
-      if (mat != nullptr) {
-        if ((mat->_attrib_flags & Material::F_transparency) != 0u &&
-            mat->_transparency_mode > 0) {
-          cast_shadows = false;
-
-        } else if ((mat->_attrib_flags & Material::F_alpha_test) != 0u &&
-                    mat->_alpha_test_mode > 0) {
-          cast_shadows = false;
-        }
-      }
-
-      uint32_t contents = 0;
-      if (!cast_shadows) {
-        contents |= LightBuilder::C_dont_block_light;
-      }
-
-      builder.add_vertex_geom(geom, state, TransformState::make_identity(), i, j, contents);
-    }
-  }
-
   NodePath dlnp;
   bool got_directional = false;
 
@@ -2244,84 +2140,246 @@ build_lighting() {
     builder._lights.push_back(light);
   }
 
-  // Add ambient probes.
-
-  // Start at the lowest corner of the level bounds and work our way to the top.
-#if 0
-  for (PN_stdfloat z = _scene_mins[2]; z <= _scene_maxs[2]; z += 128.0f) {
-    for (PN_stdfloat y = _scene_mins[1]; y <= _scene_maxs[1]; y += 128.0f) {
-      for (PN_stdfloat x = _scene_mins[0]; x <= _scene_maxs[0]; x += 128.0f) {
-        LPoint3 pos(x, y, z);
-        if (_out_data->get_area_cluster_tree()->get_leaf_value_from_point(pos) == -1) {
-          // Probe is not in valid cluster.  Skip it.
-          continue;
-        }
-
-        builder._probes.push_back({ pos });
-      }
+  // The lights have been added to the output.  If the lightmaps were baked
+  // before from the same inputs, the rest can come from the cache.
+  HashVal light_hash;
+  if (_cache.is_enabled()) {
+    Datagram dg;
+    dg.add_string("lighting");
+    _geometry_hash.write_datagram(dg);
+    _vis_hash.write_datagram(dg);
+    add_entity_inputs(dg);
+    dg.add_int32(_options.get_light_num_rays_per_sample());
+    light_hash = MapBuildCache::hash_datagram(dg);
+
+    if (read_lighting_cache(light_hash)) {
+      assign_sun_light(dlnp);
+      return EC_ok;
     }
   }
-#else
-  {
-    const BSPTree *tree = (const BSPTree *)_out_data->get_area_cluster_tree();
-    VisClusterSampler sampler(_out_data);
-    LVecBase3 probe_density(128.0f, 128.0f, 128.0f);
-    for (int i = 0; i < (int)tree->_leaves.size(); i++) {
-      const BSPTree::Leaf *leaf = tree->get_leaf(i);
-      if (leaf->is_solid() || leaf->get_value() < 0) {
-        continue;
-      }
-      pset<LPoint3> samples;
-      sampler.generate_samples(i, probe_density, 128, 1, samples);
-      for (const LPoint3 &sample : samples) {
-        builder._probes.push_back({ sample });
-      }
+
+  // Add map polygons to lightmapper.
+  for (size_t i = 0; i < _meshes.size(); i++) {
+    MapMesh *mesh = _meshes[i];
+    int ent_index = mesh->_entity;
+    MapEntitySrc *ent = _source_map->_entities[ent_index];
+    bool ent_has_disable_shadows = false;
+    if (ent->_properties.find("disableshadows") != ent->_properties.end()) {
+      ent_has_disable_shadows = (bool)atoi(ent->_properties["disableshadows"].c_str());
     }
-  }
-#endif
 
-  mapbuilder_cat.info()
-    << builder._probes.size() << " ambient probes\n";
+    for (size_t j = 0; j < mesh->_polys.size(); j++) {
+      MapGeom *poly = mesh->_polys[j];
 
-  if (!builder.solve()) {
-    return EC_lightmap_failed;
-  }
+      bool is_sky = false;
+      bool occluder = false;
 
-#if 1
-  // Write static prop vertex light arrays.
-  for (const LightBuilder::LightmapGeom &lgeom : builder._geoms) {
-    if (lgeom.light_mode != LightBuilder::LightmapGeom::LM_per_vertex) {
-      continue;
-    }
+      Material *mat = poly->get_material();
 
-    MapStaticProp *sprop = (MapStaticProp *)_out_data->get_static_prop(lgeom.model_index);
-    sprop->_geom_vertex_lighting[lgeom.geom_index] = lgeom.vertex_light_array;
-  }
-#endif
+      if (mat != nullptr) {
+        if (mat->has_tag("compile_trigger")) {
+          continue;
+        } else if (mat->has_tag("compile_sky")) {
+          is_sky = true;
+          occluder = true;
+        } else if (mat->has_tag("compile_nodraw")) {
+          occluder = true;
+        }
+      }
 
-#if 0
-  // Write debug data.
-  LightDebugData &ld_data = _out_data->_light_debug_data;
-  for (const LightBuilder::LightmapVertex &v : builder._vertices) {
-    LightDebugData::Vertex lv;
-    lv.pos = v.pos;
-    ld_data._vertices.push_back(lv);
-  }
-  for (const LightBuilder::LightmapTri &tri : builder._triangles) {
-    LightDebugData::Triangle lt;
-    lt.vert0 = tri.indices[0];
-    lt.vert1 = tri.indices[1];
-    lt.vert2 = tri.indices[2];
-    ld_data._triangles.push_back(lt);
-  }
-  for (const LightBuilder::KDNode *pnode = builder._kd_tree_head; pnode != nullptr; pnode = pnode->next) {
-    const LightBuilder::KDNode &node = *pnode;
+      if (!occluder && poly->has_geom()) {
+        NodePath geom_np(poly->get_geom_node());
 
-    LightDebugData::KDNode ln;
-    ln.first_tri = node.first_triangle;
-    ln.num_tris = node.num_triangles;
-    ln.back_child = node.get_child_node_index(0);
-    ln.front_child = node.get_child_node_index(1);
+        uint32_t contents = 0;
+        if (mat != nullptr) {
+          if (mat->has_tag("compile_water")) {
+            // Water don't block or reflect light, but we want a lightmap for it.
+            contents |= LightBuilder::C_dont_block_light;
+            contents |= LightBuilder::C_dont_reflect_light;
+          }
+        }
+        if (ent_has_disable_shadows) {
+          contents |= LightBuilder::C_dont_block_light | LightBuilder::C_dont_reflect_light;
+        }
+
+        GeomNode *pgn = poly->get_geom_node();
+        int pgi = poly->get_geom_index();
+
+        builder.add_geom(pgn->get_geom(pgi),
+                        pgn->get_geom_state(pgi),
+                        geom_np.get_net_transform(), poly->get_lightmap_size(),
+                        pgn, pgi, contents);
+
+      } else if (!poly->has_index() && occluder) {
+        // Add sky triangles as occluders (not lightmapped) with the sky
+        // contents, so rays that hit them bring in the sky/sun color.
+        // This also adds nodraw to block light (consistent with source).
+        Winding w;
+        poly->get_winding(w);
+        for (size_t ipoint = 1; ipoint < (w.get_num_points() - 1); ++ipoint) {
+          LightBuilder::OccluderTri otri;
+          otri.a = w.get_point(ipoint + 1);
+          otri.b = w.get_point(ipoint);
+          otri.c = w.get_point(0);
+          otri.contents = is_sky ? LightBuilder::C_sky : LightBuilder::C_none;
+          builder._occluder_tris.push_back(std::move(otri));
+        }
+      }
+    }
+  }
+
+  // Now get static props.
+  for (int i = 0; i < _out_data->get_num_static_props(); i++) {
+    MapStaticProp *sprop = (MapStaticProp *)_out_data->get_static_prop(i);
+
+    PT(PandaNode) prop_model_node = Loader::get_global_ptr()->load_sync(sprop->get_model_filename());
+    if (prop_model_node == nullptr) {
+      continue;
+    }
+    ModelRoot *prop_mdl_root = DCAST(ModelRoot, prop_model_node);
+    NodePath prop_model(prop_model_node);
+    prop_model.set_pos(sprop->get_pos());
+    prop_model.set_hpr(sprop->get_hpr());
+    int skin = sprop->get_skin();
+    if (skin >= 0 && skin < prop_mdl_root->get_num_material_groups()) {
+      prop_mdl_root->set_active_material_group(skin);
+    }
+
+    prop_model.flatten_light();
+
+    // Get all the Geoms.
+    // If there's an LOD, only get Geoms from the lowest LOD level.
+    NodePath lod = prop_model.find("**/+LODNode");
+    if (!lod.is_empty()) {
+      prop_model = lod.get_child(0);
+    }
+
+    pvector<std::pair<CPT(Geom), CPT(RenderState)>> geoms;
+    r_collect_geoms(prop_model.node(), geoms);
+
+    sprop->_geom_vertex_lighting.resize(geoms.size());
+
+    if ((sprop->_flags & MapStaticProp::F_no_vertex_lighting)) {
+      continue;
+    }
+
+    // Now add the triangles from all the geoms as occluders.
+    for (int j = 0; j < (int)geoms.size(); ++j) {
+      CPT(Geom) geom = geoms[j].first;
+      CPT(RenderState) state = geoms[j].second;
+
+      bool cast_shadows = (sprop->_flags & MapStaticProp::F_no_shadows) == 0;
+
+      // Exclude triangles with transparency enabled.
+      const TransparencyAttrib *trans;
+      state->get_attrib_def(trans);
+      if (trans->get_mode() != TransparencyAttrib::M_none) {
+        cast_shadows = false;
+      }
+      if (state->has_attrib(AlphaTestAttrib::get_class_slot())) {
+        cast_shadows = false;
+      }
+      const MaterialAttrib *mattr;
+      state->get_attrib_def(mattr);
+      Material *mat = mattr->get_material();
+      if (mat != nullptr) {
+        if ((mat->_attrib_flags & Material::F_transparency) != 0u &&
+            mat->_transparency_mode > 0) {
+          cast_shadows = false;
+
+        } else if ((mat->_attrib_flags & Material::F_alpha_test) != 0u &&
+                    mat->_alpha_test_mode > 0) {
+          cast_shadows = false;
+        }
+      }
+
+      uint32_t contents = 0;
+      if (!cast_shadows) {
+        contents |= LightBuilder::C_dont_block_light;
+      }
+
+      builder.add_vertex_geom(geom, state, TransformState::make_identity(), i, j, contents);
+    }
+  }
+
+  // Add ambient probes.
+
+  // Start at the lowest corner of the level bounds and work our way to the top.
+#if 0
+  for (PN_stdfloat z = _scene_mins[2]; z <= _scene_maxs[2]; z += 128.0f) {
+    for (PN_stdfloat y = _scene_mins[1]; y <= _scene_maxs[1]; y += 128.0f) {
+      for (PN_stdfloat x = _scene_mins[0]; x <= _scene_maxs[0]; x += 128.0f) {
+        LPoint3 pos(x, y, z);
+        if (_out_data->get_area_cluster_tree()->get_leaf_value_from_point(pos) == -1) {
+          // Probe is not in valid cluster.  Skip it.
+          continue;
+        }
+
+        builder._probes.push_back({ pos });
+      }
+    }
+  }
+#else
+  {
+    const BSPTree *tree = (const BSPTree *)_out_data->get_area_cluster_tree();
+    VisClusterSampler sampler(_out_data);
+    LVecBase3 probe_density(128.0f, 128.0f, 128.0f);
+    for (int i = 0; i < (int)tree->_leaves.size(); i++) {
+      const BSPTree::Leaf *leaf = tree->get_leaf(i);
+      if (leaf->is_solid() || leaf->get_value() < 0) {
+        continue;
+      }
+      pset<LPoint3> samples;
+      sampler.generate_samples(i, probe_density, 128, 1, samples);
+      for (const LPoint3 &sample : samples) {
+        builder._probes.push_back({ sample });
+      }
+    }
+  }
+#endif
+
+  mapbuilder_cat.info()
+    << builder._probes.size() << " ambient probes\n";
+
+  if (!builder.solve()) {
+    return EC_lightmap_failed;
+  }
+
+#if 1
+  // Write static prop vertex light arrays.
+  for (const LightBuilder::LightmapGeom &lgeom : builder._geoms) {
+    if (lgeom.light_mode != LightBuilder::LightmapGeom::LM_per_vertex) {
+      continue;
+    }
+
+    MapStaticProp *sprop = (MapStaticProp *)_out_data->get_static_prop(lgeom.model_index);
+    sprop->_geom_vertex_lighting[lgeom.geom_index] = lgeom.vertex_light_array;
+  }
+#endif
+
+#if 0
+  // Write debug data.
+  LightDebugData &ld_data = _out_data->_light_debug_data;
+  for (const LightBuilder::LightmapVertex &v : builder._vertices) {
+    LightDebugData::Vertex lv;
+    lv.pos = v.pos;
+    ld_data._vertices.push_back(lv);
+  }
+  for (const LightBuilder::LightmapTri &tri : builder._triangles) {
+    LightDebugData::Triangle lt;
+    lt.vert0 = tri.indices[0];
+    lt.vert1 = tri.indices[1];
+    lt.vert2 = tri.indices[2];
+    ld_data._triangles.push_back(lt);
+  }
+  for (const LightBuilder::KDNode *pnode = builder._kd_tree_head; pnode != nullptr; pnode = pnode->next) {
+    const LightBuilder::KDNode &node = *pnode;
+
+    LightDebugData::KDNode ln;
+    ln.first_tri = node.first_triangle;
+    ln.num_tris = node.num_triangles;
+    ln.back_child = node.get_child_node_index(0);
+    ln.front_child = node.get_child_node_index(1);
     ln.mins = node.mins;
     ln.maxs = node.maxs;
     for (int j = 0; j < 6; ++j) {
@@ -2400,7 +2458,20 @@ build_lighting() {
     _out_data->add_ambient_probe(mprobe);
   }
 
-  // Assign the sun light to any polys that can see the sky.
+  if (_cache.is_enabled()) {
+    write_lighting_cache(light_hash);
+  }
+
+  assign_sun_light(dlnp);
+
+  return EC_ok;
+}
+
+/**
+ * Assigns the indicated sun light to any world polygons that can see the sky.
+ */
+void MapBuilder::
+assign_sun_light(const NodePath &dlnp) {
   if (!dlnp.is_empty()) {
     for (size_t i = 0; i < _meshes[0]->_polys.size(); ++i) {
       MapGeom *poly = _meshes[0]->_polys[i];
@@ -2826,6 +2897,628 @@ build_overlays() {
   }
 }
 
+/**
+ * Adds the class name and properties of every entity in the source map to
+ * the Datagram of stage inputs.
+ */
+void MapBuilder::
+add_entity_inputs(Datagram &dg) const {
+  dg.add_uint32((uint32_t)_source_map->_entities.size());
+  for (const MapEntitySrc *ent : _source_map->_entities) {
+    dg.add_string(ent->_class_name);
+    dg.add_uint32((uint32_t)ent->_properties.size());
+    for (auto it = ent->_properties.begin(); it != ent->_properties.end(); ++it) {
+      dg.add_string((*it).first);
+      dg.add_string((*it).second);
+    }
+  }
+}
+
+/**
+ * Adds the vertices, material, and lightmap parameters of the indicated
+ * polygon to the Datagram of stage inputs.
+ */
+void MapBuilder::
+add_poly_inputs(Datagram &dg, const MapGeom *poly) {
+  dg.add_int32(poly->get_side_id());
+  dg.add_bool(poly->is_visible());
+  dg.add_bool(poly->can_see_sky());
+
+  Material *mat = poly->get_material();
+  if (mat != nullptr) {
+    _cache.add_file_hash(dg, mat->get_fullpath());
+  } else {
+    dg.add_string(std::string());
+  }
+  Texture *base_tex = poly->get_base_tex();
+  if (base_tex != nullptr) {
+    _cache.add_file_hash(dg, base_tex->get_fullpath());
+  } else {
+    dg.add_string(std::string());
+  }
+
+  poly->get_lightmap_size().write_datagram(dg);
+
+  int num_rows = poly->get_num_vertex_rows();
+  dg.add_uint32(num_rows);
+  for (int i = 0; i < num_rows; ++i) {
+    poly->get_pos(i).write_datagram(dg);
+    if (poly->has_normal()) {
+      poly->get_normal(i).write_datagram(dg);
+    }
+    poly->get_uv(i).write_datagram(dg);
+    poly->get_lightmap_uv(i).write_datagram(dg);
+    if (poly->has_alpha()) {
+      dg.add_stdfloat(poly->get_alpha(i));
+    }
+  }
+
+  if (poly->has_index()) {
+    int num_vertices = poly->get_num_vertices();
+    dg.add_uint32(num_vertices);
+    for (int i = 0; i < num_vertices; ++i) {
+      dg.add_int32(poly->get_index(i));
+    }
+  }
+}
+
+/**
+ * Returns a hash of everything that goes into building the BSP tree and PVS:
+ * the structural world solids, the materials that decide which of their
+ * sides are opaque, the entities that the outside is flooded from, and the
+ * world polygons that are clipped into the tree.
+ */
+HashVal MapBuilder::
+hash_vis_inputs() {
+  Datagram dg;
+  dg.add_string("vis-bsp");
+
+  dg.add_uint32((uint32_t)_source_map->_world->_solids.size());
+  for (const MapSolid *solid : _source_map->_world->_solids) {
+    dg.add_uint32((uint32_t)solid->_sides.size());
+    for (const MapSide *side : solid->_sides) {
+      side->_plane.write_datagram(dg);
+      dg.add_bool(side->_displacement != nullptr);
+
+      Filename material_filename = Filename(downcase(side->_material_filename.get_fullpath_wo_extension()));
+      material_filename.set_extension("mto");
+      _cache.add_file_hash(dg, material_filename);
+    }
+  }
+
+  add_entity_inputs(dg);
+
+  const MapMesh *world_mesh = _meshes[0];
+  dg.add_uint32((uint32_t)world_mesh->_polys.size());
+  for (const MapGeom *poly : world_mesh->_polys) {
+    int num_rows = poly->get_num_vertex_rows();
+    dg.add_uint32(num_rows);
+    for (int i = 0; i < num_rows; ++i) {
+      poly->get_pos(i).write_datagram(dg);
+    }
+    dg.add_bool(poly->has_index());
+    if (poly->has_index()) {
+      int num_vertices = poly->get_num_vertices();
+      dg.add_uint32(num_vertices);
+      for (int i = 0; i < num_vertices; ++i) {
+        dg.add_int32(poly->get_index(i));
+      }
+    }
+  }
+
+  return MapBuildCache::hash_datagram(dg);
+}
+
+/**
+ * Returns a hash of the renderable geometry of the map after visibility has
+ * been computed: every mesh polygon with its materials, and every static
+ * prop model with its placement.
+ */
+HashVal MapBuilder::
+hash_geometry_inputs() {
+  Datagram dg;
+  dg.add_string("geometry");
+
+  dg.add_uint32((uint32_t)_meshes.size());
+  for (const MapMesh *mesh : _meshes) {
+    dg.add_int32(mesh->_entity);
+    dg.add_bool(mesh->_3d_sky_mesh);
+    dg.add_uint32((uint32_t)mesh->_polys.size());
+    for (const MapGeom *poly : mesh->_polys) {
+      add_poly_inputs(dg, poly);
+    }
+  }
+
+  dg.add_uint32((uint32_t)_out_data->get_num_static_props());
+  for (size_t i = 0; i < _out_data->get_num_static_props(); ++i) {
+    const MapStaticProp *sprop = _out_data->get_static_prop(i);
+    _cache.add_file_hash(dg, sprop->get_model_filename());
+    sprop->get_pos().write_datagram(dg);
+    sprop->get_hpr().write_datagram(dg);
+    dg.add_int32(sprop->get_skin());
+    dg.add_bool(sprop->get_solid());
+    dg.add_uint32(sprop->_flags);
+  }
+
+  return MapBuildCache::hash_datagram(dg);
+}
+
+/**
+ * Returns a hash of everything that goes into baking the Steam Audio probes:
+ * the world geometry and static props that make up the acoustic scene, with
+ * the materials that their surface properties come from, and the visibility
+ * information and level bounds that the probes are placed with.
+ */
+HashVal MapBuilder::
+hash_steam_audio_inputs() {
+  Datagram dg;
+  dg.add_string("steam-audio");
+#ifdef HAVE_STEAM_AUDIO
+  dg.add_uint32(STEAMAUDIO_VERSION);
+#endif
+
+  _geometry_hash.write_datagram(dg);
+
+  // The probes are placed in the leaves of the BSP tree, or on a grid over
+  // the level bounds without one.
+  dg.add_uint8((uint8_t)_options.get_vis());
+  _vis_hash.write_datagram(dg);
+  _scene_mins.write_datagram(dg);
+  _scene_maxs.write_datagram(dg);
+
+  dg.add_bool(_options._do_steam_audio_reflections);
+  dg.add_bool(_options._do_steam_audio_pathing);
+
+  return MapBuildCache::hash_datagram(dg);
+}
+
+/**
+ * Applies the cached results of a previous visibility build with the same
+ * inputs, if there are any.  Returns true if the cached results were used,
+ * or false if visibility needs to be computed.
+ */
+bool MapBuilder::
+read_vis_cache(const HashVal &hash) {
+  Datagram data;
+  MapBuildCache::Objects objects;
+  if (!_cache.read_entry("vis", hash, data, objects)) {
+    return false;
+  }
+
+  if (objects.size() != 1 || !objects[0]->is_of_type(BSPTree::get_class_type())) {
+    return false;
+  }
+  BSPTree *tree = DCAST(BSPTree, objects[0].p());
+
+  // The whole entry is read and checked before any of it is applied, so that
+  // a damaged entry only means that the stage is run again.
+  DatagramIterator scan(data);
+  const size_t point_size = data.get_stdfloat_double() ? 24 : 12;
+
+  MapMesh *world_mesh = _meshes[0];
+  if (scan.get_remaining_size() < 4 ||
+      scan.get_uint32() != world_mesh->_polys.size()) {
+    return false;
+  }
+
+  pvector<vector_int> poly_leaves(world_mesh->_polys.size());
+  pvector<unsigned char> poly_flags(world_mesh->_polys.size());
+  for (size_t i = 0; i < world_mesh->_polys.size(); ++i) {
+    if (scan.get_remaining_size() < 7) {
+      return false;
+    }
+    poly_flags[i] = (scan.get_bool() ? 1 : 0) |
+                    (scan.get_bool() ? 2 : 0) |
+                    (scan.get_bool() ? 4 : 0);
+    size_t num_leaves = scan.get_uint32();
+    if (num_leaves > scan.get_remaining_size() / 4) {
+      return false;
+    }
+    poly_leaves[i].resize(num_leaves);
+    for (size_t j = 0; j < num_leaves; ++j) {
+      poly_leaves[i][j] = scan.get_int32();
+    }
+  }
+
+  if (scan.get_remaining_size() < 4) {
+    return false;
+  }
+  size_t num_clusters = scan.get_uint32();
+  if (num_clusters > scan.get_remaining_size() / 13) {
+    return false;
+  }
+
+  // Reads a list of cluster indices, returning false if it runs past the end
+  // of the entry or names a cluster that doesn't exist.
+  auto read_clusters = [&scan, num_clusters](vector_int &clusters) {
+    if (scan.get_remaining_size() < 4) {
+      return false;
+    }
+    size_t count = scan.get_uint32();
+    if (count > scan.get_remaining_size() / 4) {
+      return false;
+    }
+    clusters.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      clusters[i] = scan.get_int32();
+      if (clusters[i] < 0 || clusters[i] >= (int)num_clusters) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  pvector<AreaClusterPVS> clusters(num_clusters);
+  for (AreaClusterPVS &pvs : clusters) {
+    if (scan.get_remaining_size() < 1) {
+      return false;
+    }
+    pvs._3d_sky_cluster = scan.get_bool();
+    if (!read_clusters(pvs._pvs) || !read_clusters(pvs._phs)) {
+      return false;
+    }
+    if (scan.get_remaining_size() < 4) {
+      return false;
+    }
+    size_t count = scan.get_uint32();
+    if (count > scan.get_remaining_size() / point_size) {
+      return false;
+    }
+    pvs._box_bounds.resize(count);
+    for (size_t j = 0; j < count; ++j) {
+      pvs._box_bounds[j].read_datagram(scan);
+    }
+  }
+
+  if (scan.get_remaining_size() < 4) {
+    return false;
+  }
+  size_t num_portals = scan.get_uint32();
+  if (num_portals * point_size != scan.get_remaining_size()) {
+    return false;
+  }
+  pvector<LPoint3> portal_centers(num_portals);
+  for (size_t i = 0; i < num_portals; ++i) {
+    portal_centers[i].read_datagram(scan);
+  }
+
+  // The polygons are in leaves of the tree, which are numbered by cluster.
+  for (const vector_int &leaves : poly_leaves) {
+    for (int leaf : leaves) {
+      if (leaf < 0 || leaf >= (int)num_clusters) {
+        return false;
+      }
+    }
+  }
+
+  // Each child of a node comes after it, so walking down the tree always
+  // ends in a leaf.
+  if (tree->_nodes.empty()) {
+    return false;
+  }
+  for (size_t i = 0; i < tree->_nodes.size(); ++i) {
+    for (int child : tree->_nodes[i].children) {
+      if (child > 0 ? (child <= (int)i || child >= (int)tree->_nodes.size())
+                    : (child < 0 && ~child >= (int)tree->_leaves.size())) {
+        return false;
+      }
+    }
+  }
+  for (const BSPTree::Leaf &leaf : tree->_leaves) {
+    if (leaf.value >= (int)num_clusters) {
+      return false;
+    }
+  }
+
+  // The parent links aren't written to the bam file, but the later stages
+  // walk up the tree with them.
+  tree->_node_parents.assign(tree->_nodes.size(), -1);
+  tree->_leaf_parents.assign(tree->_leaves.size(), -1);
+  for (size_t i = 0; i < tree->_nodes.size(); ++i) {
+    for (int child : tree->_nodes[i].children) {
+      if (child > 0) {
+        tree->_node_parents[child] = (int)i;
+      } else if (child < 0) {
+        tree->_leaf_parents[~child] = (int)i;
+      }
+    }
+  }
+
+  bool any_in_3d_sky = false;
+  for (size_t i = 0; i < world_mesh->_polys.size(); ++i) {
+    MapGeom *poly = world_mesh->_polys[i];
+    poly->set_visible((poly_flags[i] & 1) != 0);
+    poly->set_in_3d_sky((poly_flags[i] & 2) != 0);
+    poly->set_can_see_sky((poly_flags[i] & 4) != 0);
+    for (int leaf : poly_leaves[i]) {
+      poly->insert_leaf(leaf);
+    }
+    any_in_3d_sky = any_in_3d_sky || poly->is_in_3d_sky();
+  }
+
+  if (any_in_3d_sky) {
+    // Move polygons in the 3-D skybox into their own mesh, as the
+    // VisBuilder does.
+    _3d_sky_mesh = new MapMesh;
+    _3d_sky_mesh->_is_mesh = true;
+    _3d_sky_mesh->_3d_sky_mesh = true;
+    _3d_sky_mesh->_in_group = false;
+    _3d_sky_mesh->_in_mesh_group = false;
+    _3d_sky_mesh->_entity = 0;
+    for (auto it = world_mesh->_polys.begin(); it != world_mesh->_polys.end();) {
+      MapGeom *poly = *it;
+      if (poly->is_in_3d_sky()) {
+        _3d_sky_mesh->_polys.push_back(poly);
+        it = world_mesh->_polys.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    _meshes.push_back(_3d_sky_mesh);
+    _3d_sky_mesh_index = (int)_meshes.size() - 1;
+  }
+
+  for (const AreaClusterPVS &pvs : clusters) {
+    _out_data->add_cluster_pvs(pvs);
+  }
+  _out_data->set_area_cluster_tree(tree);
+  _portal_centers.insert(_portal_centers.end(), portal_centers.begin(), portal_centers.end());
+
+  return true;
+}
+
+/**
+ * Stores the results of the visibility build in the cache.  world_polys is
+ * the list of world polygons in the order they were in before the
+ * VisBuilder moved the 3-D skybox polygons out of the world mesh.
+ */
+void MapBuilder::
+write_vis_cache(const HashVal &hash, const pvector<PT(MapGeom)> &world_polys) const {
+  Datagram data;
+
+  data.add_uint32((uint32_t)world_polys.size());
+  for (const MapGeom *poly : world_polys) {
+    data.add_bool(poly->is_visible());
+    data.add_bool(poly->is_in_3d_sky());
+    data.add_bool(poly->can_see_sky());
+    const pset<int> &leaves = poly->get_leaves();
+    data.add_uint32((uint32_t)leaves.size());
+    for (int leaf : leaves) {
+      data.add_int32(leaf);
+    }
+  }
+
+  data.add_uint32((uint32_t)_out_data->get_num_clusters());
+  for (int i = 0; i < _out_data->get_num_clusters(); ++i) {
+    const AreaClusterPVS *pvs = _out_data->get_cluster_pvs(i);
+    data.add_bool(pvs->_3d_sky_cluster);
+    data.add_uint32((uint32_t)pvs->_pvs.size());
+    for (int cluster : pvs->_pvs) {
+      data.add_int32(cluster);
+    }
+    data.add_uint32((uint32_t)pvs->_phs.size());
+    for (int cluster : pvs->_phs) {
+      data.add_int32(cluster);
+    }
+    data.add_uint32((uint32_t)pvs->_box_bounds.size());
+    for (const LPoint3 &point : pvs->_box_bounds) {
+      point.write_datagram(data);
+    }
+  }
+
+  data.add_uint32((uint32_t)_portal_centers.size());
+  for (const LPoint3 &center : _portal_centers) {
+    center.write_datagram(data);
+  }
+
+  MapBuildCache::Objects objects;
+  objects.push_back((SpatialPartition *)_out_data->get_area_cluster_tree());
+  _cache.write_entry("vis", hash, data, objects);
+}
+
+/**
+ * Applies the cached results of a previous lighting build with the same
+ * inputs, if there are any: the lightmapped Geoms and their states, the
+ * static prop vertex lighting, and the ambient probes.  Returns true if the
+ * cached results were used, or false if lighting needs to be computed.
+ */
+bool MapBuilder::
+read_lighting_cache(const HashVal &hash) {
+  Datagram data;
+  MapBuildCache::Objects objects;
+  if (!_cache.read_entry("lighting", hash, data, objects)) {
+    return false;
+  }
+
+  if (objects.empty() || !objects[0]->is_of_type(GeomNode::get_class_type())) {
+    return false;
+  }
+  GeomNode *lit_geoms = DCAST(GeomNode, objects[0].p());
+
+  int num_geoms = 0;
+  for (const MapMesh *mesh : _meshes) {
+    for (const MapGeom *poly : mesh->_polys) {
+      if (poly->has_geom()) {
+        ++num_geoms;
+      }
+    }
+  }
+  if (num_geoms != lit_geoms->get_num_geoms()) {
+    return false;
+  }
+
+  // Check the rest of the entry before applying any of it.
+  DatagramIterator scan(data);
+  const size_t point_size = data.get_stdfloat_double() ? 24 : 12;
+  if (scan.get_remaining_size() < 4 ||
+      scan.get_uint32() != _out_data->get_num_static_props()) {
+    return false;
+  }
+
+  pvector<MapStaticProp::GeomVertexLighting> vertex_lighting(_out_data->get_num_static_props());
+  for (MapStaticProp::GeomVertexLighting &arrays : vertex_lighting) {
+    if (scan.get_remaining_size() < 4) {
+      return false;
+    }
+    size_t count = scan.get_uint32();
+    if (count > scan.get_remaining_size() / 4) {
+      return false;
+    }
+    arrays.resize(count);
+    for (size_t j = 0; j < count; ++j) {
+      int index = scan.get_int32();
+      if (index < 0) {
+        continue;
+      }
+      if (index == 0 || index >= (int)objects.size() ||
+          !objects[index]->is_of_type(GeomVertexArrayData::get_class_type())) {
+        return false;
+      }
+      arrays[j] = DCAST(GeomVertexArrayData, objects[index].p());
+    }
+  }
+
+  if (scan.get_remaining_size() < 4) {
+    return false;
+  }
+  size_t num_probes = scan.get_uint32();
+  if (num_probes * point_size * 10 != scan.get_remaining_size()) {
+    return false;
+  }
+
+  int n = 0;
+  for (const MapMesh *mesh : _meshes) {
+    for (MapGeom *poly : mesh->_polys) {
+      if (poly->has_geom()) {
+        GeomNode *geom_node = poly->get_geom_node();
+        geom_node->set_geom(poly->get_geom_index(), lit_geoms->modify_geom(n));
+        geom_node->set_geom_state(poly->get_geom_index(), lit_geoms->get_geom_state(n));
+        ++n;
+      }
+    }
+  }
+
+  for (size_t i = 0; i < _out_data->get_num_static_props(); ++i) {
+    MapStaticProp *sprop = (MapStaticProp *)_out_data->get_static_prop(i);
+    sprop->_geom_vertex_lighting.swap(vertex_lighting[i]);
+  }
+
+  for (size_t i = 0; i < num_probes; ++i) {
+    MapAmbientProbe mprobe;
+    mprobe._pos.read_datagram(scan);
+    for (int j = 0; j < 9; ++j) {
+      mprobe._color[j].read_datagram(scan);
+    }
+    _out_data->add_ambient_probe(mprobe);
+  }
+
+  return true;
+}
+
+/**
+ * Stores the results of the lighting build in the cache.  This must be
+ * called before the sun light is applied to the world Geoms, since that
+ * depends on the light entities rather than on the lightmapper.
+ */
+void MapBuilder::
+write_lighting_cache(const HashVal &hash) const {
+  MapBuildCache::Objects objects;
+
+  // The Geoms and states of the polygons are stored in a single GeomNode, in
+  // the order of the meshes and their polygons.
+  PT(GeomNode) lit_geoms = new GeomNode("lit-geoms");
+  for (const MapMesh *mesh : _meshes) {
+    for (const MapGeom *poly : mesh->_polys) {
+      if (poly->has_geom()) {
+        GeomNode *geom_node = poly->get_geom_node();
+        lit_geoms->add_geom((Geom *)geom_node->get_geom(poly->get_geom_index()).p(),
+                            geom_node->get_geom_state(poly->get_geom_index()));
+      }
+    }
+  }
+  objects.push_back(lit_geoms);
+
+  Datagram data;
+
+  // Vertex lighting arrays may be shared between Geoms of a prop, so each
+  // array is stored once and referenced by index.
+  pmap<const GeomVertexArrayData *, int> array_indices;
+  data.add_uint32((uint32_t)_out_data->get_num_static_props());
+  for (size_t i = 0; i < _out_data->get_num_static_props(); ++i) {
+    const MapStaticProp *sprop = _out_data->get_static_prop(i);
+    data.add_uint32((uint32_t)sprop->_geom_vertex_lighting.size());
+    for (const GeomVertexArrayData *array : sprop->_geom_vertex_lighting) {
+      if (array == nullptr) {
+        data.add_int32(-1);
+        continue;
+      }
+      auto it = array_indices.find(array);
+      if (it == array_indices.end()) {
+        it = array_indices.insert({ array, (int)objects.size() }).first;
+        objects.push_back((GeomVertexArrayData *)array);
+      }
+      data.add_int32((*it).second);
+    }
+  }
+
+  data.add_uint32((uint32_t)_out_data->get_num_ambient_probes());
+  for (int i = 0; i < _out_data->get_num_ambient_probes(); ++i) {
+    const MapAmbientProbe *probe = _out_data->get_ambient_probe(i);
+    probe->_pos.write_datagram(data);
+    for (int j = 0; j < 9; ++j) {
+      probe->_color[j].write_datagram(data);
+    }
+  }
+
+  _cache.write_entry("lighting", hash, data, objects);
+}
+
+/**
+ * Looks for the Steam Audio probe data baked from the inputs with the
+ * indicated hash in the build cache.  If it is found, it is stored in the
+ * output map data and true is returned.
+ */
+bool MapBuilder::
+read_steam_audio_cache(const HashVal &hash) {
+  Datagram data;
+  MapBuildCache::Objects objects;
+  if (!_cache.read_entry("steam-audio", hash, data, objects)) {
+    return false;
+  }
+
+  DatagramIterator scan(data);
+  if (scan.get_remaining_size() < 4) {
+    return false;
+  }
+  size_t size = scan.get_uint32();
+  if (size == 0 || size != scan.get_remaining_size()) {
+    return false;
+  }
+
+  PTA_uchar probe_data;
+  probe_data.resize(size);
+  scan.extract_bytes(probe_data.p(), size);
+  _out_data->_steam_audio_probe_data = probe_data;
+  return true;
+}
+
+/**
+ * Stores the Steam Audio probe data of the output map data in the build
+ * cache, under the indicated hash of its inputs.
+ */
+void MapBuilder::
+write_steam_audio_cache(const HashVal &hash) const {
+  CPTA_uchar probe_data = _out_data->_steam_audio_probe_data;
+  if (probe_data.empty()) {
+    return;
+  }
+
+  Datagram data;
+  data.add_uint32((uint32_t)probe_data.size());
+  data.append_data(probe_data.p(), probe_data.size());
+  _cache.write_entry("steam-audio", hash, data, MapBuildCache::Objects());
+}
+
 /**
  *
  */
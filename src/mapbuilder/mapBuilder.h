@@ -28,6 +28,8 @@
 #include "pset.h"
 #include "boundingBox.h"
 #include "pointerTo.h"
+#include "mapBuildCache.h"
+#include "hashVal.h"
 
 #define NUM_LIGHTMAPS (NUM_BUMP_VECTS + 1)
 
@@ -282,6 +284,21 @@ private:
 
   void r_collect_geoms(PandaNode *node, pvector<std::pair<CPT(Geom), CPT(RenderState) > > &geoms);
 
+  void assign_sun_light(const NodePath &dlnp);
+
+  void add_entity_inputs(Datagram &dg) const;
+  void add_poly_inputs(Datagram &dg, const MapGeom *poly);
+  HashVal hash_vis_inputs();
+  HashVal hash_geometry_inputs();
+  HashVal hash_steam_audio_inputs();
+
+  bool read_vis_cache(const HashVal &hash);
+  void write_vis_cache(const HashVal &hash, const pvector<PT(MapGeom)> &world_polys) const;
+  bool read_lighting_cache(const HashVal &hash);
+  void write_lighting_cache(const HashVal &hash) const;
+  bool read_steam_audio_cache(const HashVal &hash);
+  void write_steam_audio_cache(const HashVal &hash) const;
+
 public:
   PT(MapFile) _source_map;
   MapBuildOptions _options;
@@ -309,6 +326,12 @@ public:
 
   // Extracted from the VisBuilder to place audio probes.
   pvector<LPoint3> _portal_centers;
+
+  // Results of the expensive stages are cached on disk, keyed by hashes of
+  // the inputs to each stage.
+  MapBuildCache _cache;
+  HashVal _vis_hash;
+  HashVal _geometry_hash;
 };
 
 #include "mapBuilder.I"
@@ -18,6 +18,8 @@
      connectionManager.N connectionManager.h \
      connectionReader.I connectionReader.h  \
      connectionWriter.h datagramQueue.h \
+     datagramBitReader.I datagramBitReader.h \
+     datagramBitWriter.I datagramBitWriter.h \
      datagramTCPHeader.I datagramTCPHeader.h  \
      datagramUDPHeader.I datagramUDPHeader.h  \
      netAddress.h netDatagram.I netDatagram.h  \
@@ -26,23 +28,31 @@
      queuedConnectionListener.I  \
      queuedConnectionListener.h queuedConnectionManager.h  \
      queuedConnectionReader.h recentConnectionReader.h \
-     queuedReturn.h queuedReturn.I
+     queuedReturn.h queuedReturn.I \
+     snapshotDecoder.I snapshotDecoder.h \
+     snapshotEncoder.I snapshotEncoder.h \
+     snapshotLayout.I snapshotLayout.h \
+     snapshotState.I snapshotState.h
 
   #define COMPOSITE_SOURCES \
      config_net.cxx connection.cxx connectionListener.cxx  \
      connectionManager.cxx connectionReader.cxx  \
-     connectionWriter.cxx datagramQueue.cxx datagramTCPHeader.cxx  \
+     connectionWriter.cxx datagramBitReader.cxx datagramBitWriter.cxx \
+     datagramQueue.cxx datagramTCPHeader.cxx  \
      datagramUDPHeader.cxx netAddress.cxx netDatagram.cxx  \
      datagramGeneratorNet.cxx \
      datagramSinkNet.cxx \
      queuedConnectionListener.cxx  \
      queuedConnectionManager.cxx queuedConnectionReader.cxx  \
-     recentConnectionReader.cxx
+     recentConnectionReader.cxx snapshotDecoder.cxx snapshotEncoder.cxx \
+     snapshotLayout.cxx snapshotState.cxx
 
   #define INSTALL_HEADERS \
     config_net.h connection.h connectionListener.h connectionManager.h \
     connectionReader.I connectionReader.h  \
     connectionWriter.h datagramQueue.h \
+    datagramBitReader.I datagramBitReader.h \
+    datagramBitWriter.I datagramBitWriter.h \
     datagramTCPHeader.I datagramTCPHeader.h \
     datagramUDPHeader.I datagramUDPHeader.h \
     netAddress.h netDatagram.I \
@@ -51,7 +61,11 @@
     datagramSinkNet.I datagramSinkNet.h \
     queuedConnectionListener.h queuedConnectionManager.h \
     queuedConnectionReader.h queuedReturn.I queuedReturn.h \
-    recentConnectionReader.h
+    recentConnectionReader.h \
+    snapshotDecoder.I snapshotDecoder.h \
+    snapshotEncoder.I snapshotEncoder.h \
+    snapshotLayout.I snapshotLayout.h \
+    snapshotState.I snapshotState.h
 
   #define IGATESCAN all
 
@@ -84,6 +98,24 @@
 
 #end test_bin_target
 
+#begin test_bin_target
+  #define TARGET test_net_load
+  #define LOCAL_LIBS net putil
+
+  #define SOURCES \
+    test_net_load.cxx
+
+#end test_bin_target
+
+#begin test_bin_target
+  #define TARGET test_snapshot
+  #define LOCAL_LIBS net putil
+
+  #define SOURCES \
+    test_snapshot.cxx
+
+#end test_bin_target
+
 #begin test_bin_target
   #define TARGET test_tcp_client
   #define LOCAL_LIBS net
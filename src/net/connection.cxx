@@ -25,6 +25,17 @@
 #include "socket_tcp.h"
 #include "socket_udp.h"
 #include "dcast.h"
+#include "pvector.h"
+
+#if (defined(IS_LINUX) || defined(IS_OSX) || defined(IS_FREEBSD)) && !defined(SIMPLE_THREADS)
+// We can hand several buffers to the socket at once with writev(), and on
+// Linux, several UDP packets with sendmmsg().
+#define HAVE_VECTORED_SEND 1
+#include <sys/uio.h>
+#include <sys/socket.h>
+#include <limits.h>
+#include <errno.h>
+#endif
 
 
 /**
@@ -304,9 +315,10 @@ send_datagram(const NetDatagram &datagram, int tcp_header_size) {
     LightReMutexHolder holder(_write_mutex);
     DatagramUDPHeader header(datagram);
 
-    vector_uchar data;
     CPTA_uchar header_data = header.get_array();
     CPTA_uchar message = datagram.get_array();
+    vector_uchar data;
+    data.reserve(header_data.size() + message.size());
     data.insert(data.end(), header_data.begin(), header_data.end());
     data.insert(data.end(), message.begin(), message.end());
 
@@ -417,6 +429,251 @@ send_raw_datagram(const NetDatagram &datagram) {
   return true;
 }
 
+/**
+ * This method is intended only to be called by ConnectionWriter.  It writes
+ * the indicated datagrams to the socket, in order, with as few system calls
+ * as it can: TCP datagrams are written together with a single writev(), and
+ * UDP datagrams with a single sendmmsg() on Linux.  Where these aren't
+ * available, the TCP datagrams are still written together with one send(),
+ * but the UDP datagrams are sent one at a time.
+ *
+ * In collect-tcp mode, the TCP datagrams are only queued, as by
+ * send_datagram().
+ *
+ * num_calls is incremented by the number of system calls made.  Returns true
+ * on success, false on failure.
+ */
+bool Connection::
+send_datagrams(const NetDatagram *const *datagrams, size_t num_datagrams,
+               int tcp_header_size, bool raw_mode, size_t &num_calls) {
+  nassertr(_socket != nullptr, false);
+
+  if (_socket->is_exact_type(Socket_UDP::get_class_type())) {
+#if defined(HAVE_VECTORED_SEND) && defined(IS_LINUX)
+    return send_udp_vectored(datagrams, num_datagrams, raw_mode, num_calls);
+#else
+    for (size_t i = 0; i < num_datagrams; ++i) {
+      ++num_calls;
+      bool okflag = raw_mode ? send_raw_datagram(*datagrams[i])
+                             : send_datagram(*datagrams[i], tcp_header_size);
+      if (!okflag) {
+        return false;
+      }
+    }
+    return true;
+#endif
+  }
+
+  if (raw_mode) {
+    tcp_header_size = 0;
+  }
+
+  if (tcp_header_size == 2) {
+    for (size_t i = 0; i < num_datagrams; ++i) {
+      if (datagrams[i]->get_length() >= 0x10000) {
+        net_cat.error()
+          << "Attempt to send TCP datagram of " << datagrams[i]->get_length()
+          << " bytes--too long!\n";
+        nassert_raise("Datagram too long");
+        return false;
+      }
+    }
+  }
+
+  LightReMutexHolder holder(_write_mutex);
+
+#ifdef HAVE_VECTORED_SEND
+  if (!_collect_tcp) {
+    // Anything left over from collect-tcp mode has to go first.
+    if (!_queued_data.empty()) {
+      ++num_calls;
+      if (!do_flush()) {
+        return false;
+      }
+    }
+    return send_tcp_vectored(datagrams, num_datagrams, tcp_header_size,
+                             raw_mode, num_calls);
+  }
+#endif  // HAVE_VECTORED_SEND
+
+  for (size_t i = 0; i < num_datagrams; ++i) {
+    if (tcp_header_size != 0) {
+      DatagramTCPHeader header(*datagrams[i], tcp_header_size);
+      CPTA_uchar header_data = header.get_array();
+      _queued_data.insert(_queued_data.end(), header_data.begin(), header_data.end());
+    }
+    const unsigned char *message = (const unsigned char *)datagrams[i]->get_data();
+    _queued_data.insert(_queued_data.end(), message, message + datagrams[i]->get_length());
+    _queued_count++;
+  }
+
+  if (!_collect_tcp ||
+      TrueClock::get_global_ptr()->get_short_time() - _queued_data_start >= _collect_tcp_interval) {
+    ++num_calls;
+    return do_flush();
+  }
+
+  return true;
+}
+
+/**
+ * Writes the indicated datagrams to the TCP socket with writev(), without
+ * copying them together first.  Assumes the _write_mutex is already held.
+ */
+bool Connection::
+send_tcp_vectored(const NetDatagram *const *datagrams, size_t num_datagrams,
+                  int tcp_header_size, bool raw_mode, size_t &num_calls) {
+#ifdef HAVE_VECTORED_SEND
+  Socket_TCP *tcp;
+  DCAST_INTO_R(tcp, _socket, false);
+
+  // Pack all of the headers into one buffer up front, so that the iovecs
+  // can point into it.
+  vector_uchar headers;
+  if (tcp_header_size != 0) {
+    headers.reserve(num_datagrams * tcp_header_size);
+    for (size_t i = 0; i < num_datagrams; ++i) {
+      DatagramTCPHeader header(*datagrams[i], tcp_header_size);
+      CPTA_uchar header_data = header.get_array();
+      headers.insert(headers.end(), header_data.begin(), header_data.end());
+    }
+  }
+
+  pvector<struct iovec> iov;
+  iov.reserve(num_datagrams * 2);
+  size_t total_bytes = 0;
+  for (size_t i = 0; i < num_datagrams; ++i) {
+    if (tcp_header_size != 0) {
+      struct iovec header_iov;
+      header_iov.iov_base = &headers[i * tcp_header_size];
+      header_iov.iov_len = tcp_header_size;
+      iov.push_back(header_iov);
+    }
+    if (datagrams[i]->get_length() != 0) {
+      struct iovec data_iov;
+      data_iov.iov_base = (void *)datagrams[i]->get_data();
+      data_iov.iov_len = datagrams[i]->get_length();
+      iov.push_back(data_iov);
+    }
+    total_bytes += tcp_header_size + datagrams[i]->get_length();
+  }
+
+  if (net_cat.is_spam()) {
+    net_cat.spam()
+      << "Sending " << num_datagrams << " TCP datagram(s) with "
+      << total_bytes << " total bytes to " << (void *)this << "\n";
+  }
+
+  size_t first = 0;
+  while (first < iov.size()) {
+    int count = (int)std::min(iov.size() - first, (size_t)IOV_MAX);
+    ssize_t result = writev(tcp->GetSocket(), &iov[first], count);
+    ++num_calls;
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return check_send_error(false);
+    }
+
+    // Skip past whatever was written.  After a short write, we may have to
+    // pick up again in the middle of a buffer.
+    size_t written = (size_t)result;
+    while (first < iov.size() && written >= iov[first].iov_len) {
+      written -= iov[first].iov_len;
+      ++first;
+    }
+    if (written != 0) {
+      iov[first].iov_base = (char *)iov[first].iov_base + written;
+      iov[first].iov_len -= written;
+    }
+  }
+
+  return true;
+
+#else  // HAVE_VECTORED_SEND
+  nassert_raise("vectored send not available");
+  return false;
+#endif  // HAVE_VECTORED_SEND
+}
+
+/**
+ * Sends the indicated datagrams on the UDP socket with one sendmmsg() call,
+ * each to its own address.  This is only available on Linux.
+ */
+bool Connection::
+send_udp_vectored(const NetDatagram *const *datagrams, size_t num_datagrams,
+                  bool raw_mode, size_t &num_calls) {
+#if defined(HAVE_VECTORED_SEND) && defined(IS_LINUX)
+  Socket_UDP *udp;
+  DCAST_INTO_R(udp, _socket, false);
+
+  // This keeps the headers around until they have been sent.
+  pvector<CPTA_uchar> header_data;
+  if (!raw_mode) {
+    header_data.reserve(num_datagrams);
+  }
+
+  pvector<struct iovec> iov(num_datagrams * 2);
+  pvector<struct mmsghdr> msgs(num_datagrams);
+  for (size_t i = 0; i < num_datagrams; ++i) {
+    const NetDatagram &datagram = *datagrams[i];
+    if ((int)datagram.get_length() > maximum_udp_datagram) {
+      net_cat.warning()
+        << "Sending UDP datagram of " << datagram.get_length()
+        << " bytes, more than the maximum of " << maximum_udp_datagram
+        << " bytes.\n";
+    }
+
+    struct iovec *msg_iov = &iov[i * 2];
+    size_t msg_iovlen = 0;
+    if (!raw_mode) {
+      header_data.push_back(DatagramUDPHeader(datagram).get_array());
+      msg_iov[msg_iovlen].iov_base = (void *)header_data.back().p();
+      msg_iov[msg_iovlen].iov_len = header_data.back().size();
+      ++msg_iovlen;
+    }
+    msg_iov[msg_iovlen].iov_base = (void *)datagram.get_data();
+    msg_iov[msg_iovlen].iov_len = datagram.get_length();
+    ++msg_iovlen;
+
+    const sockaddr *addr = &datagram.get_address().get_addr().GetAddressInfo();
+    msgs[i].msg_hdr.msg_name = (void *)addr;
+    msgs[i].msg_hdr.msg_namelen = SA_SIZEOF(addr);
+    msgs[i].msg_hdr.msg_iov = msg_iov;
+    msgs[i].msg_hdr.msg_iovlen = msg_iovlen;
+  }
+
+  LightReMutexHolder holder(_write_mutex);
+
+  size_t sent = 0;
+  while (sent < num_datagrams) {
+    unsigned int count = (unsigned int)std::min(num_datagrams - sent, (size_t)IOV_MAX);
+    int result = sendmmsg(udp->GetSocket(), &msgs[sent], count, 0);
+    ++num_calls;
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return check_send_error(false);
+    }
+    sent += result;
+  }
+
+  if (net_cat.is_spam()) {
+    net_cat.spam()
+      << "Sent " << num_datagrams << " UDP datagram(s) to " << (void *)this
+      << "\n";
+  }
+
+  return true;
+
+#else  // HAVE_VECTORED_SEND && IS_LINUX
+  nassert_raise("vectored send not available");
+  return false;
+#endif  // HAVE_VECTORED_SEND && IS_LINUX
+}
+
 /**
  * The private implementation of flush(), this assumes the _write_mutex is
  * already held.
@@ -59,6 +59,15 @@ PUBLISHED:
 private:
   bool send_datagram(const NetDatagram &datagram, int tcp_header_size);
   bool send_raw_datagram(const NetDatagram &datagram);
+  bool send_datagrams(const NetDatagram *const *datagrams,
+                      size_t num_datagrams, int tcp_header_size,
+                      bool raw_mode, size_t &num_calls);
+  bool send_tcp_vectored(const NetDatagram *const *datagrams,
+                         size_t num_datagrams, int tcp_header_size,
+                         bool raw_mode, size_t &num_calls);
+  bool send_udp_vectored(const NetDatagram *const *datagrams,
+                         size_t num_datagrams, bool raw_mode,
+                         size_t &num_calls);
   bool do_flush();
   bool check_send_error(bool okflag);
 
@@ -26,11 +26,32 @@
 #include "pnotify.h"
 #include "atomicAdjust.h"
 #include "config_downloader.h"
+#include "configVariableBool.h"
+
+#include <string.h>
+
+#ifdef IS_LINUX
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
 
 using std::min;
 
 static const int read_buffer_size = maximum_udp_datagram + datagram_udp_header_size;
 
+// The most events we pick up from a single epoll_wait() call.
+static const int max_epoll_events = 64;
+
+static ConfigVariableBool net_use_epoll
+("net-use-epoll", true,
+ PRC_DESC("On Linux, set this true to have a ConnectionReader watch its "
+          "sockets with epoll rather than select().  This removes the "
+          "FD_SETSIZE limit on the number of connections, and lets each "
+          "reader thread wait on its own share of the sockets instead of "
+          "taking turns.  This has no effect on other platforms, or if "
+          "Panda was built with SIMPLE_THREADS."));
+
 /**
  *
  */
@@ -40,6 +61,9 @@ SocketInfo(const PT(Connection) &connection) :
 {
   _busy = false;
   _error = false;
+  _epoll_index = -1;
+  _epoll_key = 0;
+  _read_length = 0;
 }
 
 /**
@@ -104,6 +128,7 @@ ConnectionReader(ConnectionManager *manager, int num_threads,
 
   _raw_mode = false;
   _tcp_header_size = tcp_header_size;
+  _read_buffer_size = 0;
   _polling = (num_threads <= 0);
 
   _shutdown = false;
@@ -113,6 +138,37 @@ ConnectionReader(ConnectionManager *manager, int num_threads,
 
   _currently_polling_thread = -1;
 
+  _use_epoll = false;
+  _next_epoll_key = 1;
+#if defined(IS_LINUX) && !defined(SIMPLE_THREADS)
+  if (net_use_epoll) {
+    // Each thread gets an epoll instance of its own.  A polling reader needs
+    // just one.
+    int num_instances = std::max(num_threads, 1);
+    _use_epoll = true;
+    for (int i = 0; i < num_instances; ++i) {
+      EpollInstance instance;
+      instance._fd = epoll_create1(EPOLL_CLOEXEC);
+      instance._num_sockets = 0;
+      if (instance._fd < 0) {
+        net_cat.warning()
+          << "Unable to create epoll instance (" << strerror(errno)
+          << "), using select() instead.\n";
+        _use_epoll = false;
+        break;
+      }
+      _epoll.push_back(instance);
+    }
+
+    if (!_use_epoll) {
+      for (EpollInstance &instance : _epoll) {
+        close(instance._fd);
+      }
+      _epoll.clear();
+    }
+  }
+#endif
+
   std::string reader_thread_name = thread_name;
   if (thread_name.empty()) {
     reader_thread_name = "ReaderThread";
@@ -158,6 +214,13 @@ ConnectionReader::
       sinfo->_connection.clear();
     }
   }
+
+#ifdef IS_LINUX
+  for (EpollInstance &instance : _epoll) {
+    close(instance._fd);
+  }
+  _epoll.clear();
+#endif
 }
 
 /**
@@ -187,7 +250,11 @@ add_connection(Connection *connection) {
     }
   }
 
-  _sockets.push_back(new SocketInfo(connection));
+  SocketInfo *sinfo = new SocketInfo(connection);
+  _sockets.push_back(sinfo);
+  if (_use_epoll) {
+    epoll_add_socket(sinfo);
+  }
 
   return true;
 }
@@ -214,6 +281,9 @@ remove_connection(Connection *connection) {
     return false;
   }
 
+  if (_use_epoll) {
+    epoll_remove_socket(*si);
+  }
   _removed_sockets.push_back(*si);
   _sockets.erase(si);
 
@@ -262,6 +332,11 @@ poll() {
     return;
   }
 
+  if (_use_epoll) {
+    epoll_poll();
+    return;
+  }
+
   SocketInfo *sinfo = get_next_available_socket(false, -2);
   if (sinfo != nullptr) {
     double max_poll_cycle = get_net_max_poll_cycle();
@@ -345,6 +420,27 @@ get_tcp_header_size() const {
   return _tcp_header_size;
 }
 
+/**
+ * Sets the size of the buffer that each TCP connection is read into.  If this
+ * is nonzero, each read from a TCP socket takes as many bytes as are waiting,
+ * up to this size, and every complete datagram found in them is handed on
+ * before the socket is made available again; an incomplete datagram at the
+ * end is kept for the next read.  This saves one or more system calls per
+ * datagram when many small datagrams arrive together.
+ *
+ * If this is 0, the default, the header and body of each datagram are read
+ * from the socket individually.
+ *
+ * This has no effect in raw mode or if the TCP header size is 0.  It must be
+ * set before any connections are added.
+ */
+void ConnectionReader::
+set_read_buffer_size(size_t size) {
+  LightMutexHolder holder(_sockets_mutex);
+  nassertv(_sockets.empty());
+  _read_buffer_size = size;
+}
+
 /**
  * Terminates all threads cleanly.  Normally this is only called by the
  * destructor, but it may be called explicitly before destruction.
@@ -400,6 +496,24 @@ flush_read_connection(Connection *connection) {
   }
 }
 
+/**
+ * Called by the reader threads when a datagram has been found in a
+ * connection's read buffer; see set_read_buffer_size().  The data is only
+ * valid for the duration of the call.
+ *
+ * The default implementation copies it into a NetDatagram and passes that to
+ * receive_datagram().  A derived class may redefine this to copy the data
+ * directly to wherever it is going.
+ */
+void ConnectionReader::
+receive_datagram_data(Connection *connection, const NetAddress &address,
+                      const void *data, size_t size) {
+  NetDatagram datagram(data, size);
+  datagram.set_connection(connection);
+  datagram.set_address(address);
+  receive_datagram(datagram);
+}
+
 /**
  * This should normally only be called when the associated ConnectionManager
  * destructs.  It resets the ConnectionManager pointer to NULL so we don't
@@ -419,6 +533,16 @@ void ConnectionReader::
 finish_socket(SocketInfo *sinfo) {
   nassertv(sinfo->_busy);
 
+  if (_use_epoll) {
+    // The socket must stay busy until it has been rearmed, or another thread's
+    // delete_removed_sockets() could delete it out from under us if it has
+    // been removed in the meantime.
+    LightMutexHolder holder(_sockets_mutex);
+    epoll_rearm_socket(sinfo);
+    sinfo->_busy = false;
+    return;
+  }
+
   // By marking the SocketInfo nonbusy, we make it available for future polls.
   sinfo->_busy = false;
 }
@@ -439,6 +563,8 @@ process_incoming_data(SocketInfo *sinfo) {
   } else {
     if (sinfo->is_udp()) {
       return process_incoming_udp_data(sinfo);
+    } else if (_read_buffer_size != 0 && _tcp_header_size != 0) {
+      return process_buffered_incoming_tcp_data(sinfo);
     } else {
       return process_incoming_tcp_data(sinfo);
     }
@@ -654,6 +780,98 @@ process_incoming_tcp_data(SocketInfo *sinfo) {
   return true;
 }
 
+/**
+ * Reads as many bytes as are waiting on the TCP socket into its read buffer,
+ * and hands on each complete datagram found there.  See
+ * set_read_buffer_size().
+ */
+bool ConnectionReader::
+process_buffered_incoming_tcp_data(SocketInfo *sinfo) {
+  Socket_TCP *socket;
+  DCAST_INTO_R(socket, sinfo->get_socket(), false);
+
+  vector_uchar &buffer = sinfo->_read_buffer;
+  if (buffer.size() < _read_buffer_size) {
+    buffer.resize(_read_buffer_size);
+  }
+
+  int read_bytes = (int)(buffer.size() - sinfo->_read_length);
+#ifdef SIMPLE_THREADS
+  // In the SIMPLE_THREADS case, we want to limit the number of bytes we read
+  // in a single epoch, to minimize the impact on the other threads.
+  read_bytes = min(read_bytes, (int)net_max_read_per_epoch);
+#endif
+
+  char *dp = (char *)&buffer[0] + sinfo->_read_length;
+  int bytes_read = socket->RecvData(dp, read_bytes);
+#if defined(HAVE_THREADS) && defined(SIMPLE_THREADS)
+  while (bytes_read < 0 && socket->GetLastError() == LOCAL_BLOCKING_ERROR &&
+         socket->Active()) {
+    Thread::force_yield();
+    bytes_read = socket->RecvData(dp, read_bytes);
+  }
+#endif  // SIMPLE_THREADS
+
+  if (bytes_read <= 0) {
+    // The socket was closed.  Report that and return.
+    if (_manager != nullptr) {
+      _manager->connection_reset(sinfo->_connection, 0);
+    }
+    sinfo->_read_length = 0;
+    finish_socket(sinfo);
+    return false;
+  }
+
+  size_t length = sinfo->_read_length + bytes_read;
+  size_t start = 0;
+
+  // The address is the same for every datagram in this read, so we only ask
+  // the socket for it once.
+  NetAddress address(socket->GetPeerName());
+
+  // Hand on every complete datagram.  We do this before finishing the
+  // socket, since the datagrams are still in the socket's buffer, and the
+  // next thread to read the socket will reuse it.
+  size_t needed = 0;
+  while (!_shutdown && length - start >= (size_t)_tcp_header_size) {
+    DatagramTCPHeader header(&buffer[start], _tcp_header_size);
+    size_t size = (size_t)header.get_datagram_size(_tcp_header_size);
+    needed = _tcp_header_size + size;
+    if (length - start < needed) {
+      // The rest of this one hasn't arrived yet.
+      break;
+    }
+
+    if (net_cat.is_spam()) {
+      net_cat.spam()
+        << "Received TCP datagram with " << needed
+        << " bytes on " << (void *)sinfo->_connection
+        << " from " << address << "\n";
+    }
+
+    receive_datagram_data(sinfo->_connection, address,
+                          &buffer[start + _tcp_header_size], size);
+    start += needed;
+    needed = 0;
+  }
+
+  // Move the incomplete remainder, if any, to the front of the buffer.  This
+  // is at most one partial datagram, so it is normally a short copy.
+  length -= start;
+  if (length != 0 && start != 0) {
+    memmove(&buffer[0], &buffer[start], length);
+  }
+  sinfo->_read_length = length;
+
+  // If the next datagram won't fit in the buffer, make room for it now.
+  if (needed > buffer.size()) {
+    buffer.resize(needed);
+  }
+
+  finish_socket(sinfo);
+  return !_shutdown;
+}
+
 /**
  *
  */
@@ -771,6 +989,11 @@ thread_run(int thread_index) {
   nassertv(!_polling);
   nassertv(_threads[thread_index] == Thread::get_current_thread());
 
+  if (_use_epoll) {
+    epoll_thread_run(thread_index);
+    return;
+  }
+
   while (!_shutdown) {
     SocketInfo *sinfo =
       get_next_available_socket(true, thread_index);
@@ -895,8 +1118,18 @@ rebuild_select_list() {
 
   // This is also a fine time to delete the contents of the _removed_sockets
   // list.
+  delete_removed_sockets();
+}
+
+/**
+ * Deletes the SocketInfo objects on the _removed_sockets list that are no
+ * longer busy.  Assumes _sockets_mutex is held.
+ */
+void ConnectionReader::
+delete_removed_sockets() {
   if (!_removed_sockets.empty()) {
     Sockets still_busy_sockets;
+    Sockets::const_iterator si;
     for (si = _removed_sockets.begin(); si != _removed_sockets.end(); ++si) {
       SocketInfo *sinfo = (*si);
       if (sinfo->_busy) {
@@ -925,3 +1158,220 @@ accumulate_fdset(Socket_fdset &fdset) {
     }
   }
 }
+
+/**
+ * The thread function used instead of the select() loop in thread_run() when
+ * the sockets are watched with epoll.  Each thread waits only on the sockets
+ * registered with its own epoll instance.
+ */
+void ConnectionReader::
+epoll_thread_run(int epoll_index) {
+  while (!_shutdown) {
+    // We never block indefinitely, so we can check the shutdown flag every
+    // once in a while.
+    int timeout_ms = (int)(get_net_max_block() * 1000.0);
+    int num_results = epoll_wait_sockets(epoll_index, timeout_ms);
+    if (num_results < 0) {
+      Thread::force_yield();
+      continue;
+    }
+
+    for (int i = 0; i < num_results && !_shutdown; ++i) {
+      SocketInfo *sinfo = epoll_take_socket(epoll_index, i);
+      if (sinfo != nullptr) {
+        process_incoming_data(sinfo);
+        Thread::consider_yield();
+      }
+    }
+
+    LightMutexHolder holder(_sockets_mutex);
+    delete_removed_sockets();
+  }
+}
+
+/**
+ * The implementation of poll() when the sockets are watched with epoll.
+ */
+void ConnectionReader::
+epoll_poll() {
+  double max_poll_cycle = get_net_max_poll_cycle();
+  TrueClock *global_clock = TrueClock::get_global_ptr();
+  double stop = global_clock->get_short_time() + max_poll_cycle;
+
+  int num_results = epoll_wait_sockets(0, 0);
+  while (num_results > 0) {
+    for (int i = 0; i < num_results; ++i) {
+      SocketInfo *sinfo = epoll_take_socket(0, i);
+      if (sinfo != nullptr) {
+        process_incoming_data(sinfo);
+      }
+
+      if (max_poll_cycle >= 0.0 && global_clock->get_short_time() >= stop) {
+        // Out of time.  The sockets we didn't get to will have to be
+        // reported again next time.
+        epoll_skip_results(0, i + 1);
+        return;
+      }
+    }
+
+    {
+      LightMutexHolder holder(_sockets_mutex);
+      delete_removed_sockets();
+    }
+
+    // Sockets that still have data are reported again as soon as they are
+    // rearmed, so keep going until there is nothing left.
+    num_results = epoll_wait_sockets(0, 0);
+  }
+}
+
+/**
+ * Waits up to the indicated number of milliseconds for activity on the
+ * sockets of the indicated epoll instance, and stores their keys in its
+ * _results.  Returns the number of results, or -1 on error.
+ */
+int ConnectionReader::
+epoll_wait_sockets(int epoll_index, int timeout_ms) {
+  EpollInstance &instance = _epoll[epoll_index];
+  instance._results.clear();
+
+#ifdef IS_LINUX
+  struct epoll_event events[max_epoll_events];
+  int num_events = epoll_wait(instance._fd, events, max_epoll_events, timeout_ms);
+  if (num_events < 0) {
+    if (errno == EINTR) {
+      return 0;
+    }
+    net_cat.error()
+      << "epoll_wait failed: " << strerror(errno) << "\n";
+    return -1;
+  }
+
+  for (int i = 0; i < num_events; ++i) {
+    instance._results.push_back(events[i].data.u64);
+  }
+#endif
+
+  return (int)instance._results.size();
+}
+
+/**
+ * Returns the socket named by the nth result of the last epoll_wait_sockets()
+ * call on the indicated instance, marked busy, or NULL if it has been removed
+ * in the meantime.
+ */
+ConnectionReader::SocketInfo *ConnectionReader::
+epoll_take_socket(int epoll_index, int result_index) {
+  uint64_t key = _epoll[epoll_index]._results[result_index];
+
+  LightMutexHolder holder(_sockets_mutex);
+  EpollSockets::const_iterator si = _epoll_sockets.find(key);
+  if (si == _epoll_sockets.end()) {
+    return nullptr;
+  }
+
+  SocketInfo *sinfo = (*si).second;
+  if (sinfo->_error) {
+    return nullptr;
+  }
+  sinfo->_busy = true;
+  return sinfo;
+}
+
+/**
+ * Rearms the sockets named by the results of the last epoll_wait_sockets()
+ * call on the indicated instance, starting at the nth one, without reading
+ * them.
+ */
+void ConnectionReader::
+epoll_skip_results(int epoll_index, int result_index) {
+  const pvector<uint64_t> &results = _epoll[epoll_index]._results;
+  LightMutexHolder holder(_sockets_mutex);
+  for (size_t i = result_index; i < results.size(); ++i) {
+    EpollSockets::const_iterator si = _epoll_sockets.find(results[i]);
+    if (si != _epoll_sockets.end()) {
+      epoll_rearm_socket((*si).second);
+    }
+  }
+}
+
+/**
+ * Registers a newly-added socket with the epoll instance that has the fewest
+ * sockets.  Assumes _sockets_mutex is held.
+ *
+ * The socket is registered as edge-triggered and one-shot: it is reported to
+ * one thread only, and not again until finish_socket() rearms it, which takes
+ * the place of the _busy flag in the select() loop.  Rearming a socket that
+ * still has data waiting reports it again right away, so no data is missed
+ * even though we only read one datagram at a time.
+ */
+void ConnectionReader::
+epoll_add_socket(SocketInfo *sinfo) {
+#ifdef IS_LINUX
+  int best = 0;
+  for (int i = 1; i < (int)_epoll.size(); ++i) {
+    if (_epoll[i]._num_sockets < _epoll[best]._num_sockets) {
+      best = i;
+    }
+  }
+
+  uint64_t key = _next_epoll_key++;
+
+  struct epoll_event event;
+  event.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
+  event.data.u64 = key;
+  if (epoll_ctl(_epoll[best]._fd, EPOLL_CTL_ADD,
+                sinfo->get_socket()->GetSocket(), &event) != 0) {
+    net_cat.error()
+      << "Unable to add socket to epoll: " << strerror(errno) << "\n";
+    sinfo->_error = true;
+    return;
+  }
+
+  sinfo->_epoll_index = best;
+  sinfo->_epoll_key = key;
+  _epoll_sockets[key] = sinfo;
+  ++_epoll[best]._num_sockets;
+#endif
+}
+
+/**
+ * Unregisters a socket that is being removed from its epoll instance.
+ * Assumes _sockets_mutex is held.
+ */
+void ConnectionReader::
+epoll_remove_socket(SocketInfo *sinfo) {
+#ifdef IS_LINUX
+  if (sinfo->_epoll_index < 0) {
+    return;
+  }
+
+  EpollInstance &instance = _epoll[sinfo->_epoll_index];
+  struct epoll_event event;
+  epoll_ctl(instance._fd, EPOLL_CTL_DEL, sinfo->get_socket()->GetSocket(), &event);
+  --instance._num_sockets;
+
+  _epoll_sockets.erase(sinfo->_epoll_key);
+  sinfo->_epoll_index = -1;
+#endif
+}
+
+/**
+ * Makes a socket that has been reported by epoll eligible to be reported
+ * again.  Assumes _sockets_mutex is held.
+ */
+void ConnectionReader::
+epoll_rearm_socket(SocketInfo *sinfo) {
+#ifdef IS_LINUX
+  if (sinfo->_epoll_index < 0) {
+    // It has been removed, or it was never added.
+    return;
+  }
+
+  struct epoll_event event;
+  event.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
+  event.data.u64 = sinfo->_epoll_key;
+  epoll_ctl(_epoll[sinfo->_epoll_index]._fd, EPOLL_CTL_MOD,
+            sinfo->get_socket()->GetSocket(), &event);
+#endif
+}
@@ -23,10 +23,13 @@
 #include "lightMutex.h"
 #include "pvector.h"
 #include "pset.h"
+#include "pmap.h"
 #include "socket_fdset.h"
 #include "atomicAdjust.h"
+#include "vector_uchar.h"
 
 class NetDatagram;
+class NetAddress;
 class ConnectionManager;
 class Socket_Address;
 class Socket_IP;
@@ -42,6 +45,11 @@ class Socket_IP;
  * cannot be changed, but the set of sockets that is to be monitored may be
  * constantly modified at will.
  *
+ * On Linux, the sockets are normally watched with epoll rather than select()
+ * (see net-use-epoll).  In this case, each thread waits on its own subset of
+ * the sockets, so the number of sockets is not limited by FD_SETSIZE, and
+ * the threads don't have to take turns waiting for activity.
+ *
  * This is an abstract class because it doesn't define how to process each
  * received datagram.  See QueuedConnectionReader.  Also note that
  * ConnectionListener derives from this class, extending it to accept
@@ -77,14 +85,22 @@ PUBLISHED:
   void set_raw_mode(bool mode);
   bool get_raw_mode() const;
 
+  INLINE bool get_use_epoll() const;
+
   void set_tcp_header_size(int tcp_header_size);
   int get_tcp_header_size() const;
 
+  void set_read_buffer_size(size_t size);
+  INLINE size_t get_read_buffer_size() const;
+
   void shutdown();
 
 protected:
   virtual void flush_read_connection(Connection *connection);
   virtual void receive_datagram(const NetDatagram &datagram)=0;
+  virtual void receive_datagram_data(Connection *connection,
+                                     const NetAddress &address,
+                                     const void *data, size_t size);
 
   class SocketInfo {
   public:
@@ -95,6 +111,17 @@ protected:
     PT(Connection) _connection;
     bool _busy;
     bool _error;
+
+    // The epoll instance watching this socket, or -1, and the key under
+    // which it is registered there.
+    int _epoll_index;
+    uint64_t _epoll_key;
+
+    // Bytes read from a TCP socket that have not yet been handed out as
+    // datagrams, when set_read_buffer_size() is in effect.  Only the thread
+    // that has the socket busy touches these.
+    vector_uchar _read_buffer;
+    size_t _read_length;
   };
   typedef pvector<SocketInfo *> Sockets;
 
@@ -104,6 +131,7 @@ protected:
   virtual bool process_incoming_data(SocketInfo *sinfo);
   virtual bool process_incoming_udp_data(SocketInfo *sinfo);
   virtual bool process_incoming_tcp_data(SocketInfo *sinfo);
+  virtual bool process_buffered_incoming_tcp_data(SocketInfo *sinfo);
   virtual bool process_raw_incoming_udp_data(SocketInfo *sinfo);
   virtual bool process_raw_incoming_tcp_data(SocketInfo *sinfo);
 
@@ -127,10 +155,21 @@ private:
 
   void rebuild_select_list();
   void accumulate_fdset(Socket_fdset &fdset);
+  void delete_removed_sockets();
+
+  void epoll_thread_run(int epoll_index);
+  void epoll_poll();
+  int epoll_wait_sockets(int epoll_index, int timeout_ms);
+  SocketInfo *epoll_take_socket(int epoll_index, int result_index);
+  void epoll_skip_results(int epoll_index, int result_index);
+  void epoll_add_socket(SocketInfo *sinfo);
+  void epoll_remove_socket(SocketInfo *sinfo);
+  void epoll_rearm_socket(SocketInfo *sinfo);
 
 private:
   bool _raw_mode;
   int _tcp_header_size;
+  size_t _read_buffer_size;
   bool _shutdown;
 
   class ReaderThread : public Thread {
@@ -162,6 +201,25 @@ private:
   // thread is so waiting.
   AtomicAdjust::Integer _currently_polling_thread;
 
+  // Used instead of the above when the sockets are watched with epoll.  There
+  // is one epoll instance per thread, or only one if we are polling.  The
+  // sockets are registered with keys rather than pointers, so that a stale
+  // event for a socket that has since been removed can be recognized.
+  // _epoll_sockets, _epoll_counts and the SocketInfo epoll members are
+  // protected by _sockets_mutex.
+  bool _use_epoll;
+  class EpollInstance {
+  public:
+    int _fd;
+    int _num_sockets;
+    pvector<uint64_t> _results;
+  };
+  typedef pvector<EpollInstance> EpollInstances;
+  EpollInstances _epoll;
+  typedef pmap<uint64_t, SocketInfo *> EpollSockets;
+  EpollSockets _epoll_sockets;
+  uint64_t _next_epoll_key;
+
   friend class ConnectionManager;
   friend class ReaderThread;
 };
@@ -19,6 +19,27 @@
 #include "socket_udp.h"
 #include "pnotify.h"
 #include "config_downloader.h"
+#include "datagramUDPHeader.h"
+#include "lightMutexHolder.h"
+#include "trueClock.h"
+#include "configVariableDouble.h"
+#include "configVariableInt.h"
+
+#include <algorithm>
+
+static ConfigVariableDouble net_write_flush_window
+("net-write-flush-window", 0.0,
+ PRC_DESC("The default flush window of a ConnectionWriter, in seconds.  If "
+          "this is nonzero, a ConnectionWriter without threads holds the "
+          "datagrams passed to send() until the window has passed since the "
+          "first of them, or until flush() is called, and then writes each "
+          "connection's datagrams with a single system call."));
+
+static ConfigVariableInt net_write_batch_size
+("net-write-batch-size", 64,
+ PRC_DESC("The most datagrams a ConnectionWriter writes together at once, "
+          "whether they are taken from its queue by a writer thread or held "
+          "for the flush window."));
 
 /**
  *
@@ -70,6 +91,14 @@ ConnectionWriter(ConnectionManager *manager, int num_threads,
   _immediate = (num_threads <= 0);
   _shutdown = false;
 
+  _flush_window = net_write_flush_window;
+  _max_batch_size = (size_t)std::max((int)net_write_batch_size, 1);
+  _held_start = 0.0;
+
+  _num_datagrams_sent = 0;
+  _num_bytes_sent = 0;
+  _num_system_calls = 0;
+
   std::string writer_thread_name = thread_name;
   if (thread_name.empty()) {
     writer_thread_name = "WriterThread";
@@ -149,11 +178,10 @@ send(const Datagram &datagram, const PT(Connection) &connection, bool block) {
   copy.set_connection(connection);
 
   if (_immediate) {
-    if (_raw_mode) {
-      return connection->send_raw_datagram(copy);
-    } else {
-      return connection->send_datagram(copy, _tcp_header_size);
+    if (_flush_window > 0.0) {
+      return hold_datagram(copy);
     }
+    return write_datagrams(&copy, 1);
   } else {
     return _queue.insert(copy, block);
   }
@@ -193,11 +221,10 @@ send(const Datagram &datagram, const PT(Connection) &connection,
   copy.set_address(address);
 
   if (_immediate) {
-    if (_raw_mode) {
-      return connection->send_raw_datagram(copy);
-    } else {
-      return connection->send_datagram(copy, _tcp_header_size);
+    if (_flush_window > 0.0) {
+      return hold_datagram(copy);
     }
+    return write_datagrams(&copy, 1);
   } else {
     return _queue.insert(copy, block);
   }
@@ -279,6 +306,105 @@ get_tcp_header_size() const {
   return _tcp_header_size;
 }
 
+/**
+ * Sets the flush window, in seconds.  If this is nonzero, and the writer has
+ * no threads, send() doesn't write each datagram right away, but holds it
+ * until the window has passed since the first datagram still being held, or
+ * until the max batch size is reached, or until flush() is called.  The held
+ * datagrams are then written together, with one system call per connection
+ * where possible.
+ *
+ * The window is only checked when send() is called, so an application that
+ * uses this should also call flush() at the end of each frame or tick.  The
+ * default is taken from net-write-flush-window.
+ */
+void ConnectionWriter::
+set_flush_window(double window) {
+  _flush_window = window;
+  if (window <= 0.0) {
+    flush();
+  }
+}
+
+/**
+ * Returns the flush window, in seconds.  See set_flush_window().
+ */
+double ConnectionWriter::
+get_flush_window() const {
+  return _flush_window;
+}
+
+/**
+ * Sets the most datagrams that are written together at once, either by a
+ * writer thread or after being held for the flush window.
+ */
+void ConnectionWriter::
+set_max_batch_size(int max_size) {
+  nassertv(max_size > 0);
+  _max_batch_size = (size_t)max_size;
+}
+
+/**
+ * Returns the most datagrams that are written together at once.  See
+ * set_max_batch_size().
+ */
+int ConnectionWriter::
+get_max_batch_size() const {
+  return (int)_max_batch_size;
+}
+
+/**
+ * Writes any datagrams being held for the flush window right away.  Returns
+ * true on success, false if any of them could not be written.  See
+ * set_flush_window().
+ */
+bool ConnectionWriter::
+flush() {
+  LightMutexHolder holder(_held_lock);
+  return do_flush_held();
+}
+
+/**
+ * Returns the total number of datagrams that this writer has written to its
+ * sockets since it was created or since reset_stats() was called.
+ */
+size_t ConnectionWriter::
+get_num_datagrams_sent() const {
+  return (size_t)AtomicAdjust::get(_num_datagrams_sent);
+}
+
+/**
+ * Returns the total number of bytes, including the datagram headers, that
+ * this writer has written to its sockets since it was created or since
+ * reset_stats() was called.
+ */
+size_t ConnectionWriter::
+get_num_bytes_sent() const {
+  return (size_t)AtomicAdjust::get(_num_bytes_sent);
+}
+
+/**
+ * Returns the number of system calls this writer has made to write its
+ * datagrams since it was created or since reset_stats() was called.  The
+ * ratio of this to get_num_datagrams_sent() shows how well the datagrams are
+ * being batched together.
+ */
+size_t ConnectionWriter::
+get_num_system_calls() const {
+  return (size_t)AtomicAdjust::get(_num_system_calls);
+}
+
+/**
+ * Resets the counts returned by get_num_datagrams_sent(),
+ * get_num_bytes_sent() and get_num_system_calls() to zero.
+ */
+void ConnectionWriter::
+reset_stats() {
+  AtomicAdjust::set(_num_datagrams_sent, 0);
+  AtomicAdjust::set(_num_bytes_sent, 0);
+  AtomicAdjust::set(_num_system_calls, 0);
+}
+
 /**
  * Stops all the threads and cleans them up.  This is called automatically by
  * the destructor, but it may be called explicitly before destruction.
@@ -288,6 +414,10 @@ shutdown() {
   if (_shutdown) {
     return;
   }
+
+  // Anything still being held for the flush window goes out now.
+  flush();
+
   _shutdown = true;
 
   // First, shutdown the queue.  This will tell our threads they're done.
@@ -320,13 +450,105 @@ void ConnectionWriter::
 thread_run(int thread_index) {
   nassertv(!_immediate);
 
-  NetDatagram datagram;
-  while (_queue.extract(datagram)) {
-    if (_raw_mode) {
-      datagram.get_connection()->send_raw_datagram(datagram);
+  Held batch;
+  while (_queue.extract(batch, _max_batch_size)) {
+    write_datagrams(&batch[0], batch.size());
+    batch.clear();
+    Thread::consider_yield();
+  }
+}
+
+/**
+ * Holds the indicated datagram for the flush window, writing out everything
+ * held so far if the window has passed or the batch is full.
+ */
+bool ConnectionWriter::
+hold_datagram(const NetDatagram &datagram) {
+  LightMutexHolder holder(_held_lock);
+
+  double now = TrueClock::get_global_ptr()->get_short_time();
+  if (_held.empty()) {
+    _held_start = now;
+  }
+  _held.push_back(datagram);
+
+  // If the elapsed time is negative, someone must have reset the clock back,
+  // so just go ahead and flush.
+  double elapsed = now - _held_start;
+  if (_held.size() >= _max_batch_size ||
+      elapsed < 0.0 || elapsed >= _flush_window) {
+    return do_flush_held();
+  }
+  return true;
+}
+
+/**
+ * Writes out all of the held datagrams.  Assumes _held_lock is held.
+ */
+bool ConnectionWriter::
+do_flush_held() {
+  if (_held.empty()) {
+    return true;
+  }
+
+  bool okflag = write_datagrams(&_held[0], _held.size());
+  _held.clear();
+  return okflag;
+}
+
+/**
+ * Writes the indicated datagrams to their connections.  The datagrams going
+ * to each connection are written together, in their original order, with as
+ * few system calls as the connection can manage.  Returns true on success,
+ * false if any of them could not be written.
+ */
+bool ConnectionWriter::
+write_datagrams(const NetDatagram *datagrams, size_t num_datagrams) {
+  // Group the datagrams by connection, without changing their order within
+  // each connection.
+  typedef std::pair<Connection *, const NetDatagram *> Entry;
+  pvector<Entry> entries;
+  entries.reserve(num_datagrams);
+  for (size_t i = 0; i < num_datagrams; ++i) {
+    entries.push_back(Entry(datagrams[i].get_connection(), &datagrams[i]));
+  }
+  if (num_datagrams > 1) {
+    std::stable_sort(entries.begin(), entries.end(),
+      [](const Entry &a, const Entry &b) { return a.first < b.first; });
+  }
+
+  bool all_ok = true;
+  pvector<const NetDatagram *> run;
+  size_t num_calls = 0;
+
+  size_t begin = 0;
+  while (begin < entries.size()) {
+    Connection *connection = entries[begin].first;
+    size_t end = begin;
+    run.clear();
+    while (end < entries.size() && entries[end].first == connection) {
+      run.push_back(entries[end].second);
+      ++end;
+    }
+
+    bool is_udp = connection->get_socket()->is_exact_type(Socket_UDP::get_class_type());
+    size_t header_size = _raw_mode ? 0 : (is_udp ? datagram_udp_header_size : _tcp_header_size);
+    size_t num_bytes = 0;
+    for (const NetDatagram *datagram : run) {
+      num_bytes += header_size + datagram->get_length();
+    }
+
+    if (connection->send_datagrams(&run[0], run.size(), _tcp_header_size,
+                                   _raw_mode, num_calls)) {
+      AtomicAdjust::add(_num_datagrams_sent, (AtomicAdjust::Integer)run.size());
+      AtomicAdjust::add(_num_bytes_sent, (AtomicAdjust::Integer)num_bytes);
     } else {
-      datagram.get_connection()->send_datagram(datagram, _tcp_header_size);
+      all_ok = false;
     }
-    Thread::consider_yield();
+
+    begin = end;
   }
+
+  AtomicAdjust::add(_num_system_calls, (AtomicAdjust::Integer)num_calls);
+  return all_ok;
 }
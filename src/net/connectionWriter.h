@@ -20,6 +20,8 @@
 #include "pointerTo.h"
 #include "thread.h"
 #include "pvector.h"
+#include "lightMutex.h"
+#include "atomicAdjust.h"
 
 class ConnectionManager;
 class NetAddress;
@@ -31,6 +33,12 @@ class NetAddress;
  * A ConnectionWriter may define an arbitrary number of threads (0 or more) to
  * write its datagrams to sockets.  The number of threads is specified at
  * construction time and cannot be changed.
+ *
+ * Each writer thread takes as many datagrams off the queue at once as are
+ * waiting (up to the max batch size), and writes all of those going to the
+ * same connection with a single system call where possible.  A writer without
+ * threads may do the same if it is given a flush window; see
+ * set_flush_window().
  */
 class EXPCL_PANDA_NET ConnectionWriter {
 PUBLISHED:
@@ -63,6 +71,17 @@ PUBLISHED:
   void set_tcp_header_size(int tcp_header_size);
   int get_tcp_header_size() const;
 
+  void set_flush_window(double window);
+  double get_flush_window() const;
+  void set_max_batch_size(int max_size);
+  int get_max_batch_size() const;
+  BLOCKING bool flush();
+
+  size_t get_num_datagrams_sent() const;
+  size_t get_num_bytes_sent() const;
+  size_t get_num_system_calls() const;
+  void reset_stats();
+
   void shutdown();
 
 protected:
@@ -70,7 +89,9 @@ protected:
 
 private:
   void thread_run(int thread_index);
-  bool send_datagram(const NetDatagram &datagram);
+  bool hold_datagram(const NetDatagram &datagram);
+  bool do_flush_held();
+  bool write_datagrams(const NetDatagram *datagrams, size_t num_datagrams);
 
 protected:
   ConnectionManager *_manager;
@@ -81,6 +102,20 @@ private:
   DatagramQueue _queue;
   bool _shutdown;
 
+  double _flush_window;
+  size_t _max_batch_size;
+
+  // The datagrams held by send() for the flush window, when there are no
+  // threads.  These are protected by _held_lock.
+  LightMutex _held_lock;
+  typedef pvector<NetDatagram> Held;
+  Held _held;
+  double _held_start;
+
+  AtomicAdjust::Integer _num_datagrams_sent;
+  AtomicAdjust::Integer _num_bytes_sent;
+  AtomicAdjust::Integer _num_system_calls;
+
   class WriterThread : public Thread {
   public:
     WriterThread(ConnectionWriter *writer, const std::string &thread_name,
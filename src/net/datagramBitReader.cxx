@@ -0,0 +1,76 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file datagramBitReader.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "datagramBitReader.h"
+
+/**
+ * Creates a reader that takes its bytes from the indicated iterator, which
+ * must persist for the lifetime of the reader.
+ */
+DatagramBitReader::
+DatagramBitReader(DatagramIterator &scan) :
+  _scan(scan),
+  _bits(0),
+  _num_pending(0),
+  _error(false)
+{
+}
+
+/**
+ * Reads an unsigned integer written by add_varint().
+ */
+uint64_t DatagramBitReader::
+get_varint() {
+  uint64_t value = 0;
+  for (int shift = 0; shift < 64; shift += 7) {
+    uint32_t byte = get_bits(8);
+    value |= (uint64_t)(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+
+  // Too many bytes; this isn't a valid varint.
+  _error = true;
+  return value;
+}
+
+/**
+ * Returns the value that DatagramBitWriter::quantize() produced the
+ * indicated number from.
+ */
+double DatagramBitReader::
+dequantize(uint32_t value, double min_value, double max_value, int num_bits) {
+  nassertr(num_bits > 0 && num_bits <= 32, min_value);
+  double steps = (double)((((uint64_t)1) << num_bits) - 1);
+  return min_value + (max_value - min_value) * ((double)value / steps);
+}
+
+/**
+ * Takes bytes from the iterator until at least num_bits bits are pending.
+ * Returns false, and sets the error flag, if the Datagram runs out first.
+ */
+bool DatagramBitReader::
+fill(int num_bits) {
+  while (_num_pending < num_bits) {
+    if (!_scan.has_remaining(1)) {
+      _error = true;
+      _bits = 0;
+      _num_pending = 0;
+      return false;
+    }
+    _bits |= (uint64_t)_scan.get_uint8_unchecked() << _num_pending;
+    _num_pending += 8;
+  }
+  return true;
+}
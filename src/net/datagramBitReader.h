@@ -0,0 +1,64 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file datagramBitReader.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef DATAGRAMBITREADER_H
+#define DATAGRAMBITREADER_H
+
+#include "pandabase.h"
+#include "datagramIterator.h"
+#include "numeric_types.h"
+
+/**
+ * Reads back the values packed into a Datagram by a DatagramBitWriter, from
+ * the current position of a DatagramIterator.  The values must be read in
+ * the same order, with the same sizes, as they were written.
+ *
+ * Bytes are only taken from the DatagramIterator as they are needed, so
+ * after the last value has been read, the iterator is positioned at the
+ * first byte following the bits, and may be used to read whatever comes
+ * next.
+ *
+ * Reading past the end of the Datagram does not raise an assertion; it
+ * returns zeroes and sets a flag that may be checked with has_error().
+ */
+class EXPCL_PANDA_NET DatagramBitReader {
+PUBLISHED:
+  explicit DatagramBitReader(DatagramIterator &scan);
+
+  INLINE bool get_bool();
+  INLINE uint32_t get_bits(int num_bits);
+  uint64_t get_varint();
+  INLINE int64_t get_signed_varint();
+  INLINE PN_float32 get_float32();
+  INLINE double get_quantized(double min_value, double max_value,
+                              int num_bits);
+
+  INLINE bool has_error() const;
+
+public:
+  static double dequantize(uint32_t value, double min_value, double max_value,
+                           int num_bits);
+  INLINE static int64_t zigzag_decode(uint64_t value);
+
+private:
+  bool fill(int num_bits);
+
+  DatagramIterator &_scan;
+  uint64_t _bits;
+  int _num_pending;
+  bool _error;
+};
+
+#include "datagramBitReader.I"
+
+#endif
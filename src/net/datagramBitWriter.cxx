@@ -0,0 +1,89 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file datagramBitWriter.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "datagramBitWriter.h"
+
+#include <math.h>
+
+/**
+ * Creates a writer that appends to the indicated Datagram.  The Datagram
+ * must persist for the lifetime of the writer.
+ */
+DatagramBitWriter::
+DatagramBitWriter(Datagram &datagram) :
+  _datagram(datagram),
+  _bits(0),
+  _num_pending(0),
+  _num_bits(0),
+  _buffer_length(0)
+{
+}
+
+/**
+ * Adds an unsigned integer in a variable number of bits: seven bits at a
+ * time, each followed by a bit indicating whether more follow.
+ */
+void DatagramBitWriter::
+add_varint(uint64_t value) {
+  while (value >= 0x80) {
+    add_bits((uint32_t)(value & 0x7f) | 0x80, 8);
+    value >>= 7;
+  }
+  add_bits((uint32_t)value, 8);
+}
+
+/**
+ * Adds any bits still being collected to the Datagram, padding the last byte
+ * with zero bits.  Anything added after this begins on a new byte.
+ */
+void DatagramBitWriter::
+flush() {
+  if (_num_pending > 0) {
+    _buffer[_buffer_length++] = (unsigned char)_bits;
+    _bits = 0;
+    _num_pending = 0;
+  }
+  write_buffer();
+}
+
+/**
+ * Returns the value quantized to the indicated number of bits, for
+ * add_quantized().
+ */
+uint32_t DatagramBitWriter::
+quantize(double value, double min_value, double max_value, int num_bits) {
+  nassertr(num_bits > 0 && num_bits <= 32, 0);
+  nassertr(max_value > min_value, 0);
+
+  double steps = (double)((((uint64_t)1) << num_bits) - 1);
+  double t = (value - min_value) / (max_value - min_value);
+  if (!(t > 0.0)) {
+    // This also catches NaN.
+    return 0;
+  }
+  if (t >= 1.0) {
+    return (uint32_t)steps;
+  }
+  return (uint32_t)floor(t * steps + 0.5);
+}
+
+/**
+ * Appends the collected bytes to the Datagram.
+ */
+void DatagramBitWriter::
+write_buffer() {
+  if (_buffer_length > 0) {
+    _datagram.append_data(_buffer, _buffer_length);
+    _buffer_length = 0;
+  }
+}
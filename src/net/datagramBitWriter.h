@@ -0,0 +1,66 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file datagramBitWriter.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef DATAGRAMBITWRITER_H
+#define DATAGRAMBITWRITER_H
+
+#include "pandabase.h"
+#include "datagram.h"
+#include "numeric_types.h"
+
+/**
+ * Packs values into a Datagram at the bit level, rather than in whole bytes.
+ * Values are appended in order, least significant bit first, and are read
+ * back in the same order with a DatagramBitReader.
+ *
+ * The bits are collected and added to the Datagram a chunk at a time; call
+ * flush() (or destruct the writer) before adding anything else to the
+ * Datagram.  The last byte is padded with zero bits.
+ */
+class EXPCL_PANDA_NET DatagramBitWriter {
+PUBLISHED:
+  explicit DatagramBitWriter(Datagram &datagram);
+  INLINE ~DatagramBitWriter();
+
+  INLINE void add_bool(bool value);
+  INLINE void add_bits(uint32_t value, int num_bits);
+  void add_varint(uint64_t value);
+  INLINE void add_signed_varint(int64_t value);
+  INLINE void add_float32(PN_float32 value);
+  INLINE void add_quantized(double value, double min_value, double max_value,
+                            int num_bits);
+
+  void flush();
+
+  INLINE size_t get_num_bits() const;
+
+public:
+  static uint32_t quantize(double value, double min_value, double max_value,
+                           int num_bits);
+  INLINE static uint64_t zigzag_encode(int64_t value);
+
+private:
+  void write_buffer();
+
+  Datagram &_datagram;
+  uint64_t _bits;
+  int _num_pending;
+  size_t _num_bits;
+
+  unsigned char _buffer[64];
+  size_t _buffer_length;
+};
+
+#include "datagramBitWriter.I"
+
+#endif
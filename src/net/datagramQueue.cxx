@@ -15,6 +15,8 @@
 #include "config_net.h"
 #include "mutexHolder.h"
 
+#include <algorithm>
+
 /**
  *
  */
@@ -121,6 +123,39 @@ extract(NetDatagram &result) {
   return true;
 }
 
+/**
+ * Extracts up to max_count datagrams from the head of the queue, appending
+ * them to results.  Like the single-datagram extract(), this blocks until at
+ * least one datagram is available, but it does not wait for more than that.
+ *
+ * The return value is true if any datagrams were extracted, or false if the
+ * queue was destroyed while waiting.
+ */
+bool DatagramQueue::
+extract(pvector<NetDatagram> &results, size_t max_count) {
+  nassertr(max_count > 0, false);
+
+  MutexHolder holder(_cvlock);
+
+  while (_queue.empty() && !_shutdown) {
+    _cv.wait();
+  }
+
+  if (_shutdown) {
+    return false;
+  }
+
+  nassertr(!_queue.empty(), false);
+  size_t count = std::min(_queue.size(), max_count);
+  results.insert(results.end(), _queue.begin(), _queue.begin() + count);
+  _queue.erase(_queue.begin(), _queue.begin() + count);
+
+  // Wake up any threads waiting to stuff things into the queue.
+  _cv.notify_all();
+
+  return true;
+}
+
 /**
  * Sets the maximum size the queue is allowed to grow to.  This is primarily
  * for a sanity check; this is a limit beyond which we can assume something
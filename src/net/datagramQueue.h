@@ -20,6 +20,7 @@
 #include "pmutex.h"
 #include "conditionVar.h"
 #include "pdeque.h"
+#include "pvector.h"
 
 /**
  * A thread-safe, FIFO queue of NetDatagrams.  This is used by
@@ -34,6 +35,7 @@ public:
 
   bool insert(const NetDatagram &data, bool block = false);
   bool extract(NetDatagram &result);
+  bool extract(pvector<NetDatagram> &results, size_t max_count);
 
   void set_max_queue_size(int max_size);
   int get_max_queue_size() const;
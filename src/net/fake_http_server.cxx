@@ -21,6 +21,8 @@
 #include "connection.h"
 #include "netDatagram.h"
 #include "pmap.h"
+#include "filename.h"
+#include "string_utils.h"
 
 #include <ctype.h>
 
@@ -30,14 +32,29 @@ QueuedConnectionManager cm;
 QueuedConnectionReader reader(&cm, 10);
 ConnectionWriter writer(&cm, 10);
 
+// If this is set, we serve the files within this directory.  Otherwise, we
+// just print out the requests we receive, and never answer them.
+Filename root_dir;
+
+// If this is nonzero, every drop_every'th response with a body is cut off
+// halfway through, to simulate a lost connection.
+int drop_every = 0;
+int num_responses = 0;
+
 class ClientState {
 public:
   ClientState(Connection *client);
   void receive_data(const Datagram &data);
   void receive_line(string line);
+  void handle_request();
+  void send_response(const string &status, const string &headers,
+                     const string &body, bool send_body);
 
   Connection *_client;
   string _received;
+
+  string _request_line;
+  pmap<string, string> _headers;
 };
 
 ClientState::
@@ -77,27 +94,183 @@ receive_line(string line) {
     line = line.substr(0, size);
   }
 
-  /*
-  if (line.empty()) {
-    // Start to honor the request, as if we cared.
-    Datagram dg;
-    dg.append_data("HTTP/1.1 200 OK\r\n");
-    writer.send(dg, _client);
-    // Close the connection!
+  if (root_dir.empty()) {
+    return;
+  }
+
+  if (_request_line.empty()) {
+    // The first line of a new request.  A blank line between requests
+    // leaves this empty, so it is skipped.
+    _request_line = line;
+
+  } else if (line.empty()) {
+    // The end of the headers: honor the request.
+    handle_request();
+    _request_line = string();
+    _headers.clear();
+
+  } else {
+    size_t colon = line.find(':');
+    if (colon != string::npos) {
+      string key = downcase(line.substr(0, colon));
+      string value = trim(line.substr(colon + 1));
+      _headers[key] = value;
+    }
+  }
+}
+
+/**
+ * Serves a GET or HEAD request for a file within root_dir, honoring the Range
+ * and If-Match headers.
+ */
+void ClientState::
+handle_request() {
+  vector_string words;
+  extract_words(_request_line, words);
+  if (words.size() != 3) {
+    send_response("400 Bad Request", "", "", false);
+    return;
+  }
+  const string &method = words[0];
+  if (method != "GET" && method != "HEAD") {
+    send_response("501 Not Implemented", "", "", false);
+    return;
+  }
+  bool send_body = (method == "GET");
+
+  // Strip off the scheme and host, if the request came through a proxy, and
+  // any query string.
+  string path = words[1];
+  size_t slash = path.find("://");
+  if (slash != string::npos) {
+    slash = path.find('/', slash + 3);
+    path = (slash != string::npos) ? path.substr(slash) : "/";
+  }
+  path = path.substr(0, path.find('?'));
+  if (path.find("..") != string::npos) {
+    send_response("403 Forbidden", "", "", false);
+    return;
+  }
+
+  Filename filename(root_dir, Filename::from_os_specific(path.substr(1)));
+  filename.set_binary();
+  pifstream file;
+  if (!filename.is_regular_file() || !filename.open_read(file)) {
+    send_response("404 Not Found", "", "", false);
+    return;
+  }
+
+  file.seekg(0, std::ios::end);
+  size_t file_size = (size_t)file.tellg();
+
+  std::ostringstream etag;
+  etag << "\"" << std::hex << file_size << "-" << filename.get_timestamp() << "\"";
+
+  pmap<string, string>::const_iterator hi = _headers.find("if-match");
+  if (hi != _headers.end() && (*hi).second != "*" && (*hi).second != etag.str()) {
+    send_response("412 Precondition Failed", "", "", false);
+    return;
+  }
+
+  size_t first_byte = 0;
+  size_t last_byte = file_size - 1;
+  bool partial = false;
+  hi = _headers.find("range");
+  if (hi != _headers.end() && (*hi).second.substr(0, 6) == "bytes=") {
+    // We only handle a single range.
+    string range = (*hi).second.substr(6);
+    size_t dash = range.find('-');
+    if (dash != string::npos && range.find(',') == string::npos) {
+      string first = range.substr(0, dash);
+      string last = range.substr(dash + 1);
+      if (!first.empty()) {
+        first_byte = (size_t)atoll(first.c_str());
+        if (!last.empty()) {
+          last_byte = std::min((size_t)atoll(last.c_str()), file_size - 1);
+        }
+      } else if (!last.empty()) {
+        // A suffix range: the last n bytes.
+        size_t suffix = std::min((size_t)atoll(last.c_str()), file_size);
+        first_byte = file_size - suffix;
+      }
+      if (file_size == 0 || first_byte > last_byte) {
+        std::ostringstream headers;
+        headers << "Content-Range: bytes */" << file_size << "\r\n";
+        send_response("416 Range Not Satisfiable", headers.str(), "", false);
+        return;
+      }
+      partial = true;
+    }
+  }
+
+  size_t length = (file_size == 0) ? 0 : last_byte - first_byte + 1;
+  string body;
+  if (send_body && length != 0) {
+    body.resize(length);
+    file.seekg(first_byte);
+    file.read(&body[0], length);
+    body.resize(file.gcount());
+  }
+
+  std::ostringstream headers;
+  headers << "ETag: " << etag.str() << "\r\n"
+          << "Accept-Ranges: bytes\r\n"
+          << "Content-Length: " << length << "\r\n";
+  if (partial) {
+    headers << "Content-Range: bytes " << first_byte << "-" << last_byte
+            << "/" << file_size << "\r\n";
+  }
+  send_response(partial ? "206 Partial Content" : "200 OK", headers.str(),
+                body, send_body);
+}
+
+/**
+ * Sends the response, all in one datagram so that the writer threads can't
+ * reorder it.
+ */
+void ClientState::
+send_response(const string &status, const string &headers,
+              const string &body, bool send_body) {
+  std::cerr << "sending: " << status << "\n";
+  string response = "HTTP/1.1 " + status + "\r\n" + headers;
+  if (headers.find("Content-Length:") == string::npos) {
+    response += "Content-Length: 0\r\n";
+  }
+  response += "\r\n";
+
+  bool drop = false;
+  if (send_body && !body.empty()) {
+    ++num_responses;
+    drop = (drop_every > 0 && num_responses % drop_every == 0);
+    response += drop ? body.substr(0, body.size() / 2) : body;
+  }
+
+  Datagram dg;
+  dg.append_data(response);
+  writer.send(dg, _client);
+
+  if (drop) {
+    std::cerr << "dropping connection\n";
     cm.close_connection(_client);
   }
-  */
 }
 
 
 int
 main(int argc, char *argv[]) {
-  if (argc != 2) {
-    nout << "fake_http_server port\n";
+  if (argc < 2 || argc > 4) {
+    nout << "fake_http_server port [root_dir [drop_every]]\n";
     exit(1);
   }
 
   int port = atoi(argv[1]);
+  if (argc > 2) {
+    root_dir = Filename::from_os_specific(argv[2]);
+    nout << "Serving files from " << root_dir << "\n";
+  }
+  if (argc > 3) {
+    drop_every = atoi(argv[3]);
+  }
 
   PT(Connection) rendezvous = cm.open_TCP_server_rendezvous(port, 5);
 
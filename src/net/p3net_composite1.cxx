@@ -5,6 +5,8 @@
 #include "connectionManager.cxx"
 #include "connectionReader.cxx"
 #include "connectionWriter.cxx"
+#include "datagramBitReader.cxx"
+#include "datagramBitWriter.cxx"
 #include "datagramGeneratorNet.cxx"
 #include "datagramSinkNet.cxx"
 #include "datagramQueue.cxx"
@@ -7,3 +7,7 @@
 #include "queuedConnectionManager.cxx"
 #include "queuedConnectionReader.cxx"
 #include "recentConnectionReader.cxx"
+#include "snapshotDecoder.cxx"
+#include "snapshotEncoder.cxx"
+#include "snapshotLayout.cxx"
+#include "snapshotState.cxx"
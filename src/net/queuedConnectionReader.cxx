@@ -15,9 +15,23 @@
 #include "config_net.h"
 #include "trueClock.h"
 #include "lightMutexHolder.h"
+#include "configVariableInt.h"
 
 template class QueuedReturn<NetDatagram>;
 
+static ConfigVariableInt net_receive_ring_size
+("net-receive-ring-size", 0,
+ PRC_DESC("If this is nonzero, a QueuedConnectionReader keeps its received "
+          "datagrams in a ring of this many reusable NetDatagrams, rather "
+          "than in a queue that grows and shrinks.  See "
+          "QueuedConnectionReader::set_receive_ring_size()."));
+
+static ConfigVariableInt net_read_buffer_size
+("net-read-buffer-size", 65536,
+ PRC_DESC("The size of the buffer each TCP connection is read into by a "
+          "QueuedConnectionReader with a receive ring, in bytes.  Any "
+          "datagram larger than this grows the buffer of its connection."));
+
 /**
  *
  */
@@ -30,6 +44,13 @@ QueuedConnectionReader(ConnectionManager *manager, int num_threads) :
   _min_delay = 0.0;
   _delay_variance = 0.0;
 #endif  // SIMULATE_NETWORK_DELAY
+
+  _ring_head = 0;
+  _ring_read = 0;
+  _ring_tail = 0;
+  if (net_receive_ring_size > 0) {
+    set_receive_ring_size(net_receive_ring_size);
+  }
 }
 
 /**
@@ -52,7 +73,7 @@ data_available() {
 #ifdef SIMULATE_NETWORK_DELAY
   get_delayed();
 #endif  // SIMULATE_NETWORK_DELAY
-  return thing_available();
+  return thing_available() || ring_data_available();
 }
 
 /**
@@ -62,9 +83,34 @@ data_available() {
  * The return value is true if a datagram was successfully returned, or false
  * if there was, in fact, no datagram available.  (This may happen if there
  * are multiple threads accessing the QueuedConnectionReader).
+ *
+ * With a receive ring, this copies the datagram out of the ring and frees its
+ * slot right away.  It may not be mixed with acquire_data() while any
+ * acquired datagrams are still outstanding.
  */
 bool QueuedConnectionReader::
 get_data(NetDatagram &result) {
+  if (!_ring.empty()) {
+    LightMutexHolder holder(_ring_mutex);
+    nassertr(_ring_head == _ring_read, false);
+    if (_ring_read == _ring_tail) {
+      return false;
+    }
+
+    // This is acquire_data() and release_data() in one step.  We copy the
+    // bytes rather than assigning the datagram, which would share the slot's
+    // buffer and make the next datagram received into it reallocate.
+    NetDatagram &slot = _ring[_ring_read];
+    result.reset();
+    result.append_data(slot.get_data(), slot.get_length());
+    result.set_connection(slot.get_connection());
+    result.set_address(slot.get_address());
+    slot.set_connection(nullptr);
+    _ring_read = (_ring_read + 1) % _ring.size();
+    _ring_head = _ring_read;
+    return true;
+  }
+
   return get_thing(result);
 }
 
@@ -77,13 +123,95 @@ get_data(NetDatagram &result) {
 bool QueuedConnectionReader::
 get_data(Datagram &result) {
   NetDatagram nd;
-  if (!get_thing(nd)) {
+  if (!get_data(nd)) {
     return false;
   }
   result = nd;
   return true;
 }
 
+/**
+ * Sets up a ring of the indicated number of NetDatagrams to receive
+ * datagrams into, instead of the usual queue, or removes it if num_slots is
+ * 0.  The slots are reused for each new datagram, keeping the buffers they
+ * have grown, so that once each slot has held a datagram of typical size, no
+ * further memory is allocated to receive datagrams.  This also sets up a read
+ * buffer on each TCP connection, if there is not one already; see
+ * ConnectionReader::set_read_buffer_size().
+ *
+ * With a ring, the datagrams may be examined in place with acquire_data()
+ * and release_data(), rather than copied out with get_data().  If the ring
+ * fills up because the datagrams are not released quickly enough, new
+ * datagrams are dropped and the overflow flag is set.
+ *
+ * This must be called before any connections are added.  Simulated network
+ * delay does not apply to a reader with a ring.
+ */
+void QueuedConnectionReader::
+set_receive_ring_size(int num_slots) {
+  {
+    LightMutexHolder holder(_ring_mutex);
+    nassertv(_ring_head == _ring_tail);
+
+    _ring.clear();
+    if (num_slots > 0) {
+      _ring.resize(num_slots + 1);
+    }
+    _ring_head = 0;
+    _ring_read = 0;
+    _ring_tail = 0;
+  }
+
+  if (num_slots > 0 && get_read_buffer_size() == 0) {
+    set_read_buffer_size(std::max((int)net_read_buffer_size, 1));
+  }
+}
+
+/**
+ * Returns the number of datagrams the receive ring can hold, or 0 if there is
+ * no receive ring.  See set_receive_ring_size().
+ */
+int QueuedConnectionReader::
+get_receive_ring_size() const {
+  return _ring.empty() ? 0 : (int)_ring.size() - 1;
+}
+
+/**
+ * If there is a receive ring and a datagram is waiting in it, returns a
+ * pointer to the datagram, which remains valid until it is returned with a
+ * matching call to release_data().  Returns NULL if no datagram is waiting.
+ *
+ * Several datagrams may be acquired before releasing any; they are released
+ * in the same order they were acquired.  Call data_available() first to read
+ * any pending data from the sockets.
+ */
+const NetDatagram *QueuedConnectionReader::
+acquire_data() {
+  LightMutexHolder holder(_ring_mutex);
+  if (_ring_read == _ring_tail) {
+    return nullptr;
+  }
+
+  const NetDatagram *datagram = &_ring[_ring_read];
+  _ring_read = (_ring_read + 1) % _ring.size();
+  return datagram;
+}
+
+/**
+ * Gives back the oldest datagram returned by acquire_data(), so that its slot
+ * in the receive ring may be reused for a new datagram.  The datagram must
+ * not be accessed after this call.
+ */
+void QueuedConnectionReader::
+release_data() {
+  LightMutexHolder holder(_ring_mutex);
+  nassertv(_ring_head != _ring_read);
+
+  // Don't hold on to the connection until the slot is reused.
+  _ring[_ring_head].set_connection(nullptr);
+  _ring_head = (_ring_head + 1) % _ring.size();
+}
+
 /**
  * An internal function called by ConnectionReader() when a new datagram has
  * become available.  The QueuedConnectionReader simply queues it up for later
@@ -99,6 +227,12 @@ receive_datagram(const NetDatagram &datagram) {
   }
   */
 
+  if (!_ring.empty()) {
+    receive_datagram_data(datagram.get_connection(), datagram.get_address(),
+                          datagram.get_data(), datagram.get_length());
+    return;
+  }
+
 #ifdef SIMULATE_NETWORK_DELAY
   delay_datagram(datagram);
 
@@ -111,6 +245,64 @@ receive_datagram(const NetDatagram &datagram) {
 }
 
 
+/**
+ * Called by ConnectionReader with the data of each datagram read into a
+ * connection's read buffer.  With a receive ring, this copies the data
+ * straight into the next free slot.
+ */
+void QueuedConnectionReader::
+receive_datagram_data(Connection *connection, const NetAddress &address,
+                      const void *data, size_t size) {
+  if (_ring.empty()) {
+    ConnectionReader::receive_datagram_data(connection, address, data, size);
+    return;
+  }
+
+  LightMutexHolder holder(_ring_mutex);
+  NetDatagram *slot = begin_ring_slot();
+  if (slot == nullptr) {
+    set_overflow_flag();
+    net_cat.error()
+      << "QueuedConnectionReader queue full!\n";
+    return;
+  }
+
+  // reset() keeps the slot's buffer, so this doesn't allocate once the
+  // buffer has grown large enough.
+  slot->reset();
+  slot->append_data(data, size);
+  slot->set_connection(connection);
+  slot->set_address(address);
+  _ring_tail = (_ring_tail + 1) % _ring.size();
+}
+
+/**
+ * Returns the slot at the tail of the receive ring, or NULL if the ring is
+ * full.  Assumes the ring mutex is held.
+ */
+NetDatagram *QueuedConnectionReader::
+begin_ring_slot() {
+  size_t next = (_ring_tail + 1) % _ring.size();
+  if (next == _ring_head) {
+    return nullptr;
+  }
+  return &_ring[_ring_tail];
+}
+
+/**
+ * Returns true if there is a receive ring with at least one datagram waiting
+ * to be acquired.
+ */
+bool QueuedConnectionReader::
+ring_data_available() {
+  if (_ring.empty()) {
+    return false;
+  }
+  LightMutexHolder holder(_ring_mutex);
+  return _ring_read != _ring_tail;
+}
+
+
 #ifdef SIMULATE_NETWORK_DELAY
 /**
  * Enables a simulated network latency.  All packets received from this point
@@ -21,6 +21,7 @@
 #include "queuedReturn.h"
 #include "lightMutex.h"
 #include "pdeque.h"
+#include "pvector.h"
 
 EXPORT_TEMPLATE_CLASS(EXPCL_PANDA_NET, EXPTP_PANDA_NET, QueuedReturn<NetDatagram>);
 
@@ -29,6 +30,13 @@ EXPORT_TEMPLATE_CLASS(EXPCL_PANDA_NET, EXPTP_PANDA_NET, QueuedReturn<NetDatagram
  * of the datagrams read for later receipt by the client code.  This class is
  * useful for client code that doesn't want to deal with threading and is
  * willing to poll for datagrams at its convenience.
+ *
+ * If set_receive_ring_size() is used, the datagrams are instead kept in a
+ * fixed ring of NetDatagrams that are reused over and over, and may be
+ * examined in place with acquire_data() and release_data().  Together with
+ * the read buffer that this implies on each connection (see
+ * ConnectionReader::set_read_buffer_size()), this avoids allocating anything
+ * for each datagram once the ring has warmed up.
  */
 class EXPCL_PANDA_NET QueuedConnectionReader : public ConnectionReader,
                                public QueuedReturn<NetDatagram> {
@@ -40,8 +48,32 @@ PUBLISHED:
   bool get_data(NetDatagram &result);
   bool get_data(Datagram &result);
 
+  void set_receive_ring_size(int num_slots);
+  int get_receive_ring_size() const;
+
+  const NetDatagram *acquire_data();
+  void release_data();
+
 protected:
   virtual void receive_datagram(const NetDatagram &datagram);
+  virtual void receive_datagram_data(Connection *connection,
+                                     const NetAddress &address,
+                                     const void *data, size_t size);
+
+private:
+  NetDatagram *begin_ring_slot();
+  bool ring_data_available();
+
+  // The receive ring.  Slots from _ring_head up to _ring_read have been
+  // handed out by acquire_data() and not yet released; slots from _ring_read
+  // up to _ring_tail are waiting to be acquired.  One slot is always left
+  // empty, to tell a full ring from an empty one.
+  LightMutex _ring_mutex;
+  typedef pvector<NetDatagram> Ring;
+  Ring _ring;
+  size_t _ring_head;
+  size_t _ring_read;
+  size_t _ring_tail;
 
 #ifdef SIMULATE_NETWORK_DELAY
 PUBLISHED:
@@ -50,6 +50,7 @@ protected:
 
   bool enqueue_thing(const Thing &thing);
   bool enqueue_unique_thing(const Thing &thing);
+  INLINE void set_overflow_flag();
 
 private:
   LightMutex _mutex;
@@ -0,0 +1,203 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file snapshotDecoder.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "snapshotDecoder.h"
+#include "datagramBitReader.h"
+#include "config_net.h"
+
+#include <algorithm>
+
+/**
+ * Creates a decoder for entities with the indicated layout, keeping the
+ * indicated number of past snapshots.
+ */
+SnapshotDecoder::
+SnapshotDecoder(const SnapshotLayout *layout, int history_size) :
+  _layout(layout),
+  _history_size(std::max(history_size, 2)),
+  _history(_history_size),
+  _sequence(0),
+  _values(layout->get_num_fields(), 0)
+{
+}
+
+/**
+ * Reads the next snapshot from the iterator.  Returns true on success, in
+ * which case the entities of the new snapshot may be queried, or false if
+ * the snapshot could not be read, in which case the entities of the previous
+ * snapshot remain.
+ *
+ * A snapshot fails to read if it is truncated, if it is older than the last
+ * one read, or if it is a delta against a snapshot this decoder no longer
+ * has.
+ */
+bool SnapshotDecoder::
+read_snapshot(DatagramIterator &scan) {
+  if (!scan.has_remaining(sizeof(uint32_t) * 2)) {
+    net_cat.warning()
+      << "Truncated snapshot.\n";
+    return false;
+  }
+
+  uint32_t sequence = scan.get_uint32();
+  uint32_t baseline_sequence = scan.get_uint32();
+  if (sequence == 0) {
+    net_cat.warning()
+      << "Invalid snapshot.\n";
+    return false;
+  }
+
+  if (_sequence != 0 && (int32_t)(sequence - _sequence) <= 0) {
+    // This one arrived late; we already have a newer one.
+    if (net_cat.is_debug()) {
+      net_cat.debug()
+        << "Ignoring snapshot " << sequence << ", older than " << _sequence
+        << "\n";
+    }
+    return false;
+  }
+
+  const SnapshotFrame *baseline = nullptr;
+  if (baseline_sequence != 0) {
+    baseline = find_frame(baseline_sequence);
+    if (baseline == nullptr ||
+        baseline_sequence % _history_size == sequence % _history_size) {
+      net_cat.warning()
+        << "Received snapshot " << sequence << " as a delta against snapshot "
+        << baseline_sequence << ", which is no longer available.\n";
+      return false;
+    }
+  }
+
+  // First, read the changed entities and the removed ids.
+  int num_fields = _layout->get_num_fields();
+  _changes.clear();
+  _removed.clear();
+
+  DatagramBitReader reader(scan);
+  uint64_t num_changes = reader.get_varint();
+  uint32_t id = 0;
+  for (uint64_t i = 0; i < num_changes && !reader.has_error(); ++i) {
+    uint32_t next_id = id + (uint32_t)reader.get_varint();
+    if (i != 0 && next_id <= id) {
+      net_cat.warning()
+        << "Invalid entity id in snapshot " << sequence << ".\n";
+      return false;
+    }
+    id = next_id;
+
+    if (reader.get_bool()) {
+      int bi = (baseline != nullptr) ? baseline->find_entity(id) : -1;
+      if (bi < 0) {
+        net_cat.warning()
+          << "Snapshot " << sequence << " has a delta for entity " << id
+          << ", which isn't in snapshot " << baseline_sequence << ".\n";
+        return false;
+      }
+      const uint64_t *baseline_values = baseline->_values.data() + bi * num_fields;
+      for (int f = 0; f < num_fields; ++f) {
+        _values[f] = reader.get_bool() ? _layout->read_value(reader, f)
+                                       : baseline_values[f];
+      }
+    } else {
+      for (int f = 0; f < num_fields; ++f) {
+        _values[f] = _layout->read_value(reader, f);
+      }
+    }
+    _changes.add_entity(id, _values.data(), num_fields);
+  }
+
+  uint64_t num_removed = reader.get_varint();
+  id = 0;
+  for (uint64_t i = 0; i < num_removed && !reader.has_error(); ++i) {
+    id += (uint32_t)reader.get_varint();
+    _removed.push_back(id);
+  }
+
+  if (reader.has_error()) {
+    net_cat.warning()
+      << "Truncated snapshot " << sequence << ".\n";
+    return false;
+  }
+
+  // Now merge them with the baseline, both in order of id, to make the new
+  // snapshot.
+  SnapshotFrame &frame = _history[sequence % _history_size];
+  frame.clear();
+
+  size_t ci = 0;
+  size_t num_changed = _changes.get_num_entities();
+  size_t bi = 0;
+  size_t num_baseline = (baseline != nullptr) ? baseline->get_num_entities() : 0;
+  size_t ri = 0;
+  while (ci < num_changed || bi < num_baseline) {
+    if (bi >= num_baseline ||
+        (ci < num_changed && _changes._ids[ci] <= baseline->_ids[bi])) {
+      if (bi < num_baseline && _changes._ids[ci] == baseline->_ids[bi]) {
+        ++bi;
+      }
+      frame.add_entity(_changes._ids[ci], _changes._values.data() + ci * num_fields,
+                       num_fields);
+      ++ci;
+
+    } else {
+      // An entity that hasn't changed, unless it has been removed.
+      uint32_t baseline_id = baseline->_ids[bi];
+      while (ri < _removed.size() && _removed[ri] < baseline_id) {
+        ++ri;
+      }
+      if (ri >= _removed.size() || _removed[ri] != baseline_id) {
+        frame.add_entity(baseline_id, baseline->_values.data() + bi * num_fields,
+                         num_fields);
+      }
+      ++bi;
+    }
+  }
+
+  frame._sequence = sequence;
+  _sequence = sequence;
+  return true;
+}
+
+/**
+ * Forgets all of the snapshots that have been read.  The server should be
+ * told to start sending everything in full again.
+ */
+void SnapshotDecoder::
+clear() {
+  for (SnapshotFrame &frame : _history) {
+    frame.clear();
+  }
+  _sequence = 0;
+}
+
+/**
+ * Returns the state of the nth entity in the last snapshot read.
+ */
+SnapshotState SnapshotDecoder::
+get_entity_state(size_t n) const {
+  SnapshotState state(_layout);
+  const SnapshotFrame &frame = get_current();
+  nassertr(n < frame.get_num_entities(), state);
+  state.set_values(frame._values.data() + n * _layout->get_num_fields());
+  return state;
+}
+
+/**
+ * Returns the index of the entity with the indicated id in the last snapshot
+ * read, or -1 if it is not there.
+ */
+int SnapshotDecoder::
+find_entity(uint32_t id) const {
+  return get_current().find_entity(id);
+}
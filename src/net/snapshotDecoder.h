@@ -0,0 +1,66 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file snapshotDecoder.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef SNAPSHOTDECODER_H
+#define SNAPSHOTDECODER_H
+
+#include "pandabase.h"
+#include "snapshotState.h"
+#include "referenceCount.h"
+#include "datagramIterator.h"
+#include "pvector.h"
+
+/**
+ * Reads the snapshots written by a SnapshotEncoder, on the client.  After
+ * each successful call to read_snapshot(), the complete state of every
+ * entity as of that snapshot is available, and the snapshot's sequence
+ * number should be reported back to the server to be acknowledged.
+ *
+ * The decoder keeps the last history_size snapshots it has read, since the
+ * server may send deltas against any of them.  It must be at least as large
+ * as the history size of the encoder.
+ */
+class EXPCL_PANDA_NET SnapshotDecoder : public ReferenceCount {
+PUBLISHED:
+  explicit SnapshotDecoder(const SnapshotLayout *layout, int history_size = 32);
+
+  INLINE const SnapshotLayout *get_layout() const;
+  INLINE int get_history_size() const;
+
+  bool read_snapshot(DatagramIterator &scan);
+  void clear();
+
+  INLINE uint32_t get_sequence() const;
+  INLINE size_t get_num_entities() const;
+  INLINE uint32_t get_entity_id(size_t n) const;
+  SnapshotState get_entity_state(size_t n) const;
+  int find_entity(uint32_t id) const;
+
+private:
+  INLINE const SnapshotFrame *find_frame(uint32_t sequence) const;
+  INLINE const SnapshotFrame &get_current() const;
+
+  CPT(SnapshotLayout) _layout;
+  int _history_size;
+  pvector<SnapshotFrame> _history;
+  uint32_t _sequence;
+
+  // Used by read_snapshot(); kept here so that they keep their memory.
+  SnapshotFrame _changes;
+  pvector<uint32_t> _removed;
+  pvector<uint64_t> _values;
+};
+
+#include "snapshotDecoder.I"
+
+#endif
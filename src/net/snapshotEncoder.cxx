@@ -0,0 +1,244 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file snapshotEncoder.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "snapshotEncoder.h"
+#include "datagramBitWriter.h"
+
+#include <algorithm>
+
+/**
+ * Creates an encoder for entities with the indicated layout, keeping the
+ * indicated number of past snapshots for each client.
+ */
+SnapshotEncoder::
+SnapshotEncoder(const SnapshotLayout *layout, int history_size) :
+  _layout(layout),
+  _history_size(std::max(history_size, 2))
+{
+}
+
+/**
+ * Sets the current state of the indicated entity, adding it if it is new.
+ * The next snapshot written for each client will include it if it differs
+ * from what the client already has.
+ */
+void SnapshotEncoder::
+set_entity(uint32_t id, const SnapshotState &state) {
+  nassertv(state.get_layout() == _layout);
+
+  Entities::iterator ei = _entities.find(id);
+  if (ei == _entities.end()) {
+    _entities.insert(Entities::value_type(id, state));
+  } else {
+    (*ei).second.set_values(state.get_values());
+  }
+}
+
+/**
+ * Removes the indicated entity.  The next snapshot written for each client
+ * that had it will report it removed.
+ */
+void SnapshotEncoder::
+remove_entity(uint32_t id) {
+  _entities.erase(id);
+}
+
+/**
+ * Removes all of the entities.
+ */
+void SnapshotEncoder::
+clear_entities() {
+  _entities.clear();
+}
+
+/**
+ * Adds a new client to write snapshots for.  If the client already exists,
+ * it is reset, so that it is sent everything in full again.
+ */
+void SnapshotEncoder::
+add_client(int client_id) {
+  Client &client = _clients[client_id];
+  client._history.clear();
+  client._history.resize(_history_size);
+  client._next_sequence = 1;
+  client._baseline = 0;
+}
+
+/**
+ * Removes a client, forgetting the snapshots written for it.
+ */
+void SnapshotEncoder::
+remove_client(int client_id) {
+  _clients.erase(client_id);
+}
+
+/**
+ * Returns true if the indicated client has been added.
+ */
+bool SnapshotEncoder::
+has_client(int client_id) const {
+  return _clients.find(client_id) != _clients.end();
+}
+
+/**
+ * Appends a snapshot of the current state of all of the entities for the
+ * indicated client to the Datagram, and returns its sequence number.  The
+ * client should report this number back once it has received the snapshot,
+ * to be passed to acknowledge().
+ *
+ * The snapshot begins with its sequence number and that of the snapshot it
+ * is a delta against (0 if none), as two uint32's.  The rest is bit-packed
+ * and padded to a whole byte.
+ */
+uint32_t SnapshotEncoder::
+write_snapshot(int client_id, Datagram &datagram) {
+  Clients::iterator ci = _clients.find(client_id);
+  nassertr(ci != _clients.end(), 0);
+  Client &client = (*ci).second;
+
+  uint32_t sequence = client._next_sequence++;
+  if (client._next_sequence == 0) {
+    // Sequence number 0 means "none".
+    client._next_sequence = 1;
+  }
+
+  // We can't use a baseline in the history slot that this snapshot is about
+  // to replace.
+  const SnapshotFrame *baseline = find_frame(client, client._baseline);
+  if (baseline != nullptr &&
+      baseline->_sequence % _history_size == sequence % _history_size) {
+    baseline = nullptr;
+  }
+  uint32_t baseline_sequence = (baseline != nullptr) ? baseline->_sequence : 0;
+
+  // Compare the entities with the baseline, both in order of id, to find
+  // the ones that are new or have changed, and the ones that are gone.
+  int num_fields = _layout->get_num_fields();
+  _changes.clear();
+  _removed.clear();
+
+  size_t bi = 0;
+  size_t num_baseline = (baseline != nullptr) ? baseline->get_num_entities() : 0;
+  for (Entities::const_iterator ei = _entities.begin(); ei != _entities.end(); ++ei) {
+    uint32_t id = (*ei).first;
+    const uint64_t *values = (*ei).second.get_values();
+
+    while (bi < num_baseline && baseline->_ids[bi] < id) {
+      _removed.push_back(baseline->_ids[bi]);
+      ++bi;
+    }
+
+    Change change;
+    change._id = id;
+    change._values = values;
+    change._baseline_values = nullptr;
+    if (bi < num_baseline && baseline->_ids[bi] == id) {
+      change._baseline_values = baseline->_values.data() + bi * num_fields;
+      ++bi;
+      if (std::equal(values, values + num_fields, change._baseline_values)) {
+        // Unchanged; the client already has this.
+        continue;
+      }
+    }
+    _changes.push_back(change);
+  }
+  while (bi < num_baseline) {
+    _removed.push_back(baseline->_ids[bi]);
+    ++bi;
+  }
+
+  datagram.add_uint32(sequence);
+  datagram.add_uint32(baseline_sequence);
+
+  DatagramBitWriter writer(datagram);
+  writer.add_varint(_changes.size());
+  uint32_t prev_id = 0;
+  for (const Change &change : _changes) {
+    writer.add_varint(change._id - prev_id);
+    prev_id = change._id;
+
+    if (change._baseline_values != nullptr) {
+      // A delta: each field is preceded by a bit saying whether it changed.
+      writer.add_bool(true);
+      for (int f = 0; f < num_fields; ++f) {
+        bool changed = (change._values[f] != change._baseline_values[f]);
+        writer.add_bool(changed);
+        if (changed) {
+          _layout->write_value(writer, f, change._values[f]);
+        }
+      }
+    } else {
+      writer.add_bool(false);
+      for (int f = 0; f < num_fields; ++f) {
+        _layout->write_value(writer, f, change._values[f]);
+      }
+    }
+  }
+
+  writer.add_varint(_removed.size());
+  prev_id = 0;
+  for (uint32_t id : _removed) {
+    writer.add_varint(id - prev_id);
+    prev_id = id;
+  }
+  writer.flush();
+
+  // Remember what we sent, to compute later deltas against.
+  SnapshotFrame &frame = client._history[sequence % _history_size];
+  frame.clear();
+  frame._sequence = sequence;
+  for (Entities::const_iterator ei = _entities.begin(); ei != _entities.end(); ++ei) {
+    frame.add_entity((*ei).first, (*ei).second.get_values(), num_fields);
+  }
+
+  return sequence;
+}
+
+/**
+ * Records that the indicated client has received the indicated snapshot, so
+ * that later snapshots may be written as deltas against it.  Reports of
+ * snapshots older than one already acknowledged, or no longer in the
+ * history, are ignored.
+ */
+void SnapshotEncoder::
+acknowledge(int client_id, uint32_t sequence) {
+  Clients::iterator ci = _clients.find(client_id);
+  nassertv(ci != _clients.end());
+  Client &client = (*ci).second;
+
+  if (find_frame(client, sequence) == nullptr) {
+    return;
+  }
+  if (client._baseline == 0 || (int32_t)(sequence - client._baseline) > 0) {
+    client._baseline = sequence;
+  }
+}
+
+/**
+ * Returns the sequence number of the snapshot that the next snapshot for the
+ * indicated client will be a delta against, or 0 if it will be sent in
+ * full.
+ */
+uint32_t SnapshotEncoder::
+get_baseline(int client_id) const {
+  Clients::const_iterator ci = _clients.find(client_id);
+  nassertr(ci != _clients.end(), 0);
+  const Client &client = (*ci).second;
+
+  const SnapshotFrame *baseline = find_frame(client, client._baseline);
+  if (baseline == nullptr ||
+      baseline->_sequence % _history_size == client._next_sequence % _history_size) {
+    return 0;
+  }
+  return baseline->_sequence;
+}
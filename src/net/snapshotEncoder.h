@@ -0,0 +1,96 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file snapshotEncoder.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef SNAPSHOTENCODER_H
+#define SNAPSHOTENCODER_H
+
+#include "pandabase.h"
+#include "snapshotState.h"
+#include "referenceCount.h"
+#include "datagram.h"
+#include "pmap.h"
+#include "pvector.h"
+
+/**
+ * Writes snapshots of the state of a set of entities for a number of
+ * clients, each as a delta against the last snapshot that client has
+ * acknowledged receiving.
+ *
+ * The server keeps the current state of each entity with set_entity(), and
+ * once per tick calls write_snapshot() for each client.  The first snapshot
+ * for a client contains every entity in full.  After the client reports
+ * (through whatever message the application likes) that it has received a
+ * snapshot, and the server passes this on to acknowledge(), later snapshots
+ * only contain the fields that have changed since that one, and the ids of
+ * the entities that have been removed.  Entities that haven't changed at all
+ * are not mentioned.
+ *
+ * A client is only sent deltas against snapshots that are still among the
+ * last history_size snapshots written for it; beyond that, it is sent
+ * everything in full again until it acknowledges a newer one.  The matching
+ * SnapshotDecoder must use at least the same history size.
+ */
+class EXPCL_PANDA_NET SnapshotEncoder : public ReferenceCount {
+PUBLISHED:
+  explicit SnapshotEncoder(const SnapshotLayout *layout, int history_size = 32);
+
+  INLINE const SnapshotLayout *get_layout() const;
+  INLINE int get_history_size() const;
+
+  void set_entity(uint32_t id, const SnapshotState &state);
+  void remove_entity(uint32_t id);
+  void clear_entities();
+  INLINE size_t get_num_entities() const;
+
+  void add_client(int client_id);
+  void remove_client(int client_id);
+  bool has_client(int client_id) const;
+
+  uint32_t write_snapshot(int client_id, Datagram &datagram);
+  void acknowledge(int client_id, uint32_t sequence);
+  uint32_t get_baseline(int client_id) const;
+
+private:
+  class Client {
+  public:
+    pvector<SnapshotFrame> _history;
+    uint32_t _next_sequence;
+    uint32_t _baseline;
+  };
+
+  INLINE const SnapshotFrame *find_frame(const Client &client,
+                                         uint32_t sequence) const;
+
+  CPT(SnapshotLayout) _layout;
+  int _history_size;
+
+  typedef pmap<uint32_t, SnapshotState> Entities;
+  Entities _entities;
+
+  typedef pmap<int, Client> Clients;
+  Clients _clients;
+
+  // Used by write_snapshot(); kept here so that it keeps its memory.
+  class Change {
+  public:
+    uint32_t _id;
+    const uint64_t *_values;
+    const uint64_t *_baseline_values;
+  };
+  pvector<Change> _changes;
+  pvector<uint32_t> _removed;
+};
+
+#include "snapshotEncoder.I"
+
+#endif
@@ -0,0 +1,217 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file snapshotLayout.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "snapshotLayout.h"
+#include "datagramBitWriter.h"
+#include "datagramBitReader.h"
+#include "indent.h"
+
+/**
+ *
+ */
+SnapshotLayout::
+SnapshotLayout() {
+}
+
+/**
+ * Adds a new field of the indicated type, and returns its index.  Use
+ * add_quantized_field() for an FT_quantized field.
+ */
+int SnapshotLayout::
+add_field(const std::string &name, FieldType type) {
+  nassertr(type != FT_quantized, -1);
+
+  Field field;
+  field._name = name;
+  field._type = type;
+  field._min_value = 0.0;
+  field._max_value = 0.0;
+  field._num_bits = 0;
+  switch (type) {
+  case FT_bool:
+    field._num_bits = 1;
+    break;
+
+  case FT_float:
+    field._num_bits = 32;
+    break;
+
+  default:
+    break;
+  }
+
+  _fields.push_back(field);
+  return (int)_fields.size() - 1;
+}
+
+/**
+ * Adds a new floating-point field that holds values in the range [min_value,
+ * max_value] to num_bits bits of precision, and returns its index.
+ */
+int SnapshotLayout::
+add_quantized_field(const std::string &name, double min_value,
+                    double max_value, int num_bits) {
+  nassertr(max_value > min_value, -1);
+  nassertr(num_bits > 0 && num_bits <= 32, -1);
+
+  Field field;
+  field._name = name;
+  field._type = FT_quantized;
+  field._min_value = min_value;
+  field._max_value = max_value;
+  field._num_bits = num_bits;
+  _fields.push_back(field);
+  return (int)_fields.size() - 1;
+}
+
+/**
+ * Returns the index of the field with the indicated name, or -1 if there is
+ * no such field.
+ */
+int SnapshotLayout::
+find_field(const std::string &name) const {
+  for (size_t i = 0; i < _fields.size(); ++i) {
+    if (_fields[i]._name == name) {
+      return (int)i;
+    }
+  }
+  return -1;
+}
+
+/**
+ *
+ */
+void SnapshotLayout::
+output(std::ostream &out) const {
+  out << "SnapshotLayout, " << _fields.size() << " fields";
+}
+
+/**
+ *
+ */
+void SnapshotLayout::
+write(std::ostream &out, int indent_level) const {
+  indent(out, indent_level) << *this << ":\n";
+  for (const Field &field : _fields) {
+    indent(out, indent_level + 2) << field._name << ": " << field._type;
+    if (field._type == FT_quantized) {
+      out << " [" << field._min_value << ", " << field._max_value << "] in "
+          << field._num_bits << " bits";
+    }
+    out << "\n";
+  }
+}
+
+/**
+ * Returns the form in which the indicated floating-point value is stored in
+ * the nth field, which must be an FT_float or FT_quantized field.
+ */
+uint64_t SnapshotLayout::
+encode_float(int n, double value) const {
+  nassertr(n >= 0 && n < (int)_fields.size(), 0);
+  const Field &field = _fields[n];
+  if (field._type == FT_quantized) {
+    return DatagramBitWriter::quantize(value, field._min_value,
+                                       field._max_value, field._num_bits);
+  }
+
+  nassertr(field._type == FT_float, 0);
+  PN_float32 value32 = (PN_float32)value;
+  uint32_t bits;
+  memcpy(&bits, &value32, sizeof(bits));
+  return bits;
+}
+
+/**
+ * The inverse of encode_float().
+ */
+double SnapshotLayout::
+decode_float(int n, uint64_t value) const {
+  nassertr(n >= 0 && n < (int)_fields.size(), 0.0);
+  const Field &field = _fields[n];
+  if (field._type == FT_quantized) {
+    return DatagramBitReader::dequantize((uint32_t)value, field._min_value,
+                                         field._max_value, field._num_bits);
+  }
+
+  nassertr(field._type == FT_float, 0.0);
+  uint32_t bits = (uint32_t)value;
+  PN_float32 value32;
+  memcpy(&value32, &bits, sizeof(value32));
+  return value32;
+}
+
+/**
+ * Writes the stored form of a value of the nth field.
+ */
+void SnapshotLayout::
+write_value(DatagramBitWriter &writer, int n, uint64_t value) const {
+  const Field &field = _fields[n];
+  switch (field._type) {
+  case FT_bool:
+  case FT_float:
+  case FT_quantized:
+    writer.add_bits((uint32_t)value, field._num_bits);
+    break;
+
+  case FT_uint:
+  case FT_int:
+    // Signed values are already stored zigzag-encoded.
+    writer.add_varint(value);
+    break;
+  }
+}
+
+/**
+ * Reads the stored form of a value of the nth field.
+ */
+uint64_t SnapshotLayout::
+read_value(DatagramBitReader &reader, int n) const {
+  const Field &field = _fields[n];
+  switch (field._type) {
+  case FT_bool:
+  case FT_float:
+  case FT_quantized:
+    return reader.get_bits(field._num_bits);
+
+  case FT_uint:
+  case FT_int:
+    return reader.get_varint();
+  }
+  return 0;
+}
+
+/**
+ *
+ */
+std::ostream &
+operator << (std::ostream &out, SnapshotLayout::FieldType type) {
+  switch (type) {
+  case SnapshotLayout::FT_bool:
+    return out << "bool";
+
+  case SnapshotLayout::FT_uint:
+    return out << "uint";
+
+  case SnapshotLayout::FT_int:
+    return out << "int";
+
+  case SnapshotLayout::FT_float:
+    return out << "float";
+
+  case SnapshotLayout::FT_quantized:
+    return out << "quantized";
+  }
+
+  return out << "**invalid SnapshotLayout::FieldType(" << (int)type << ")**";
+}
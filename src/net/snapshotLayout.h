@@ -0,0 +1,97 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file snapshotLayout.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef SNAPSHOTLAYOUT_H
+#define SNAPSHOTLAYOUT_H
+
+#include "pandabase.h"
+#include "referenceCount.h"
+#include "pvector.h"
+#include "numeric_types.h"
+
+class DatagramBitWriter;
+class DatagramBitReader;
+
+/**
+ * Describes the fields that make up the replicated state of one kind of
+ * entity, for SnapshotState, SnapshotEncoder and SnapshotDecoder.  The
+ * server and the client must build the same layout, adding the same fields
+ * in the same order.
+ *
+ * Each field is kept in a SnapshotState in the form it is sent in: a
+ * quantized float field, for instance, holds the quantized integer.  This
+ * way, a change too small to survive quantization is not considered a change
+ * at all.
+ *
+ * All of the fields must be added before any SnapshotState is made with the
+ * layout.
+ */
+class EXPCL_PANDA_NET SnapshotLayout : public ReferenceCount {
+PUBLISHED:
+  enum FieldType {
+    FT_bool,       // A single bit.
+    FT_uint,       // An unsigned integer, sent as a varint.
+    FT_int,        // A signed integer, sent as a zigzag varint.
+    FT_float,      // A full 32-bit float.
+    FT_quantized,  // A float in a fixed range, sent in a fixed number of bits.
+  };
+
+  SnapshotLayout();
+
+  int add_field(const std::string &name, FieldType type);
+  int add_quantized_field(const std::string &name, double min_value,
+                          double max_value, int num_bits);
+
+  INLINE int get_num_fields() const;
+  INLINE const std::string &get_field_name(int n) const;
+  INLINE FieldType get_field_type(int n) const;
+  INLINE double get_field_min(int n) const;
+  INLINE double get_field_max(int n) const;
+  INLINE int get_field_num_bits(int n) const;
+  MAKE_SEQ(get_field_names, get_num_fields, get_field_name);
+
+  int find_field(const std::string &name) const;
+
+  void output(std::ostream &out) const;
+  void write(std::ostream &out, int indent_level = 0) const;
+
+public:
+  uint64_t encode_float(int n, double value) const;
+  double decode_float(int n, uint64_t value) const;
+
+  void write_value(DatagramBitWriter &writer, int n, uint64_t value) const;
+  uint64_t read_value(DatagramBitReader &reader, int n) const;
+
+private:
+  class Field {
+  public:
+    std::string _name;
+    FieldType _type;
+    double _min_value;
+    double _max_value;
+    int _num_bits;
+  };
+  typedef pvector<Field> Fields;
+  Fields _fields;
+};
+
+INLINE std::ostream &operator << (std::ostream &out, const SnapshotLayout &layout) {
+  layout.output(out);
+  return out;
+}
+
+EXPCL_PANDA_NET std::ostream &operator << (std::ostream &out, SnapshotLayout::FieldType type);
+
+#include "snapshotLayout.I"
+
+#endif
@@ -0,0 +1,73 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file snapshotState.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "snapshotState.h"
+
+#include <algorithm>
+
+/**
+ * Creates a state with all of the fields of the layout set to zero.
+ */
+SnapshotState::
+SnapshotState(const SnapshotLayout *layout) :
+  _layout(layout),
+  _values(layout->get_num_fields(), 0)
+{
+}
+
+/**
+ *
+ */
+void SnapshotState::
+output(std::ostream &out) const {
+  out << "SnapshotState(";
+  for (int i = 0; i < (int)_values.size(); ++i) {
+    if (i != 0) {
+      out << ", ";
+    }
+    out << _layout->get_field_name(i) << " = ";
+    switch (_layout->get_field_type(i)) {
+    case SnapshotLayout::FT_bool:
+      out << (get_bool(i) ? "true" : "false");
+      break;
+
+    case SnapshotLayout::FT_uint:
+      out << get_uint(i);
+      break;
+
+    case SnapshotLayout::FT_int:
+      out << get_int(i);
+      break;
+
+    case SnapshotLayout::FT_float:
+    case SnapshotLayout::FT_quantized:
+      out << get_float(i);
+      break;
+    }
+  }
+  out << ")";
+}
+
+/**
+ * Returns the index of the entity with the indicated id, or -1 if it is not
+ * in the frame.
+ */
+int SnapshotFrame::
+find_entity(uint32_t id) const {
+  pvector<uint32_t>::const_iterator it =
+    std::lower_bound(_ids.begin(), _ids.end(), id);
+  if (it != _ids.end() && *it == id) {
+    return (int)(it - _ids.begin());
+  }
+  return -1;
+}
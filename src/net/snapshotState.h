@@ -0,0 +1,86 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file snapshotState.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef SNAPSHOTSTATE_H
+#define SNAPSHOTSTATE_H
+
+#include "pandabase.h"
+#include "snapshotLayout.h"
+#include "datagramBitWriter.h"
+#include "datagramBitReader.h"
+#include "pointerTo.h"
+#include "pvector.h"
+
+/**
+ * The values of all of the fields of one entity, as described by a
+ * SnapshotLayout.  These are given to a SnapshotEncoder on the server, and
+ * retrieved from a SnapshotDecoder on the client.
+ */
+class EXPCL_PANDA_NET SnapshotState {
+PUBLISHED:
+  explicit SnapshotState(const SnapshotLayout *layout);
+
+  INLINE const SnapshotLayout *get_layout() const;
+
+  INLINE void set_bool(int n, bool value);
+  INLINE bool get_bool(int n) const;
+  INLINE void set_uint(int n, uint64_t value);
+  INLINE uint64_t get_uint(int n) const;
+  INLINE void set_int(int n, int64_t value);
+  INLINE int64_t get_int(int n) const;
+  INLINE void set_float(int n, double value);
+  INLINE double get_float(int n) const;
+
+  INLINE bool operator == (const SnapshotState &other) const;
+  INLINE bool operator != (const SnapshotState &other) const;
+
+  void output(std::ostream &out) const;
+
+public:
+  INLINE uint64_t get_value(int n) const;
+  INLINE void set_value(int n, uint64_t value);
+  INLINE const uint64_t *get_values() const;
+  INLINE void set_values(const uint64_t *values);
+
+private:
+  CPT(SnapshotLayout) _layout;
+  pvector<uint64_t> _values;
+};
+
+INLINE std::ostream &operator << (std::ostream &out, const SnapshotState &state) {
+  state.output(out);
+  return out;
+}
+
+/**
+ * The stored field values of a set of entities at one moment, sorted by
+ * entity id.  This is the record that SnapshotEncoder and SnapshotDecoder
+ * keep of each snapshot, to compute later deltas against.
+ */
+class EXPCL_PANDA_NET SnapshotFrame {
+public:
+  INLINE SnapshotFrame();
+
+  INLINE void clear();
+  INLINE size_t get_num_entities() const;
+  INLINE void add_entity(uint32_t id, const uint64_t *values, int num_fields);
+  int find_entity(uint32_t id) const;
+
+  uint32_t _sequence;
+  pvector<uint32_t> _ids;
+  pvector<uint64_t> _values;
+};
+
+#include "snapshotState.I"
+
+#endif
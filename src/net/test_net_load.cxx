@@ -0,0 +1,208 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_net_load.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "pandabase.h"
+
+#include "queuedConnectionManager.h"
+#include "queuedConnectionListener.h"
+#include "queuedConnectionReader.h"
+#include "connectionWriter.h"
+#include "netAddress.h"
+#include "connection.h"
+#include "netDatagram.h"
+#include "datagramIterator.h"
+#include "trueClock.h"
+#include "thread.h"
+#include "pvector.h"
+
+#include <algorithm>
+
+/**
+ * Opens a number of client connections to a server in the same process over
+ * the loopback interface, and keeps a fixed number of messages in flight on
+ * each one.  The server echoes each message back to its sender.  At the end,
+ * reports the number of round trips per second and the round-trip latency
+ * percentiles.
+ *
+ * If ring_size is nonzero, both readers receive into a ring of that many
+ * datagrams, which are read in place with acquire_data(), or copied out with
+ * get_data() if copy_out is nonzero, as existing client code would.
+ */
+int
+main(int argc, char *argv[]) {
+  if (argc > 8) {
+    nout << "test_net_load [num_clients [seconds [reader_threads [window [port [ring_size [copy_out]]]]]]]\n";
+    exit(1);
+  }
+
+  int num_clients = (argc > 1) ? atoi(argv[1]) : 100;
+  double seconds = (argc > 2) ? atof(argv[2]) : 10.0;
+  int num_threads = (argc > 3) ? atoi(argv[3]) : 4;
+  int window = (argc > 4) ? atoi(argv[4]) : 4;
+  int port = (argc > 5) ? atoi(argv[5]) : 21500;
+  int ring_size = (argc > 6) ? atoi(argv[6]) : 0;
+  bool copy_out = (argc > 7) ? (atoi(argv[7]) != 0) : false;
+  bool in_place = (ring_size > 0 && !copy_out);
+
+  QueuedConnectionManager cm;
+  PT(Connection) rendezvous = cm.open_TCP_server_rendezvous(port, num_clients);
+  if (rendezvous.is_null()) {
+    nout << "Cannot grab port " << port << ".\n";
+    exit(1);
+  }
+
+  QueuedConnectionListener listener(&cm, 1);
+  listener.add_connection(rendezvous);
+
+  QueuedConnectionReader server_reader(&cm, num_threads);
+  QueuedConnectionReader client_reader(&cm, num_threads);
+  ConnectionWriter writer(&cm, 0);
+
+  if (ring_size > 0) {
+    server_reader.set_receive_ring_size(ring_size);
+    client_reader.set_receive_ring_size(ring_size);
+  }
+
+  nout << "Using " << (server_reader.get_use_epoll() ? "epoll" : "select()")
+       << " with " << num_threads << " reader threads";
+  if (ring_size > 0) {
+    nout << " and a receive ring of " << ring_size
+         << (copy_out ? ", read with get_data()" : ", read in place");
+  }
+  nout << ".\n";
+
+  // Open the clients.
+  NetAddress host;
+  host.set_host("127.0.0.1", port);
+
+  pvector<PT(Connection)> clients;
+  for (int i = 0; i < num_clients; ++i) {
+    PT(Connection) c = cm.open_TCP_client_connection(host, 5000);
+    if (c.is_null()) {
+      nout << "Could only open " << i << " connections.\n";
+      break;
+    }
+    client_reader.add_connection(c);
+    clients.push_back(c);
+  }
+
+  // Wait for the server to accept them all.
+  int num_accepted = 0;
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double give_up = clock->get_short_time() + 10.0;
+  while (num_accepted < (int)clients.size() && clock->get_short_time() < give_up) {
+    while (listener.new_connection_available()) {
+      PT(Connection) rv;
+      NetAddress address;
+      PT(Connection) new_connection;
+      if (listener.get_new_connection(rv, address, new_connection)) {
+        server_reader.add_connection(new_connection);
+        ++num_accepted;
+      }
+    }
+    Thread::sleep(0.001);
+  }
+  nout << "Opened " << clients.size() << " connections, server accepted "
+       << num_accepted << ".\n";
+
+  pvector<int> in_flight(clients.size(), 0);
+  pvector<double> latencies;
+  int num_sent = 0;
+  int num_received = 0;
+
+  double start = clock->get_short_time();
+  double stop = start + seconds;
+  double now = start;
+
+  while (now < stop) {
+    // Keep each client's window full.
+    for (size_t ci = 0; ci < clients.size(); ++ci) {
+      while (in_flight[ci] < window) {
+        NetDatagram datagram;
+        datagram.add_uint32((uint32_t)ci);
+        datagram.add_float64(clock->get_short_time());
+        if (!writer.send(datagram, clients[ci])) {
+          break;
+        }
+        ++in_flight[ci];
+        ++num_sent;
+      }
+    }
+
+    // The server echoes everything back to the sender.
+    while (server_reader.data_available()) {
+      if (in_place) {
+        const NetDatagram *datagram = server_reader.acquire_data();
+        if (datagram != nullptr) {
+          writer.send(*datagram, datagram->get_connection());
+          server_reader.release_data();
+        }
+      } else {
+        NetDatagram datagram;
+        if (server_reader.get_data(datagram)) {
+          writer.send(datagram, datagram.get_connection());
+        }
+      }
+    }
+
+    // The clients record the round trip.
+    while (client_reader.data_available()) {
+      NetDatagram copy;
+      const NetDatagram *datagram = nullptr;
+      if (in_place) {
+        datagram = client_reader.acquire_data();
+      } else if (client_reader.get_data(copy)) {
+        datagram = &copy;
+      }
+      if (datagram != nullptr) {
+        DatagramIterator scan(*datagram);
+        uint32_t ci = scan.get_uint32();
+        double sent = scan.get_float64();
+        latencies.push_back(clock->get_short_time() - sent);
+        if (ci < in_flight.size()) {
+          --in_flight[ci];
+        }
+        ++num_received;
+        if (in_place) {
+          client_reader.release_data();
+        }
+      }
+    }
+
+    while (cm.reset_connection_available()) {
+      PT(Connection) connection;
+      if (cm.get_reset_connection(connection)) {
+        nout << "Lost connection from " << connection->get_address() << "\n";
+        cm.close_connection(connection);
+      }
+    }
+
+    Thread::consider_yield();
+    now = clock->get_short_time();
+  }
+
+  double elapsed = now - start;
+  nout << "Sent " << num_sent << ", received " << num_received
+       << " messages in " << elapsed << " seconds: "
+       << num_received / elapsed << " round trips/sec.\n";
+
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    size_t n = latencies.size();
+    nout << "Round-trip latency: p50 " << latencies[n / 2] * 1000.0
+         << " ms, p99 " << latencies[std::min(n - 1, n * 99 / 100)] * 1000.0
+         << " ms, max " << latencies[n - 1] * 1000.0 << " ms.\n";
+  }
+
+  return (0);
+}
@@ -0,0 +1,140 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_snapshot.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "pandabase.h"
+
+#include "snapshotEncoder.h"
+#include "snapshotDecoder.h"
+#include "datagram.h"
+#include "datagramIterator.h"
+#include "trueClock.h"
+
+#include <stdlib.h>
+
+/**
+ * Replicates a set of moving entities from an encoder to a decoder for a
+ * number of ticks, with the acknowledgements arriving a few ticks late, and
+ * checks that the decoder always ends up with the same state as the encoder.
+ * Reports the average snapshot size, against the size of sending every
+ * field of every entity in full, and the time spent encoding and decoding.
+ */
+int
+main(int argc, char *argv[]) {
+  if (argc > 4) {
+    nout << "test_snapshot [num_entities [num_ticks [percent_moving]]]\n";
+    exit(1);
+  }
+
+  int num_entities = (argc > 1) ? atoi(argv[1]) : 1000;
+  int num_ticks = (argc > 2) ? atoi(argv[2]) : 600;
+  int percent_moving = (argc > 3) ? atoi(argv[3]) : 10;
+  const int ack_latency = 3;
+
+  PT(SnapshotLayout) layout = new SnapshotLayout;
+  int f_x = layout->add_quantized_field("x", -4096.0, 4096.0, 20);
+  int f_y = layout->add_quantized_field("y", -4096.0, 4096.0, 20);
+  int f_z = layout->add_quantized_field("z", -1024.0, 1024.0, 18);
+  int f_h = layout->add_quantized_field("h", 0.0, 360.0, 10);
+  int f_health = layout->add_field("health", SnapshotLayout::FT_int);
+  int f_visible = layout->add_field("visible", SnapshotLayout::FT_bool);
+  int f_model = layout->add_field("model", SnapshotLayout::FT_uint);
+
+  PT(SnapshotEncoder) encoder = new SnapshotEncoder(layout);
+  PT(SnapshotDecoder) decoder = new SnapshotDecoder(layout);
+  encoder->add_client(0);
+
+  pvector<SnapshotState> states(num_entities, SnapshotState(layout));
+  for (int i = 0; i < num_entities; ++i) {
+    SnapshotState &state = states[i];
+    state.set_float(f_x, (rand() % 8000) - 4000);
+    state.set_float(f_y, (rand() % 8000) - 4000);
+    state.set_float(f_z, (rand() % 200) - 100);
+    state.set_float(f_h, rand() % 360);
+    state.set_int(f_health, 100);
+    state.set_bool(f_visible, true);
+    state.set_uint(f_model, rand() % 50);
+    encoder->set_entity(i, state);
+  }
+
+  // The size of one entity with every field in whole bytes: floats for the
+  // positions and heading, and 32-bit health and model.
+  size_t full_entity_size = 4 * 4 + 4 + 1 + 4 + 4;
+
+  pvector<uint32_t> unacknowledged;
+  size_t total_bytes = 0;
+  double encode_time = 0.0;
+  double decode_time = 0.0;
+  int num_errors = 0;
+  TrueClock *clock = TrueClock::get_global_ptr();
+
+  for (int tick = 0; tick < num_ticks; ++tick) {
+    // Move some of the entities.
+    for (int i = 0; i < num_entities; ++i) {
+      if (rand() % 100 < percent_moving) {
+        SnapshotState &state = states[i];
+        state.set_float(f_x, state.get_float(f_x) + (rand() % 7) - 3);
+        state.set_float(f_y, state.get_float(f_y) + (rand() % 7) - 3);
+        state.set_float(f_h, rand() % 360);
+        if (rand() % 10 == 0) {
+          state.set_int(f_health, state.get_int(f_health) - 1);
+        }
+        encoder->set_entity(i, state);
+      }
+    }
+
+    Datagram datagram;
+    double start = clock->get_short_time();
+    uint32_t sequence = encoder->write_snapshot(0, datagram);
+    encode_time += clock->get_short_time() - start;
+    total_bytes += datagram.get_length();
+
+    DatagramIterator scan(datagram);
+    start = clock->get_short_time();
+    bool okflag = decoder->read_snapshot(scan);
+    decode_time += clock->get_short_time() - start;
+
+    if (!okflag || decoder->get_num_entities() != (size_t)num_entities) {
+      ++num_errors;
+    } else {
+      for (int i = 0; i < num_entities; ++i) {
+        if (decoder->get_entity_state(i) != states[i]) {
+          ++num_errors;
+          break;
+        }
+      }
+    }
+
+    // The client reports each snapshot back a few ticks later.
+    unacknowledged.push_back(sequence);
+    if ((int)unacknowledged.size() > ack_latency) {
+      encoder->acknowledge(0, unacknowledged.front());
+      unacknowledged.erase(unacknowledged.begin());
+    }
+  }
+
+  double average = (double)total_bytes / num_ticks;
+  double full = (double)(full_entity_size * num_entities);
+  nout << num_entities << " entities, " << percent_moving
+       << "% moving per tick, " << num_ticks << " ticks.\n"
+       << "Average snapshot " << average << " bytes, against " << full
+       << " bytes in full (" << 100.0 * average / full << "%).\n"
+       << "Encoding " << encode_time * 1000000.0 / num_ticks
+       << " us, decoding " << decode_time * 1000000.0 / num_ticks
+       << " us per snapshot.\n";
+
+  if (num_errors != 0) {
+    nout << num_errors << " snapshots did not match!\n";
+    return 1;
+  }
+  return 0;
+}
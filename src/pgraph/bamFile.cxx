@@ -23,9 +23,26 @@
 #include "config_express.h"
 #include "virtualFileSystem.h"
 #include "dcast.h"
+#include "configVariableBool.h"
 
 using std::string;
 
+static ConfigVariableBool bam_map_data
+("bam-map-data", false,
+ PRC_DESC("Set this true to memory-map bam files that are opened by filename, "
+          "so that vertex and index arrays may reference their data in place "
+          "within the file instead of copying it.  The file stays mapped for "
+          "as long as any such array refers to it.  This only applies to bam "
+          "files that are stored uncompressed on disk or in a Multifile."));
+
+static ConfigVariableBool bam_write_toc
+("bam-write-toc", false,
+ PRC_DESC("Set this true to append a table of contents to bam files written "
+          "with BamFile, listing where each object is stored in the file.  "
+          "This allows individual objects, such as a single animation, to "
+          "be loaded from the file without reading the rest of it.  Older "
+          "readers ignore the table."));
+
 /**
  *
  */
@@ -55,6 +72,10 @@ open_read(const Filename &bam_filename, bool report_errors) {
     return false;
   }
 
+  if (bam_map_data) {
+    _din.map_file();
+  }
+
   return continue_open_read(bam_filename, report_errors);
 }
 
@@ -247,6 +268,7 @@ close() {
     _reader = nullptr;
   }
   if (_writer != nullptr) {
+    _writer->write_toc();
     delete _writer;
     _writer = nullptr;
   }
@@ -412,5 +434,7 @@ continue_open_write(const string &bam_filename, bool report_errors) {
     return false;
   }
 
+  _writer->set_write_toc(bam_write_toc);
+
   return true;
 }
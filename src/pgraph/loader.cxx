@@ -149,6 +149,18 @@ load_file(const Filename &filename, const LoaderOptions &options) const {
     extension = Filename(this_filename.get_basename_wo_extension()).get_extension();
   }
 #endif  // HAVE_ZLIB
+#ifdef HAVE_ZSTD
+  if (extension == "zst") {
+    compressed = true;
+    extension = Filename(this_filename.get_basename_wo_extension()).get_extension();
+  }
+#endif  // HAVE_ZSTD
+#ifdef HAVE_LZ4
+  if (extension == "lz4") {
+    compressed = true;
+    extension = Filename(this_filename.get_basename_wo_extension()).get_extension();
+  }
+#endif  // HAVE_LZ4
 
   if (extension.empty()) {
     if (report_errors) {
@@ -363,7 +375,8 @@ try_load_file(const Filename &pathname, const LoaderOptions &options,
     // Do we have the same filename, but with .bam appended to the end?
     string extension = pathname.get_extension();
     Filename pathname_bam = pathname;
-    if (extension == "pz" || extension == "gz") {
+    if (extension == "pz" || extension == "gz" ||
+        extension == "zst" || extension == "lz4") {
       // Strip .pz/.gz, so that model.egg.pz -> model.egg.bam
       extension = pathname_bam.get_extension();
       pathname_bam = pathname_bam.get_fullpath_wo_extension();
@@ -432,6 +445,18 @@ save_file(const Filename &filename, const LoaderOptions &options,
     extension = Filename(this_filename.get_basename_wo_extension()).get_extension();
   }
 #endif  // HAVE_ZLIB
+#ifdef HAVE_ZSTD
+  if (extension == "zst") {
+    compressed = true;
+    extension = Filename(this_filename.get_basename_wo_extension()).get_extension();
+  }
+#endif  // HAVE_ZSTD
+#ifdef HAVE_LZ4
+  if (extension == "lz4") {
+    compressed = true;
+    extension = Filename(this_filename.get_basename_wo_extension()).get_extension();
+  }
+#endif  // HAVE_LZ4
 
   if (extension.empty()) {
     if (report_errors) {
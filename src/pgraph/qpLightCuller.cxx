@@ -14,11 +14,17 @@
 #include "qpLightCuller.h"
 #include "pStatCollector.h"
 #include "pStatTimer.h"
+#include "jobSystem.h"
+#include "patomic.h"
+#include <algorithm>
 
 static PStatCollector bin_lights_pcollector("LightCuller:BinLights");
+static PStatCollector bin_spheres_pcollector("LightCuller:BinSpheres");
 
-// If this is changed, also update $DMODELS/src/shadersnew/common_clustered_lighting.inc.glsl!
-#define MAX_LIGHTS_PER_CLUSTER 64
+// Number of sector tree leaves that are binned by a single job.
+static constexpr int bin_leaves_per_job = 16;
+
+#define MAX_LIGHTS_PER_CLUSTER qpLightCuller::max_lights_per_cluster
 
 /**
  *
@@ -60,6 +66,8 @@ initialize() {
   _sector_tree->_div_mins.set(0, 0, 0);
   _sector_tree->_div_maxs.set(_x_div, _y_div, _z_div);
   tree_static_subdiv(_sector_tree);
+  _leaves.clear();
+  r_collect_leaves(_sector_tree);
 
   for (int i = 0; i < num_buffers; ++i) {
     _light_list_buffers[i] = new Texture("light-list-buffer");
@@ -78,10 +86,6 @@ void qpLightCuller::
 bin_lights(const NodePath &camera, const Lens *lens) {
   PStatTimer timer(bin_lights_pcollector);
 
-  if (_light_mgr == nullptr) {
-    return;
-  }
-
   _lens = lens;
 
   if (_sector_tree == nullptr) {
@@ -94,6 +98,12 @@ bin_lights(const NodePath &camera, const Lens *lens) {
 
   _lens = nullptr;
 
+  // The sector bounds are kept up-to-date even without a light manager, so
+  // bin_spheres() can still be used to cluster lights on the CPU.
+  if (_light_mgr == nullptr) {
+    return;
+  }
+
   if (_last_dynamic_light_count == 0 && _light_mgr->get_num_dynamic_lights() == 0) {
     // Light count remains at 0, so we don't have to cull anything!
     return;
@@ -101,10 +111,6 @@ bin_lights(const NodePath &camera, const Lens *lens) {
 
   _last_dynamic_light_count = _light_mgr->get_num_dynamic_lights();
 
-  for (Sector &s : _sectors) {
-    s._num_lights = 0;
-  }
-
   const LMatrix4 *world_to_view = camera.get_net_transform()->get_inverse_mat();
   if (world_to_view == nullptr) {
     return;
@@ -120,26 +126,133 @@ bin_lights(const NodePath &camera, const Lens *lens) {
   int16_t *light_list_data = (int16_t *)light_list_img.p();
   memset(light_list_data, 0, light_list_img.size());
 
-  // Cull each static light.
-  for (int i = 0; i < _light_mgr->get_num_static_lights(); ++i) {
+  // Move all of the lights into view-space up front.  Static lights come
+  // first, followed by dynamic lights, so the light order within each sector
+  // matches the order they were binned in.
+  int num_static = _light_mgr->get_num_static_lights();
+  int num_dynamic = _light_mgr->get_num_dynamic_lights();
+  _bin_spheres.resize(num_static + num_dynamic);
+
+  for (int i = 0; i < num_static; ++i) {
     qpLight *light = _light_mgr->get_static_light(i);
     PN_stdfloat radius = light->get_cull_radius();
-    LPoint3 pos = world_to_view->xform_point(light->get_pos());
-    r_bin_light(_sector_tree, pos, radius * radius, i, false, light_list_data);
+    _bin_spheres[i]._center = world_to_view->xform_point(light->get_pos());
+    _bin_spheres[i]._radius_sqr = radius * radius;
   }
 
-  // Cull each dynamic light.
-  for (int i = 0; i < _light_mgr->get_num_dynamic_lights(); ++i) {
+  for (int i = 0; i < num_dynamic; ++i) {
     qpLight *light = _light_mgr->get_dynamic_light(i);
     PN_stdfloat radius = light->get_cull_radius();
-    LPoint3 pos = world_to_view->xform_point(light->get_pos());
-    r_bin_light(_sector_tree, pos, radius * radius, i, true, light_list_data);
+    _bin_spheres[num_static + i]._center = world_to_view->xform_point(light->get_pos());
+    _bin_spheres[num_static + i]._radius_sqr = radius * radius;
   }
 
+  do_bin_spheres(_bin_spheres.data(), (int)_bin_spheres.size(), MAX_LIGHTS_PER_CLUSTER,
+    [light_list_data, num_static] (int sector, int slot, int sphere) {
+      // A negative index indicates a dynamic light, and a positive index
+      // indicates a static light.  0 terminates the list.
+      int index;
+      if (sphere >= num_static) {
+        index = ~(sphere - num_static);
+      } else {
+        index = sphere + 1;
+      }
+      assert(index < INT16_MAX && index >= INT16_MIN);
+      light_list_data[sector * MAX_LIGHTS_PER_CLUSTER + slot] = index;
+    },
+    [this] (int sector, int count, bool overflowed) {
+      _sectors[sector]._num_lights = count;
+    });
+
   ++_buffer_index;
   _buffer_index %= num_buffers;
 }
 
+/**
+ * Bins an arbitrary set of world-space spheres into the view frustum sectors
+ * of the last lens given to bin_lights().  Each sphere is specified as a
+ * center point in the XYZ components and a radius in the W component.
+ *
+ * This can be used to cluster lights on the CPU for per-object light
+ * selection, using the same sectors that the GPU uses for shading.  The
+ * result is stored in the indicated SectorBins object, which is reused to
+ * avoid reallocating the bins each frame.
+ */
+void qpLightCuller::
+bin_spheres(const LMatrix4 &world_to_view, const LVecBase4 *spheres,
+            int num_spheres, SectorBins &bins, int max_per_sector) const {
+  PStatTimer timer(bin_spheres_pcollector);
+
+  bins._max_per_sector = max_per_sector;
+  bins._counts.resize(_sectors.size());
+  bins._items.resize(_sectors.size() * max_per_sector);
+
+  if (_sector_tree == nullptr || num_spheres == 0) {
+    std::fill(bins._counts.begin(), bins._counts.end(), 0);
+    return;
+  }
+
+  pvector<BinSphere> view_spheres;
+  view_spheres.resize(num_spheres);
+  for (int i = 0; i < num_spheres; ++i) {
+    view_spheres[i]._center = world_to_view.xform_point(spheres[i].get_xyz());
+    view_spheres[i]._radius_sqr = spheres[i][3] * spheres[i][3];
+  }
+
+  int *items = bins._items.data();
+  int *counts = bins._counts.data();
+  patomic<int> num_overflowed(0);
+  do_bin_spheres(view_spheres.data(), num_spheres, max_per_sector,
+    [items, max_per_sector] (int sector, int slot, int sphere) {
+      items[sector * max_per_sector + slot] = sphere;
+    },
+    [counts, &num_overflowed] (int sector, int count, bool overflowed) {
+      counts[sector] = count;
+      if (overflowed) {
+        num_overflowed.fetch_add(1);
+      }
+    });
+  bins._num_overflowed = num_overflowed.load();
+}
+
+/**
+ * Fills the indicated vector with the indices of all sectors that overlap
+ * the given view-space bounding box.
+ */
+void qpLightCuller::
+collect_sectors(const LPoint3 &view_mins, const LPoint3 &view_maxs, vector_int &sectors) const {
+  if (_sector_tree == nullptr) {
+    return;
+  }
+  r_collect_sectors(_sector_tree, view_mins, view_maxs, sectors);
+}
+
+/**
+ * Returns true if the given view-space bounding box lies entirely within the
+ * view frustum that the sectors divide up, so that the sectors returned by
+ * collect_sectors() cover all of it.
+ */
+bool qpLightCuller::
+contains_box(const LPoint3 &view_mins, const LPoint3 &view_maxs) const {
+  if (_sector_tree == nullptr) {
+    return false;
+  }
+
+  for (int i = 0; i < 6; ++i) {
+    // Only the corner of the box furthest along the outward normal of the
+    // plane needs to be tested.
+    const LPlane &plane = _frustum_planes[i];
+    LPoint3 corner(plane[0] > 0.0f ? view_maxs[0] : view_mins[0],
+                   plane[1] > 0.0f ? view_maxs[1] : view_mins[1],
+                   plane[2] > 0.0f ? view_maxs[2] : view_mins[2]);
+    if (plane.dist_to_plane(corner) > 0.0f) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
 /**
  *
  */
@@ -200,6 +313,122 @@ r_bin_light(TreeNode *node, const LPoint3 &center, PN_stdfloat radius_sqr, int l
 }
 
 
+/**
+ * Bins the indicated view-space spheres into the frustum sectors.  The work
+ * is split across the job system by sector tree leaf; each sector lives in
+ * exactly one leaf, so no two jobs ever write to the same sector.
+ *
+ * store(sector, slot, sphere) is called for each sphere that lands in a
+ * sector, up to max_per_sector spheres, and count(sector, n, overflowed) is
+ * called once per sector with the final count.  If more than max_per_sector
+ * spheres overlap a sector, the ones whose centers are nearest to the sector
+ * are kept.  Spheres are stored in increasing index order within each sector.
+ */
+template<class StoreFunc, class CountFunc>
+void qpLightCuller::
+do_bin_spheres(const BinSphere *spheres, int num_spheres, int max_per_sector,
+               StoreFunc store, CountFunc count) const {
+  int num_leaves = (int)_leaves.size();
+  int num_jobs = (num_leaves + bin_leaves_per_job - 1) / bin_leaves_per_job;
+
+  JobSystem *jsys = JobSystem::get_global_ptr();
+  jsys->parallel_process(num_jobs,
+    [&] (int job) {
+      // Spheres that overlap the current leaf.  Only these need to be tested
+      // against the individual sectors of the leaf.
+      vector_int leaf_spheres;
+      leaf_spheres.reserve(num_spheres);
+      vector_int sector_spheres;
+      sector_spheres.reserve(num_spheres);
+
+      int first = job * bin_leaves_per_job;
+      int last = std::min(first + bin_leaves_per_job, num_leaves);
+      for (int l = first; l < last; ++l) {
+        const TreeNode *leaf = _leaves[l];
+
+        leaf_spheres.clear();
+        for (int i = 0; i < num_spheres; ++i) {
+          if (qp_aabb_sphere_overlap(leaf->_mins, leaf->_maxs, spheres[i]._center, spheres[i]._radius_sqr)) {
+            leaf_spheres.push_back(i);
+          }
+        }
+
+        for (int sector : leaf->_sectors) {
+          const Sector *s = &_sectors[sector];
+          sector_spheres.clear();
+          for (int i : leaf_spheres) {
+            if (qp_aabb_sphere_overlap(s->_mins, s->_maxs, spheres[i]._center, spheres[i]._radius_sqr)) {
+              sector_spheres.push_back(i);
+            }
+          }
+
+          bool overflowed = false;
+          if ((int)sector_spheres.size() > max_per_sector) {
+            // Too many spheres reach this sector.  Keep the ones whose
+            // centers are nearest to the sector, rather than whichever
+            // happen to come first in the array.
+            overflowed = true;
+            LPoint3 center = (s->_mins + s->_maxs) * 0.5f;
+            std::nth_element(sector_spheres.begin(), sector_spheres.begin() + max_per_sector,
+                             sector_spheres.end(),
+              [spheres, &center] (int a, int b) {
+                return (spheres[a]._center - center).length_squared() <
+                       (spheres[b]._center - center).length_squared();
+              });
+            sector_spheres.resize(max_per_sector);
+            std::sort(sector_spheres.begin(), sector_spheres.end());
+          }
+
+          int num_in_sector = (int)sector_spheres.size();
+          for (int slot = 0; slot < num_in_sector; ++slot) {
+            store(sector, slot, sector_spheres[slot]);
+          }
+          count(sector, num_in_sector, overflowed);
+        }
+      }
+    });
+}
+
+/**
+ * Records the leaves of the sector tree into _leaves.
+ */
+void qpLightCuller::
+r_collect_leaves(TreeNode *node) {
+  if (node->_children[0].is_null()) {
+    _leaves.push_back(node);
+    return;
+  }
+
+  for (int i = 0; i < 8; ++i) {
+    r_collect_leaves(node->_children[i]);
+  }
+}
+
+/**
+ *
+ */
+void qpLightCuller::
+r_collect_sectors(const TreeNode *node, const LPoint3 &view_mins,
+                  const LPoint3 &view_maxs, vector_int &sectors) const {
+  if (!qp_box_overlap(node->_mins, node->_maxs, view_mins, view_maxs)) {
+    return;
+  }
+
+  if (node->_children[0].is_null()) {
+    for (int i : node->_sectors) {
+      const Sector *s = &_sectors[i];
+      if (qp_box_overlap(s->_mins, s->_maxs, view_mins, view_maxs)) {
+        sectors.push_back(i);
+      }
+    }
+    return;
+  }
+
+  for (int i = 0; i < 8; ++i) {
+    r_collect_sectors(node->_children[i], view_mins, view_maxs, sectors);
+  }
+}
+
 /**
  *
  */
@@ -239,6 +468,35 @@ recompute_sector_bounds() {
       }
     }
   }
+
+  // Remember the planes bounding the whole frustum, for contains_box().  The
+  // corners are numbered with bit 0 for X, bit 1 for Y and bit 2 for depth.
+  LPoint3 corners[8];
+  LPoint3 center(0.0f);
+  for (int i = 0; i < 8; ++i) {
+    corners[i] = lens_extrude_depth_linear(LPoint3((i & 1) ? 1.0f : -1.0f,
+                                                   (i & 2) ? 1.0f : -1.0f,
+                                                   (i & 4) ? 1.0f : -1.0f));
+    center += corners[i];
+  }
+  center /= 8.0f;
+
+  static const int faces[6][3] = {
+    { 0, 2, 4 }, { 1, 3, 5 },
+    { 0, 1, 4 }, { 2, 3, 6 },
+    { 0, 1, 2 }, { 4, 5, 6 },
+  };
+  for (int i = 0; i < 6; ++i) {
+    const LPoint3 &a = corners[faces[i][0]];
+    const LPoint3 &b = corners[faces[i][1]];
+    const LPoint3 &c = corners[faces[i][2]];
+    // Make the normals point out of the frustum.
+    LPlane plane(a, b, c);
+    if (plane.dist_to_plane(center) > 0.0f) {
+      plane = LPlane(a, c, b);
+    }
+    _frustum_planes[i] = plane;
+  }
 }
 
 /**
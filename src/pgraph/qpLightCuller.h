@@ -20,6 +20,7 @@
 #include "texture.h"
 #include "lens.h"
 #include "luse.h"
+#include "plane.h"
 #include "vector_int.h"
 #include "pvector.h"
 #include "nodePath.h"
@@ -83,6 +84,32 @@ PUBLISHED:
   };
   typedef pvector<Sector> Sectors;
 
+public:
+  // If this is changed, also update $DMODELS/src/shadersnew/common_clustered_lighting.inc.glsl!
+  static constexpr int max_lights_per_cluster = 64;
+
+  /**
+   * The result of binning an arbitrary set of spheres into the view frustum
+   * sectors on the CPU.  Each sector stores up to _max_per_sector indices
+   * into the array of spheres that was binned.
+   */
+  class SectorBins {
+  public:
+    INLINE int get_num_items(int sector) const { return _counts[sector]; }
+    INLINE const int *get_items(int sector) const { return &_items[sector * _max_per_sector]; }
+
+  public:
+    vector_int _counts;
+    vector_int _items;
+    int _max_per_sector = 0;
+
+    // The number of sectors that overlapped more than _max_per_sector
+    // spheres.  Those sectors keep the spheres nearest to them and leave the
+    // rest out.
+    int _num_overflowed = 0;
+  };
+
+PUBLISHED:
   qpLightCuller(qpLightManager *light_mgr);
 
   void initialize();
@@ -102,7 +129,15 @@ PUBLISHED:
   void r_bin_light(TreeNode *node, const LPoint3 &center, PN_stdfloat radius_sqr,
                    int light_index, bool is_dynamic, int16_t *light_list);
 
+public:
+  void bin_spheres(const LMatrix4 &world_to_view, const LVecBase4 *spheres,
+                   int num_spheres, SectorBins &bins,
+                   int max_per_sector = max_lights_per_cluster) const;
+  void collect_sectors(const LPoint3 &view_mins, const LPoint3 &view_maxs,
+                       vector_int &sectors) const;
+  bool contains_box(const LPoint3 &view_mins, const LPoint3 &view_maxs) const;
 
+PUBLISHED:
   INLINE void set_frustum_div(int x, int y, int z);
   INLINE LVecBase3i get_frustum_div() const { return LVecBase3i(_x_div, _y_div, _z_div); }
 
@@ -114,6 +149,20 @@ PUBLISHED:
   INLINE Texture *get_light_list_buffer() const;
   INLINE qpLightManager *get_light_mgr() const { return _light_mgr; }
 
+private:
+  class BinSphere {
+  public:
+    LPoint3 _center;
+    PN_stdfloat _radius_sqr;
+  };
+
+  template<class StoreFunc, class CountFunc>
+  void do_bin_spheres(const BinSphere *spheres, int num_spheres, int max_per_sector,
+                      StoreFunc store, CountFunc count) const;
+  void r_collect_leaves(TreeNode *node);
+  void r_collect_sectors(const TreeNode *node, const LPoint3 &view_mins,
+                         const LPoint3 &view_maxs, vector_int &sectors) const;
+
 private:
   // Buffer texture containing a list of indices into the qpLightManager's
   // light buffers for each view frustum sector.  Each sector stores a max
@@ -149,6 +198,16 @@ private:
   PT(TreeNode) _sector_tree;
   Sectors _sectors;
 
+  // The planes bounding the frustum that the sectors divide up, with their
+  // normals pointing outward.
+  LPlane _frustum_planes[6];
+
+  // The leaves of the sector tree.  Binning is done in parallel over these,
+  // since each sector belongs to exactly one leaf.
+  typedef pvector<TreeNode *> Leaves;
+  Leaves _leaves;
+  pvector<BinSphere> _bin_spheres;
+
   PT(qpLightManager) _light_mgr;
 
   int _last_dynamic_light_count;
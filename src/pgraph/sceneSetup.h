@@ -25,6 +25,7 @@
 #include "geometricBoundingVolume.h"
 
 class DisplayRegion;
+class qpLightCuller;
 
 /**
  * This object holds the camera position, etc., and other general setup
@@ -38,6 +39,9 @@ PUBLISHED:
   INLINE void set_display_region(DisplayRegion *display_region);
   INLINE DisplayRegion *get_display_region() const;
 
+  INLINE void set_light_culler(qpLightCuller *light_culler);
+  INLINE qpLightCuller *get_light_culler() const;
+
   INLINE void set_viewport_size(int width, int height);
   INLINE int get_viewport_width() const;
   INLINE int get_viewport_height() const;
@@ -80,6 +84,7 @@ PUBLISHED:
 
 private:
   DisplayRegion *_display_region;
+  qpLightCuller *_light_culler;
   int _viewport_width;
   int _viewport_height;
   NodePath _scene_root;
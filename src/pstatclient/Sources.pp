@@ -10,34 +10,51 @@
   #define BUILDING_DLL BUILDING_PANDA_PSTATCLIENT
 
   #define SOURCES \
-     config_pstatclient.h pStatClient.I pStatClient.h \
+     config_pstatclient.h pStatCaptureFile.h \
+     pStatCaptureReader.I pStatCaptureReader.h \
+     pStatCaptureWriter.I pStatCaptureWriter.h \
+     pStatClient.I pStatClient.h \
      pStatClientImpl.I pStatClientImpl.h \
      pStatClientVersion.I  \
      pStatClientVersion.h pStatClientControlMessage.h  \
      pStatCollector.I pStatCollector.h pStatCollectorDef.h  \
      pStatCollectorForward.I pStatCollectorForward.h \
+     pStatAccumulator.I pStatAccumulator.h \
+     pStatCounter.I pStatCounter.h \
+     pStatCounterTimer.I pStatCounterTimer.h \
+     pStatHistogram.I pStatHistogram.h \
      pStatFrameData.I pStatFrameData.h pStatProperties.h  \
      pStatServerControlMessage.h pStatThread.I pStatThread.h  \
      pStatTimer.I pStatTimer.h
 
   #define COMPOSITE_SOURCES  \
-     config_pstatclient.cxx pStatClient.cxx pStatClientImpl.cxx \
+     config_pstatclient.cxx pStatCaptureFile.cxx \
+     pStatCaptureReader.cxx pStatCaptureWriter.cxx \
+     pStatClient.cxx pStatClientImpl.cxx \
      pStatClientVersion.cxx  \
      pStatClientControlMessage.cxx \
      pStatCollector.cxx \
      pStatCollectorDef.cxx  \
      pStatCollectorForward.cxx \
+     pStatAccumulator.cxx pStatCounter.cxx pStatHistogram.cxx \
      pStatFrameData.cxx pStatProperties.cxx  \
      pStatServerControlMessage.cxx \
      pStatThread.cxx
 
   #define INSTALL_HEADERS \
-    config_pstatclient.h pStatClient.I pStatClient.h \
+    config_pstatclient.h pStatCaptureFile.h \
+    pStatCaptureReader.I pStatCaptureReader.h \
+    pStatCaptureWriter.I pStatCaptureWriter.h \
+    pStatClient.I pStatClient.h \
     pStatClientImpl.I pStatClientImpl.h \
     pStatClientVersion.I pStatClientVersion.h \
     pStatClientControlMessage.h pStatCollector.I pStatCollector.h \
     pStatCollectorDef.h \
     pStatCollectorForward.I pStatCollectorForward.h \
+    pStatAccumulator.I pStatAccumulator.h \
+    pStatCounter.I pStatCounter.h \
+    pStatCounterTimer.I pStatCounterTimer.h \
+    pStatHistogram.I pStatHistogram.h \
     pStatFrameData.I pStatFrameData.h \
     pStatProperties.h \
     pStatServerControlMessage.h pStatThread.I pStatThread.h \
@@ -60,3 +77,14 @@
     test_client.cxx
 
 #end test_bin_target
+
+#begin bin_target
+  #define LOCAL_LIBS \
+    pstatclient
+
+  #define TARGET pstats_capture_convert
+
+  #define SOURCES \
+    pstats_capture_convert.cxx
+
+#end bin_target
@@ -98,6 +98,27 @@ ConfigVariableBool pstats_python_profiler
           "somewhat, and requires a recent version of the PStats server, so "
           "it is not enabled by default."));
 
+ConfigVariableFilename pstats_capture_file
+("pstats-capture-file", "",
+ PRC_DESC("If this is set, the first call to PStatClient::main_tick() starts "
+          "capturing PStats data to the named file instead of sending it to "
+          "a PStats server.  This is useful on hosts that can't reach a "
+          "server.  Use pstats_capture_convert to turn the file into a "
+          "Chrome trace and a per-collector summary."));
+
+ConfigVariableInt pstats_capture_frames
+("pstats-capture-frames", 0,
+ PRC_DESC("The number of main-thread frames to capture to pstats-capture-file "
+          "before the capture stops by itself.  Set this to 0 to capture "
+          "until PStatClient::disconnect() is called."));
+
+ConfigVariableInt pstats_counter_sample_rate
+("pstats-counter-sample-rate", 1,
+ PRC_DESC("The default number of timed scopes of a PStatCounter for each one "
+          "that is actually measured; the measured time is scaled up by this "
+          "factor.  Raise this to reduce the cost of timing very short, very "
+          "frequent operations.  It is rounded down to a power of two."));
+
 // The rest are different in that they directly control the server, not the
 // client.
 ConfigVariableBool pstats_scroll_mode
@@ -22,6 +22,7 @@
 #include "configVariableInt.h"
 #include "configVariableDouble.h"
 #include "configVariableBool.h"
+#include "configVariableFilename.h"
 
 // Configure variables for pstats package.
 
@@ -40,6 +41,9 @@ extern EXPCL_PANDA_PSTATCLIENT ConfigVariableDouble pstats_target_frame_rate;
 extern EXPCL_PANDA_PSTATCLIENT ConfigVariableBool pstats_gpu_timing;
 extern EXPCL_PANDA_PSTATCLIENT ConfigVariableBool pstats_thread_profiling;
 extern EXPCL_PANDA_PSTATCLIENT ConfigVariableBool pstats_python_profiler;
+extern EXPCL_PANDA_PSTATCLIENT ConfigVariableFilename pstats_capture_file;
+extern EXPCL_PANDA_PSTATCLIENT ConfigVariableInt pstats_capture_frames;
+extern EXPCL_PANDA_PSTATCLIENT ConfigVariableInt pstats_counter_sample_rate;
 
 extern EXPCL_PANDA_PSTATCLIENT ConfigVariableBool pstats_scroll_mode;
 extern EXPCL_PANDA_PSTATCLIENT ConfigVariableDouble pstats_history;
@@ -1,5 +1,8 @@
 
 #include "config_pstatclient.cxx"
+#include "pStatCaptureFile.cxx"
+#include "pStatCaptureReader.cxx"
+#include "pStatCaptureWriter.cxx"
 #include "pStatClient.cxx"
 #include "pStatClientImpl.cxx"
 #include "pStatClientVersion.cxx"
@@ -1,6 +1,9 @@
 
 #include "pStatCollectorDef.cxx"
 #include "pStatCollectorForward.cxx"
+#include "pStatAccumulator.cxx"
+#include "pStatCounter.cxx"
+#include "pStatHistogram.cxx"
 #include "pStatFrameData.cxx"
 #include "pStatProperties.cxx"
 #include "pStatServerControlMessage.cxx"
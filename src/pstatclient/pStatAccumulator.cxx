@@ -0,0 +1,185 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatAccumulator.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "pStatAccumulator.h"
+
+#ifdef DO_PSTATS
+
+#include "pStatClient.h"
+#include "trueClock.h"
+#include "reMutexHolder.h"
+
+#include <algorithm>
+
+patomic<bool> PStatAccumulator::_enabled(false);
+uint64_t PStatAccumulator::_calibrate_cycles = 0;
+double PStatAccumulator::_calibrate_time = 0.0;
+double PStatAccumulator::_seconds_per_cycle = 0.0;
+
+/**
+ * Creates an accumulator that keeps num_values values per thread, and reports
+ * them on the collector with the indicated name (and any children the
+ * subclass creates).
+ */
+PStatAccumulator::
+PStatAccumulator(const std::string &name, int num_values) :
+  _collector(name),
+  _num_values(num_values),
+  // Round up to a multiple of eight values, so that different threads'
+  // values don't share a cache line.
+  _stride((num_values + 7) & ~7),
+  _deltas(num_values, 0)
+{
+  for (int i = 0; i < max_pages; ++i) {
+    _pages[i].store(nullptr, std::memory_order_relaxed);
+  }
+
+  PStatClient *client = PStatClient::get_global_pstats();
+  ReMutexHolder holder(client->_lock);
+  client->_accumulators.push_back(this);
+}
+
+/**
+ *
+ */
+PStatAccumulator::
+~PStatAccumulator() {
+  PStatClient *client = PStatClient::get_global_pstats();
+  {
+    ReMutexHolder holder(client->_lock);
+    pvector<PStatAccumulator *> &accumulators = client->_accumulators;
+    accumulators.erase(std::remove(accumulators.begin(), accumulators.end(), this),
+                       accumulators.end());
+  }
+
+  for (int i = 0; i < max_pages; ++i) {
+    delete _pages[i].load(std::memory_order_relaxed);
+  }
+}
+
+/**
+ * Returns the number of seconds per unit returned by get_cycles().  This is
+ * calibrated against the TrueClock over the whole time since it was first
+ * called, so it becomes more accurate as the program runs.  Returns 0 for
+ * the first few frames, until there is enough time to measure.
+ *
+ * This is called while flushing, with the client lock held.
+ */
+double PStatAccumulator::
+get_seconds_per_cycle() {
+  double now = TrueClock::get_global_ptr()->get_short_time();
+  uint64_t cycles = get_cycles();
+
+  if (_calibrate_time == 0.0) {
+    _calibrate_time = now;
+    _calibrate_cycles = cycles;
+
+  } else if (now - _calibrate_time >= 0.05 && cycles > _calibrate_cycles) {
+    _seconds_per_cycle = (now - _calibrate_time) / (double)(cycles - _calibrate_cycles);
+  }
+
+  return _seconds_per_cycle;
+}
+
+/**
+ * The slow path of get_values(), called the first time a thread touches this
+ * accumulator.  Registers the thread with PStats if necessary, and allocates
+ * the page that holds its values.
+ */
+patomic<uint64_t> *PStatAccumulator::
+make_values() {
+  PStatClient *client = PStatClient::get_global_pstats();
+  int index = client->get_current_thread().get_index();
+  if (index < 0 || index >= max_pages * page_size) {
+    return nullptr;
+  }
+
+  ReMutexHolder holder(client->_lock);
+  patomic<Page *> &page_ptr = _pages[index >> page_bits];
+  Page *page = page_ptr.load(std::memory_order_relaxed);
+  if (page == nullptr) {
+    page = new Page(_stride, _num_values);
+    page_ptr.store(page, std::memory_order_release);
+  }
+  return page->_values + (index & page_mask) * _stride;
+}
+
+/**
+ * Reports the values the indicated thread accumulated since the last call.
+ * Called by PStatClientImpl at the end of each of the thread's frames, with
+ * the client lock held.
+ */
+void PStatAccumulator::
+flush(PStatClient *client, int thread_index) {
+  if (thread_index < 0 || thread_index >= max_pages * page_size) {
+    return;
+  }
+  Page *page = _pages[thread_index >> page_bits].load(std::memory_order_acquire);
+  if (page == nullptr) {
+    return;
+  }
+
+  int slot = thread_index & page_mask;
+  patomic<uint64_t> *values = page->_values + slot * _stride;
+  uint64_t *last = page->_last + slot * _num_values;
+
+  bool any = false;
+  for (int i = 0; i < _num_values; ++i) {
+    uint64_t value = values[i].load(std::memory_order_relaxed);
+    _deltas[i] = value - last[i];
+    last[i] = value;
+    any = any || (_deltas[i] != 0);
+  }
+
+  // Once a thread has reported something, keep reporting it every frame, so
+  // that the level drops back to zero in frames where nothing happened.
+  if (any || page->_active[slot]) {
+    page->_active[slot] = true;
+    report(client, thread_index, _deltas.data());
+  }
+}
+
+/**
+ * Called by the global PStatClient when it connects or disconnects.  While
+ * disabled, the accumulators don't record anything.
+ */
+void PStatAccumulator::
+set_enabled(bool enabled) {
+  _enabled.store(enabled, std::memory_order_relaxed);
+}
+
+/**
+ *
+ */
+PStatAccumulator::Page::
+Page(int stride, int num_values) :
+  _values(new patomic<uint64_t>[page_size * stride]),
+  _last(new uint64_t[page_size * num_values])
+{
+  for (int i = 0; i < page_size * stride; ++i) {
+    _values[i].store(0, std::memory_order_relaxed);
+  }
+  std::fill(_last, _last + page_size * num_values, 0);
+  std::fill(_active, _active + page_size, false);
+}
+
+/**
+ *
+ */
+PStatAccumulator::Page::
+~Page() {
+  delete[] _values;
+  delete[] _last;
+}
+
+#endif  // DO_PSTATS
@@ -0,0 +1,126 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatAccumulator.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef PSTATACCUMULATOR_H
+#define PSTATACCUMULATOR_H
+
+#include "pandabase.h"
+
+#include "pStatCollector.h"
+#include "patomic.h"
+#include "thread.h"
+#include "pvector.h"
+
+// For __rdtsc
+#if defined(__i386) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#elif defined(__GNUC__) && !defined(__clang__)
+#include <x86intrin.h>
+#endif
+#else
+#include <chrono>
+#endif
+
+/**
+ * The base class of PStatCounter and PStatHistogram, which are cheaper than
+ * a PStatCollector for measuring things that happen many times per frame.
+ *
+ * Each thread adds to its own private set of values, without taking any
+ * locks or making any atomic read-modify-write operations.  Once per frame,
+ * when the thread's frame ends, the values accumulated during the frame are
+ * reported as levels on ordinary collectors, so they show up in the usual
+ * PStats views.
+ *
+ * An accumulator reports only to the global PStatClient.
+ */
+class EXPCL_PANDA_PSTATCLIENT PStatAccumulator {
+#ifdef DO_PSTATS
+protected:
+  PStatAccumulator(const std::string &name, int num_values);
+  virtual ~PStatAccumulator();
+
+public:
+  INLINE const PStatCollector &get_collector() const;
+
+  INLINE static uint64_t get_cycles();
+
+protected:
+  INLINE patomic<uint64_t> *get_values();
+  INLINE static void add_value(patomic<uint64_t> &value, uint64_t increment);
+
+  static double get_seconds_per_cycle();
+  virtual void report(PStatClient *client, int thread_index,
+                      const uint64_t *deltas)=0;
+
+private:
+  patomic<uint64_t> *make_values();
+  void flush(PStatClient *client, int thread_index);
+  static void set_enabled(bool enabled);
+
+protected:
+  PStatCollector _collector;
+
+private:
+  // The values for each thread are stored in pages of page_size threads,
+  // indexed by the thread's PStats index.  Pages are allocated the first
+  // time a thread in that range touches the accumulator, and are never moved
+  // or freed while the accumulator exists.
+  enum {
+    page_bits = 5,
+    page_size = 1 << page_bits,
+    page_mask = page_size - 1,
+    max_pages = 64,
+  };
+
+  class Page {
+  public:
+    Page(int stride, int num_values);
+    ~Page();
+
+    // Written only by the owning thread.
+    patomic<uint64_t> *_values;
+
+    // Read and written only while flushing, with the client lock held.
+    uint64_t *_last;
+    bool _active[page_size];
+  };
+
+  int _num_values;
+  int _stride;
+  patomic<Page *> _pages[max_pages];
+
+  // Scratch space for flush().
+  pvector<uint64_t> _deltas;
+
+  static patomic<bool> _enabled;
+  static uint64_t _calibrate_cycles;
+  static double _calibrate_time;
+  static double _seconds_per_cycle;
+
+  friend class PStatClient;
+  friend class PStatClientImpl;
+
+#else  // DO_PSTATS
+protected:
+  PStatAccumulator(const std::string &, int) { }
+  virtual ~PStatAccumulator() { }
+
+public:
+  INLINE static uint64_t get_cycles() { return 0; }
+#endif  // DO_PSTATS
+};
+
+#include "pStatAccumulator.I"
+
+#endif
@@ -0,0 +1,17 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatCaptureFile.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "pStatCaptureFile.h"
+
+// Bump the trailing version byte whenever the record layout changes.
+const std::string PStatCaptureFile::_header = std::string("pscap\0\n\1", 8);
@@ -0,0 +1,52 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatCaptureFile.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef PSTATCAPTUREFILE_H
+#define PSTATCAPTUREFILE_H
+
+#include "pandabase.h"
+
+/**
+ * Constants shared by PStatCaptureWriter and PStatCaptureReader.
+ *
+ * A capture file begins with a fixed header, followed by a sequence of
+ * length-prefixed datagrams as written by DatagramOutputFile.  Each datagram
+ * is one record, beginning with a uint8 RecordType:
+ *
+ * RT_collector: uint16 index, uint16 parent index, string name, string
+ * level units.
+ *
+ * RT_thread: uint16 index, string name, string sync name.
+ *
+ * RT_frame: uint16 thread index, uint32 frame number, float64 time of the
+ * first event, followed by bit-packed data: a varint event count, and for
+ * each event a varint collector index, a stop bit and a signed varint delta
+ * in nanoseconds from the previous event; then a varint level count, and for
+ * each level a varint collector index and a float32 value.
+ *
+ * Collectors and threads are always defined before the first frame that
+ * refers to them.
+ */
+class EXPCL_PANDA_PSTATCLIENT PStatCaptureFile {
+public:
+  enum RecordType {
+    RT_invalid,
+    RT_collector,
+    RT_thread,
+    RT_frame,
+  };
+
+  static const std::string _header;
+};
+
+#endif
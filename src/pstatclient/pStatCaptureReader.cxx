@@ -0,0 +1,239 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatCaptureReader.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "pStatCaptureReader.h"
+#include "config_pstatclient.h"
+#include "datagram.h"
+#include "datagramIterator.h"
+#include "datagramBitReader.h"
+
+static const std::string empty_string;
+
+/**
+ *
+ */
+PStatCaptureReader::
+PStatCaptureReader() :
+  _is_open(false),
+  _error(false),
+  _thread_index(-1),
+  _frame_number(0)
+{
+}
+
+/**
+ * Opens the indicated capture file and checks its header.  Returns true on
+ * success.
+ */
+bool PStatCaptureReader::
+open(const Filename &filename) {
+  close();
+
+  _filename = filename;
+  _error = false;
+
+  if (!_din.open(filename)) {
+    pstats_cat.error()
+      << "Unable to open " << filename << ".\n";
+    return false;
+  }
+
+  std::string header;
+  if (!_din.read_header(header, _header.size()) || header != _header) {
+    pstats_cat.error()
+      << filename << " is not a PStats capture file, or is from a different "
+      << "version of Panda.\n";
+    _din.close();
+    return false;
+  }
+
+  _is_open = true;
+  return true;
+}
+
+/**
+ * Closes the file and forgets the collectors and threads read from it.
+ */
+void PStatCaptureReader::
+close() {
+  if (_is_open) {
+    _din.close();
+    _is_open = false;
+  }
+  _collectors.clear();
+  _threads.clear();
+  _thread_index = -1;
+  _frame_number = 0;
+  _frame_data.clear();
+}
+
+/**
+ * Reads the next record from the file.  Definitions of collectors and threads
+ * are stored in the reader; frame data may be retrieved with get_frame_data()
+ * until the next call.  Returns RT_invalid at the end of the file, or if the
+ * file is corrupt; use is_error() to tell these apart.
+ */
+PStatCaptureFile::RecordType PStatCaptureReader::
+read_record() {
+  if (!_is_open) {
+    return RT_invalid;
+  }
+
+  Datagram datagram;
+  if (!_din.get_datagram(datagram)) {
+    if (!_din.is_eof()) {
+      pstats_cat.error()
+        << "Error reading " << _filename << ".\n";
+      _error = true;
+    }
+    return RT_invalid;
+  }
+
+  DatagramIterator scan(datagram);
+  RecordType type = (RecordType)scan.get_uint8();
+
+  switch (type) {
+  case RT_collector:
+    {
+      int index = scan.get_uint16();
+      if (index >= (int)_collectors.size()) {
+        _collectors.resize(index + 1);
+      }
+      CollectorDef &def = _collectors[index];
+      def._defined = true;
+      def._parent_index = scan.get_uint16();
+      def._name = scan.get_string();
+      def._level_units = scan.get_string();
+    }
+    return type;
+
+  case RT_thread:
+    {
+      int index = scan.get_uint16();
+      if (index >= (int)_threads.size()) {
+        _threads.resize(index + 1);
+      }
+      ThreadDef &def = _threads[index];
+      def._name = scan.get_string();
+      def._sync_name = scan.get_string();
+    }
+    return type;
+
+  case RT_frame:
+    if (read_frame(scan)) {
+      return type;
+    }
+    break;
+
+  default:
+    break;
+  }
+
+  pstats_cat.error()
+    << "Invalid record in " << _filename << ".\n";
+  _error = true;
+  return RT_invalid;
+}
+
+/**
+ * Returns the name of the indicated collector.
+ */
+const std::string &PStatCaptureReader::
+get_collector_name(int index) const {
+  nassertr(index >= 0 && index < (int)_collectors.size(), empty_string);
+  return _collectors[index]._name;
+}
+
+/**
+ * Returns the units in which the indicated collector's level is measured, or
+ * the empty string if it has not been specified.
+ */
+const std::string &PStatCaptureReader::
+get_collector_level_units(int index) const {
+  nassertr(index >= 0 && index < (int)_collectors.size(), empty_string);
+  return _collectors[index]._level_units;
+}
+
+/**
+ * Returns the "full name" of the indicated collector, as
+ * PStatClient::get_collector_fullname() does: the names of all of its parents
+ * except Frame, and its own name, separated by colons.
+ */
+std::string PStatCaptureReader::
+get_collector_fullname(int index) const {
+  nassertr(index >= 0 && index < (int)_collectors.size(), std::string());
+
+  const CollectorDef &def = _collectors[index];
+  if (def._parent_index == 0 || def._parent_index == index ||
+      def._parent_index >= (int)_collectors.size()) {
+    return def._name;
+  } else {
+    return get_collector_fullname(def._parent_index) + ":" + def._name;
+  }
+}
+
+/**
+ * Returns the name of the indicated thread.
+ */
+const std::string &PStatCaptureReader::
+get_thread_name(int index) const {
+  nassertr(index >= 0 && index < (int)_threads.size(), empty_string);
+  return _threads[index]._name;
+}
+
+/**
+ * Returns the sync name of the indicated thread.
+ */
+const std::string &PStatCaptureReader::
+get_thread_sync_name(int index) const {
+  nassertr(index >= 0 && index < (int)_threads.size(), empty_string);
+  return _threads[index]._sync_name;
+}
+
+/**
+ * Decodes the body of an RT_frame record into _frame_data.  Returns false if
+ * the record is malformed.
+ */
+bool PStatCaptureReader::
+read_frame(DatagramIterator &scan) {
+  _frame_data.clear();
+  _thread_index = scan.get_uint16();
+  _frame_number = scan.get_uint32();
+  double base_time = scan.get_float64();
+
+  DatagramBitReader bits(scan);
+
+  // A corrupt count stops at the end of the record, since the bit reader
+  // flags an error rather than reading past it.
+  size_t num_events = bits.get_varint();
+  int64_t ns = 0;
+  for (size_t i = 0; i < num_events && !bits.has_error(); ++i) {
+    int index = (int)bits.get_varint();
+    bool is_stop = bits.get_bool();
+    ns += bits.get_signed_varint();
+    double time = base_time + (double)ns * 1.0e-9;
+    if (is_stop) {
+      _frame_data.add_stop(index & 0x7fff, time);
+    } else {
+      _frame_data.add_start(index & 0x7fff, time);
+    }
+  }
+
+  size_t num_levels = bits.get_varint();
+  for (size_t i = 0; i < num_levels && !bits.has_error(); ++i) {
+    int index = (int)bits.get_varint();
+    _frame_data.add_level(index & 0xffff, bits.get_float32());
+  }
+
+  return !bits.has_error();
+}
@@ -0,0 +1,89 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatCaptureReader.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef PSTATCAPTUREREADER_H
+#define PSTATCAPTUREREADER_H
+
+#include "pandabase.h"
+
+#include "pStatCaptureFile.h"
+#include "pStatFrameData.h"
+#include "datagramInputFile.h"
+#include "filename.h"
+#include "pvector.h"
+
+class DatagramIterator;
+
+/**
+ * Reads back a capture file written by PStatCaptureWriter, one record at a
+ * time.  The collector and thread definitions are accumulated as they are
+ * encountered; the most recent frame is available until the next call to
+ * read_record().
+ */
+class EXPCL_PANDA_PSTATCLIENT PStatCaptureReader : public PStatCaptureFile {
+public:
+  PStatCaptureReader();
+
+  bool open(const Filename &filename);
+  void close();
+
+  RecordType read_record();
+  INLINE bool is_error() const;
+
+  INLINE int get_num_collectors() const;
+  INLINE bool has_collector(int index) const;
+  const std::string &get_collector_name(int index) const;
+  INLINE int get_collector_parent(int index) const;
+  const std::string &get_collector_level_units(int index) const;
+  std::string get_collector_fullname(int index) const;
+
+  INLINE int get_num_threads() const;
+  const std::string &get_thread_name(int index) const;
+  const std::string &get_thread_sync_name(int index) const;
+
+  INLINE int get_thread_index() const;
+  INLINE int get_frame_number() const;
+  INLINE const PStatFrameData &get_frame_data() const;
+
+private:
+  bool read_frame(DatagramIterator &scan);
+
+  DatagramInputFile _din;
+  Filename _filename;
+  bool _is_open;
+  bool _error;
+
+  class CollectorDef {
+  public:
+    bool _defined = false;
+    int _parent_index = 0;
+    std::string _name;
+    std::string _level_units;
+  };
+  pvector<CollectorDef> _collectors;
+
+  class ThreadDef {
+  public:
+    std::string _name;
+    std::string _sync_name;
+  };
+  pvector<ThreadDef> _threads;
+
+  int _thread_index;
+  int _frame_number;
+  PStatFrameData _frame_data;
+};
+
+#include "pStatCaptureReader.I"
+
+#endif
@@ -0,0 +1,161 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatCaptureWriter.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "pStatCaptureWriter.h"
+#include "pStatFrameData.h"
+#include "config_pstatclient.h"
+#include "datagram.h"
+#include "datagramBitWriter.h"
+
+#include <cmath>
+
+/**
+ *
+ */
+PStatCaptureWriter::
+PStatCaptureWriter() :
+  _is_open(false),
+  _num_frames(0)
+{
+}
+
+/**
+ * Opens the indicated file for writing, replacing any file that was there,
+ * and writes the file header.  Returns true on success.
+ */
+bool PStatCaptureWriter::
+open(const Filename &filename) {
+  close();
+
+  _filename = filename;
+  _num_frames = 0;
+
+  if (!_dout.open(filename)) {
+    pstats_cat.error()
+      << "Unable to open " << filename << " for writing.\n";
+    return false;
+  }
+
+  if (!_dout.write_header(_header)) {
+    pstats_cat.error()
+      << "Unable to write to " << filename << ".\n";
+    _dout.close();
+    return false;
+  }
+
+  _is_open = true;
+  return true;
+}
+
+/**
+ * Flushes and closes the file, if it is open.
+ */
+void PStatCaptureWriter::
+close() {
+  if (_is_open) {
+    _dout.flush();
+    _dout.close();
+    _is_open = false;
+  }
+}
+
+/**
+ * Records the definition of a collector.  The top-level collector is its own
+ * parent.
+ */
+void PStatCaptureWriter::
+write_collector(int index, int parent_index, const std::string &name,
+                const std::string &level_units) {
+  Datagram datagram;
+  datagram.add_uint8(RT_collector);
+  datagram.add_uint16(index);
+  datagram.add_uint16(parent_index);
+  datagram.add_string(name);
+  datagram.add_string(level_units);
+  put_record(datagram);
+}
+
+/**
+ * Records the definition of a thread.
+ */
+void PStatCaptureWriter::
+write_thread(int index, const std::string &name, const std::string &sync_name) {
+  Datagram datagram;
+  datagram.add_uint8(RT_thread);
+  datagram.add_uint16(index);
+  datagram.add_string(name);
+  datagram.add_string(sync_name);
+  put_record(datagram);
+}
+
+/**
+ * Records a frame's worth of data for the indicated thread.
+ */
+void PStatCaptureWriter::
+write_frame(int thread_index, int frame_number,
+            const PStatFrameData &frame_data) {
+  double base_time = frame_data.get_start();
+
+  Datagram datagram;
+  datagram.add_uint8(RT_frame);
+  datagram.add_uint16(thread_index);
+  datagram.add_uint32(frame_number);
+  datagram.add_float64(base_time);
+
+  {
+    DatagramBitWriter bits(datagram);
+
+    // The times are stored as deltas from the previous event, in whole
+    // nanoseconds since the first event, so that rounding errors don't
+    // accumulate over a long frame.  The events are not necessarily in
+    // order, so the deltas are signed.
+    size_t num_events = frame_data.get_num_events();
+    bits.add_varint(num_events);
+    int64_t last_ns = 0;
+    for (size_t i = 0; i < num_events; ++i) {
+      int64_t ns = (int64_t)std::llround((frame_data.get_time(i) - base_time) * 1.0e9);
+      bits.add_varint(frame_data.get_time_collector(i));
+      bits.add_bool(!frame_data.is_start(i));
+      bits.add_signed_varint(ns - last_ns);
+      last_ns = ns;
+    }
+
+    size_t num_levels = frame_data.get_num_levels();
+    bits.add_varint(num_levels);
+    for (size_t i = 0; i < num_levels; ++i) {
+      bits.add_varint(frame_data.get_level_collector(i));
+      bits.add_float32((PN_float32)frame_data.get_level(i));
+    }
+  }
+
+  put_record(datagram);
+  ++_num_frames;
+}
+
+/**
+ * Writes the indicated record to the file.  If this fails, the file is
+ * closed, and no further records are written.
+ */
+void PStatCaptureWriter::
+put_record(const Datagram &datagram) {
+  if (!_is_open) {
+    return;
+  }
+
+  if (!_dout.put_datagram(datagram) || _dout.is_error()) {
+    pstats_cat.error()
+      << "Error writing to " << _filename << "; capture stopped.\n";
+    _dout.close();
+    _is_open = false;
+  }
+}
@@ -0,0 +1,67 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatCaptureWriter.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef PSTATCAPTUREWRITER_H
+#define PSTATCAPTUREWRITER_H
+
+#include "pandabase.h"
+
+#include "pStatCaptureFile.h"
+#include "datagramOutputFile.h"
+#include "filename.h"
+
+class PStatFrameData;
+
+/**
+ * Writes PStats collector, thread and frame data to a capture file, which
+ * can later be read back with PStatCaptureReader.  This is used by
+ * PStatClientImpl in place of a server connection when capturing.
+ *
+ * The frame data is stored compactly: event times are written as variable-
+ * length nanosecond deltas from the previous event, which typically take two
+ * or three bytes each.
+ *
+ * This class is not thread-safe; the caller must serialize access to it.
+ */
+class EXPCL_PANDA_PSTATCLIENT PStatCaptureWriter : public PStatCaptureFile {
+public:
+  PStatCaptureWriter();
+  INLINE ~PStatCaptureWriter();
+
+  bool open(const Filename &filename);
+  void close();
+  INLINE bool is_open() const;
+  INLINE const Filename &get_filename() const;
+
+  void write_collector(int index, int parent_index, const std::string &name,
+                       const std::string &level_units);
+  void write_thread(int index, const std::string &name,
+                    const std::string &sync_name);
+  void write_frame(int thread_index, int frame_number,
+                   const PStatFrameData &frame_data);
+
+  INLINE size_t get_num_frames() const;
+  INLINE std::streampos get_num_bytes();
+
+private:
+  void put_record(const Datagram &datagram);
+
+  DatagramOutputFile _dout;
+  Filename _filename;
+  bool _is_open;
+  size_t _num_frames;
+};
+
+#include "pStatCaptureWriter.I"
+
+#endif
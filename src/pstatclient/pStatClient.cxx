@@ -19,6 +19,7 @@
 // This file only defines anything interesting if DO_PSTATS is defined.
 
 #include "pStatClientImpl.h"
+#include "pStatAccumulator.h"
 #include "pStatClientControlMessage.h"
 #include "pStatServerControlMessage.h"
 #include "config_pstatclient.h"
@@ -372,6 +373,17 @@ main_tick() {
   }
 #endif  // DO_MEMORY_USAGE
 
+  // Start capturing to a file on the first frame, if this was requested in
+  // the config file.
+  static bool checked_capture_file = false;
+  if (!checked_capture_file) {
+    checked_capture_file = true;
+    Filename capture_filename = pstats_capture_file;
+    if (!capture_filename.empty() && !is_connected()) {
+      capture(capture_filename, pstats_capture_frames);
+    }
+  }
+
   get_global_pstats()->client_main_tick();
 }
 
@@ -467,7 +479,11 @@ bool PStatClient::
 client_connect(string hostname, int port) {
   ReMutexHolder holder(_lock);
   client_disconnect();
-  return get_impl()->client_connect(hostname, port);
+  bool connected = get_impl()->client_connect(hostname, port);
+  if (this == _global_pstats) {
+    PStatAccumulator::set_enabled(connected);
+  }
+  return connected;
 }
 
 /**
@@ -476,6 +492,9 @@ client_connect(string hostname, int port) {
 void PStatClient::
 client_disconnect() {
   ReMutexHolder holder(_lock);
+  if (this == _global_pstats) {
+    PStatAccumulator::set_enabled(false);
+  }
   if (has_impl()) {
     _impl->client_disconnect();
     delete _impl;
@@ -511,6 +530,29 @@ client_is_connected() const {
   return has_impl() && _impl->client_is_connected();
 }
 
+/**
+ * The nonstatic implementation of capture().
+ */
+bool PStatClient::
+client_capture(const Filename &filename, int num_frames) {
+  ReMutexHolder holder(_lock);
+  client_disconnect();
+  bool capturing = get_impl()->client_capture(filename, num_frames);
+  if (this == _global_pstats) {
+    PStatAccumulator::set_enabled(capturing);
+  }
+  return capturing;
+}
+
+/**
+ * The nonstatic implementation of is_capturing().
+ */
+bool PStatClient::
+client_is_capturing() const {
+  return has_impl() && _impl->client_is_connected() &&
+    _impl->client_is_capturing();
+}
+
 /**
  * Resumes the PStatClient after the simulation has been paused for a while.
  * This allows the stats to continue exactly where it left off, instead of
@@ -635,6 +677,24 @@ make_collector_with_name(int parent_index, const string &name) {
   return PStatCollector(this, num_collectors);
 }
 
+/**
+ * Overrides the units reported for the indicated collector's level, whatever
+ * initialize_collector_def() would have chosen.  This may be called before
+ * the config variables have been read, since the def is not created until it
+ * is needed.
+ */
+void PStatClient::
+set_level_units(int collector_index, const string &units) {
+  ReMutexHolder holder(_lock);
+  nassertv(collector_index >= 0 && collector_index < get_num_collectors());
+
+  Collector *collector = get_collector_ptr(collector_index);
+  collector->_level_units = units;
+  if (collector->_def != nullptr) {
+    collector->_def->_level_units = units;
+  }
+}
+
 /**
  * Similar to get_current_thread, but does not grab the lock.
  */
@@ -1300,6 +1360,9 @@ make_def(const PStatClient *client, int this_index) {
       _def->set_parent(*parent_def);
     }
     initialize_collector_def(client, _def);
+    if (!_level_units.empty()) {
+      _def->_level_units = _level_units;
+    }
   }
 }
 
@@ -1439,6 +1502,16 @@ client_is_connected() const {
   return false;
 }
 
+bool PStatClient::
+client_capture(const Filename &filename, int num_frames) {
+  return false;
+}
+
+bool PStatClient::
+client_is_capturing() const {
+  return false;
+}
+
 void PStatClient::
 client_resume_after_pause() {
   return;
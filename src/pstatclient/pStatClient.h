@@ -30,11 +30,13 @@
 #include "numeric_types.h"
 #include "bitArray.h"
 #include "extension.h"
+#include "filename.h"
 
 class PStatClientImpl;
 class PStatCollector;
 class PStatCollectorDef;
 class PStatThread;
+class PStatAccumulator;
 class GraphicsStateGuardian;
 
 /**
@@ -93,6 +95,9 @@ PUBLISHED:
   EXTEND INLINE static void disconnect();
   INLINE static bool is_connected();
 
+  INLINE static bool capture(const Filename &filename, int num_frames = 0);
+  INLINE static bool is_capturing();
+
   INLINE static void resume_after_pause();
 
   static void main_tick();
@@ -105,6 +110,8 @@ PUBLISHED:
   EXTEND bool client_connect(std::string hostname, int port);
   EXTEND void client_disconnect();
   bool client_is_connected() const;
+  bool client_capture(const Filename &filename, int num_frames = 0);
+  bool client_is_capturing() const;
 
   void client_resume_after_pause();
 
@@ -118,6 +125,7 @@ private:
 
   PStatCollector make_collector_with_relname(int parent_index, std::string relname);
   PStatCollector make_collector_with_name(int parent_index, const std::string &name);
+  void set_level_units(int collector_index, const std::string &units);
   PStatThread do_get_current_thread() const;
   PStatThread make_thread(Thread *thread);
   PStatThread do_make_thread(Thread *thread);
@@ -193,6 +201,9 @@ private:
     // This data is used to create the PStatCollectorDef when it is needed.
     int _parent_index;
     std::string _name;
+    std::string _level_units;
+
+    friend class PStatClient;
 
   public:
     // Relations to other collectors.
@@ -236,6 +247,10 @@ private:
 
   mutable PStatClientImpl *_impl;
 
+  // The PStatCounters and PStatHistograms that report to this client.  Only
+  // the global client has any.
+  pvector<PStatAccumulator *> _accumulators;
+
   static PStatCollector _heap_total_size_pcollector;
   static PStatCollector _heap_overhead_size_pcollector;
   static PStatCollector _heap_single_size_pcollector;
@@ -259,6 +274,9 @@ private:
   friend class PStatCollector;
   friend class PStatThread;
   friend class PStatClientImpl;
+  friend class PStatAccumulator;
+  friend class PStatCounter;
+  friend class PStatHistogram;
   friend class GraphicsStateGuardian;
 
   friend class Extension<PStatClient>;
@@ -297,6 +315,8 @@ PUBLISHED:
   INLINE static bool connect(const std::string & = std::string(), int = -1) { return false; }
   INLINE static void disconnect() { }
   INLINE static bool is_connected() { return false; }
+  INLINE static bool capture(const Filename &, int = 0) { return false; }
+  INLINE static bool is_capturing() { return false; }
   INLINE static void resume_after_pause() { }
 
   static void main_tick();
@@ -310,6 +330,8 @@ public:
   bool client_connect(std::string hostname, int port);
   void client_disconnect();
   bool client_is_connected() const;
+  bool client_capture(const Filename &filename, int num_frames = 0);
+  bool client_is_capturing() const;
 
   void client_resume_after_pause();
 
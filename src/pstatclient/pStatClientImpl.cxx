@@ -21,6 +21,7 @@
 #include "pStatServerControlMessage.h"
 #include "pStatCollector.h"
 #include "pStatThread.h"
+#include "pStatAccumulator.h"
 #include "config_pstatclient.h"
 #include "pStatProperties.h"
 #include "cmath.h"
@@ -28,6 +29,7 @@
 #include "conditionVarPosixImpl.h"
 #include "genericThread.h"
 #include "mutexHolder.h"
+#include "reMutexHolder.h"
 
 #include <algorithm>
 
@@ -264,6 +266,40 @@ client_connect(std::string hostname, int port) {
   return _is_connected;
 }
 
+/**
+ * Called only by PStatClient::client_capture().  Opens the indicated file and
+ * starts recording to it as if it were a server connection.
+ */
+bool PStatClientImpl::
+client_capture(const Filename &filename, int num_frames) {
+  nassertr(!_is_connected, true);
+
+  if (!_capture.open(filename)) {
+    return false;
+  }
+
+  if (pstats_cat.is_info()) {
+    pstats_cat.info()
+      << "Capturing PStats data to " << filename;
+    if (num_frames > 0) {
+      pstats_cat.info(false)
+        << " for " << num_frames << " frames";
+    }
+    pstats_cat.info(false)
+      << ".\n";
+  }
+
+  _is_connected = true;
+  _capturing = true;
+  _capture_frames_remaining = num_frames;
+
+  // Record the collectors and threads we already know about.  There is no
+  // writer thread in this mode; each thread writes its own frames to the
+  // file at the end of the frame.
+  transmit_control_data();
+  return true;
+}
+
 /**
  * Called only by PStatClient::client_disconnect().
  */
@@ -297,7 +333,17 @@ client_disconnect() {
     _thread_profiling = false;
   }
 
-  if (_is_connected) {
+  if (_capturing) {
+    if (_capture.is_open()) {
+      pstats_cat.info()
+        << "Captured " << _capture.get_num_frames()
+        << " frames of PStats data to " << _capture.get_filename() << ".\n";
+      _capture.close();
+    }
+    _capturing = false;
+    _capture_frames_remaining = 0;
+
+  } else if (_is_connected) {
 #ifdef DEBUG_THREADS
     MutexDebug::decrement_pstats();
 #endif // DEBUG_THREADS
@@ -342,7 +388,7 @@ new_frame(int thread_index, int frame_number) {
 
   // If we've got the UDP port by the time the frame starts, it's time to
   // become active and start actually tracking data.
-  if (_got_udp_port) {
+  if (_got_udp_port || _capturing) {
     pthread->_is_active = true;
   }
 
@@ -356,6 +402,15 @@ new_frame(int thread_index, int frame_number) {
     // Collector 0 is the whole frame.
     _client->stop(0, thread_index, frame_start);
 
+    // Turn whatever the counters and histograms accumulated on this thread
+    // during the frame into levels.
+    {
+      ReMutexHolder holder(_client->_lock);
+      for (PStatAccumulator *accumulator : _client->_accumulators) {
+        accumulator->flush(_client, thread_index);
+      }
+    }
+
     // Fill up the level data for all the collectors who have level data for
     // this pthread.
     int num_collectors = _client->_num_collectors;
@@ -416,6 +471,13 @@ new_frame(int thread_index, int frame_number) {
 
   if (!frame_data.is_empty()) {
     enqueue_frame_data(thread_index, frame_number, std::move(frame_data));
+
+    if (thread_index == 0 && _capture_frames_remaining > 0 &&
+        --_capture_frames_remaining == 0) {
+      // That was the last frame we were asked to capture.  The next call to
+      // PStatClient::client_main_tick() will notice and close the file.
+      _is_connected = false;
+    }
   }
   _client->stop(pstats_index, current_thread_index, get_real_time());
 }
@@ -443,7 +505,7 @@ add_frame(int thread_index, int frame_number, PStatFrameData &&frame_data) {
 
   // If we've got the UDP port by the time the frame starts, it's time to
   // become active and start actually tracking data.
-  if (_got_udp_port) {
+  if (_got_udp_port || _capturing) {
     pthread->_is_active = true;
   }
 
@@ -466,6 +528,10 @@ add_frame(int thread_index, int frame_number, PStatFrameData &&frame_data) {
 void PStatClientImpl::
 remove_thread(int thread_index) {
   nassertv(thread_index >= 0 && thread_index < _client->_num_threads);
+  if (_capturing) {
+    // The capture file only needs to know which threads existed.
+    return;
+  }
 
   PStatClientControlMessage message;
   message._type = PStatClientControlMessage::T_expire_thread;
@@ -561,7 +627,21 @@ transmit_frame_data(int thread_index, int frame_number,
   PStatClient::InternalThread *thread = _client->get_thread_ptr(thread_index);
   nassertv(thread != nullptr);
 
-  if (_is_connected && thread->_is_active) {
+  if (_is_connected && thread->_is_active && _capturing) {
+    // There is no need to limit the rate when writing to a file.  The client
+    // lock serializes the writes from the different threads, and makes sure
+    // any new collectors are defined in the file first.
+    ReMutexHolder holder(_client->_lock);
+    report_new_collectors();
+    report_new_threads();
+    _capture.write_frame(thread_index, frame_number, frame_data);
+
+    if (!_capture.is_open()) {
+      // The write failed.  Stop capturing at the next main tick.
+      _is_connected = false;
+    }
+
+  } else if (_is_connected && thread->_is_active) {
 
     // We don't want to send too many packets in a hurry and flood the server.
     // Check that enough time has elapsed for us to send a new packet.  If
@@ -717,6 +797,17 @@ report_new_collectors() {
   // So we limit ourselves here to sending only half that many.
   static const int max_collectors_at_once = 700;
 
+  if (_capturing) {
+    ReMutexHolder holder(_client->_lock);
+    while (_collectors_reported < _client->_num_collectors) {
+      const PStatCollectorDef *def = _client->get_collector_def(_collectors_reported);
+      _capture.write_collector(_collectors_reported, def->_parent_index,
+                               def->_name, def->_level_units);
+      _collectors_reported++;
+    }
+    return;
+  }
+
   while (_is_connected && _collectors_reported < _client->_num_collectors) {
     PStatClientControlMessage message;
     message._type = PStatClientControlMessage::T_define_collectors;
@@ -740,6 +831,22 @@ report_new_collectors() {
  */
 void PStatClientImpl::
 report_new_threads() {
+  if (_capturing) {
+    ReMutexHolder holder(_client->_lock);
+    PStatClient::ThreadPointer *threads =
+      (PStatClient::ThreadPointer *)_client->_threads;
+    while (_threads_reported < _client->_num_threads) {
+      PStatClient::InternalThread *thread = threads[_threads_reported];
+      if (thread != nullptr) {
+        _capture.write_thread(_threads_reported, thread->_name, thread->_sync_name);
+      } else {
+        _capture.write_thread(_threads_reported, std::string(), std::string());
+      }
+      _threads_reported++;
+    }
+    return;
+  }
+
   while (_is_connected && _threads_reported < _client->_num_threads) {
     PStatClientControlMessage message;
     message._type = PStatClientControlMessage::T_define_threads;
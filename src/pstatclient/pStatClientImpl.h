@@ -20,6 +20,7 @@
 #ifdef DO_PSTATS
 
 #include "pStatFrameData.h"
+#include "pStatCaptureWriter.h"
 #include "connectionManager.h"
 #include "queuedConnectionReader.h"
 #include "connectionWriter.h"
@@ -64,6 +65,8 @@ public:
   bool client_connect(std::string hostname, int port);
   void client_disconnect();
   INLINE bool client_is_connected() const;
+  bool client_capture(const Filename &filename, int num_frames);
+  INLINE bool client_is_capturing() const;
 
   INLINE void client_resume_after_pause();
 
@@ -141,6 +144,11 @@ private:
   unsigned int _udp_count;
 
   bool _thread_profiling = false;
+
+  // Used instead of the server connection when capturing to a file.
+  PStatCaptureWriter _capture;
+  bool _capturing = false;
+  int _capture_frames_remaining = 0;
 };
 
 #include "pStatClientImpl.I"
@@ -0,0 +1,79 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatCounter.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "pStatCounter.h"
+
+#ifdef DO_PSTATS
+
+#include "pStatClient.h"
+#include "config_pstatclient.h"
+
+/**
+ * Creates a counter that reports on the collector with the indicated name.
+ * If sample_rate is 0, the value of pstats-counter-sample-rate is used.
+ */
+PStatCounter::
+PStatCounter(const std::string &name, int sample_rate) :
+  PStatAccumulator(name, V_num_values),
+  _time_collector(_collector, "Time"),
+  _sample_mask(0),
+  _default_sample_rate(sample_rate <= 0),
+  _has_timing(false)
+{
+  PStatClient::get_global_pstats()->set_level_units(_time_collector.get_index(), "ms");
+  if (sample_rate > 0) {
+    set_sample_rate(sample_rate);
+  }
+}
+
+/**
+ * Sets the number of timed scopes for each one that is actually measured.
+ * The measured time is multiplied by this number, so the reported time is an
+ * estimate of the total.  Higher rates reduce the cost of a PStatCounterTimer
+ * to little more than that of add().  The rate is rounded down to a power of
+ * two.
+ */
+void PStatCounter::
+set_sample_rate(int sample_rate) {
+  uint64_t rate = 1;
+  while (rate * 2 <= (uint64_t)sample_rate) {
+    rate *= 2;
+  }
+  _sample_mask.store(rate - 1, std::memory_order_relaxed);
+  _default_sample_rate = false;
+}
+
+/**
+ * Reports the count, and the time if the counter has been timed, for the
+ * indicated thread's frame.
+ */
+void PStatCounter::
+report(PStatClient *client, int thread_index, const uint64_t *deltas) {
+  if (_default_sample_rate) {
+    // We can't read the config variable at static init time, when most
+    // counters are constructed, so we wait for the first frame.
+    set_sample_rate(pstats_counter_sample_rate);
+  }
+
+  client->set_level(_collector.get_index(), thread_index, (double)deltas[V_count]);
+
+  if (deltas[V_cycles] != 0) {
+    _has_timing = true;
+  }
+  if (_has_timing) {
+    double ms = (double)deltas[V_cycles] * get_seconds_per_cycle() * 1000.0;
+    client->set_level(_time_collector.get_index(), thread_index, ms);
+  }
+}
+
+#endif  // DO_PSTATS
@@ -0,0 +1,80 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatCounter.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef PSTATCOUNTER_H
+#define PSTATCOUNTER_H
+
+#include "pandabase.h"
+
+#include "pStatAccumulator.h"
+
+/**
+ * Counts how many times something happens per frame, and optionally how much
+ * time it takes, cheaply enough to be used inside a tight loop.
+ *
+ * The count is reported as the level of the collector with the counter's
+ * name.  If the counter is used with a PStatCounterTimer, the accumulated
+ * time is reported in milliseconds as the level of a child collector named
+ * "Time".
+ *
+ * Timing reads the processor's time-stamp counter rather than the PStats
+ * clock.  To reduce the overhead further, the counter may time only one in
+ * every sample_rate scopes, and scale up the result; see set_sample_rate().
+ */
+class EXPCL_PANDA_PSTATCLIENT PStatCounter : public PStatAccumulator {
+#ifdef DO_PSTATS
+public:
+  explicit PStatCounter(const std::string &name, int sample_rate = 0);
+
+  INLINE void add(uint64_t count = 1);
+
+  void set_sample_rate(int sample_rate);
+  INLINE int get_sample_rate() const;
+
+  INLINE uint64_t start_timing();
+  INLINE void stop_timing(uint64_t start);
+
+protected:
+  virtual void report(PStatClient *client, int thread_index,
+                      const uint64_t *deltas);
+
+private:
+  enum Values {
+    V_count,
+    V_cycles,
+    V_num_values,
+  };
+
+  PStatCollector _time_collector;
+  patomic<uint64_t> _sample_mask;
+  bool _default_sample_rate;
+  bool _has_timing;
+
+#else  // DO_PSTATS
+public:
+  explicit PStatCounter(const std::string &name, int = 0) :
+    PStatAccumulator(name, 0) { }
+
+  INLINE void add(uint64_t = 1) { }
+
+  void set_sample_rate(int) { }
+  INLINE int get_sample_rate() const { return 1; }
+
+  INLINE uint64_t start_timing() { return 0; }
+  INLINE void stop_timing(uint64_t) { }
+#endif  // DO_PSTATS
+};
+
+#include "pStatCounter.I"
+
+#endif
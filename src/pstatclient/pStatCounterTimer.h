@@ -0,0 +1,45 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatCounterTimer.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef PSTATCOUNTERTIMER_H
+#define PSTATCOUNTERTIMER_H
+
+#include "pandabase.h"
+
+#include "pStatCounter.h"
+
+/**
+ * The PStatCounter equivalent of PStatTimer: counts one occurrence when it is
+ * created, and adds the time until it goes out of scope to the counter's
+ * total.
+ */
+class EXPCL_PANDA_PSTATCLIENT PStatCounterTimer {
+public:
+#ifdef DO_PSTATS
+  INLINE PStatCounterTimer(PStatCounter &counter);
+  INLINE ~PStatCounterTimer();
+
+private:
+  PStatCounter &_counter;
+  uint64_t _start;
+#else // DO_PSTATS
+
+  INLINE PStatCounterTimer(PStatCounter &) { }
+  INLINE ~PStatCounterTimer() { }
+
+#endif  // DO_PSTATS
+};
+
+#include "pStatCounterTimer.I"
+
+#endif
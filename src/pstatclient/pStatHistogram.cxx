@@ -0,0 +1,74 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatHistogram.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "pStatHistogram.h"
+
+#ifdef DO_PSTATS
+
+#include "pStatClient.h"
+
+#include <algorithm>
+#include <sstream>
+
+/**
+ * Creates a histogram with num_buckets equal buckets covering the range from
+ * min_value to max_value, reporting on the collector with the indicated name.
+ */
+PStatHistogram::
+PStatHistogram(const std::string &name, double min_value, double max_value,
+               int num_buckets) :
+  PStatAccumulator(name, std::max(num_buckets, 1) + 2),
+  _min_value(min_value),
+  _max_value(max_value),
+  _num_buckets(std::max(num_buckets, 1))
+{
+  _scale = (max_value > min_value) ? _num_buckets / (max_value - min_value) : 0.0;
+
+  _bucket_collectors.reserve(_num_buckets + 2);
+  {
+    std::ostringstream strm;
+    strm << "< " << _min_value;
+    _bucket_collectors.push_back(PStatCollector(_collector, strm.str()));
+  }
+  double width = (_max_value - _min_value) / _num_buckets;
+  for (int i = 0; i < _num_buckets; ++i) {
+    std::ostringstream strm;
+    strm << "[" << _min_value + width * i << ", "
+         << _min_value + width * (i + 1) << ")";
+    _bucket_collectors.push_back(PStatCollector(_collector, strm.str()));
+  }
+  {
+    std::ostringstream strm;
+    strm << ">= " << _max_value;
+    _bucket_collectors.push_back(PStatCollector(_collector, strm.str()));
+  }
+
+  nassertv(num_buckets > 0 && max_value > min_value);
+}
+
+/**
+ * Reports the number of values in each bucket, and the total, for the
+ * indicated thread's frame.
+ */
+void PStatHistogram::
+report(PStatClient *client, int thread_index, const uint64_t *deltas) {
+  uint64_t total = 0;
+  for (size_t i = 0; i < _bucket_collectors.size(); ++i) {
+    total += deltas[i];
+    client->set_level(_bucket_collectors[i].get_index(), thread_index,
+                      (double)deltas[i]);
+  }
+  client->set_level(_collector.get_index(), thread_index, (double)total);
+}
+
+#endif  // DO_PSTATS
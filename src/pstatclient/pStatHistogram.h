@@ -0,0 +1,69 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pStatHistogram.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef PSTATHISTOGRAM_H
+#define PSTATHISTOGRAM_H
+
+#include "pandabase.h"
+
+#include "pStatAccumulator.h"
+#include "pvector.h"
+
+/**
+ * Counts how many of the values added during each frame fall into each of a
+ * number of equal-sized buckets between min_value and max_value, cheaply
+ * enough to be used inside a tight loop.
+ *
+ * Each bucket is reported as the level of a child collector, named for its
+ * range; values outside of the range are counted in two more children.  The
+ * total number of values is reported as the level of the collector with the
+ * histogram's name.
+ */
+class EXPCL_PANDA_PSTATCLIENT PStatHistogram : public PStatAccumulator {
+#ifdef DO_PSTATS
+public:
+  PStatHistogram(const std::string &name, double min_value, double max_value,
+                 int num_buckets);
+
+  INLINE void add(double value);
+
+  INLINE int get_num_buckets() const;
+  INLINE double get_min_value() const;
+  INLINE double get_max_value() const;
+
+protected:
+  virtual void report(PStatClient *client, int thread_index,
+                      const uint64_t *deltas);
+
+private:
+  double _min_value;
+  double _max_value;
+  double _scale;
+  int _num_buckets;
+
+  // The underflow bucket, each of the buckets in order, then the overflow
+  // bucket.
+  pvector<PStatCollector> _bucket_collectors;
+
+#else  // DO_PSTATS
+public:
+  PStatHistogram(const std::string &name, double, double, int) :
+    PStatAccumulator(name, 0) { }
+
+  INLINE void add(double) { }
+#endif  // DO_PSTATS
+};
+
+#include "pStatHistogram.I"
+
+#endif
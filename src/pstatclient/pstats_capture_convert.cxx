@@ -0,0 +1,353 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file pstats_capture_convert.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "pandabase.h"
+#include "pStatCaptureReader.h"
+#include "filename.h"
+#include "preprocess_argv.h"
+#include "pmap.h"
+#include "pvector.h"
+
+#include <algorithm>
+#include <iomanip>
+
+using std::cerr;
+using std::string;
+
+/**
+ * Accumulated statistics for one collector in one thread.
+ */
+class CollectorStats {
+public:
+  // Time collectors.
+  int _calls = 0;
+  int _frames = 0;
+  double _total_time = 0.0;
+  double _min_frame_time = 0.0;
+  double _max_frame_time = 0.0;
+
+  // Level collectors.
+  int _samples = 0;
+  double _total_level = 0.0;
+  double _min_level = 0.0;
+  double _max_level = 0.0;
+};
+
+/**
+ * The state kept for each thread while reading the capture.
+ */
+class ThreadState {
+public:
+  int _frames = 0;
+
+  // The start time of each collector currently started in this thread, or
+  // -1 if it is not started.  This persists across frames, since a collector
+  // may be started in one frame and stopped in the next.
+  pvector<double> _open;
+
+  // The time spent in each collector in the current frame.
+  pmap<int, double> _frame_time;
+};
+
+typedef pmap<std::pair<int, int>, CollectorStats> Stats;
+
+static void
+usage() {
+  cerr <<
+    "\nUsage:\n"
+    "  pstats_capture_convert capture.pscap [trace.json [summary.csv]]\n\n"
+
+    "Converts a file written by PStatClient::capture() (or by setting\n"
+    "pstats-capture-file) into a JSON file that may be loaded into\n"
+    "chrome://tracing or Perfetto, and a CSV file with one row per\n"
+    "collector per thread.  If the output names are omitted, they are\n"
+    "derived from the capture file name.\n\n"
+
+    "For time collectors, the summary gives the number of frames the\n"
+    "collector appeared in, the number of start/stop pairs, and the total,\n"
+    "mean per frame, minimum and maximum per-frame times in milliseconds.\n"
+    "The mean is taken over all of the thread's frames.  For level\n"
+    "collectors, it gives the number of samples and their total, mean,\n"
+    "minimum and maximum.\n\n";
+}
+
+/**
+ * Writes the string to the stream as a quoted JSON string.
+ */
+static void
+write_json_string(std::ostream &out, const string &str) {
+  out << '"';
+  for (char ch : str) {
+    switch (ch) {
+    case '"':
+      out << "\\\"";
+      break;
+    case '\\':
+      out << "\\\\";
+      break;
+    case '\n':
+      out << "\\n";
+      break;
+    case '\t':
+      out << "\\t";
+      break;
+    default:
+      if ((unsigned char)ch < 0x20) {
+        out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+            << (int)ch << std::dec << std::setfill(' ');
+      } else {
+        out << ch;
+      }
+    }
+  }
+  out << '"';
+}
+
+/**
+ * Writes the string to the stream as a CSV field, quoting it if necessary.
+ */
+static void
+write_csv_string(std::ostream &out, const string &str) {
+  if (str.find_first_of(",\"\n") == string::npos) {
+    out << str;
+    return;
+  }
+  out << '"';
+  for (char ch : str) {
+    if (ch == '"') {
+      out << '"';
+    }
+    out << ch;
+  }
+  out << '"';
+}
+
+int
+main(int argc, char *argv[]) {
+  preprocess_argv(argc, argv);
+  if (argc < 2 || argc > 4) {
+    usage();
+    return 1;
+  }
+
+  Filename capture_filename = Filename::from_os_specific(argv[1]);
+
+  Filename trace_filename;
+  if (argc > 2) {
+    trace_filename = Filename::from_os_specific(argv[2]);
+  } else {
+    trace_filename = capture_filename;
+    trace_filename.set_extension("json");
+  }
+
+  Filename summary_filename;
+  if (argc > 3) {
+    summary_filename = Filename::from_os_specific(argv[3]);
+  } else {
+    summary_filename = capture_filename;
+    summary_filename.set_extension("csv");
+  }
+
+  PStatCaptureReader reader;
+  if (!reader.open(capture_filename)) {
+    return 1;
+  }
+
+  trace_filename.set_text();
+  pofstream trace;
+  if (!trace_filename.open_write(trace)) {
+    cerr << "Unable to open " << trace_filename << ".\n";
+    return 1;
+  }
+
+  trace << std::fixed << std::setprecision(3);
+  trace << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+  bool first_event = true;
+  auto begin_event = [&]() -> std::ostream & {
+    if (!first_event) {
+      trace << ",\n";
+    }
+    first_event = false;
+    return trace;
+  };
+
+  pvector<ThreadState> threads;
+  Stats stats;
+  bool have_base_time = false;
+  double base_time = 0.0;
+  int num_frames = 0;
+
+  PStatCaptureFile::RecordType type;
+  while ((type = reader.read_record()) != PStatCaptureFile::RT_invalid) {
+    if (type == PStatCaptureFile::RT_thread) {
+      // Emit the name of each thread as metadata.
+      int ti = reader.get_num_threads() - 1;
+      begin_event() << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":"
+                    << ti << ",\"args\":{\"name\":";
+      write_json_string(trace, reader.get_thread_name(ti));
+      trace << "}}";
+      continue;
+    }
+    if (type != PStatCaptureFile::RT_frame) {
+      continue;
+    }
+
+    ++num_frames;
+    int ti = reader.get_thread_index();
+    const PStatFrameData &frame_data = reader.get_frame_data();
+
+    if (ti >= (int)threads.size()) {
+      threads.resize(ti + 1);
+    }
+    ThreadState &thread = threads[ti];
+    ++thread._frames;
+
+    if (!have_base_time && !frame_data.is_time_empty()) {
+      base_time = frame_data.get_start();
+      have_base_time = true;
+    }
+
+    // Match up the starts and stops, writing out a complete event for each
+    // pair.
+    size_t num_events = frame_data.get_num_events();
+    for (size_t i = 0; i < num_events; ++i) {
+      int ci = frame_data.get_time_collector(i);
+      double time = frame_data.get_time(i);
+      if (ci >= (int)thread._open.size()) {
+        thread._open.resize(ci + 1, -1.0);
+      }
+
+      if (frame_data.is_start(i)) {
+        thread._open[ci] = time;
+        continue;
+      }
+
+      double start = thread._open[ci];
+      if (start < 0.0) {
+        // Stopped without having been started in the capture.
+        continue;
+      }
+      thread._open[ci] = -1.0;
+
+      string name = reader.has_collector(ci) ? reader.get_collector_fullname(ci) : string();
+      begin_event() << "{\"name\":";
+      write_json_string(trace, name);
+      trace << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << ti
+            << ",\"ts\":" << (start - base_time) * 1.0e6
+            << ",\"dur\":" << (time - start) * 1.0e6 << "}";
+
+      CollectorStats &cs = stats[std::make_pair(ti, ci)];
+      cs._calls++;
+      cs._total_time += time - start;
+      thread._frame_time[ci] += time - start;
+    }
+
+    for (const auto &item : thread._frame_time) {
+      CollectorStats &cs = stats[std::make_pair(ti, item.first)];
+      if (cs._frames == 0) {
+        cs._min_frame_time = item.second;
+        cs._max_frame_time = item.second;
+      } else {
+        cs._min_frame_time = std::min(cs._min_frame_time, item.second);
+        cs._max_frame_time = std::max(cs._max_frame_time, item.second);
+      }
+      cs._frames++;
+    }
+    thread._frame_time.clear();
+
+    // The levels become counters, with one series per thread.
+    double frame_ts = frame_data.is_time_empty() ? 0.0 : (frame_data.get_start() - base_time) * 1.0e6;
+    size_t num_levels = frame_data.get_num_levels();
+    for (size_t i = 0; i < num_levels; ++i) {
+      int ci = frame_data.get_level_collector(i);
+      double level = frame_data.get_level(i);
+
+      string name = reader.has_collector(ci) ? reader.get_collector_fullname(ci) : string();
+      begin_event() << "{\"name\":";
+      write_json_string(trace, name);
+      trace << ",\"ph\":\"C\",\"pid\":0,\"ts\":" << frame_ts << ",\"args\":{";
+      write_json_string(trace, ti < reader.get_num_threads() ? reader.get_thread_name(ti) : string());
+      trace << ":" << level << "}}";
+
+      CollectorStats &cs = stats[std::make_pair(ti, ci)];
+      if (cs._samples == 0) {
+        cs._min_level = level;
+        cs._max_level = level;
+      } else {
+        cs._min_level = std::min(cs._min_level, level);
+        cs._max_level = std::max(cs._max_level, level);
+      }
+      cs._samples++;
+      cs._total_level += level;
+    }
+  }
+
+  trace << "\n]}\n";
+  trace.close();
+
+  if (reader.is_error()) {
+    cerr << capture_filename << " is truncated or corrupt; converted the "
+         << num_frames << " frames before the error.\n";
+  }
+
+  summary_filename.set_text();
+  pofstream summary;
+  if (!summary_filename.open_write(summary)) {
+    cerr << "Unable to open " << summary_filename << ".\n";
+    return 1;
+  }
+
+  summary << "thread,collector,kind,units,frames,calls,total,mean,min,max\n";
+  summary << std::setprecision(6);
+  for (const auto &item : stats) {
+    int ti = item.first.first;
+    int ci = item.first.second;
+    const CollectorStats &cs = item.second;
+
+    string thread_name = ti < reader.get_num_threads() ? reader.get_thread_name(ti) : string();
+    string name = reader.has_collector(ci) ? reader.get_collector_fullname(ci) : string();
+
+    if (cs._calls > 0) {
+      int thread_frames = std::max(threads[ti]._frames, 1);
+      write_csv_string(summary, thread_name);
+      summary << ",";
+      write_csv_string(summary, name);
+      summary << ",time,ms," << cs._frames << "," << cs._calls
+              << "," << cs._total_time * 1000.0
+              << "," << cs._total_time * 1000.0 / thread_frames
+              << "," << cs._min_frame_time * 1000.0
+              << "," << cs._max_frame_time * 1000.0 << "\n";
+    }
+
+    if (cs._samples > 0) {
+      write_csv_string(summary, thread_name);
+      summary << ",";
+      write_csv_string(summary, name);
+      summary << ",level,";
+      write_csv_string(summary, reader.has_collector(ci) ? reader.get_collector_level_units(ci) : string());
+      summary << "," << cs._samples << "," << cs._samples
+              << "," << cs._total_level
+              << "," << cs._total_level / cs._samples
+              << "," << cs._min_level
+              << "," << cs._max_level << "\n";
+    }
+  }
+  summary.close();
+
+  cerr << "Read " << num_frames << " frames from " << capture_filename
+            << "; wrote " << trace_filename << " and " << summary_filename
+            << ".\n";
+
+  return reader.is_error() ? 1 : 0;
+}
@@ -33,13 +33,26 @@ static const unsigned short _bam_major_ver = 7;
 // Bumped to major version 7 on 2021-06-13 due to major animation system changes.
 
 static const unsigned short _bam_first_minor_ver = 0;
-static const unsigned short _bam_last_minor_ver = 1;
-static const unsigned short _bam_minor_ver = 1;
+static const unsigned short _bam_last_minor_ver = 2;
+static const unsigned short _bam_minor_ver = 2;
 
 //
 // BAM 7.x minor version history
 //
 // Bumped to minor version 1 on 2021-09-15 for ModelRoot collision info.
+// Bumped to minor version 2 on 2026-10-18 to align vertex array data.
+
+// A bam file written with a table of contents ends with a BOC_ignore datagram
+// holding the table, followed by a fixed-size BOC_ignore datagram holding
+// this magic number and the file position of the table.  Readers that don't
+// know about the table simply skip both.  See BamWriter::write_toc().
+static const std::string _bam_toc_magic = std::string("ptoc", 4);
+static const size_t _bam_toc_trailer_size = 4 + 1 + 4 + 8;
+
+// Flags stored with each object in the table of contents.
+static const unsigned char _bam_toc_root = 0x01;
+static const unsigned char _bam_toc_long_object_id = 0x02;
+static const unsigned char _bam_toc_long_pta_id = 0x04;
 
 
 //
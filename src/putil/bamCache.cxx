@@ -18,6 +18,7 @@
 #include "hashVal.h"
 #include "datagramInputFile.h"
 #include "datagramOutputFile.h"
+#include "datagramBuffer.h"
 #include "config_putil.h"
 #include "bam.h"
 #include "typeRegistry.h"
@@ -28,6 +29,7 @@
 #include "virtualFileSystem.h"
 
 using std::istream;
+using std::istringstream;
 using std::ostream;
 using std::ostringstream;
 using std::string;
@@ -42,7 +44,11 @@ BamCache() :
   _active(true),
   _read_only(false),
   _index(new BamCacheIndex),
-  _index_stale_since(0)
+  _index_stale_since(0),
+  _store_cvar(_store_lock),
+  _store_shutdown(false),
+  _evict_pending(false),
+  _flush_requested(false)
 {
   ConfigVariableFilename model_cache_dir
     ("model-cache-dir", Filename(),
@@ -86,6 +92,21 @@ BamCache() :
     ("model-cache-max-kbytes", 10485760,
      PRC_DESC("This is the maximum size of the model cache, in kilobytes."));
 
+  ConfigVariableBool model_cache_async_store
+    ("model-cache-async-store", true,
+     PRC_DESC("If this is set to true, cache files are written to disk by a "
+              "background thread, so that the thread that loaded a model or "
+              "texture doesn't have to wait for it to be written to the "
+              "model cache.  The object is still serialized right away."));
+
+  ConfigVariableInt model_cache_evict_batch
+    ("model-cache-evict-batch", 16,
+     PRC_DESC("When the model cache grows larger than model-cache-max-kbytes "
+              "and cache files are being written in the background, this is "
+              "the maximum number of old files that are removed at a time "
+              "before the background thread goes back to writing new "
+              "files."));
+
   _cache_models = model_cache_models;
   _cache_textures = model_cache_textures;
   _cache_compressed_textures = model_cache_compressed_textures;
@@ -94,6 +115,9 @@ BamCache() :
   _flush_time = model_cache_flush;
   _max_kbytes = model_cache_max_kbytes;
 
+  _async_store = model_cache_async_store;
+  _evict_batch = std::max((int)model_cache_evict_batch, 1);
+
   if (!model_cache_dir.empty()) {
     set_root(model_cache_dir);
   }
@@ -104,6 +128,7 @@ BamCache() :
  */
 BamCache::
 ~BamCache() {
+  stop_store_thread();
   flush_index();
   delete _index;
   _index = nullptr;
@@ -120,6 +145,8 @@ BamCache::
  */
 void BamCache::
 set_root(const Filename &root) {
+  flush_stores();
+
   ReMutexHolder holder(_lock);
   flush_index();
   _root = root;
@@ -163,7 +190,6 @@ set_root(const Filename &root) {
  */
 PT(BamCacheRecord) BamCache::
 lookup(const Filename &source_filename, const string &cache_extension) {
-  ReMutexHolder holder(_lock);
   consider_flush_index();
 
   VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
@@ -172,7 +198,7 @@ lookup(const Filename &source_filename, const string &cache_extension) {
   source_pathname.make_absolute(vfs->get_cwd());
 
   Filename rel_pathname(source_pathname);
-  rel_pathname.make_relative_to(_root, false);
+  rel_pathname.make_relative_to(get_root(), false);
   if (rel_pathname.is_local()) {
     // If the source pathname is already within the cache directory, don't
     // cache it further.
@@ -182,6 +208,11 @@ lookup(const Filename &source_filename, const string &cache_extension) {
   Filename cache_filename = hash_filename(source_pathname.get_fullpath());
   cache_filename.set_extension(cache_extension);
 
+  // If the store thread is about to write or delete this file, wait for it
+  // to be done.  This must happen before we take the lock for the file, which
+  // the store thread also takes while it writes it.
+  wait_for_store(cache_filename);
+
   return find_and_read_record(source_pathname, cache_filename);
 }
 
@@ -189,120 +220,88 @@ lookup(const Filename &source_filename, const string &cache_extension) {
  * Flushes a cache entry to disk.  You must have retrieved the cache record
  * via a prior call to lookup(), and then stored the data via
  * record->set_data().  Returns true on success, false on failure.
+ *
+ * The object is serialized before this returns, so the caller may go on to
+ * modify it.  If async-store is enabled, however, the file is written by a
+ * background thread, and a true return value only means that it has been
+ * queued; a failure to write it is reported in the log.  Call flush_stores()
+ * to wait for it.
  */
 bool BamCache::
 store(BamCacheRecord *record) {
-  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
-  ReMutexHolder holder(_lock);
   nassertr(!record->_cache_pathname.empty(), false);
   nassertr(record->has_data(), false);
 
-  if (_read_only) {
-    return false;
-  }
-
-  consider_flush_index();
+  bool async_store;
+  {
+    ReMutexHolder holder(_lock);
+    if (_read_only) {
+      return false;
+    }
 
 #ifndef NDEBUG
-  // Ensure that the cache_pathname is within the _root directory tree.
-  Filename rel_pathname(record->_cache_pathname);
-  rel_pathname.make_relative_to(_root, false);
-  nassertr(rel_pathname.is_local(), false);
+    // Ensure that the cache_pathname is within the _root directory tree.
+    Filename rel_pathname(record->_cache_pathname);
+    rel_pathname.make_relative_to(_root, false);
+    nassertr(rel_pathname.is_local(), false);
 #endif  // NDEBUG
 
-  record->_recorded_time = time(nullptr);
+    async_store = _async_store && Thread::is_threading_supported();
+  }
 
-  Filename cache_pathname = Filename::binary_filename(record->_cache_pathname);
+  consider_flush_index();
 
-  // We actually do the write to a temporary filename first, and then move it
-  // into place, so that no one attempts to read the file while it is in the
-  // process of being written.
-  Thread *current_thread = Thread::get_current_thread();
-  string extension = current_thread->get_unique_id() + string(".tmp");
-  Filename temp_pathname = cache_pathname;
-  temp_pathname.set_extension(extension);
-  temp_pathname.set_binary();
+  record->_recorded_time = time(nullptr);
 
-  DatagramOutputFile dout;
-  if (!dout.open(temp_pathname)) {
-    util_cat.error()
-      << "Could not write cache file: " << temp_pathname << "\n";
-    vfs->delete_file(temp_pathname);
-    emergency_read_only();
-    return false;
-  }
+  Filename cache_pathname = Filename::binary_filename(record->_cache_pathname);
 
-  if (!dout.write_header(_bam_header)) {
+  vector_uchar data;
+  if (!write_record(record, data)) {
     util_cat.error()
-      << "Unable to write to " << temp_pathname << "\n";
-    vfs->delete_file(temp_pathname);
+      << "Unable to write object to cache file " << cache_pathname << "\n";
     return false;
   }
+  record->_record_size = data.size();
 
-  {
-    BamWriter writer(&dout);
-    if (!writer.init()) {
-      util_cat.error()
-        << "Unable to write Bam header to " << temp_pathname << "\n";
-      vfs->delete_file(temp_pathname);
-      return false;
+  if (async_store) {
+    MutexHolder holder(_store_lock);
+    if (_store_thread == nullptr && !_store_shutdown) {
+      start_store_thread();
     }
-
-    TypeRegistry *type_registry = TypeRegistry::ptr();
-    TypeHandle texture_type = type_registry->find_type("Texture");
-    if (record->get_data()->is_of_type(texture_type)) {
-      // Texture objects write the actual texture image.
-      writer.set_file_texture_mode(BamWriter::BTM_rawdata);
-    } else {
-      // Any other kinds of objects write texture references.
-      writer.set_file_texture_mode(BamWriter::BTM_fullpath);
-    }
-
-    // This is necessary for relative NodePaths to work.
-    TypeHandle node_type = type_registry->find_type("PandaNode");
-    if (record->get_data()->is_of_type(node_type)) {
-      writer.set_root_node(record->get_data());
-    }
-
-    if (!writer.write_object(record)) {
-      util_cat.error()
-        << "Unable to write object to " << temp_pathname << "\n";
-      vfs->delete_file(temp_pathname);
-      return false;
-    }
-
-    if (!writer.write_object(record->get_data())) {
-      util_cat.error()
-        << "Unable to write object data to " << temp_pathname << "\n";
-      vfs->delete_file(temp_pathname);
-      return false;
+    if (_store_thread != nullptr) {
+      StoreRequest request;
+      request._cache_pathname = cache_pathname;
+      request._cache_filename = record->get_cache_filename();
+      request._record = record->make_copy();
+      request._data.swap(data);
+      ++_pending_stores[request._cache_filename];
+      _store_queue.push_back(std::move(request));
+      _store_cvar.notify_all();
+      return true;
     }
-
-    // Now that we are done with the BamWriter, it's important to let it
-    // destruct now and clean itself up, or it might get mad if we delete any
-    // TypedWritables below that haven't been written yet.
   }
 
-  record->_record_size = dout.get_file_pos();
-  dout.close();
-
-  // Now move the file into place.
-  if (!vfs->rename_file(temp_pathname, cache_pathname) && vfs->exists(temp_pathname)) {
-    vfs->delete_file(cache_pathname);
-    if (!vfs->rename_file(temp_pathname, cache_pathname)) {
-      util_cat.error()
-        << "Unable to rename " << temp_pathname << " to "
-        << cache_pathname << "\n";
-      vfs->delete_file(temp_pathname);
-      return false;
-    }
+  MutexHolder holder(get_shard_lock(record->get_cache_filename()));
+  if (!write_record_file(cache_pathname, data)) {
+    return false;
   }
 
   add_to_index(record);
-
   return true;
 }
 
+/**
+ * Blocks until all of the cache files queued by store() have been written to
+ * disk.
+ */
+void BamCache::
+flush_stores() {
+  MutexHolder holder(_store_lock);
+  while (!_pending_stores.empty()) {
+    _store_cvar.wait();
+  }
+}
+
 /**
  * Called when an attempt to write to the cache dir has failed, usually for
  * lack of disk space or because of incorrect file permissions.  Outputs an
@@ -332,7 +331,19 @@ consider_flush_index() {
   if (_index_stale_since != 0) {
     int elapsed = (int)time(nullptr) - (int)_index_stale_since;
     if (elapsed > _flush_time) {
-      flush_index();
+      // If we have a store thread, let it write the index instead.
+      bool requested = false;
+      {
+        MutexHolder holder(_store_lock);
+        if (_store_thread != nullptr) {
+          _flush_requested = true;
+          _store_cvar.notify_all();
+          requested = true;
+        }
+      }
+      if (!requested) {
+        flush_index();
+      }
     }
   }
 
@@ -623,6 +634,7 @@ void BamCache::
 add_to_index(const BamCacheRecord *record) {
   PT(BamCacheRecord) new_record = record->make_copy();
 
+  ReMutexHolder holder(_lock);
   if (_index->add_record(new_record)) {
     mark_index_stale();
     check_cache_size();
@@ -634,14 +646,21 @@ add_to_index(const BamCacheRecord *record) {
  */
 void BamCache::
 remove_from_index(const Filename &source_pathname) {
+  ReMutexHolder holder(_lock);
   if (_index->remove_record(source_pathname)) {
     mark_index_stale();
   }
 }
 
 /**
- * If the cache size has exceeded its specified size limit, removes an old
- * file.
+ * If the cache size has exceeded its specified size limit, removes old files.
+ * Assumes the lock is held.
+ *
+ * If there is a store thread, only a batch of files is removed at a time, and
+ * they are deleted by the store thread, which calls this again between
+ * writing files until the cache is small enough.  This way, a thread that is
+ * loading a model never has to wait for a large number of files to be
+ * deleted.
  */
 void BamCache::
 check_cache_size() {
@@ -650,22 +669,52 @@ check_cache_size() {
     return;
   }
 
-  if (_index->_cache_size / 1024 > _max_kbytes) {
-    while (_index->_cache_size / 1024 > _max_kbytes) {
-      PT(BamCacheRecord) record = _index->evict_old_file();
-      if (record == nullptr) {
-        // Never mind; the cache is empty.
-        break;
-      }
-      VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
-      Filename cache_pathname(_root, record->get_cache_filename());
-      if (util_cat.is_debug()) {
-        util_cat.debug()
-          << "Deleting " << cache_pathname
-          << " to keep cache size below " << _max_kbytes << "K\n";
-      }
+  if (_index->_cache_size / 1024 <= _max_kbytes) {
+    return;
+  }
+
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+  MutexHolder holder(_store_lock);
+  bool incremental = (_store_thread != nullptr);
+
+  int num_evicted = 0;
+  while (_index->_cache_size / 1024 > _max_kbytes) {
+    if (incremental && num_evicted >= _evict_batch) {
+      // Leave the rest for later.
+      _evict_pending = true;
+      _store_cvar.notify_all();
+      break;
+    }
+
+    PT(BamCacheRecord) record = _index->evict_old_file();
+    if (record == nullptr) {
+      // Never mind; the cache is empty.
+      break;
+    }
+    ++num_evicted;
+
+    Filename cache_pathname(_root, record->get_cache_filename());
+    if (util_cat.is_debug()) {
+      util_cat.debug()
+        << "Deleting " << cache_pathname
+        << " to keep cache size below " << _max_kbytes << "K\n";
+    }
+
+    if (incremental) {
+      // Queue it up with the files being written, so that it can't be
+      // deleted after a newer version of the same file is written.
+      StoreRequest request;
+      request._cache_pathname = cache_pathname;
+      request._cache_filename = record->get_cache_filename();
+      ++_pending_stores[request._cache_filename];
+      _store_queue.push_back(std::move(request));
+      _store_cvar.notify_all();
+    } else {
       vfs->delete_file(cache_pathname);
     }
+  }
+
+  if (num_evicted != 0) {
     mark_index_stale();
   }
 }
@@ -801,38 +850,61 @@ read_record(const Filename &source_pathname,
             const Filename &cache_filename,
             int pass) {
   VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
-  Filename cache_pathname(_root, cache_filename);
+  Filename cache_pathname(get_root(), cache_filename);
   if (pass != 0) {
     ostringstream strm;
     strm << cache_pathname.get_basename_wo_extension() << "_" << pass;
     cache_pathname.set_basename_wo_extension(strm.str());
   }
 
-  if (!cache_pathname.exists()) {
-    // There is no such cache file already.  Declare it.
+  // We don't hold the index lock while reading the file, only the lock for
+  // this particular cache file, so other threads can go on looking up other
+  // files in the meantime.  Even that lock is released before the record is
+  // decoded, since decoding a cached model may look up its textures in the
+  // cache in turn.
+  string data;
+  {
+    MutexHolder holder(get_shard_lock(cache_filename));
+    if (!cache_pathname.exists()) {
+      // There is no such cache file already.  Declare it.
+      if (util_cat.is_debug()) {
+        util_cat.debug()
+          << "Declaring new cache file " << cache_pathname << " for " << source_pathname << "\n";
+      }
+      PT(BamCacheRecord) record =
+        new BamCacheRecord(source_pathname, cache_filename);
+      record->_cache_pathname = cache_pathname;
+      return record;
+    }
+
     if (util_cat.is_debug()) {
       util_cat.debug()
-        << "Declaring new cache file " << cache_pathname << " for " << source_pathname << "\n";
+        << "Reading cache file " << cache_pathname << " for " << source_pathname << "\n";
     }
-    PT(BamCacheRecord) record =
-      new BamCacheRecord(source_pathname, cache_filename);
-    record->_cache_pathname = cache_pathname;
-    return record;
-  }
 
-  if (util_cat.is_debug()) {
-    util_cat.debug()
-      << "Reading cache file " << cache_pathname << " for " << source_pathname << "\n";
+    if (!vfs->read_file(cache_pathname, data, false)) {
+      data.clear();
+    }
   }
 
-  PT(BamCacheRecord) record = do_read_record(cache_pathname, true);
+  PT(BamCacheRecord) record;
+  {
+    istringstream in(data);
+    DatagramInputFile din;
+    if (din.open(in, cache_pathname)) {
+      record = do_read_record(din, cache_pathname, true);
+    }
+  }
   if (record == nullptr) {
     // Well, it was invalid, so blow it away, and make a new one.
     if (util_cat.is_debug()) {
       util_cat.debug()
         << "Deleting invalid cache file " << cache_pathname << "\n";
     }
-    vfs->delete_file(cache_pathname);
+    {
+      MutexHolder holder(get_shard_lock(cache_filename));
+      vfs->delete_file(cache_pathname);
+    }
     remove_from_index(source_pathname);
 
     PT(BamCacheRecord) record =
@@ -840,6 +912,7 @@ read_record(const Filename &source_pathname,
     record->_cache_pathname = cache_pathname;
     return record;
   }
+  record->_record_size = data.size();
 
   if (record->get_source_pathname() != source_pathname) {
     // This might be just a hash conflict.
@@ -875,6 +948,24 @@ do_read_record(const Filename &cache_pathname, bool read_data) {
     return nullptr;
   }
 
+  PT(BamCacheRecord) record = do_read_record(din, cache_pathname, read_data);
+  if (record != nullptr) {
+    // Also get the total file size.
+    PT(VirtualFile) vfile = din.get_vfile();
+    istream &in = din.get_stream();
+    in.clear();
+    record->_record_size = vfile->get_file_size(&in);
+  }
+  return record;
+}
+
+/**
+ * Reads a record from the indicated cache file, which has already been
+ * opened.  The record size is not filled in.
+ */
+PT(BamCacheRecord) BamCache::
+do_read_record(DatagramInputFile &din, const Filename &cache_pathname,
+               bool read_data) {
   string head;
   if (!din.read_header(head, _bam_header.size())) {
     if (util_cat.is_debug()) {
@@ -947,18 +1038,209 @@ do_read_record(const Filename &cache_pathname, bool read_data) {
     }
   }
 
-  // Also get the total file size.
-  PT(VirtualFile) vfile = din.get_vfile();
-  istream &in = din.get_stream();
-  in.clear();
-  record->_record_size = vfile->get_file_size(&in);
-
   // And the last access time is now, duh.
   record->_record_access_time = time(nullptr);
 
   return record;
 }
 
+/**
+ * Serializes the indicated record, followed by its data, into a block of
+ * memory in cache file format.  Returns true on success.
+ */
+bool BamCache::
+write_record(BamCacheRecord *record, vector_uchar &data) {
+  DatagramBuffer buffer;
+  if (!buffer.write_header(_bam_header)) {
+    return false;
+  }
+
+  {
+    BamWriter writer(&buffer);
+    if (!writer.init()) {
+      return false;
+    }
+
+    TypeRegistry *type_registry = TypeRegistry::ptr();
+    TypeHandle texture_type = type_registry->find_type("Texture");
+    if (record->get_data()->is_of_type(texture_type)) {
+      // Texture objects write the actual texture image.
+      writer.set_file_texture_mode(BamWriter::BTM_rawdata);
+    } else {
+      // Any other kinds of objects write texture references.
+      writer.set_file_texture_mode(BamWriter::BTM_fullpath);
+    }
+
+    // This is necessary for relative NodePaths to work.
+    TypeHandle node_type = type_registry->find_type("PandaNode");
+    if (record->get_data()->is_of_type(node_type)) {
+      writer.set_root_node(record->get_data());
+    }
+
+    if (!writer.write_object(record) ||
+        !writer.write_object(record->get_data())) {
+      return false;
+    }
+
+    // Now that we are done with the BamWriter, it's important to let it
+    // destruct now and clean itself up, or it might get mad if we delete any
+    // TypedWritables below that haven't been written yet.
+  }
+
+  buffer.swap_data(data);
+  return true;
+}
+
+/**
+ * Writes a record previously serialized by write_record() to the indicated
+ * cache file.  Returns true on success.
+ */
+bool BamCache::
+write_record_file(const Filename &cache_pathname, const vector_uchar &data) {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+
+  // We actually do the write to a temporary filename first, and then move it
+  // into place, so that no one attempts to read the file while it is in the
+  // process of being written.
+  Thread *current_thread = Thread::get_current_thread();
+  string extension = current_thread->get_unique_id() + string(".tmp");
+  Filename temp_pathname = cache_pathname;
+  temp_pathname.set_extension(extension);
+  temp_pathname.set_binary();
+
+  if (!vfs->write_file(temp_pathname, data.data(), data.size(), false)) {
+    util_cat.error()
+      << "Could not write cache file: " << temp_pathname << "\n";
+    vfs->delete_file(temp_pathname);
+
+    ReMutexHolder holder(_lock);
+    emergency_read_only();
+    return false;
+  }
+
+  // Now move the file into place.
+  if (!vfs->rename_file(temp_pathname, cache_pathname) && vfs->exists(temp_pathname)) {
+    vfs->delete_file(cache_pathname);
+    if (!vfs->rename_file(temp_pathname, cache_pathname)) {
+      util_cat.error()
+        << "Unable to rename " << temp_pathname << " to "
+        << cache_pathname << "\n";
+      vfs->delete_file(temp_pathname);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/**
+ * Blocks until the store thread has finished with any queued requests for
+ * the indicated cache file.  Must not be called while holding the lock for
+ * that file.
+ */
+void BamCache::
+wait_for_store(const Filename &cache_filename) {
+  MutexHolder holder(_store_lock);
+  while (_pending_stores.count(cache_filename) != 0) {
+    _store_cvar.wait();
+  }
+}
+
+/**
+ * Starts the thread that writes queued cache files.  Assumes _store_lock is
+ * held.
+ */
+void BamCache::
+start_store_thread() {
+  PT(StoreThread) thread = new StoreThread(this);
+  if (thread->start(TP_low, true)) {
+    _store_thread = thread;
+  }
+}
+
+/**
+ * Stops the store thread, after it has written all of the files that have
+ * been queued.
+ */
+void BamCache::
+stop_store_thread() {
+  PT(StoreThread) thread;
+  {
+    MutexHolder holder(_store_lock);
+    _store_shutdown = true;
+    _store_cvar.notify_all();
+    thread = _store_thread;
+    _store_thread = nullptr;
+  }
+
+  if (thread != nullptr) {
+    thread->join();
+  }
+}
+
+/**
+ * The main loop of the store thread.  Writes or deletes the queued files in
+ * order; when the queue is empty, continues evicting old files and writes the
+ * index if it was asked to.
+ */
+void BamCache::
+process_stores() {
+  VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
+
+  _store_lock.lock();
+  while (true) {
+    if (!_store_queue.empty()) {
+      StoreRequest request = std::move(_store_queue.front());
+      _store_queue.pop_front();
+      _store_lock.unlock();
+
+      {
+        // Hold the lock for this file while it is written or deleted, just
+        // as store() does when it writes the file itself.
+        MutexHolder holder(get_shard_lock(request._cache_filename));
+        if (request._record != nullptr) {
+          if (write_record_file(request._cache_pathname, request._data)) {
+            add_to_index(request._record);
+          }
+        } else {
+          vfs->delete_file(request._cache_pathname);
+        }
+      }
+
+      _store_lock.lock();
+      PendingStores::iterator pi = _pending_stores.find(request._cache_filename);
+      nassertd(pi != _pending_stores.end()) continue;
+      if (--(*pi).second == 0) {
+        _pending_stores.erase(pi);
+      }
+      _store_cvar.notify_all();
+
+    } else if (_evict_pending || _flush_requested) {
+      bool flush = _flush_requested;
+      _evict_pending = false;
+      _flush_requested = false;
+      _store_lock.unlock();
+
+      {
+        ReMutexHolder holder(_lock);
+        check_cache_size();
+        if (flush) {
+          flush_index();
+        }
+      }
+
+      _store_lock.lock();
+
+    } else if (_store_shutdown) {
+      break;
+
+    } else {
+      _store_cvar.wait();
+    }
+  }
+  _store_lock.unlock();
+}
+
 /**
  * Returns the appropriate filename to use for a cache file, given the
  * fullpath string to the source filename.
@@ -984,3 +1266,21 @@ make_global() {
     _global_ptr->set_active(false);
   }
 }
+
+/**
+ *
+ */
+BamCache::StoreThread::
+StoreThread(BamCache *cache) :
+  Thread("BamCacheStore", "BamCacheStore"),
+  _cache(cache)
+{
+}
+
+/**
+ *
+ */
+void BamCache::StoreThread::
+thread_main() {
+  _cache->process_stores();
+}
@@ -22,10 +22,17 @@
 #include "pvector.h"
 #include "reMutex.h"
 #include "reMutexHolder.h"
+#include "pmutex.h"
+#include "mutexHolder.h"
+#include "conditionVar.h"
+#include "thread.h"
+#include "pdeque.h"
+#include "vector_uchar.h"
 
 #include <time.h>
 
 class BamCacheIndex;
+class DatagramInputFile;
 
 /**
  * This class maintains a cache of Bam and/or Txo objects generated from model
@@ -38,6 +45,14 @@ class BamCacheIndex;
  * multiple different processes writing to the same index, and without relying
  * too heavily on low-level os-provided file locks (which work poorly with C++
  * iostreams).
+ *
+ * Several threads may look up and store records at the same time.  The lock
+ * on the index is only held briefly; reading and writing the cache files
+ * themselves is protected by one of a number of smaller locks, chosen by the
+ * cache filename, so that only operations on the same file wait for each
+ * other.  Unless async-store is disabled, store() serializes the object
+ * right away and then leaves it to a background thread to write the file,
+ * update the index and evict old files.
  */
 class EXPCL_PANDA_PUTIL BamCache {
 PUBLISHED:
@@ -71,9 +86,13 @@ PUBLISHED:
   INLINE void set_read_only(bool ro);
   INLINE bool get_read_only() const;
 
+  INLINE void set_async_store(bool flag);
+  INLINE bool get_async_store() const;
+
   PT(BamCacheRecord) lookup(const Filename &source_filename,
                             const std::string &cache_extension);
   bool store(BamCacheRecord *record);
+  void flush_stores();
 
   void consider_flush_index();
   void flush_index();
@@ -96,6 +115,7 @@ PUBLISHED:
   MAKE_PROPERTY(flush_time, get_flush_time, set_flush_time);
   MAKE_PROPERTY(cache_max_kbytes, get_cache_max_kbytes, set_cache_max_kbytes);
   MAKE_PROPERTY(read_only, get_read_only, set_read_only);
+  MAKE_PROPERTY(async_store, get_async_store, set_async_store);
 
 private:
   void read_index();
@@ -122,6 +142,20 @@ private:
                                  int pass);
   static PT(BamCacheRecord) do_read_record(const Filename &cache_pathname,
                                            bool read_data);
+  static PT(BamCacheRecord) do_read_record(DatagramInputFile &din,
+                                           const Filename &cache_pathname,
+                                           bool read_data);
+
+  static bool write_record(BamCacheRecord *record, vector_uchar &data);
+  bool write_record_file(const Filename &cache_pathname,
+                         const vector_uchar &data);
+  void wait_for_store(const Filename &cache_filename);
+
+  void start_store_thread();
+  void stop_store_thread();
+  void process_stores();
+
+  INLINE Mutex &get_shard_lock(const Filename &cache_filename);
 
   static std::string hash_filename(const std::string &filename);
   static void make_global();
@@ -144,6 +178,52 @@ private:
   std::string _index_ref_contents;
 
   ReMutex _lock;
+
+  // Protects the reading and writing of the cache files, by cache filename.
+  // If _lock is also needed, the shard lock must be acquired first.
+  enum { num_shard_locks = 16 };
+  Mutex _shard_locks[num_shard_locks];
+
+  // A file waiting to be written by the store thread.  If _record is NULL,
+  // the file is to be deleted instead.  _cache_filename picks the lock that
+  // is held while the file is written.
+  class StoreRequest {
+  public:
+    Filename _cache_pathname;
+    Filename _cache_filename;
+    PT(BamCacheRecord) _record;
+    vector_uchar _data;
+  };
+
+  class StoreThread : public Thread {
+  public:
+    StoreThread(BamCache *cache);
+    virtual void thread_main();
+
+    BamCache *_cache;
+  };
+
+  bool _async_store;
+  int _evict_batch;
+
+  // The remaining members are protected by _store_lock.  If both locks are
+  // needed, _lock must be acquired first.
+  Mutex _store_lock;
+  ConditionVar _store_cvar;
+
+  typedef pdeque<StoreRequest> StoreQueue;
+  StoreQueue _store_queue;
+
+  // The number of queued requests for each cache filename.
+  typedef pmap<Filename, int> PendingStores;
+  PendingStores _pending_stores;
+
+  PT(StoreThread) _store_thread;
+  bool _store_shutdown;
+  bool _evict_pending;
+  bool _flush_requested;
+
+  friend class StoreThread;
 };
 
 #include "bamCache.I"
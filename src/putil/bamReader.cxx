@@ -19,9 +19,24 @@
 #include "datagramIterator.h"
 #include "config_putil.h"
 #include "pipelineCyclerBase.h"
+#include "configVariableBool.h"
+#include "configVariableInt.h"
 
 using std::string;
 
+static ConfigVariableBool bam_parallel_decode
+("bam-parallel-decode", true,
+ PRC_DESC("Set this true to allow large payloads within bam objects, such as "
+          "vertex arrays, texture images and animation tables, to be decoded "
+          "in parallel on the job system while the rest of the file is "
+          "read.  This has no effect until the job system is initialized."));
+
+static ConfigVariableInt bam_parallel_decode_min_size
+("bam-parallel-decode-min-size", 16384,
+ PRC_DESC("The smallest payload, in bytes, that is considered for parallel "
+          "decoding when bam-parallel-decode is true.  Smaller payloads are "
+          "decoded immediately, since they are not worth handing off."));
+
 TypeHandle BamReaderAuxData::_type_handle;
 
 WritableFactory *BamReader::_factory = nullptr;
@@ -29,6 +44,7 @@ BamReader *const BamReader::Null = nullptr;
 WritableFactory *const BamReader::NullFactory = nullptr;
 
 BamReader::NewTypes BamReader::_new_types;
+BamReader::ParallelFunc *BamReader::_parallel_func = nullptr;
 
 const int BamReader::_cur_major = _bam_major_ver;
 const int BamReader::_cur_minor = _bam_minor_ver;
@@ -49,6 +65,11 @@ BamReader(DatagramGenerator *source)
   _pta_id = -1;
   _long_object_id = false;
   _long_pta_id = false;
+  _mapped_datagram = nullptr;
+  _mapped_datagram_data = nullptr;
+  _parallel_decode = bam_parallel_decode;
+  _has_toc = false;
+  _toc_entry = -1;
 }
 
 
@@ -59,6 +80,7 @@ BamReader::
 ~BamReader() {
   nassertv(_num_extra_objects == 0);
   nassertv(_nesting_level == 0);
+  nassertv(_deferred_decodes.empty());
 }
 
 /**
@@ -266,6 +288,9 @@ read_object(TypedWritable *&ptr, ReferenceCount *&ref_ptr) {
     p_read_object();
   }
 
+  // The objects are only complete once their payloads have been decoded.
+  run_deferred_decodes();
+
   // Now look up the pointer of the object we read first.  It should be
   // available now.
   if (object_id == 0) {
@@ -325,6 +350,8 @@ skip_object() {
     p_read_object();
   }
 
+  run_deferred_decodes();
+
   return object_id != 0;
 }
 
@@ -343,6 +370,10 @@ skip_object() {
  */
 bool BamReader::
 resolve() {
+  // Objects may inspect each other's contents while completing their
+  // pointers, so make sure all of them have been fully read first.
+  run_deferred_decodes();
+
   bool all_completed;
   bool any_completed_this_pass;
 
@@ -469,6 +500,250 @@ resolve() {
   return all_completed;
 }
 
+/**
+ * Looks for a table of contents at the end of the bam file, as written by
+ * BamWriter::write_toc(), and reads it if it is there.  Returns true if the
+ * table was read, in which case individual objects may be read from anywhere
+ * in the file with read_toc_object().  Returns false if the file has no table
+ * of contents, or if the source does not support seeking.
+ *
+ * This may be called any time after init().  Since it moves the read
+ * position, the file should not be read in order with read_object()
+ * afterwards.
+ */
+bool BamReader::
+read_toc() {
+  _toc_entries.clear();
+  _toc_types.clear();
+  _has_toc = false;
+  nassertr(_source != nullptr && !_needs_init, false);
+
+  // The trailer at the very end of the file tells us where to find the table.
+  Datagram trailer;
+  if (!_source->seek_file_pos(-(std::streamoff)_bam_toc_trailer_size, std::ios::end) ||
+      !get_datagram(trailer) ||
+      trailer.get_length() + 4 != _bam_toc_trailer_size) {
+    return false;
+  }
+
+  DatagramIterator scan(trailer);
+  if (scan.get_uint8() != BOC_ignore ||
+      scan.get_fixed_string(_bam_toc_magic.size()) != _bam_toc_magic) {
+    return false;
+  }
+  std::streamoff toc_pos = (std::streamoff)scan.get_uint64();
+
+  Datagram dg;
+  if (!_source->seek_file_pos(toc_pos) || !get_datagram(dg)) {
+    bam_cat.error()
+      << "Unable to read table of contents of " << get_filename() << "\n";
+    return false;
+  }
+
+  scan.assign(dg);
+  if (dg.get_length() < 5 || scan.get_uint8() != BOC_ignore) {
+    bam_cat.error()
+      << "Invalid table of contents in " << get_filename() << "\n";
+    return false;
+  }
+
+  // Each field is checked against the size of what's left before it is read,
+  // so that a truncated or corrupt table is rejected rather than reading
+  // past the end of the datagram.
+  bool okay = true;
+  TypeRegistry *type_registry = TypeRegistry::ptr();
+  size_t num_types = scan.get_uint32();
+  for (size_t i = 0; okay && i < num_types; ++i) {
+    // Index, string length, and the string and entry that follow.
+    if (scan.get_remaining_size() < 4) {
+      okay = false;
+      break;
+    }
+    int index = scan.get_uint16();
+    size_t name_length = scan.get_uint16();
+    if (scan.get_remaining_size() < name_length + 4) {
+      okay = false;
+      break;
+    }
+    std::string name = scan.get_fixed_string(name_length);
+
+    TocType &toc_type = _toc_types[index];
+    toc_type._entry = scan.get_int32();
+    toc_type._type = type_registry->find_type(name);
+    if (toc_type._type == TypeHandle::none()) {
+      toc_type._type = type_registry->register_dynamic_type(name);
+      _new_types.insert(toc_type._type);
+    }
+  }
+
+  // The fixed-size fields of an entry: position, object ID, type index,
+  // flags, and the dependency and file data counts.
+  static const size_t entry_size = 8 + 4 + 2 + 1 + 4 + 4;
+
+  size_t num_entries = 0;
+  if (okay && scan.get_remaining_size() >= 4) {
+    num_entries = scan.get_uint32();
+    okay = (num_entries <= scan.get_remaining_size() / entry_size);
+  } else {
+    okay = false;
+  }
+
+  // BamWriter never writes a table of contents for a stream in which an
+  // object ID is reused, so read_toc_object() can look the objects up by ID.
+  // An ID listed more than once is the same object written again; it must
+  // keep its type.
+  pmap<int, TypeHandle> object_types;
+
+  if (okay) {
+    _toc_entries.resize(num_entries);
+  }
+  for (size_t n = 0; okay && n < num_entries; ++n) {
+    TocEntry &entry = _toc_entries[n];
+    if (scan.get_remaining_size() < entry_size) {
+      okay = false;
+      break;
+    }
+    entry._pos = (std::streamoff)scan.get_uint64();
+    entry._object_id = scan.get_uint32();
+
+    TocTypes::const_iterator ti = _toc_types.find(scan.get_uint16());
+    if (ti != _toc_types.end()) {
+      entry._type = (*ti).second._type;
+    }
+
+    unsigned char flags = scan.get_uint8();
+    entry._root = (flags & _bam_toc_root) != 0;
+    entry._long_object_id = (flags & _bam_toc_long_object_id) != 0;
+    entry._long_pta_id = (flags & _bam_toc_long_pta_id) != 0;
+    entry._loaded = false;
+
+    if (entry._object_id <= 0) {
+      okay = false;
+      break;
+    }
+    auto result = object_types.insert(std::make_pair(entry._object_id, entry._type));
+    if (!result.second && (*result.first).second != entry._type) {
+      okay = false;
+      break;
+    }
+
+    size_t num_deps = scan.get_uint32();
+    if (num_deps > (scan.get_remaining_size() - 4) / 4) {
+      okay = false;
+      break;
+    }
+    for (size_t i = 0; i < num_deps; ++i) {
+      size_t dep = scan.get_uint32();
+      if (dep < num_entries) {
+        entry._deps.push_back((int)dep);
+      }
+    }
+
+    size_t num_file_data = scan.get_uint32();
+    if (num_file_data > scan.get_remaining_size() / 8) {
+      okay = false;
+      break;
+    }
+    for (size_t i = 0; i < num_file_data; ++i) {
+      entry._file_data.push_back((std::streamoff)scan.get_uint64());
+    }
+  }
+
+  if (!okay || scan.get_remaining_size() != 0) {
+    bam_cat.error()
+      << "Invalid table of contents in " << get_filename() << "\n";
+    _toc_entries.clear();
+    _toc_types.clear();
+    return false;
+  }
+
+  if (bam_cat.is_debug()) {
+    bam_cat.debug()
+      << "Read table of contents with " << _toc_entries.size()
+      << " objects from " << get_filename() << "\n";
+  }
+
+  _has_toc = true;
+  return true;
+}
+
+/**
+ * Returns the index of the first object in the table of contents, starting
+ * at the indicated index, that is of the indicated type or a type derived
+ * from it, or -1 if there is no such object.
+ */
+int BamReader::
+find_toc_entry(TypeHandle type, int start) const {
+  for (int n = std::max(start, 0); n < (int)_toc_entries.size(); ++n) {
+    if (_toc_entries[n]._type.is_derived_from(type)) {
+      return n;
+    }
+  }
+  return -1;
+}
+
+/**
+ * Reads the nth object listed in the table of contents, along with all of
+ * the objects it refers to, directly or indirectly, that have not already
+ * been read.  Nothing else in the file is read.  read_toc() must have been
+ * called first.
+ *
+ * As with read_object(), the returned pointers are not valid for use until
+ * resolve() is subsequently called.
+ * @return true on success, or false on failure.
+ */
+bool BamReader::
+read_toc_object(int n, TypedWritable *&ptr, ReferenceCount *&ref_ptr) {
+  ptr = nullptr;
+  ref_ptr = nullptr;
+  nassertr(_has_toc, false);
+  nassertr(n >= 0 && n < (int)_toc_entries.size(), false);
+
+  // Gather up the object and everything it needs that hasn't been read yet.
+  vector_int needed;
+  vector_int stack;
+  pset<int> visited;
+  stack.push_back(n);
+  while (!stack.empty()) {
+    int i = stack.back();
+    stack.pop_back();
+    if (_toc_entries[i]._loaded || !visited.insert(i).second) {
+      continue;
+    }
+    needed.push_back(i);
+    for (int dep : _toc_entries[i]._deps) {
+      stack.push_back(dep);
+    }
+  }
+
+  // The entries are listed in file order.  They have to be read in that order
+  // too, since shared arrays are only defined by the first object that wrote
+  // them.
+  std::sort(needed.begin(), needed.end());
+  for (int i : needed) {
+    if (!read_toc_entry(i)) {
+      run_deferred_decodes();
+      return false;
+    }
+  }
+
+  run_deferred_decodes();
+
+  // BamWriter doesn't write a table of contents for a stream that reuses an
+  // object ID, so the ID identifies the object of the entry.
+  CreatedObjs::iterator oi = _created_objs.find(_toc_entries[n]._object_id);
+  if (oi == _created_objs.end()) {
+    bam_cat.error()
+      << "Undefined object encountered!\n";
+    return false;
+  }
+
+  CreatedObj &created_obj = (*oi).second;
+  ptr = created_obj._ptr;
+  ref_ptr = created_obj._ref_ptr;
+  return ptr != nullptr;
+}
+
 /**
  * Indicates that an object recently read from the bam stream should be
  * replaced with a new object.  Any future occurrences of the original object
@@ -551,8 +826,18 @@ read_handle(DatagramIterator &scan) {
     return TypeHandle::none();
   }
 
+  if (_toc_entry >= 0) {
+    // We are reading objects out of order, so we can't go by which types we
+    // have encountered so far.  The table of contents tells us which
+    // datagram carries the definition.
+    TocTypes::const_iterator ti = _toc_types.find(id);
+    if (ti != _toc_types.end() && (*ti).second._entry != _toc_entry) {
+      return (*ti).second._type;
+    }
+  }
+
   IndexMap::const_iterator mi = _index_map.find(id);
-  if (mi != _index_map.end()) {
+  if (mi != _index_map.end() && _toc_entry < 0) {
     // We've encountered this index number before, so there should be no type
     // definition following the id.  Simply return the TypeHandle we
     // previously associated with the id.
@@ -599,7 +884,7 @@ read_handle(DatagramIterator &scan) {
   }
 
   bool inserted = _index_map.insert(IndexMap::value_type(id, type)).second;
-  nassertr(inserted, type);
+  nassertr(inserted || _toc_entry >= 0, type);
 
   if (bam_cat.is_spam()) {
     bam_cat.spam()
@@ -702,6 +987,88 @@ read_file_data(SubfileInfo &info) {
   _file_data_records.pop_front();
 }
 
+/**
+ * Skips over the padding written by a matching call to
+ * BamWriter::write_alignment_padding().
+ */
+void BamReader::
+skip_alignment_padding(DatagramIterator &scan) {
+  size_t pad = scan.get_uint8();
+  scan.skip_bytes(pad);
+}
+
+/**
+ * If the source is memory-mapped, checks whether the next size bytes of the
+ * indicated datagram, which must belong to the object currently being read,
+ * can be referenced in place within the mapping at the indicated alignment.
+ * If so, fills in mapping and data and returns true; the caller should keep a
+ * reference to the mapping for as long as it references the data.  Returns
+ * false if the data has to be copied out of the datagram as usual.
+ *
+ * This does not advance the iterator.
+ */
+bool BamReader::
+get_mapped_data(const DatagramIterator &scan, size_t size, size_t alignment,
+                PT(VirtualFileMapping) &mapping,
+                const unsigned char *&data) const {
+  if (_mapped_datagram_data == nullptr ||
+      &scan.get_datagram() != _mapped_datagram ||
+      scan.get_remaining_size() < size) {
+    return false;
+  }
+
+  const unsigned char *ptr = _mapped_datagram_data + scan.get_current_index();
+  if (((uintptr_t)ptr % alignment) != 0) {
+    return false;
+  }
+
+  // As a sanity check, make sure the mapping really does hold the same bytes
+  // that we read from the stream.
+  const unsigned char *expected = (const unsigned char *)scan.get_datagram().get_data() + scan.get_current_index();
+  if (memcmp(ptr, expected, std::min(size, (size_t)16)) != 0) {
+    return false;
+  }
+
+  mapping = _source->get_mapping();
+  if (mapping == nullptr) {
+    return false;
+  }
+  data = ptr;
+  return true;
+}
+
+/**
+ * Arranges for the next size bytes of the indicated datagram, which must
+ * belong to the object currently being read, to be decoded by the indicated
+ * function, and advances the iterator past them.
+ *
+ * The function is given an iterator positioned at the start of the payload.
+ * If parallel decoding is enabled and the payload is large enough, it is not
+ * called right away, but together with the other payloads deferred while
+ * reading the current object, possibly on several threads at once, before
+ * read_object() returns.  It must therefore do nothing but unpack the bytes
+ * into storage that belongs to the object being read and was allocated by
+ * the caller, and it may not call back into the BamReader.
+ */
+void BamReader::
+defer_decode(DatagramIterator &scan, size_t size, DecodeFunc func) {
+  if (!_parallel_decode || _parallel_func == nullptr ||
+      size < (size_t)bam_parallel_decode_min_size ||
+      &scan.get_datagram() != _mapped_datagram ||
+      scan.get_remaining_size() < size) {
+    func(scan);
+    return;
+  }
+
+  DeferredDecode decode;
+  decode._datagram = scan.get_datagram();
+  decode._index = scan.get_current_index();
+  decode._func = std::move(func);
+  _deferred_decodes.push_back(std::move(decode));
+
+  scan.skip_bytes(size);
+}
+
 /**
  * Reads in the indicated CycleData object.  This should be used by classes
  * that store some or all of their data within a CycleData subclass, in
@@ -918,6 +1285,7 @@ finalize_now(TypedWritable *whom) {
 
   Finalize::iterator fi = _finalize_list.find(whom);
   if (fi != _finalize_list.end()) {
+    run_deferred_decodes();
     _finalize_list.erase(fi);
     if (bam_cat.is_spam()) {
       bam_cat.spam()
@@ -1080,6 +1448,10 @@ p_read_object() {
     return 0;
   }
 
+  // If the source is memory-mapped, this is where the datagram's contents
+  // are found within the mapping.
+  const unsigned char *mapped_data = _source->get_mapped_datagram_data();
+
   // Now extract the object definition from the datagram.
   DatagramIterator scan(dg);
 
@@ -1195,9 +1567,15 @@ p_read_object() {
       // This might recursively call back into this p_read_object(), so be
       // sure to save and restore the original value of _now_creating.
       CreatedObjs::iterator was_creating = _now_creating;
+      const Datagram *was_mapped_datagram = _mapped_datagram;
+      const unsigned char *was_mapped_data = _mapped_datagram_data;
       _now_creating = oi;
+      _mapped_datagram = &dg;
+      _mapped_datagram_data = mapped_data;
       created_obj._ptr->fillin(scan, this);
       _now_creating = was_creating;
+      _mapped_datagram = was_mapped_datagram;
+      _mapped_datagram_data = was_mapped_data;
 
       if (scan.get_remaining_size() > 0) {
         bam_cat.warning()
@@ -1215,10 +1593,16 @@ p_read_object() {
 
       // As above, we update and preserve _now_creating during this call.
       CreatedObjs::iterator was_creating = _now_creating;
+      const Datagram *was_mapped_datagram = _mapped_datagram;
+      const unsigned char *was_mapped_data = _mapped_datagram_data;
       _now_creating = oi;
+      _mapped_datagram = &dg;
+      _mapped_datagram_data = mapped_data;
       TypedWritable *object =
         _factory->make_instance_more_general(type, fparams);
       _now_creating = was_creating;
+      _mapped_datagram = was_mapped_datagram;
+      _mapped_datagram_data = was_mapped_data;
 
       // And now we can store the new object pointer in the map.
       nassertr(created_obj._ptr == object || created_obj._ptr == nullptr, object_id);
@@ -1316,6 +1700,48 @@ p_read_object() {
   return object_id;
 }
 
+/**
+ * Reads the object datagram of the nth entry in the table of contents, along
+ * with any auxiliary file data that goes with it.  Returns true on success.
+ */
+bool BamReader::
+read_toc_entry(int n) {
+  TocEntry &entry = _toc_entries[n];
+  entry._loaded = true;
+
+  for (std::streampos pos : entry._file_data) {
+    SubfileInfo info;
+    if (!_source->seek_file_pos(pos) || !_source->save_datagram(info)) {
+      bam_cat.error()
+        << "Failed to read file data.\n";
+      return false;
+    }
+    _file_data_records.push_back(info);
+  }
+
+  if (!_source->seek_file_pos(entry._pos)) {
+    return false;
+  }
+
+  // The width of the IDs depends on how many were written before this point.
+  _long_object_id = entry._long_object_id;
+  _long_pta_id = entry._long_pta_id;
+
+  int was_nesting_level = _nesting_level;
+  _toc_entry = n;
+  int object_id = p_read_object();
+  _toc_entry = -1;
+  _nesting_level = was_nesting_level;
+
+  if (object_id != entry._object_id) {
+    bam_cat.error()
+      << "Table of contents of " << get_filename()
+      << " does not match its contents.\n";
+    return false;
+  }
+  return true;
+}
+
 /**
  * Checks whether all of the pointers a particular object is waiting for have
  * been filled in yet.  If they have, calls complete_pointers() on the object
@@ -1517,6 +1943,36 @@ resolve_cycler_pointers(PipelineCyclerBase *cycler,
   return false;
 }
 
+/**
+ * Runs all the payload decodes that were put off by defer_decode(), spreading
+ * them over the job system's threads, and waits for them to finish.
+ */
+void BamReader::
+run_deferred_decodes() {
+  if (_deferred_decodes.empty()) {
+    return;
+  }
+
+  // Move the list aside first, so that it is left empty even if a decode
+  // somehow ends up back in here.
+  DeferredDecodes decodes;
+  decodes.swap(_deferred_decodes);
+
+  auto run_one = [&decodes] (int i) {
+    DeferredDecode &decode = decodes[i];
+    DatagramIterator scan(decode._datagram, decode._index);
+    decode._func(scan);
+  };
+
+  if (decodes.size() == 1 || _parallel_func == nullptr) {
+    for (size_t i = 0; i < decodes.size(); ++i) {
+      run_one((int)i);
+    }
+  } else {
+    (*_parallel_func)((int)decodes.size(), run_one);
+  }
+}
+
 /**
  * Should be called after all objects have been read, this will finalize all
  * the objects that registered themselves for the finalize callback.
@@ -1528,6 +1984,8 @@ finalize() {
       << "Finalizing bam source\n";
   }
 
+  run_deferred_decodes();
+
   Finalize::iterator fi = _finalize_list.begin();
   while (fi != _finalize_list.end()) {
     TypedWritable *object = (*fi);
@@ -25,6 +25,7 @@
 #include "bamReaderParam.h"
 #include "bamEnums.h"
 #include "subfileInfo.h"
+#include "virtualFileMapping.h"
 #include "loaderOptions.h"
 #include "factory.h"
 #include "vector_int.h"
@@ -36,6 +37,7 @@
 #include "referenceCount.h"
 
 #include <algorithm>
+#include <functional>
 
 
 // A handy macro for reading PointerToArrays.
@@ -132,6 +134,9 @@ PUBLISHED:
   INLINE const LoaderOptions &get_loader_options() const;
   INLINE void set_loader_options(const LoaderOptions &options);
 
+  INLINE void set_parallel_decode(bool flag);
+  INLINE bool get_parallel_decode() const;
+
 #if defined(CPPPARSER) && defined(HAVE_PYTHON)
   EXTENSION(PyObject *read_object());
 #else
@@ -143,6 +148,16 @@ PUBLISHED:
   INLINE bool is_eof() const;
   bool resolve();
 
+  bool read_toc();
+  INLINE bool has_toc() const;
+  INLINE int get_num_toc_entries() const;
+  INLINE int get_toc_object_id(int n) const;
+  INLINE TypeHandle get_toc_type(int n) const;
+  INLINE bool is_toc_root(int n) const;
+  INLINE int get_num_toc_dependencies(int n) const;
+  INLINE int get_toc_dependency(int n, int i) const;
+  int find_toc_entry(TypeHandle type, int start = 0) const;
+
   bool change_pointer(const TypedWritable *orig_pointer, const TypedWritable *new_pointer);
 
   INLINE int get_file_major_ver() const;
@@ -159,6 +174,7 @@ PUBLISHED:
   MAKE_PROPERTY(source, get_source, set_source);
   MAKE_PROPERTY(filename, get_filename);
   MAKE_PROPERTY(loader_options, get_loader_options, set_loader_options);
+  MAKE_PROPERTY(parallel_decode, get_parallel_decode, set_parallel_decode);
 
   PY_MAKE_PROPERTY(file_version, get_file_version);
   MAKE_PROPERTY(file_endian, get_file_endian);
@@ -173,6 +189,16 @@ public:
 
   void read_file_data(SubfileInfo &info);
 
+  void skip_alignment_padding(DatagramIterator &scan);
+  bool get_mapped_data(const DatagramIterator &scan, size_t size,
+                       size_t alignment, PT(VirtualFileMapping) &mapping,
+                       const unsigned char *&data) const;
+
+  BLOCKING bool read_toc_object(int n, TypedWritable *&ptr, ReferenceCount *&ref_ptr);
+
+  typedef std::function<void(DatagramIterator &scan)> DecodeFunc;
+  void defer_decode(DatagramIterator &scan, size_t size, DecodeFunc func);
+
   void read_cdata(DatagramIterator &scan, PipelineCyclerBase &cycler);
   void read_cdata(DatagramIterator &scan, PipelineCyclerBase &cycler,
                   void *extra_data);
@@ -206,6 +232,9 @@ public:
                                       void *user_data = nullptr);
   INLINE static WritableFactory *get_factory();
 
+  typedef void ParallelFunc(int count, const std::function<void(int)> &func);
+  INLINE static void set_parallel_func(ParallelFunc *func);
+
 PUBLISHED:
   PY_EXTENSION(static void register_factory(TypeHandle handle, PyObject *func));
 
@@ -223,6 +252,8 @@ private:
   bool resolve_cycler_pointers(PipelineCyclerBase *cycler, const vector_int &pointer_ids,
                                bool require_fully_complete);
   void finalize();
+  void run_deferred_decodes();
+  bool read_toc_entry(int n);
 
   INLINE bool get_datagram(Datagram &datagram);
 
@@ -326,6 +357,59 @@ private:
   typedef pdeque<SubfileInfo> FileDataRecords;
   FileDataRecords _file_data_records;
 
+  // If the source is memory-mapped, this is the datagram of the object
+  // currently being read, along with the location of its contents within the
+  // mapping.  See get_mapped_data().
+  const Datagram *_mapped_datagram;
+  const unsigned char *_mapped_datagram_data;
+
+  // Payloads whose decoding was put off by defer_decode(), to be done in
+  // parallel once the current object and everything it references has been
+  // read.  Each keeps a reference to the datagram it is read from.
+  class DeferredDecode {
+  public:
+    Datagram _datagram;
+    size_t _index;
+    DecodeFunc _func;
+  };
+  typedef pvector<DeferredDecode> DeferredDecodes;
+  DeferredDecodes _deferred_decodes;
+  bool _parallel_decode;
+
+  static ParallelFunc *_parallel_func;
+
+  // The table of contents read by read_toc(), listing where each object is
+  // found in the file and which other objects must be read before it.
+  class TocEntry {
+  public:
+    std::streampos _pos;
+    int _object_id;
+    TypeHandle _type;
+    bool _root;
+    bool _long_object_id;
+    bool _long_pta_id;
+    bool _loaded;
+    vector_int _deps;
+    pvector<std::streampos> _file_data;
+  };
+  typedef pvector<TocEntry> TocEntries;
+  TocEntries _toc_entries;
+
+  // The type of each type index in the file, and the entry whose datagram
+  // carries its definition.
+  class TocType {
+  public:
+    TypeHandle _type;
+    int _entry;
+  };
+  typedef phash_map<int, TocType, int_hash> TocTypes;
+  TocTypes _toc_types;
+  bool _has_toc;
+
+  // The entry currently being read by read_toc_object(), or -1 when reading
+  // the file in order.
+  int _toc_entry;
+
   // This is used internally to record all of the new types created on-the-fly
   // to satisfy bam requirements.  We keep track of this just so we can
   // suppress warning messages from attempts to create objects of these types.
@@ -39,6 +39,9 @@ struct ObsoleteName {
   }
 };
 
+// Marks an object ID in _toc_object_entries whose object has been freed.
+static const int toc_freed_id = -2;
+
 // This is a SimpleHashMap to avoid static init ordering issues.
 static SimpleHashMap<TypeHandle, std::set<ObsoleteName> > obsolete_type_names;
 
@@ -60,6 +63,9 @@ BamWriter(DatagramSink *target) :
   _next_pta_id = 1;
   _long_pta_id = false;
 
+  _toc_current = -1;
+  _write_toc = false;
+
   // Check which version .bam files we should write.
   if (bam_version.get_num_words() > 0) {
     if (bam_version.get_num_words() != 2) {
@@ -270,6 +276,96 @@ flush() {
   _target->flush();
 }
 
+/**
+ * Appends a table of contents to the output, listing the position, type and
+ * dependencies of each object written so far, so that a BamReader may later
+ * read any one of them without reading the rest of the file.  See
+ * BamReader::read_toc().
+ *
+ * This should be called once, after the last object has been written.  It
+ * does nothing and returns false if set_write_toc() was not enabled, or if
+ * the positions of the objects within the output are not known.
+ */
+bool BamWriter::
+write_toc() {
+  nassertr(_target != nullptr, false);
+  if (!_write_toc || _toc_entries.empty() || _target->is_error()) {
+    return false;
+  }
+  _write_toc = false;
+
+  std::streampos toc_pos = _target->get_file_pos();
+  if (toc_pos <= 0) {
+    return false;
+  }
+
+  Datagram dg;
+  dg.add_uint8(BOC_ignore);
+
+  dg.add_uint32(_toc_types.size());
+  for (const TocType &toc_type : _toc_types) {
+    dg.add_uint16(toc_type._index);
+    dg.add_string(toc_type._name);
+    dg.add_int32(toc_type._entry);
+  }
+
+  dg.add_uint32(_toc_entries.size());
+  for (size_t i = 0; i < _toc_entries.size(); ++i) {
+    const TocEntry &entry = _toc_entries[i];
+    if (entry._pos <= 0) {
+      // We don't know where this one went.
+      return false;
+    }
+
+    dg.add_uint64((std::streamoff)entry._pos);
+    dg.add_uint32(entry._object_id);
+    dg.add_uint16(entry._type_index);
+    dg.add_uint8(entry._flags);
+
+    // Leave out duplicates and references to the entry itself, keeping the
+    // order in which the pointers were written.
+    vector_int deps;
+    pset<int> seen;
+    seen.insert((int)i);
+    for (int dep : entry._deps) {
+      if (dep >= 0 && seen.insert(dep).second) {
+        deps.push_back(dep);
+      }
+    }
+
+    dg.add_uint32(deps.size());
+    for (int dep : deps) {
+      dg.add_uint32(dep);
+    }
+
+    dg.add_uint32(entry._file_data.size());
+    for (std::streampos pos : entry._file_data) {
+      dg.add_uint64((std::streamoff)pos);
+    }
+  }
+
+  // The trailer that lets the reader find the table from the end of the
+  // file.
+  Datagram trailer;
+  trailer.add_uint8(BOC_ignore);
+  trailer.append_data(_bam_toc_magic.data(), _bam_toc_magic.size());
+  trailer.add_uint64((std::streamoff)toc_pos);
+  nassertr(trailer.get_length() + 4 == _bam_toc_trailer_size, false);
+
+  _toc_entries.clear();
+  _toc_object_entries.clear();
+  _toc_pta_entries.clear();
+  _toc_pending_deps.clear();
+  _toc_types.clear();
+
+  if (!_target->put_datagram(dg) || !_target->put_datagram(trailer)) {
+    util_cat.error()
+      << "Unable to write data to output.\n";
+    return false;
+  }
+  return true;
+}
+
 /**
  * Should be called from TypedWritable::update_bam_nested() to recursively
  * check the entire hiererachy of writable objects for needed updates.  This
@@ -328,6 +424,7 @@ write_pointer(Datagram &packet, const TypedWritable *object) {
       // the object definition up for later.
       int object_id = enqueue_object(object);
       write_object_id(packet, object_id);
+      add_toc_object_dep(object_id, true);
 
     } else {
       // We have already assigned this pointer an ID, so it has previously
@@ -342,6 +439,7 @@ write_pointer(Datagram &packet, const TypedWritable *object) {
       }
 
       write_object_id(packet, object_id);
+      add_toc_object_dep(object_id, !already_written);
 
       if (!already_written) {
         // It's stale, so queue the object for rewriting too.
@@ -374,6 +472,9 @@ write_file_data(SubfileInfo &result, const Filename &filename) {
 
   // Then we can write the file data itself, as its own (possibly quite large)
   // followup datagram.
+  if (_toc_current >= 0) {
+    _toc_entries[_toc_current]._file_data.push_back(_target->get_file_pos());
+  }
   if (!_target->copy_datagram(result, filename)) {
     util_cat.error()
       << "Unable to write file data to output.\n";
@@ -405,6 +506,9 @@ write_file_data(SubfileInfo &result, const SubfileInfo &source) {
 
   // Then we can write the file data itself, as its own (possibly quite large)
   // followup datagram.
+  if (_toc_current >= 0) {
+    _toc_entries[_toc_current]._file_data.push_back(_target->get_file_pos());
+  }
   if (!_target->copy_datagram(result, source)) {
     util_cat.error()
       << "Unable to write file data to output.\n";
@@ -416,6 +520,30 @@ write_file_data(SubfileInfo &result, const SubfileInfo &source) {
   // order and queued up in the BamReader.
 }
 
+/**
+ * Writes enough padding to the indicated datagram, which must be the datagram
+ * of the object currently being written, so that whatever is written next
+ * begins at a multiple of the indicated alignment (which must be less than
+ * 256) from the start of the file.  This allows a BamReader reading from a
+ * memory-mapped file to reference that data in place; see
+ * BamReader::get_mapped_data().  This must be balanced by a matching call to
+ * BamReader::skip_alignment_padding() on restore.
+ *
+ * The padding is only an optimization; if the datagram ends up elsewhere in
+ * the file than predicted here, the data will simply be copied on load.
+ */
+void BamWriter::
+write_alignment_padding(Datagram &packet, size_t alignment) {
+  nassertv(alignment > 0 && alignment < 256);
+
+  // Account for the length prefix that precedes the datagram in the file and
+  // for the padding count itself.
+  size_t pos = (size_t)_target->get_file_pos() + 4 + packet.get_length() + 1;
+  size_t pad = (alignment - pos % alignment) % alignment;
+  packet.add_uint8((uint8_t)pad);
+  packet.pad_bytes(pad);
+}
+
 /**
  * Writes out the indicated CycleData object.  This should be used by classes
  * that store some or all of their data within a CycleData subclass, in
@@ -481,6 +609,13 @@ register_pta(Datagram &packet, const void *ptr) {
     bool inserted = _pta_map.insert(PTAMap::value_type(ptr, pta_id)).second;
     nassertr(inserted, false);
 
+    if (_write_toc) {
+      if (pta_id >= (int)_toc_pta_entries.size()) {
+        _toc_pta_entries.resize(pta_id + 1, -1);
+      }
+      _toc_pta_entries[pta_id] = _toc_current;
+    }
+
     write_pta_id(packet, pta_id);
 
     // Return false to indicate the caller must now write out the array
@@ -492,6 +627,15 @@ register_pta(Datagram &packet, const void *ptr) {
     int pta_id = (*pi).second;
     write_pta_id(packet, pta_id);
 
+    // The array is only defined in the datagram of the object that wrote it
+    // first, so that object must be read before this one.
+    if (_toc_current >= 0 && pta_id < (int)_toc_pta_entries.size()) {
+      int owner = _toc_pta_entries[pta_id];
+      if (owner >= 0 && owner != _toc_current) {
+        _toc_entries[_toc_current]._deps.push_back(owner);
+      }
+    }
+
     // Return true to indicate the caller need do nothing further.
     return true;
   }
@@ -525,12 +669,22 @@ write_handle(Datagram &packet, TypeHandle type) {
       // This is the first time this TypeHandle has been written, so also
       // write out its definition.
 
+      std::string name;
       if (_file_major == _bam_major_ver && _file_minor == _bam_minor_ver) {
-        packet.add_string(type.get_name());
+        name = type.get_name();
       } else {
         // We are writing an older .bam format, so we need to look up whether
         // we may need to write an older type name.
-        packet.add_string(get_obsolete_type_name(type, _file_major, _file_minor));
+        name = get_obsolete_type_name(type, _file_major, _file_minor);
+      }
+      packet.add_string(name);
+
+      if (_write_toc) {
+        TocType toc_type;
+        toc_type._index = index;
+        toc_type._name = std::move(name);
+        toc_type._entry = _toc_current;
+        _toc_types.push_back(std::move(toc_type));
       }
 
       // We also need to write the derivation of the TypeHandle, in case the
@@ -605,6 +759,15 @@ object_destructs(TypedWritable *object) {
     int object_id = (*si).second._object_id;
     _freed_object_ids.push_back(object_id);
 
+    // A reader that reads by the table of contents skips the BOC_remove, so
+    // it could not tell another object written with this ID from this one.
+    // Remember that the ID was freed, so that flush_queue() can refuse to
+    // write a table of contents if the ID is ever written again.
+    if (object_id < (int)_toc_object_entries.size()) {
+      _toc_object_entries[object_id] = toc_freed_id;
+    }
+    _toc_pending_deps.erase(object_id);
+
     _state_map.erase(si);
   }
 }
@@ -627,6 +790,28 @@ write_object_id(Datagram &dg, int object_id) {
   }
 }
 
+/**
+ * Records that the object whose table of contents entry is being written
+ * refers to the indicated object.  If queued is true, the object is about to
+ * be written or rewritten, and the dependency is on the entry it gets then;
+ * otherwise it is on the entry that last wrote the object.
+ */
+void BamWriter::
+add_toc_object_dep(int object_id, bool queued) {
+  if (_toc_current < 0) {
+    return;
+  }
+
+  vector_int &deps = _toc_entries[_toc_current]._deps;
+  if (queued) {
+    _toc_pending_deps[object_id].push_back(std::make_pair(_toc_current, deps.size()));
+    deps.push_back(-1);
+
+  } else if (object_id < (int)_toc_object_entries.size()) {
+    deps.push_back(_toc_object_entries[object_id]);
+  }
+}
+
 /**
  * Writes the indicated pta id to the datagram.
  */
@@ -741,6 +926,7 @@ flush_queue() {
     Datagram dg;
     dg.set_stdfloat_double(_file_stdfloat_double);
     dg.add_uint8(_next_boc);
+    bool is_root = (_next_boc == BOC_push);
     _next_boc = BOC_adjunct;
 
     if (!already_written) {
@@ -772,6 +958,55 @@ flush_queue() {
           << " to bam file\n";
       }
 
+      if (_write_toc && object_id < (int)_toc_object_entries.size() &&
+          _toc_object_entries[object_id] == toc_freed_id) {
+        // The ID of a freed object is being written again.  BamReader looks
+        // up the objects it reads by the table of contents by their IDs, so
+        // it would find the freed object instead of this one.
+        util_cat.warning()
+          << "Object id " << object_id << " was reused; not writing a table "
+          << "of contents to the bam file.\n";
+        _write_toc = false;
+        _toc_current = -1;
+        _toc_entries.clear();
+        _toc_object_entries.clear();
+        _toc_pta_entries.clear();
+        _toc_pending_deps.clear();
+        _toc_types.clear();
+      }
+
+      if (_write_toc) {
+        TocEntry entry;
+        entry._object_id = object_id;
+        entry._type_index = type.get_index();
+        entry._flags = 0;
+        if (is_root) {
+          entry._flags |= _bam_toc_root;
+        }
+        if (_long_object_id) {
+          entry._flags |= _bam_toc_long_object_id;
+        }
+        if (_long_pta_id) {
+          entry._flags |= _bam_toc_long_pta_id;
+        }
+        _toc_current = (int)_toc_entries.size();
+        _toc_entries.push_back(std::move(entry));
+
+        if (object_id >= (int)_toc_object_entries.size()) {
+          _toc_object_entries.resize(object_id + 1, -1);
+        }
+        _toc_object_entries[object_id] = _toc_current;
+
+        // Point the objects that were waiting for this one at this entry.
+        TocPendingDeps::iterator pi = _toc_pending_deps.find(object_id);
+        if (pi != _toc_pending_deps.end()) {
+          for (const std::pair<int, size_t> &slot : (*pi).second) {
+            _toc_entries[slot.first]._deps[slot.second] = _toc_current;
+          }
+          _toc_pending_deps.erase(pi);
+        }
+      }
+
       write_handle(dg, type);
       write_object_id(dg, object_id);
 
@@ -809,6 +1044,11 @@ flush_queue() {
       ((TypedWritable *)object)->update_bam_nested(this);
     }
 
+    if (_toc_current >= 0) {
+      _toc_entries[_toc_current]._pos = _target->get_file_pos();
+      _toc_current = -1;
+    }
+
     if (!_target->put_datagram(dg)) {
       util_cat.error()
         << "Unable to write data to output.\n";
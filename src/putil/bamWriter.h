@@ -90,6 +90,10 @@ PUBLISHED:
   INLINE TypedWritable *get_root_node() const;
   INLINE void set_root_node(TypedWritable *root_node);
 
+  INLINE void set_write_toc(bool flag);
+  INLINE bool get_write_toc() const;
+  bool write_toc();
+
 public:
   EXTENSION(PyObject *get_file_version() const);
 
@@ -112,6 +116,7 @@ public:
 
   void write_file_data(SubfileInfo &result, const Filename &filename);
   void write_file_data(SubfileInfo &result, const SubfileInfo &source);
+  void write_alignment_padding(Datagram &packet, size_t alignment);
 
   void write_cdata(Datagram &packet, const PipelineCyclerBase &cycler);
   void write_cdata(Datagram &packet, const PipelineCyclerBase &cycler,
@@ -127,6 +132,7 @@ private:
   void object_destructs(TypedWritable *object);
 
   void write_object_id(Datagram &dg, int object_id);
+  void add_toc_object_dep(int object_id, bool queued);
   void write_pta_id(Datagram &dg, int pta_id);
   int enqueue_object(const TypedWritable *object);
   bool flush_queue();
@@ -193,6 +199,49 @@ private:
   int _next_pta_id;
   bool _long_pta_id;
 
+  // This records where each object was written and which other entries it
+  // needs in order to be read, for the table of contents written by
+  // write_toc().  A dependency is -1 until the entry it refers to has been
+  // written.
+  class TocEntry {
+  public:
+    std::streampos _pos;
+    int _object_id;
+    int _type_index;
+    unsigned char _flags;
+    vector_int _deps;
+    pvector<std::streampos> _file_data;
+  };
+  typedef pvector<TocEntry> TocEntries;
+  TocEntries _toc_entries;
+
+  // The entry of the object currently being written, or -1.
+  int _toc_current;
+
+  // The entry that last wrote each object ID, and that first defined each
+  // PTA ID.  An object ID's entry is set to toc_freed_id when the ID is
+  // freed, and no table of contents is written if it is used again.
+  vector_int _toc_object_entries;
+  vector_int _toc_pta_entries;
+
+  // Dependencies on objects that are queued to be written, and so have no
+  // entry yet, by object ID.  Each is an entry index and a position within
+  // its _deps, which are filled in when the object is written.
+  typedef pvector<std::pair<int, size_t> > TocDepSlots;
+  typedef pmap<int, TocDepSlots> TocPendingDeps;
+  TocPendingDeps _toc_pending_deps;
+
+  // The entry in which each type definition was written.
+  class TocType {
+  public:
+    int _index;
+    std::string _name;
+    int _entry;
+  };
+  typedef pvector<TocType> TocTypes;
+  TocTypes _toc_types;
+  bool _write_toc;
+
   // The destination to write all the output to.
   DatagramSink *_target;
   bool _needs_init;
@@ -78,6 +78,8 @@ open(std::istream &in, const Filename &filename) {
 void DatagramInputFile::
 close() {
   _vfile.clear();
+  _mapping.clear();
+  _mapped_datagram_data = nullptr;
   if (_owns_in) {
     VirtualFileSystem *vfs = VirtualFileSystem::get_global_ptr();
     vfs->close_read_file(_in);
@@ -125,6 +127,7 @@ bool DatagramInputFile::
 get_datagram(Datagram &data) {
   nassertr(_in != nullptr, false);
   _read_first_datagram = true;
+  _mapped_datagram_data = nullptr;
 
   // First, get the size of the upcoming datagram.
   StreamReader reader(_in, false);
@@ -172,6 +175,15 @@ get_datagram(Datagram &data) {
     }
   }
 
+  if (_mapping != nullptr) {
+    // Note where the datagram lies within the mapping, so that its contents
+    // may be referenced in place.
+    streampos pos = _in->tellg();
+    if (pos >= 0 && (size_t)pos + num_bytes <= _mapping->get_size()) {
+      _mapped_datagram_data = _mapping->get_data() + (size_t)pos;
+    }
+  }
+
   // Now, read the datagram itself. We construct an empty datagram, use
   // pad_bytes to make it big enough, and read *directly* into the datagram's
   // internal buffer. Doing this saves us a copy operation.
@@ -368,3 +380,63 @@ get_file_pos() {
   }
   return _in->tellg();
 }
+
+/**
+ * Moves the read position within the file, so that the next call to
+ * get_datagram() returns the datagram that begins at the indicated position.
+ * Returns true on success.
+ */
+bool DatagramInputFile::
+seek_file_pos(std::streamoff offset, std::ios::seekdir dir) {
+  if (_in == nullptr) {
+    return false;
+  }
+  _mapped_datagram_data = nullptr;
+  _in->clear();
+  _in->seekg(offset, dir);
+  return !_in->fail();
+}
+
+/**
+ * Maps the file being read into memory, in addition to reading it as a
+ * stream, so that the contents of each datagram may also be accessed in place
+ * through get_mapped_datagram_data().  This is only possible for a file
+ * opened by filename that is stored uncompressed on disk.  Returns true if
+ * the file is now mapped, false otherwise.
+ */
+bool DatagramInputFile::
+map_file() {
+  _mapping.clear();
+  _mapped_datagram_data = nullptr;
+  if (_vfile == nullptr) {
+    return false;
+  }
+
+  PT(VirtualFileMapping) mapping = _vfile->map_file(true);
+  if (mapping == nullptr || !mapping->is_mapped()) {
+    // There is no point in keeping a copy of the file in a buffer.
+    return false;
+  }
+
+  _mapping = std::move(mapping);
+  return true;
+}
+
+/**
+ * Returns the memory mapping of the file, if map_file() has been called
+ * successfully, or NULL otherwise.
+ */
+VirtualFileMapping *DatagramInputFile::
+get_mapping() {
+  return _mapping;
+}
+
+/**
+ * If the file is mapped, returns a pointer to the contents of the datagram
+ * most recently returned by get_datagram() within the mapping.  Returns NULL
+ * if the file is not mapped.
+ */
+const unsigned char *DatagramInputFile::
+get_mapped_datagram_data() {
+  return _mapped_datagram_data;
+}
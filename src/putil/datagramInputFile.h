@@ -49,11 +49,22 @@ PUBLISHED:
   virtual VirtualFile *get_vfile();
   virtual std::streampos get_file_pos();
 
+  bool map_file();
+
+public:
+  virtual bool seek_file_pos(std::streamoff offset,
+                             std::ios::seekdir dir = std::ios::beg);
+
+  virtual VirtualFileMapping *get_mapping();
+  virtual const unsigned char *get_mapped_datagram_data();
+
 private:
   bool _read_first_datagram;
   bool _error;
   CPT(FileReference) _file;
   PT(VirtualFile) _vfile;
+  PT(VirtualFileMapping) _mapping;
+  const unsigned char *_mapped_datagram_data;
   std::istream *_in;
   bool _owns_in;
   Filename _filename;
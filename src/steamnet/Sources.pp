@@ -15,6 +15,7 @@
     steamNetworkEnums.h \
     steamNetworkEvent.h steamNetworkEvent.I \
     steamNetworkMessage.h steamNetworkMessage.I \
+    steamNetworkMessageBatch.h steamNetworkMessageBatch.I \
     steamNetworkSystem.h steamNetworkSystem.I
 
   #define COMPOSITE_SOURCES \
@@ -29,8 +30,19 @@
     steamNetworkEnums.h \
     steamNetworkEvent.h steamNetworkEvent.I \
     steamNetworkMessage.h steamNetworkMessage.I \
+    steamNetworkMessageBatch.h steamNetworkMessageBatch.I \
     steamNetworkSystem.h steamNetworkSystem.I
 
   #define IGATESCAN all
 
 #end lib_target
+
+#begin test_bin_target
+  #define TARGET test_steamnet_batch
+  #define USE_PACKAGES valve_steamnet
+  #define LOCAL_LIBS steamnet net express putil
+
+  #define SOURCES \
+    test_steamnet_batch.cxx
+
+#end test_bin_target
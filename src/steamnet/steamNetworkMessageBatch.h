@@ -0,0 +1,54 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file steamNetworkMessageBatch.h
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#ifndef STEAMNETWORKMESSAGEBATCH_H
+#define STEAMNETWORKMESSAGEBATCH_H
+
+#include "config_steamnet.h"
+#include "steamNetworkMessage.h"
+#include "pdeque.h"
+
+/**
+ * A list of messages filled in by one call to
+ * SteamNetworkSystem::receive_messages_on_poll_group() or
+ * receive_messages_on_connection().
+ *
+ * The batch is meant to be kept around and passed in again on every call.
+ * The messages, and the buffers of their datagrams, are reused from one call
+ * to the next, so draining the incoming messages doesn't allocate anything
+ * once the batch has grown to its working size.
+ */
+class EXPCL_PANDA_STEAMNET SteamNetworkMessageBatch {
+PUBLISHED:
+  INLINE SteamNetworkMessageBatch();
+
+  INLINE size_t get_num_messages() const;
+  INLINE SteamNetworkMessage &get_message(size_t n);
+  MAKE_SEQ(get_messages, get_num_messages, get_message);
+  MAKE_SEQ_PROPERTY(messages, get_num_messages, get_message);
+
+  INLINE void clear();
+
+public:
+  INLINE SteamNetworkMessage &add_message();
+
+private:
+  // A deque, since each message's DatagramIterator points into the message
+  // itself, so the messages must not move once they have been created.
+  pdeque<SteamNetworkMessage> _messages;
+  size_t _num_messages;
+};
+
+#include "steamNetworkMessageBatch.I"
+
+#endif // STEAMNETWORKMESSAGEBATCH_H
@@ -13,8 +13,10 @@
 
 #include "steamNetworkSystem.h"
 #include "steamNetworkMessage.h"
+#include "steamNetworkMessageBatch.h"
 #include "steamNetworkConnectionInfo.h"
 #include "pStatCollector.h"
+#include "configVariableInt.h"
 
 #ifndef CPPPARSER
 #include "steam/isteamnetworkingutils.h"
@@ -23,6 +25,14 @@
 IMPLEMENT_CLASS(SteamNetworkSystem);
 
 static PStatCollector copy_datagram_coll("App:SteamNetworking:CopyMessageDatagram");
+static PStatCollector send_messages_coll("App:SteamNetworking:SendMessages");
+
+static ConfigVariableInt steamnet_send_batch_size
+("steamnet-send-batch-size", 256,
+ PRC_DESC("The maximum number of datagrams that SteamNetworkSystem's "
+          "queue_datagram() collects before it hands them all to the "
+          "networking library at once.  Any remaining datagrams are sent by "
+          "flush_queued_datagrams()."));
 
 SteamNetworkSystem *SteamNetworkSystem::_global_ptr = nullptr;
 
@@ -75,6 +85,7 @@ SteamNetworkSystem() {
  */
 SteamNetworkSystem::
 ~SteamNetworkSystem() {
+  flush_queued_datagrams();
   GameNetworkingSockets_Kill();
 }
 
@@ -146,6 +157,74 @@ send_datagram(const Datagram &dg, SteamNetworkSystem::NetworkSendFlags flags) {
   send_datagram(_client_connection, dg, flags);
 }
 
+/**
+ * Queues a datagram to be sent to the indicated connection with the next
+ * batch.  The datagram is copied, so it may be modified or reused right away.
+ *
+ * The queued datagrams are handed to the networking library together, with a
+ * single call, when steamnet-send-batch-size of them have accumulated or when
+ * flush_queued_datagrams() is called, which should be done at least once per
+ * frame.  This is much cheaper than calling send_datagram() for each message
+ * when sending to many connections.  Datagrams sent to the same connection
+ * are still delivered in the order they were queued.
+ */
+void SteamNetworkSystem::
+queue_datagram(SteamNetworkConnectionHandle conn, const Datagram &dg,
+               SteamNetworkSystem::NetworkSendFlags flags) {
+  ISteamNetworkingMessage *msg =
+    SteamNetworkingUtils()->AllocateMessage((int)dg.get_length());
+  if (msg == nullptr) {
+    steamnet_cat.error()
+      << "Unable to allocate message of " << dg.get_length() << " bytes\n";
+    return;
+  }
+
+  memcpy(msg->m_pData, dg.get_data(), dg.get_length());
+  msg->m_conn = conn;
+  msg->m_nFlags = flags;
+  _send_queue.push_back(msg);
+
+  if ((int)_send_queue.size() >= steamnet_send_batch_size) {
+    flush_queued_datagrams();
+  }
+}
+
+/**
+ * Sends all of the datagrams queued by queue_datagram().
+ */
+void SteamNetworkSystem::
+flush_queued_datagrams() {
+  if (_send_queue.empty()) {
+    return;
+  }
+
+  send_messages_coll.start();
+  _send_results.resize(_send_queue.size());
+
+  // The library takes ownership of the messages, whether or not they can be
+  // sent.
+  _interface->SendMessages((int)_send_queue.size(), _send_queue.data(),
+                           _send_results.data());
+  send_messages_coll.stop();
+
+  if (steamnet_cat.is_debug()) {
+    // A negative result is the EResult of the failure.
+    size_t num_failed = 0;
+    for (int64 result : _send_results) {
+      if (result < 0) {
+        ++num_failed;
+      }
+    }
+    if (num_failed != 0) {
+      steamnet_cat.debug()
+        << "Failed to send " << num_failed << " of " << _send_results.size()
+        << " queued messages\n";
+    }
+  }
+
+  _send_queue.clear();
+}
+
 /**
  *
  */
@@ -194,7 +273,7 @@ receive_message_on_connection(SteamNetworkConnectionHandle conn, SteamNetworkMes
   }
 
   copy_datagram_coll.start();
-  msg.set_datagram(Datagram(in_msg->m_pData, in_msg->m_cbSize));
+  msg.set_data(in_msg->m_pData, in_msg->m_cbSize);
   copy_datagram_coll.stop();
 
   msg.set_connection(in_msg->GetConnection());
@@ -216,7 +295,7 @@ receive_message_on_poll_group(SteamNetworkPollGroupHandle poll_group, SteamNetwo
   }
 
   copy_datagram_coll.start();
-  msg.set_datagram(Datagram(in_msg->m_pData, in_msg->m_cbSize));
+  msg.set_data(in_msg->m_pData, in_msg->m_cbSize);
   copy_datagram_coll.stop();
 
   msg.set_connection(in_msg->GetConnection());
@@ -226,6 +305,63 @@ receive_message_on_poll_group(SteamNetworkPollGroupHandle poll_group, SteamNetwo
   return true;
 }
 
+/**
+ * Receives up to max_messages waiting messages on the indicated connection
+ * into the batch, replacing its previous contents.  Returns the number of
+ * messages received.
+ */
+int SteamNetworkSystem::
+receive_messages_on_connection(SteamNetworkConnectionHandle conn,
+                               SteamNetworkMessageBatch &batch,
+                               int max_messages) {
+  nassertr(max_messages > 0, 0);
+  _received.resize(max_messages);
+  int msg_count = _interface->ReceiveMessagesOnConnection(
+    conn, _received.data(), max_messages);
+  fill_batch(msg_count, batch);
+  return (int)batch.get_num_messages();
+}
+
+/**
+ * Receives up to max_messages waiting messages on any connection in the
+ * indicated poll group into the batch, replacing its previous contents.
+ * Returns the number of messages received.
+ *
+ * This is much cheaper than calling receive_message_on_poll_group() for each
+ * message, since the library is only asked once.  Keep passing in the same
+ * batch, so that its messages can be reused.
+ */
+int SteamNetworkSystem::
+receive_messages_on_poll_group(SteamNetworkPollGroupHandle poll_group,
+                               SteamNetworkMessageBatch &batch,
+                               int max_messages) {
+  nassertr(max_messages > 0, 0);
+  _received.resize(max_messages);
+  int msg_count = _interface->ReceiveMessagesOnPollGroup(
+    poll_group, _received.data(), max_messages);
+  fill_batch(msg_count, batch);
+  return (int)batch.get_num_messages();
+}
+
+/**
+ * Copies the first msg_count messages in _received into the batch, and
+ * releases them.
+ */
+void SteamNetworkSystem::
+fill_batch(int msg_count, SteamNetworkMessageBatch &batch) {
+  batch.clear();
+
+  copy_datagram_coll.start();
+  for (int i = 0; i < msg_count; ++i) {
+    ISteamNetworkingMessage *in_msg = _received[i];
+    SteamNetworkMessage &msg = batch.add_message();
+    msg.set_data(in_msg->m_pData, in_msg->m_cbSize);
+    msg.set_connection(in_msg->GetConnection());
+    in_msg->Release();
+  }
+  copy_datagram_coll.stop();
+}
+
 /**
  *
  */
@@ -21,6 +21,7 @@
 #include "netAddress.h"
 #include "datagramIterator.h"
 #include "pdeque.h"
+#include "pvector.h"
 #include "steamnet_includes.h"
 #include "steamNetworkEnums.h"
 #include "steamNetworkEvent.h"
@@ -28,6 +29,7 @@
 
 class SteamNetworkConnectionInfo;
 class SteamNetworkMessage;
+class SteamNetworkMessageBatch;
 
 /**
  * Main interface to the SteamNetworkingSockets implementation.
@@ -45,12 +47,23 @@ PUBLISHED:
                      NetworkSendFlags flags = NSF_reliable_no_nagle);
   // Only valid for client connections. Sends a datagram to the server.
   void send_datagram(const Datagram &dg, NetworkSendFlags flags = NSF_reliable_no_nagle);
+
+  void queue_datagram(SteamNetworkConnectionHandle conn, const Datagram &dg,
+                      NetworkSendFlags flags = NSF_reliable_no_nagle);
+  void flush_queued_datagrams();
+  INLINE size_t get_num_queued_datagrams() const;
   void close_connection(SteamNetworkConnectionHandle conn);
   void run_callbacks();
   bool accept_connection(SteamNetworkConnectionHandle conn);
   bool set_connection_poll_group(SteamNetworkConnectionHandle conn, SteamNetworkPollGroupHandle poll_group);
   bool receive_message_on_connection(SteamNetworkConnectionHandle conn, SteamNetworkMessage &msg);
   bool receive_message_on_poll_group(SteamNetworkPollGroupHandle poll_group, SteamNetworkMessage &msg);
+  int receive_messages_on_connection(SteamNetworkConnectionHandle conn,
+                                     SteamNetworkMessageBatch &batch,
+                                     int max_messages = 64);
+  int receive_messages_on_poll_group(SteamNetworkPollGroupHandle poll_group,
+                                     SteamNetworkMessageBatch &batch,
+                                     int max_messages = 64);
   SteamNetworkPollGroupHandle create_poll_group();
   SteamNetworkListenSocketHandle create_listen_socket(int port);
 
@@ -64,6 +77,8 @@ PUBLISHED:
   INLINE static SteamNetworkSystem *get_global_ptr();
 
 private:
+  void fill_batch(int msg_count, SteamNetworkMessageBatch &batch);
+
   ISteamNetworkingSockets *_interface;
   static SteamNetworkSystem *_global_ptr;
 
@@ -72,6 +87,16 @@ private:
   bool _is_client;
 
   pdeque<PT(SteamNetworkEvent)> _events;
+
+  // Messages received by the last receive_messages_*() call.
+  pvector<ISteamNetworkingMessage *> _received;
+
+  // Messages queued by queue_datagram(), waiting to be handed to
+  // SendMessages().
+  pvector<ISteamNetworkingMessage *> _send_queue;
+#ifndef CPPPARSER
+  pvector<int64> _send_results;
+#endif
 };
 
 #include "steamNetworkSystem.I"
@@ -0,0 +1,146 @@
+/**
+ * PANDA 3D SOFTWARE
+ * Copyright (c) Carnegie Mellon University.  All rights reserved.
+ *
+ * All use of this software is subject to the terms of the revised BSD
+ * license.  You should have received a copy of this license along
+ * with this source code in a file named "LICENSE."
+ *
+ * @file test_steamnet_batch.cxx
+ * @author brian
+ * @date 2026-10-18
+ */
+
+#include "pandabase.h"
+#include "steamNetworkSystem.h"
+#include "steamNetworkMessage.h"
+#include "steamNetworkMessageBatch.h"
+#include "steamNetworkEvent.h"
+#include "netAddress.h"
+#include "datagram.h"
+#include "trueClock.h"
+
+#include <algorithm>
+
+/**
+ * Sends the indicated number of messages from the client connection to the
+ * server over loopback, and returns the number of messages per second
+ * received by the server.  If batched is true, the messages are sent with
+ * queue_datagram() and received with receive_messages_on_poll_group();
+ * otherwise, they are sent and received one at a time.
+ */
+static double
+run_test(SteamNetworkSystem *sys, SteamNetworkConnectionHandle client,
+         SteamNetworkPollGroupHandle poll_group, int num_messages,
+         bool batched) {
+  static const int chunk_size = 500;
+  static const int max_in_flight = 4000;
+
+  Datagram dg;
+  dg.pad_bytes(64);
+
+  SteamNetworkMessage msg;
+  SteamNetworkMessageBatch batch;
+
+  int num_sent = 0;
+  int num_received = 0;
+
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double start = clock->get_short_time();
+  double give_up = start + 60.0;
+
+  while (num_received < num_messages && clock->get_short_time() < give_up) {
+    if (num_sent < num_messages && num_sent - num_received < max_in_flight) {
+      int count = std::min(chunk_size, num_messages - num_sent);
+      for (int i = 0; i < count; ++i) {
+        if (batched) {
+          sys->queue_datagram(client, dg);
+        } else {
+          sys->send_datagram(client, dg);
+        }
+      }
+      if (batched) {
+        sys->flush_queued_datagrams();
+      }
+      num_sent += count;
+    }
+
+    sys->run_callbacks();
+
+    if (batched) {
+      int count;
+      while ((count = sys->receive_messages_on_poll_group(poll_group, batch)) > 0) {
+        num_received += count;
+      }
+    } else {
+      while (sys->receive_message_on_poll_group(poll_group, msg)) {
+        ++num_received;
+      }
+    }
+  }
+
+  double elapsed = clock->get_short_time() - start;
+  return num_received / elapsed;
+}
+
+/**
+ * Compares sending and receiving SteamNetworkSystem messages one at a time
+ * against doing it in batches, over a loopback connection.
+ */
+int
+main(int argc, char *argv[]) {
+  if (argc > 3) {
+    nout << "test_steamnet_batch [num_messages [port]]\n";
+    exit(1);
+  }
+
+  int num_messages = (argc > 1) ? atoi(argv[1]) : 200000;
+  int port = (argc > 2) ? atoi(argv[2]) : 21600;
+
+  SteamNetworkSystem *sys = SteamNetworkSystem::get_global_ptr();
+  SteamNetworkListenSocketHandle listen_socket = sys->create_listen_socket(port);
+  SteamNetworkPollGroupHandle poll_group = sys->create_poll_group();
+
+  NetAddress address;
+  address.set_host("127.0.0.1", port);
+  SteamNetworkConnectionHandle client = sys->connect_by_IP_address(address);
+  if (listen_socket == INVALID_STEAM_NETWORK_LISTEN_SOCKET_HANDLE ||
+      client == INVALID_STEAM_NETWORK_CONNECTION_HANDLE) {
+    nout << "Unable to open loopback connection on port " << port << ".\n";
+    exit(1);
+  }
+
+  // Accept the connection on the server side, and wait for both ends to be
+  // connected.
+  int num_connected = 0;
+  TrueClock *clock = TrueClock::get_global_ptr();
+  double give_up = clock->get_short_time() + 10.0;
+  while (num_connected < 2 && clock->get_short_time() < give_up) {
+    sys->run_callbacks();
+
+    PT(SteamNetworkEvent) event;
+    while ((event = sys->get_next_event()) != nullptr) {
+      if (event->get_state() == SteamNetworkSystem::NCS_connecting &&
+          event->get_connection() != client) {
+        sys->accept_connection(event->get_connection());
+        sys->set_connection_poll_group(event->get_connection(), poll_group);
+
+      } else if (event->get_state() == SteamNetworkSystem::NCS_connected) {
+        ++num_connected;
+      }
+    }
+  }
+  if (num_connected < 2) {
+    nout << "Timed out waiting for loopback connection.\n";
+    exit(1);
+  }
+
+  double single_rate = run_test(sys, client, poll_group, num_messages, false);
+  nout << "One at a time: " << single_rate << " messages/sec\n";
+
+  double batched_rate = run_test(sys, client, poll_group, num_messages, true);
+  nout << "Batched: " << batched_rate << " messages/sec\n";
+
+  sys->close_connection(client);
+  return (0);
+}